@@ -0,0 +1,100 @@
+#ifndef AUDIO_BLOCK_POOL_H
+#define AUDIO_BLOCK_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#define AUDIO_BLOCK_SAMPLES 256 // 每塊樣本數 (與麥克風讀取大小一致)
+
+// 擷取任務填寫一次、由所有消費者 (發布、特徵提取 ...) 共用的音訊塊
+struct AudioBlock
+{
+    std::atomic<uint8_t> refCount; // 0 表示在池中閒置
+    uint64_t samplePosition; // 第一個樣本在串流樣本時鐘上的位置 (擷取取樣率)
+    uint64_t epochMicros;    // 樣本位置 0 的 Unix 時間 (µs)，0 表示尚未校時
+    uint64_t captureMicros; // I2S 讀取完成的時間 (monotonicMicros)
+    uint64_t queuedMicros;  // 放入發布環形緩衝區的時間
+    uint16_t sequenceNumber;
+    uint16_t dataLength;
+    int16_t audioData[AUDIO_BLOCK_SAMPLES];
+};
+
+// 固定大小、引用計數的音訊塊池
+// acquire() 取得引用計數為 1 的塊，每個消費者以 retain() 持有引用，最後一次 release() 時塊回到池中
+// 閒置與否只看引用計數，取得時以 CAS 佔用，任一任務都可以釋放，不需要鎖
+// 塊陣列是物件成員；物件放在全域或靜態記憶體即位於內部 RAM
+// 只依賴標準 C++，可在主機端以多個執行緒驗證
+template <uint32_t Capacity>
+class AudioBlockPool
+{
+    static_assert(Capacity >= 1 && Capacity <= 255, "容量必須介於 1 與 255 之間");
+
+private:
+    AudioBlock blocks[Capacity];
+    uint32_t nextIndex; // 僅取得端使用：下一次搜尋的起點
+
+    std::atomic<uint32_t> inUse;
+    uint32_t highWaterMark;
+    uint32_t exhaustedCount;
+
+public:
+    AudioBlockPool() : nextIndex(0), inUse(0), highWaterMark(0), exhaustedCount(0)
+    {
+        for (uint32_t i = 0; i < Capacity; i++)
+        {
+            blocks[i].refCount.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr uint32_t capacity() { return Capacity; }
+
+    // 取得一個閒置塊 (引用計數為 1)；池已用盡時回傳 nullptr 並累計 exhaustedCount
+    // 取得端應為單一任務 (擷取任務)
+    AudioBlock *acquire()
+    {
+        for (uint32_t n = 0; n < Capacity; n++)
+        {
+            uint32_t index = (nextIndex + n) % Capacity;
+            uint8_t expected = 0;
+            if (blocks[index].refCount.compare_exchange_strong(expected, 1, std::memory_order_acquire,
+                                                               std::memory_order_relaxed))
+            {
+                nextIndex = (index + 1) % Capacity;
+
+                uint32_t used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (used > highWaterMark)
+                {
+                    highWaterMark = used;
+                }
+                return &blocks[index];
+            }
+        }
+
+        exhaustedCount++;
+        return nullptr;
+    }
+
+    // 新增一個消費者引用 (呼叫端必須已持有引用)
+    void retain(AudioBlock *block)
+    {
+        block->refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 放棄一個引用；最後一個引用釋放時塊回到池中
+    void release(AudioBlock *block)
+    {
+        if (block->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            inUse.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // ===== 狀態 (任一側可讀，結果為近似值) =====
+
+    uint32_t getInUse() const { return inUse.load(std::memory_order_relaxed); }
+    uint32_t getHighWaterMark() const { return highWaterMark; }
+    uint32_t getExhaustedCount() const { return exhaustedCount; }
+};
+
+#endif // AUDIO_BLOCK_POOL_H
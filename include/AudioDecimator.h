@@ -0,0 +1,59 @@
+#ifndef AUDIO_DECIMATOR_H
+#define AUDIO_DECIMATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 2:1 降取樣：7 階半頻帶低通 [-1, 0, 9, 16, 9, 0, -1] / 32 後每兩個樣本取一個
+// 濾波狀態跨塊延續；切換串流層級或重新同步時呼叫 reset()
+// 只依賴標準 C++
+class AudioDecimator
+{
+private:
+    int16_t history[6]; // 前一次呼叫最後 6 個輸入樣本 (history[5] 最新)
+
+public:
+    AudioDecimator() { reset(); }
+
+    void reset()
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            history[i] = 0;
+        }
+    }
+
+    // 輸出 inputCount / 2 個樣本 (inputCount 應為偶數)，回傳輸出樣本數；input 與 output 不可重疊
+    size_t process(const int16_t *input, size_t inputCount, int16_t *output)
+    {
+        size_t outputCount = inputCount / 2;
+        for (size_t n = 0; n < outputCount; n++)
+        {
+            // 視窗為輸入 x[2n-5] ... x[2n+1]，中心 x[2n-2]
+            int32_t x[7];
+            for (int k = 0; k < 7; k++)
+            {
+                int32_t index = (int32_t)(2 * n) - 5 + k;
+                x[k] = index < 0 ? history[6 + index] : input[index];
+            }
+            int32_t acc = 16 * x[3] + 9 * (x[2] + x[4]) - (x[0] + x[6]);
+            acc = (acc + 16) >> 5;
+            output[n] = (int16_t)(acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc));
+        }
+
+        // 保留最後 6 個輸入樣本 (輸入不足 6 個時與舊狀態銜接)
+        int16_t next[6];
+        for (int k = 0; k < 6; k++)
+        {
+            int32_t index = (int32_t)(2 * outputCount) - 6 + k;
+            next[k] = index < 0 ? history[6 + index] : input[index];
+        }
+        for (int k = 0; k < 6; k++)
+        {
+            history[k] = next[k];
+        }
+        return outputCount;
+    }
+};
+
+#endif // AUDIO_DECIMATOR_H
@@ -4,74 +4,240 @@
 #include <Arduino.h>
 #include <math.h>
 #include "arduinoFFT.h"
+#include "FeatureTables.h"
+#include "RealFft.h"
+#include "FixedPointMfcc.h"
 
-// 音訊特徵提取配置
-#define FFT_SIZE 512
-#define SAMPLE_RATE 16000
-#define MEL_FILTER_BANKS 26
-#define MFCC_COEFFS 13
-#define FRAME_SIZE 400
-#define HOP_SIZE 160
+// 特徵提取數值精度：ESP32-S3 FPU 僅支援單精度，double 運算皆由軟體模擬
+// 預設使用 float 引擎；編譯時定義 AUDIO_FEATURE_PRECISION=AUDIO_FEATURE_PRECISION_DOUBLE 可切回 double 參考實作
+// float 引擎與雙精度參考 (直接 DFT) 的最大絕對偏差，主機端實測 (預設設定檔 / 低成本設定檔，test/test_float_mfcc.cpp)：
+//   滿刻度 0.49 fs 正弦：MFCC 0.0136 / 0.0016，對數梅爾 0.054 / 0.0032
+//   滿刻度 100 Hz 正弦：MFCC 0.0016 / 0.0002；其餘具名訊號 (440 Hz、-20 dB、雜訊、靜音)：MFCC < 0.0007
+// double 引擎與參考的偏差 < 1e-9；誤差集中在高動態範圍幀中能量很低的梅爾頻帶 (單精度 FFT 的捨入雜訊)
+#define AUDIO_FEATURE_PRECISION_DOUBLE 0
+#define AUDIO_FEATURE_PRECISION_FLOAT 1
 
-class AudioFeatureExtractor
+#ifndef AUDIO_FEATURE_PRECISION
+#define AUDIO_FEATURE_PRECISION AUDIO_FEATURE_PRECISION_FLOAT
+#endif
+
+#if AUDIO_FEATURE_PRECISION == AUDIO_FEATURE_PRECISION_FLOAT
+typedef float feature_t;
+#else
+typedef double feature_t;
+#endif
+
+// 實數輸入 FFT：將 FFT_SIZE 個實數樣本打包成 FFT_SIZE/2 點複數 FFT 再展開頻譜，約省一半運算
+// 定義 AUDIO_FEATURE_REAL_FFT=0 可改回完整的 FFT_SIZE 點複數 FFT
+#ifndef AUDIO_FEATURE_REAL_FFT
+#define AUDIO_FEATURE_REAL_FFT 1
+#endif
+
+// 整數 MFCC 引擎 (FixedPointMfcc.h)：視窗~DCT 全部以 Q15/Q31 整數運算，不經 FPU
+// 預設關閉；定義 AUDIO_FEATURE_FIXED_POINT=1 改為預設使用整數引擎，執行期可用 setFixedPointEnabled() 切換
+// 與雙精度 MFCC 的偏差見 FixedPointMfcc.h (滿刻度低頻或近 Nyquist 正弦可達 0.09 ~ 0.14，一般訊號 < 0.01)
+#ifndef AUDIO_FEATURE_FIXED_POINT
+#define AUDIO_FEATURE_FIXED_POINT 0
+#endif
+
+// 頻譜滾降點：累積能量達總能量此比例時的頻率
+#ifndef SPECTRAL_ROLLOFF_RATIO
+#define SPECTRAL_ROLLOFF_RATIO 0.85
+#endif
+
+// 每幀頻譜/時域統計 (extractFeatures 時一次算好，之後讀取皆為 O(1))
+// 頻譜統計不含 DC 頻點
+struct SpectralStats
 {
+    feature_t centroid;         // 頻譜重心 (Hz)
+    feature_t bandwidth;        // 頻譜帶寬 (Hz)
+    feature_t rolloff;          // 頻譜滾降點 (Hz)
+    feature_t flatness;         // 頻譜平坦度 (幾何平均/算術平均, 0~1)
+    feature_t totalEnergy;      // 頻譜總能量
+    feature_t zeroCrossingRate; // 過零率
+    feature_t rmsEnergy;        // RMS 能量
+};
+
+// 每階段累計週期數 (ESP.getCycleCount)
+struct FeatureStageTiming
+{
+    uint64_t windowCycles;
+    uint64_t fftCycles;
+    uint64_t powerCycles;
+    uint64_t melCycles;
+    uint64_t dctCycles;
+    uint32_t frames;
+};
+
+// 音訊特徵提取器：所有尺寸皆為模板參數，查表於編譯期產生，緩衝區固定大小、不使用堆積
+// 成員函數定義在 AudioFeatureExtractor.cpp，並在該檔尾端為下方各設定檔顯式實例化
+template <uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks, uint8_t MfccCoeffs,
+          uint16_t FrameSize, uint16_t HopSize>
+class AudioFeatureExtractorT
+{
+public:
+    // 音訊特徵提取配置
+    static constexpr uint32_t SAMPLE_RATE = SampleRate;
+    static constexpr uint16_t FFT_SIZE = FftSize;
+    static constexpr uint8_t MEL_FILTER_BANKS = MelBanks;
+    static constexpr uint8_t MFCC_COEFFS = MfccCoeffs;
+    static constexpr uint16_t FRAME_SIZE = FrameSize;
+    static constexpr uint16_t HOP_SIZE = HopSize; // 預設跳距，執行期可用 setHopSize() 修改
+    static constexpr uint16_t SPECTRUM_BINS = FftSize / 2 + 1;
+
+    static_assert((FftSize & (FftSize - 1)) == 0 && FftSize >= 16, "FFT_SIZE 必須是 2 的冪次");
+    static_assert(FrameSize <= FftSize, "FRAME_SIZE 不可大於 FFT_SIZE");
+    static_assert(HopSize > 0 && HopSize <= FrameSize, "HOP_SIZE 必須介於 1 與 FRAME_SIZE 之間");
+    static_assert(MfccCoeffs <= MelBanks, "MFCC_COEFFS 不可大於 MEL_FILTER_BANKS");
+
+    // 每完成一個跳距幀 (特徵已計算) 時呼叫
+    typedef void (*FrameCallback)(AudioFeatureExtractorT *extractor, void *context);
+
 private:
+    // 編譯期查表 (存放於 flash)：視窗、DCT 與旋轉因子不在每幀計算 cos
+    static constexpr FeatureTable<feature_t, FrameSize> windowTable =
+        makeHammingWindow<feature_t, FrameSize>(); // 漢明視窗 × 1/32768 正規化
+    static constexpr FeatureTable<feature_t, MfccCoeffs * MelBanks> dctTable =
+        makeDctTable<feature_t, MfccCoeffs, MelBanks>(); // DCT-II 係數，已含正交化比例
+    static constexpr FeatureTable<feature_t, FftSize / 4 + 1> rfftCos =
+        makeTwiddleCos<feature_t, FftSize>(); // 實數 FFT 展開用旋轉因子
+    static constexpr FeatureTable<feature_t, FftSize / 4 + 1> rfftSin =
+        makeTwiddleSin<feature_t, FftSize>();
+    static constexpr MelFilterBank<feature_t, MelBanks, FftSize> melBank =
+        makeMelFilterBank<feature_t, SampleRate, FftSize, MelBanks>(); // 稀疏梅爾濾波器
+
     // FFT 相關
-    ArduinoFFT<double> FFT;
-    double *vReal;
-    double *vImag;
-    double *powerSpectrum;
+    ArduinoFFT<feature_t> FFT;
+    feature_t vReal[FftSize];
+    feature_t vImag[FftSize];
+    feature_t powerSpectrum[SPECTRUM_BINS];
+    feature_t cumulativeEnergy[SPECTRUM_BINS]; // 功率譜前綴和 (不含 DC)，供滾降點二分搜尋
+    bool useRealFFT;
+
+    // 整數引擎
+    FixedPointMfccT<SampleRate, FftSize, MelBanks, MfccCoeffs, FrameSize> fixedEngine;
+    bool useFixedPoint;
 
-    // 梅爾濾波器組
-    double melFilters[MEL_FILTER_BANKS][FFT_SIZE / 2 + 1];
-    double melEnergies[MEL_FILTER_BANKS];
-    double mfccCoeffs[MFCC_COEFFS];
+    // 本幀統計快取
+    SpectralStats stats;
 
-    // 音訊緩衝區
-    int16_t audioBuffer[FRAME_SIZE];
-    int bufferIndex;
+    // 梅爾能量與 MFCC
+    feature_t melEnergies[MelBanks];
+    feature_t mfccCoeffs[MfccCoeffs];
+
+    // 每階段計時
+    FeatureStageTiming timing;
+
+    // 音訊緩衝區：環形緩衝區接收樣本，滿一個跳距時展開成線性幀 audioBuffer
+    int16_t ringBuffer[FrameSize];
+    int16_t audioBuffer[FrameSize];
+    uint16_t ringWritePos;
+    uint16_t samplesUntilFrame; // 距離下一幀完成還需的樣本數
+    uint16_t hopSize;           // 目前跳距 (1 ~ FRAME_SIZE)
+    uint32_t frameCount; // 0 表示 audioBuffer 尚無完整的幀
+    int frameInputEnd; // 目前幀最後一個樣本之後，在最近一次 processAudioFrame 輸入中的索引
+
+    // 幀輸出回調
+    FrameCallback frameCallback;
+    void *frameCallbackContext;
 
     // 預處理函數
-    void initMelFilters();
-    double melScale(double freq);
-    double invMelScale(double mel);
-    void applyHammingWindow(double *signal, int length);
+    void loadFrame();
+    void computeFFT();
+    void computeComplexFFT();
+    void computeRealFFT();
     void computePowerSpectrum();
     void applyMelFilters();
     void computeMFCC();
+    void extractFeaturesFixedPoint();
+
+    // 以 powerAt(i) 取得各頻點功率，寫入 powerSpectrum 並同時累計頻譜統計
+    template <typename PowerAt>
+    void accumulateSpectrum(PowerAt powerAt);
 
 public:
-    // 建構函數和解構函數
-    AudioFeatureExtractor();
-    ~AudioFeatureExtractor();
+    // 建構函數
+    AudioFeatureExtractorT();
 
     // 初始化
     bool begin();
 
-    // 音訊數據處理
-    bool processAudioFrame(int16_t *audio, int length);
-    bool isFrameReady();
+    // 音訊數據處理：寫入任意長度樣本，每湊滿一個跳距即提取一幀並呼叫回調，回傳本次產生的幀數
+    // 新幀只以回調與回傳值通知；之後讀取的特徵都屬於最近一幀
+    int processAudioFrame(int16_t *audio, int length);
+    void setFrameCallback(FrameCallback callback, void *context)
+    {
+        frameCallback = callback;
+        frameCallbackContext = context;
+    }
 
-    // 特徵提取
+    // 跳距：新值從下一幀完成後開始計算 (已排定的下一幀不變)，因此回調中的 getHopSize() 即到下一幀的距離
+    bool setHopSize(uint16_t hop);
+    uint16_t getHopSize() { return hopSize; }
+
+    // 目前幀的樣本 (時間順序) 與自 reset() 起的幀序號
+    int16_t *getFrame() { return audioBuffer; }
+    uint32_t getFrameCount() { return frameCount; }
+
+    // 回調中使用：目前幀結束於本次 processAudioFrame 輸入的第幾個樣本之前 (呼叫端據此換算幀的樣本位置)
+    int getFrameInputEnd() { return frameInputEnd; }
+
+    // 對目前幀提取特徵 (processAudioFrame 會自動呼叫；尚無完整的幀時不做任何事)
     void extractFeatures();
 
+    // FFT 模式 (實數打包 / 完整複數)
+    void setRealFFTEnabled(bool enabled) { useRealFFT = enabled; }
+    bool isRealFFTEnabled() { return useRealFFT; }
+
+    // 比較實數 FFT 與完整複數 FFT 每幀所需週期數
+    void benchmarkFFT(int iterations = 100);
+
+    // 特徵引擎 (浮點 / 整數)
+    void setFixedPointEnabled(bool enabled) { useFixedPoint = enabled; }
+    bool isFixedPointEnabled() { return useFixedPoint; }
+
+    // 以目前幀比較浮點與整數引擎：週期數、整數參考/最佳化實作是否逐位元一致、MFCC 最大偏差
+    void benchmarkFixedPoint(int iterations = 100);
+
+    // 每階段計時報告
+    const FeatureStageTiming &getStageTiming() { return timing; }
+    void printTimingReport();
+    void resetTiming();
+
     // 獲取結果
-    double *getMelEnergies() { return melEnergies; }
-    double *getMFCCCoeffs() { return mfccCoeffs; }
-    double *getPowerSpectrum() { return powerSpectrum; }
+    feature_t *getMelEnergies() { return melEnergies; }
+    feature_t *getMFCCCoeffs() { return mfccCoeffs; }
+    feature_t *getPowerSpectrum() { return powerSpectrum; }
 
-    // 音訊特徵分析
-    double computeSpectralCentroid();
-    double computeSpectralBandwidth();
-    double computeZeroCrossingRate(int16_t *audio, int length);
-    double computeRMSEnergy(int16_t *audio, int length);
+    // 本幀統計 (快取值，直到下一次 extractFeatures)
+    const SpectralStats &getSpectralStats() { return stats; }
+    feature_t getSpectralCentroid() { return stats.centroid; }
+    feature_t getSpectralBandwidth() { return stats.bandwidth; }
+    feature_t getSpectralRolloff() { return stats.rolloff; }
+    feature_t getSpectralFlatness() { return stats.flatness; }
+    feature_t getSpectralEnergy() { return stats.totalEnergy; }
+    feature_t getZeroCrossingRate() { return stats.zeroCrossingRate; }
+    feature_t getRMSEnergy() { return stats.rmsEnergy; }
+
+    // 任意音訊緩衝區的時域特徵
+    feature_t computeZeroCrossingRate(int16_t *audio, int length);
+    feature_t computeRMSEnergy(int16_t *audio, int length);
 
     // 特徵向量輸出
-    void getFeatureVector(double *features, int maxLength);
+    void getFeatureVector(feature_t *features, int maxLength);
     void printFeatures();
 
+    // 輸入串流不連續 (有樣本遺失) 時丟棄未完成的幀，從下一個樣本重新湊滿 FRAME_SIZE；保留幀序號與計時
+    void resync();
+
     // 重置緩衝區
     void reset();
 };
 
+// 預設設定檔：16 kHz / 512 點 FFT / 26 梅爾 / 13 MFCC / 25 ms 幀 / 10 ms 跳距
+typedef AudioFeatureExtractorT<16000, 512, 26, 13, 400, 160> AudioFeatureExtractor;
+
+// 低成本設定檔：8 kHz / 256 點 FFT / 20 梅爾 / 13 MFCC / 25 ms 幀 / 10 ms 跳距
+typedef AudioFeatureExtractorT<8000, 256, 20, 13, 200, 80> AudioFeatureExtractorNarrowband;
+
 #endif // AUDIO_FEATURE_EXTRACTOR_H
@@ -4,63 +4,184 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <PubSubClient.h>
-#include <ArduinoJson.h>
+#include <mutex>
 #include "AudioFeatureExtractor.h"
+#include "SpscRing.h"
+#include "AudioBlockPool.h"
+#include "AudioWireFormat.h"
+#include "FeatureWireFormat.h"
+#include "StreamQualityController.h"
+#include "AudioDecimator.h"
+#include "AudioSpool.h"
+#include "AudioSink.h"
+#include "AudioStreamManager.h"
+#include "AudioWebSocketServer.h"
+#include "StreamConfig.h"
+#include "JsonFieldReader.h"
+#include "JsonFrameWriter.h"
+#include "HeapAllocCounter.h"
+#include "LatencyHistogram.h"
+#include "MonotonicClock.h"
+#include "ReconnectBackoff.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
+#include "lwip/ip_addr.h"
+
+// 音訊批次發布：發布任務就地讀取環形緩衝區中所有連續的包，合併成一則 MQTT 訊息
+// 批次在包數或位元組預算用盡、或最早的包等待超過延遲預算時送出 (包數與延遲可用 configure 命令修改)
+#define AUDIO_RING_BLOCKS 16 // 擷取 → 音訊發布任務的環形緩衝區塊數 (2 的冪次)
+#define AUDIO_BATCH_MAX_PACKETS 8      // 包數上限與預設值
+#define AUDIO_BATCH_MAX_BYTES 4096     // 單則訊息負載上限 (各啟用格式取最大估計值)
+#define AUDIO_BATCH_MAX_LATENCY_MS 50  // 預設：最早的包從擷取到發布的最長等待
+#define AUDIO_JSON_BYTES_PER_SAMPLE 7  // JSON 每樣本最壞情況 ("-32768,")
+#define AUDIO_JSON_OVERHEAD 160        // JSON 欄位與括號 (含 64 位元樣本位置)
 
 // MQTT 配置
-#define MQTT_BUFFER_SIZE 2048
-#define MQTT_RECONNECT_INTERVAL 5000
-#define AUDIO_PUBLISH_INTERVAL 100   // ms
-#define FEATURE_PUBLISH_INTERVAL 200 // ms
+#define MQTT_BUFFER_SIZE 2048 // 接收控制訊息；音訊、特徵與狀態以 beginPublish 串流，不經此緩衝區
+#define STATUS_FRAME_BYTES 4096 // 狀態訊息的序列化緩衝區 (所有欄位取最大值約 2.9 KB)
+
+// 非阻塞連線狀態機：MQTT 任務每輪只輪詢一次 DNS 或 TCP 連線狀態，不會因服務器緩慢而卡住 mqttClient.loop()
+// 失敗後以抖動指數退避重試；TCP 建立後的 MQTT 握手仍由 PubSubClient 同步等待，上限為 MQTT_HANDSHAKE_TIMEOUT_S
+#define MQTT_BACKOFF_BASE_MS 500      // 第一次重試前的等待上限
+#define MQTT_BACKOFF_MAX_MS 30000     // 等待上限
+#define MQTT_DNS_TIMEOUT_MS 5000      // 名稱解析逾時
+#define MQTT_TCP_TIMEOUT_MS 5000      // TCP 連線逾時
+#define MQTT_HANDSHAKE_TIMEOUT_S 2    // CONNECT → CONNACK 等待上限 (PubSubClient socket timeout)
+
+// 連線狀態 (connectionState)
+#define MQTT_CONN_BACKOFF 0   // 等待下次嘗試
+#define MQTT_CONN_RESOLVING 1 // 等待 DNS 回應
+#define MQTT_CONN_TCP 2       // 等待非阻塞 TCP 連線完成
+#define MQTT_CONN_CONNECTED 3
+
+// 名稱解析狀態 (dnsStatus 的低 2 位元；其餘位元為嘗試編號)
+// dns_gethostbyname 經 tcpip_callback 在 lwIP 執行緒中呼叫；逾時的嘗試其回調仍可能晚到，
+// 回調只在嘗試編號相符且仍為 PENDING 時以 compare-exchange 寫入結果，不會影響下一次嘗試
+#define MQTT_DNS_PENDING 0
+#define MQTT_DNS_CLAIMED 1 // 回調已認領，正在寫入 resolvedAddress
+#define MQTT_DNS_RESOLVED 2
+#define MQTT_DNS_FAILED 3
+#define MQTT_DNS_REQUEST_SLOTS 4 // 回調上下文以嘗試編號輪替，晚到的回調不會讀到被覆寫的請求
+
+// 單一發布任務：平時阻塞等待任務通知，音訊嚴格優先於特徵
+// 特徵等待超過 FEATURE_STARVATION_MS 時插入一幀特徵，避免音訊持續到達時特徵永遠發不出去
+#define PUBLISH_EVENT_AUDIO 0x01    // 任務通知位元：音訊環形緩衝區有新塊
+#define PUBLISH_EVENT_FEATURES 0x02 // 任務通知位元：特徵隊列有新幀
+#define PUBLISH_EVENT_STOP 0x04     // 任務通知位元：isPublishing 已清除，立即檢查並自行結束
+#define TASK_EXIT_TIMEOUT_MS 2000   // 停止任務時等待它自行結束的上限
+#define FEATURE_STARVATION_MS 100 // 預設值，可用 configure 命令的 featureIntervalMs 修改
+
+// 特徵提取任務配置：麥克風擷取任務在 APP_CPU，特徵提取放到另一個核心，避免 FFT 尖峰延遲 i2s_read
+#define FEATURE_TASK_CORE PRO_CPU_NUM
+#define FEATURE_TASK_PRIORITY 2
+#define FEATURE_TASK_STACK_SIZE 6144
+#define FEATURE_RING_BLOCKS 16   // 擷取 → 特徵任務的環形緩衝區塊數 (2 的冪次)
+#define FEATURE_QUEUE_DEPTH 20   // 特徵任務 → 發布任務的幀隊列深度
+#define FEATURE_FRAME_BATCH 4    // 緊湊特徵訊息最多合併的連續幀數
 
 // MQTT 主題定義
 #define MQTT_TOPIC_AUDIO "esp32/audio/raw"
+#define MQTT_TOPIC_AUDIO_BINARY "esp32/audio/raw/bin" // 二進位封包 (AudioWireFormat.h)
 #define MQTT_TOPIC_MFCC "esp32/audio/mfcc"
 #define MQTT_TOPIC_MEL "esp32/audio/mel"
 #define MQTT_TOPIC_FEATURES "esp32/audio/features"
+#define MQTT_TOPIC_FEATURE_FRAME "esp32/audio/frame" // 緊湊特徵幀 (FeatureWireFormat.h)
 #define MQTT_TOPIC_STATUS "esp32/audio/status"
 #define MQTT_TOPIC_CONTROL "esp32/audio/control"
 
-// 音訊數據包結構 (優化為 MQTT 傳輸)
-struct MqttAudioPacket
+// 音訊與特徵輸出格式 (AUDIO_OUTPUT_* / FEATURE_OUTPUT_*) 與特徵集定義於 StreamConfig.h
+
+// 執行期串流設定 (configure 命令)：發布任務在兩批訊息之間一次套用，跳距由特徵任務在下一個輸入塊套用
+// 命令帶 "persist": true 時把指定的欄位寫入 NVS，下次開機於 begin() 載入
+#define CONFIG_AUDIO_INTERVAL_MAX_MS 200    // 超過會使環形緩衝區 (16 塊約 256 ms) 在批次收集期間溢位
+#define CONFIG_HOP_MIN_SAMPLES 80           // 5 ms；跳距越小特徵任務負載越高
+#define CONFIG_FEATURE_INTERVAL_MIN_MS 10
+#define CONFIG_FEATURE_INTERVAL_MAX_MS 1000
+#define STREAM_CONFIG_NVS_NAMESPACE "audio_stream"
+#define STREAM_CONFIG_NVS_VERSION 1 // StreamConfig 佈局改變時遞增，舊版本的儲存值即被忽略
+#define STREAM_CONFIG_ACK_BYTES 512 // 確認訊息緩衝區 (堆疊)
+
+// 自適應串流品質：壅塞時依序降為 ADPCM、8 kHz ADPCM、只發布特徵，鏈路恢復後逐級升回
+#ifndef STREAM_QUALITY_ADAPTIVE
+#define STREAM_QUALITY_ADAPTIVE 1
+#endif
+#define STREAM_TIER_REQUEST_NONE -1 // 控制命令 → 發布任務：沒有待處理的請求
+#define STREAM_TIER_REQUEST_AUTO -2 // 控制命令 → 發布任務：恢復自動切換
+
+// 斷線暫存與補發：斷線或發布失敗時音訊 (IMA-ADPCM) 與特徵 (緊湊幀) 寫入暫存區，
+// 重新連線後以令牌桶限速補發，與即時資料交錯
+#define SPOOL_REPLAY_BYTES_PER_SEC 32768 // 約 3.5 倍即時 ADPCM 速率
+#define SPOOL_REPLAY_BURST_BYTES AUDIO_BATCH_MAX_BYTES
+#define SPOOL_REPLAY_INTERVAL_MS 10 // 有積壓時發布任務的最長等待
+
+// 即時音訊的替代傳輸 (AudioSink)：擷取任務直接送出，不經過發布任務
+#define AUDIO_SINK_MAX 4
+#ifndef AUDIO_WEBSOCKET_ENABLED
+#define AUDIO_WEBSOCKET_ENABLED 1 // begin() 時啟動 WebSocket 串流伺服器 (WS_SERVER_PORT)
+#endif
+
+// 音訊發布管線的各階段 (µs)，依序相接，總和即 audioLatency (I2S 讀取完成 → 交給連線完成)
+#define LATENCY_STAGE_CAPTURE 0 // I2S 讀取完成 → 放入發布環形緩衝區 (複製、特徵與替代傳輸)
+#define LATENCY_STAGE_QUEUE 1   // 環形緩衝區中等待發布任務取出 (含批次收集)
+#define LATENCY_STAGE_LOCK 2    // 等待 MQTT 互斥鎖 (控制訊息、狀態、重連)
+#define LATENCY_STAGE_ENCODE 3  // 序列化 (JSON 或二進位編碼)
+#define LATENCY_STAGE_SEND 4    // beginPublish → endPublish (寫入 TCP 連線)
+#define LATENCY_STAGE_COUNT 5
+
+// 系統時間早於此值 (2020-09) 視為尚未由 NTP 校正，封包的 epochMicros 為 0，校正後才錨定樣本時鐘
+#define SAMPLE_CLOCK_MIN_EPOCH_S 1600000000
+
+// 共用音訊塊池：兩個環形緩衝區全滿時仍留有擷取中的塊
+#define AUDIO_POOL_BLOCKS (AUDIO_RING_BLOCKS + FEATURE_RING_BLOCKS + 2)
+
+// 擷取 → 特徵任務的音訊塊引用
+class AudioMqttManager;
+
+// 交給 lwIP 執行緒的名稱解析請求 (回調上下文)
+struct MqttDnsRequest
 {
-    uint32_t timestamp;
-    uint16_t sequenceNumber;
-    uint16_t dataLength;
-    int16_t audioData[256]; // 減少大小以適應 MQTT
+    AudioMqttManager *manager;
+    std::atomic<uint32_t> attempt;
 };
 
-// MFCC 特徵包結構
-struct MqttMfccPacket
+struct FeatureBlockRef
 {
-    uint32_t timestamp;
-    double mfccCoeffs[MFCC_COEFFS];
-    bool isValid;
+    AudioBlock *block;
+    bool discontinuity; // 此塊之前有樣本因環形緩衝區已滿而遺失
 };
 
-// 梅爾能量包結構
-struct MqttMelPacket
+// 特徵任務 → 發布任務的單幀特徵 (每個跳距一筆)，兩種輸出格式都由此產生
+struct MqttFeatureFrame
 {
-    uint32_t timestamp;
-    double melEnergies[MEL_FILTER_BANKS];
-    bool isValid;
+    uint64_t samplePosition; // 幀第一個樣本在串流樣本時鐘上的位置
+    uint64_t epochMicros;
+    uint64_t extractedMicros; // 提取完成的時間 (monotonicMicros)，只用於量測延遲
+    uint16_t sequence; // 幀序號，連續幀才會合併成同一則緊湊訊息
+    uint16_t hopSamples; // 到下一幀的距離 (樣本)，跳距相同的連續幀才會合併
+    float mfcc[AudioFeatureExtractor::MFCC_COEFFS];
+    float mel[AudioFeatureExtractor::MEL_FILTER_BANKS];
+    float stats[FEATURE_WIRE_STAT_COUNT]; // 順序見 FeatureWireFormat.h
 };
 
-// 其他音訊特徵包結構
-struct MqttFeaturesPacket
+// configure 命令的確認：套用後發布到狀態主題
+struct StreamConfigAck
 {
-    uint32_t timestamp;
-    double spectralCentroid;
-    double spectralBandwidth;
-    double zeroCrossingRate;
-    double rmsEnergy;
-    bool isValid;
+    const char *command; // 命令名稱 (字串常數)，nullptr 表示不需確認 (程式內呼叫)
+    int32_t id;          // 命令帶的 id，未指定為 -1
+    uint16_t fields;     // 命令指定的欄位
+    bool persisted;      // 已寫入 NVS
 };
 
+static_assert(AUDIO_BATCH_MAX_BYTES >= AUDIO_WIRE_HEADER_SIZE + sizeof(AudioBlock::audioData),
+              "AUDIO_BATCH_MAX_BYTES 至少要放得下一個 PCM16 封包");
+static_assert(AUDIO_BATCH_MAX_BYTES >= FEATURE_WIRE_HEADER_SIZE +
+                                           FEATURE_FRAME_BATCH * 2 * (AudioFeatureExtractor::MFCC_COEFFS +
+                                                                      AudioFeatureExtractor::MEL_FILTER_BANKS +
+                                                                      FEATURE_WIRE_STAT_COUNT),
+              "AUDIO_BATCH_MAX_BYTES 至少要放得下一則緊湊特徵訊息");
+
 class AudioMqttManager
 {
 private:
@@ -68,20 +189,33 @@ private:
     WiFiClient wifiClient;
     PubSubClient mqttClient;
 
-    // 音訊特徵提取器
-    AudioFeatureExtractor *featureExtractor;
+    // 音訊特徵提取器 (固定大小成員，不使用堆積)
+    AudioFeatureExtractor featureExtractor;
 
     // 音訊緩衝區和隊列
-    QueueHandle_t audioQueue;
-    QueueHandle_t mfccQueue;
-    QueueHandle_t melQueue;
-    QueueHandle_t featuresQueue;
+    QueueHandle_t featureQueue; // MqttFeatureFrame
     SemaphoreHandle_t mqttMutex;
 
+    // 擷取任務每塊只填寫一次，各消費者以引用計數共用 (靜態成員陣列，位於內部 RAM)
+    AudioBlockPool<AUDIO_POOL_BLOCKS> blockPool;
+
+    // 擷取 → 音訊發布任務的無鎖環形緩衝區 (傳遞塊引用)，發布任務以任務通知喚醒
+    SpscRing<AudioBlock *, AUDIO_RING_BLOCKS> audioRing;
+
+    // 擷取 → 特徵任務的無鎖環形緩衝區 (麥克風任務寫入、特徵任務讀取)
+    SpscRing<FeatureBlockRef, FEATURE_RING_BLOCKS> featureRing;
+    bool featureDiscontinuity; // 僅生產者使用：下一塊需標記不連續
+
     // 任務控制柄
     TaskHandle_t mqttTaskHandle;
-    TaskHandle_t audioPublishTaskHandle;
-    TaskHandle_t featurePublishTaskHandle;
+    TaskHandle_t publisherTaskHandle;
+    TaskHandle_t featureTaskHandle;
+
+    // 任務只在迴圈邊界自行結束 (vTaskDelete(nullptr))，結束前給出信號量；停止端清除旗標、通知並等待
+    // 不從其他任務刪除：可能正持有 mqttMutex，或已釋放塊引用但尚未歸還環形緩衝區槽位
+    SemaphoreHandle_t publisherExitSemaphore; // 發布任務 (二元)
+    SemaphoreHandle_t taskExitSemaphore;      // MQTT 與特徵任務 (計數，end() 時使用)
+    std::atomic<bool> tasksRunning;           // 清除後 MQTT 與特徵任務結束
 
     // MQTT 連接參數
     const char *mqttServer;
@@ -92,40 +226,181 @@ private:
 
     // 狀態變量
     bool isConnected;
-    bool isPublishing;
+    std::atomic<bool> isPublishing; // 發布任務每輪檢查；由 stopPublishing() 清除
     bool isFeatureExtractionEnabled;
     uint16_t currentSequence;
     uint32_t lastAudioPublish;
     uint32_t lastFeaturePublish;
-    uint32_t lastReconnectAttempt;
+
+    // 非阻塞連線狀態機：只由 loop() 在持有 mqttMutex 時推進 (loop() 只由 MQTT 任務呼叫)；
+    // connect() / disconnect() 只重設 nextConnectAttempt；dnsStatus 與 resolvedAddress 由 lwIP 執行緒的回調寫入
+    uint8_t connectionState;
+    ReconnectBackoff backoff;
+    uint32_t connectStart;      // 本次嘗試開始時間 (含 DNS)
+    uint32_t stateStart;        // 進入目前狀態的時間
+    uint32_t nextConnectAttempt;
+    int connectSocket;
+    uint32_t dnsAttempt;                          // 每次嘗試 +1
+    MqttDnsRequest dnsRequests[MQTT_DNS_REQUEST_SLOTS];
+    std::atomic<uint32_t> dnsStatus;              // (dnsAttempt << 2) | MQTT_DNS_*
+    uint32_t resolvedAddress;                     // IPv4，網路位元組順序；dnsStatus 為 RESOLVED 後才可讀取
+
+    // 執行期串流設定：請求端 (MQTT 任務的控制命令或公開的 set 方法) 寫入 requestedConfig，
+    // 發布任務在兩批訊息之間以序號鎖讀取完整快照後一次套用；讀取端只重試不加鎖，請求端不會被發布任務阻塞
+    // (發布任務只在迴圈邊界自行結束，見 stopPublishing)
+    StreamConfig config;                  // 目前套用的設定，僅發布任務修改 (未發布時由請求端直接套用)
+    StreamConfig requestedConfig;         // 最近一次請求後的完整設定
+    StreamConfigAck requestedAck;         // 同一幀邊界前的多個請求合併套用，只確認最後一個
+    std::atomic<uint32_t> configSequence; // 每次請求 +2，寫入期間為奇數
+    uint32_t appliedConfigSequence;       // 僅套用端使用
+    std::mutex configWriteLock;           // 只在請求端之間互斥
+    std::atomic<uint16_t> featureHopSamples; // 發布任務 → 特徵任務：下一個輸入塊套用的跳距
+
+    // 音訊輸出 (格式與編碼見 config)
+    ImaAdpcmCodec adpcmEncoder; // 狀態跨封包延續
+    bool audioResyncPending;    // 下一個二進位封包標記 AUDIO_WIRE_FLAG_RESYNC
+    uint32_t audioSampleRate;
+
+    // 串流樣本時鐘：封包與特徵幀的時間都由樣本位置推得 (見 AudioWireFormat.h)
+    uint64_t samplePosition;              // 僅擷取任務使用：下一個樣本的位置
+    uint64_t streamEpochMicros;           // 僅擷取任務使用：樣本位置 0 的 Unix 時間 (µs)，0 表示尚未校時
+    std::atomic<bool> sampleClockRestart; // startPublishing() → 擷取任務：下一塊從位置 0 重新開始
+    uint64_t featureInputPosition;        // 僅特徵任務使用：目前輸入塊的位置與紀元
+    uint64_t featureInputEpoch;
+    uint64_t nextAudioPosition;       // 僅發布任務使用：各串流預期的下一個位置，跳躍時標記 GAP
+    uint64_t nextFeaturePosition;     // MQTT 特徵 (以幀的起始位置計)
+    uint64_t nextSinkFeaturePosition; // 替代傳輸的特徵
+
+    // 自適應串流品質 (控制器與解碼器狀態僅發布任務使用)
+    StreamQualityController quality;
+    AudioDecimator decimator;              // STREAM_TIER_ADPCM_8K 的 2:1 降取樣
+    std::atomic<uint8_t> streamTier;       // 目前套用的層級，擷取任務讀取
+    std::atomic<int8_t> streamTierRequest; // 控制命令指定的層級 (或 STREAM_TIER_REQUEST_*)
+
+    // 特徵輸出 (格式、編碼與特徵集見 config)
+    uint16_t featureSequence; // 僅特徵任務使用：下一幀的序號
+    MqttFeatureFrame featureBatch[FEATURE_FRAME_BATCH]; // 僅發布任務使用
+
+    // 發布訊息的序列化緩衝區 (二進位封包、JSON 與補發共用)，僅發布任務使用
+    uint8_t frameBuffer[AUDIO_BATCH_MAX_BYTES];
+
+    // 狀態訊息的序列化緩衝區 (MQTT 任務與發布任務都會發布狀態，持有 mqttMutex 時使用)
+    char statusBuffer[STATUS_FRAME_BYTES];
+
+    // 即時音訊的替代傳輸 (內建 UDP/RTP 與 WebSocket，其他 sink 以 addAudioSink 註冊)
+    AudioStreamManager rtpStream;
+    AudioWebSocketServer wsStream;
+    AudioSink *audioSinks[AUDIO_SINK_MAX];
+    uint8_t audioSinkCount;
+
+    // 斷線暫存區 (僅發布任務寫入與讀取)
+    AudioSpool spool;
+    ImaAdpcmCodec spoolEncoder;
+    bool spoolResyncPending; // 下一筆暫存音訊重新開始編碼並標記 AUDIO_WIRE_FLAG_RESYNC
+    uint8_t spoolBuffer[SPOOL_RECORD_MAX_BYTES];
+    uint32_t replayTokens;
+    uint32_t replayLastRefill;
 
     // 統計信息
     struct
     {
         uint32_t audioPacketsPublished;
+        uint32_t audioMessagesPublished;
+        uint32_t audioQueueDrops;
         uint32_t mfccPacketsPublished;
         uint32_t melPacketsPublished;
         uint32_t featurePacketsPublished;
+        uint32_t featureFramesPublished;   // 以緊湊格式發布的幀數
+        uint32_t featureMessagesPublished; // 緊湊格式訊息數
+        uint32_t featureQueueDrops;
         uint32_t reconnectCount;
+        uint32_t connectAttempts;
+        uint32_t connectFailures;
+        uint32_t lastConnectMs; // 最近一次成功連線耗時
         uint32_t publishErrors;
+        uint32_t featureFramesExtracted;
+        uint32_t featureDroppedSamples;
+        uint32_t adpcmPacketsEncoded;
+        uint64_t adpcmEncodeCycles;
+        uint32_t frameOverflows; // 序列化超出 frameBuffer 而丟棄的訊息
+        uint32_t spoolReplayedRecords;
+        uint32_t spoolReplayMessages;
+        uint32_t audioGaps;   // 標記 AUDIO_WIRE_FLAG_GAP 的音訊訊息
+        uint32_t featureGaps; // 標記 FEATURE_WIRE_FLAG_GAP 的特徵訊息
     } stats;
 
+    // 各類訊息從擷取 (音訊) 或提取 (特徵) 到發布完成的延遲
+    LatencyHistogram audioLatency;
+    LatencyHistogram featureLatency;
+    LatencyHistogram connectLatency; // 從開始嘗試 (含 DNS) 到 CONNACK
+
+    // 音訊管線各階段的延遲 (LATENCY_STAGE_*)；CAPTURE 由擷取任務寫入，其餘由發布任務寫入
+    LatencyHistogram stageLatency[LATENCY_STAGE_COUNT];
+    uint32_t frameSendMicros; // publishFrame 累計的寫入時間 (持有 mqttMutex 時讀寫)
+
+    // 發布速率 (publishStatus 兩次呼叫之間)
+    uint32_t rateWindowStart;
+    uint32_t rateWindowPackets;
+
     // 內部方法
     void mqttCallback(char *topic, byte *payload, unsigned int length);
-    bool reconnectMqtt();
-    bool publishAudioPacket(MqttAudioPacket *packet);
-    bool publishMfccPacket(MqttMfccPacket *packet);
-    bool publishMelPacket(MqttMelPacket *packet);
-    bool publishFeaturesPacket(MqttFeaturesPacket *packet);
-    void handleControlMessage(const char *message);
+    void serviceConnection();
+    bool startConnectAttempt();
+    bool startTcpConnect();
+    int pollTcpConnect();
+    bool completeMqttHandshake();
+    void failConnectAttempt(const char *reason);
+    void closeConnectSocket();
+    static void staticDnsStart(void *context);
+    static void staticDnsFound(const char *name, const ip_addr_t *address, void *context);
+    void finishDns(uint32_t attempt, const ip_addr_t *address);
+    uint8_t effectiveAudioFormats();
+    uint8_t effectiveAudioCodec();
+    void updateStreamQuality();
+    void applyStreamTier(uint8_t tier);
+    size_t audioPacketCost(const AudioBlock &block);
+    size_t collectAudioBatch(AudioBlock **batch);
+    bool publishAudioBatch(const AudioBlock *const *batch, size_t count);
+    bool publishAudioJson(const AudioBlock *const *batch, size_t count, bool gap);
+    bool publishAudioBinary(const AudioBlock *const *batch, size_t count, bool gap);
+    bool publishFrame(const char *topic, const uint8_t *data, size_t length);
+    bool featuresPending();
+    void publishAudioStep(AudioBlock **batch, size_t count);
+    void publishFeatureStep();
+    void spoolAudioBatch(const AudioBlock *const *batch, size_t count);
+    void spoolFeatureFrames(const MqttFeatureFrame *frames, size_t count);
+    void replayStep();
+    size_t collectFeatureBatch();
+    size_t encodeFeatureFrames(const MqttFeatureFrame *frames, size_t count, uint8_t flags, uint8_t *out,
+                               size_t capacity);
+    bool publishFeatureFrames(const MqttFeatureFrame *frames, size_t count, uint8_t flags);
+    bool publishMfccJson(const MqttFeatureFrame &frame);
+    bool publishMelJson(const MqttFeatureFrame &frame);
+    bool publishFeaturesJson(const MqttFeatureFrame &frame);
+    void handleControlMessage(const char *message, size_t length);
+    void handleConfigureCommand(const JsonFieldReader &reader, const char *command, int32_t id);
+    void commitConfigRequest(const StreamConfig &next, const StreamConfigAck &ack, bool persist);
+    bool applyRequestedConfig(StreamConfigAck *ack);
+    void applyConfig(const StreamConfig &next);
+    void publishConfigAck(const StreamConfigAck &ack, const char *invalidField);
+    bool persistConfig(const StreamConfig &source, uint16_t fields);
+    void loadPersistedConfig();
+    bool clearPersistedConfig();
+    static StreamConfig defaultConfig();
+    static StreamConfigLimits configLimits();
+    void pushFeatureBlock(AudioBlock *block);
+    void pushAudioBlock(AudioBlock *block);
+    uint64_t anchorSampleClock(uint64_t captureMicros, size_t length);
+    void onFeatureFrame(AudioFeatureExtractor *extractor);
 
     // 靜態任務函數
     static void mqttTask(void *parameter);
-    static void audioPublishTask(void *parameter);
-    static void featurePublishTask(void *parameter);
+    static void publisherTask(void *parameter);
+    static void featureExtractionTask(void *parameter);
 
     // 靜態回調函數
     static void staticMqttCallback(char *topic, byte *payload, unsigned int length);
+    static void staticFeatureFrameCallback(AudioFeatureExtractor *extractor, void *context);
 
 public:
     // 建構函數和解構函數
@@ -138,13 +413,15 @@ public:
                const char *clientId = "ESP32_Audio");
     void end();
 
-    // MQTT 連接控制
+    // MQTT 連接控制：連線由 MQTT 任務非同步建立，connect() 只要求立即嘗試並回傳目前是否已連線
     bool connect();
     void disconnect();
     bool isConnectedToMqtt() { return isConnected; }
 
     // 音訊發布控制
+    // 不需要等待連線：未連線時資料寫入斷線暫存區，MQTT 任務連上後補發；只在任務建立失敗時回傳 false
     bool startPublishing();
+    // 等待發布任務自行結束 (最多 TASK_EXIT_TIMEOUT_MS)；逾時回傳 false，之後可再呼叫
     bool stopPublishing();
     bool isPublishingActive() { return isPublishing; }
 
@@ -153,25 +430,79 @@ public:
     bool disableFeatureExtraction();
     bool isFeatureExtractionActive() { return isFeatureExtractionEnabled; }
 
-    // 音訊數據輸入
-    bool pushAudioData(int16_t *audioData, size_t length);
+    // 音訊數據輸入 (captureMicros 為 I2S 讀取完成時的 monotonicMicros()，0 表示以呼叫時間代替)
+    bool pushAudioData(int16_t *audioData, size_t length, uint64_t captureMicros = 0);
+
+    // 執行期串流設定：以 config 的 fields 欄位發出請求 (無效時回傳 false)，發布中於下一個幀邊界套用
+    bool requestConfig(const StreamConfig &next, uint16_t fields, bool persist = false);
+    const StreamConfig &getStreamConfig() { return config; }
 
-    // 配置方法
+    // 配置方法 (音訊批次延遲預算與特徵最長等待，ms)
     void setPublishIntervals(int audioInterval, int featureInterval);
     void setMqttKeepAlive(int keepAlive);
 
+    // 音訊輸出格式 (AUDIO_OUTPUT_JSON / AUDIO_OUTPUT_BINARY 的組合)
+    void setAudioOutputFormats(uint8_t formats);
+    uint8_t getAudioOutputFormats() { return config.audioFormats; }
+    void setAudioSampleRate(uint32_t sampleRate) { audioSampleRate = sampleRate; }
+
+    // 二進位封包編碼 (AUDIO_CODEC_PCM16 / AUDIO_CODEC_IMA_ADPCM)
+    void setAudioCodec(uint8_t codec);
+    uint8_t getAudioCodec() { return config.audioCodec; }
+    uint32_t getAdpcmCyclesPerPacket()
+    {
+        return stats.adpcmPacketsEncoded ? (uint32_t)(stats.adpcmEncodeCycles / stats.adpcmPacketsEncoded) : 0;
+    }
+
+    // 特徵輸出格式 (FEATURE_OUTPUT_JSON / FEATURE_OUTPUT_FRAME 的組合) 與緊湊幀數值編碼
+    void setFeatureOutputFormats(uint8_t formats);
+    uint8_t getFeatureOutputFormats() { return config.featureFormats; }
+    void setFeatureEncoding(uint8_t encoding);
+    uint8_t getFeatureEncoding() { return config.featureEncoding; }
+
+    // 自適應串流品質：tier 為 STREAM_TIER_*，或以 requestAdaptiveQuality() 恢復自動切換
+    void requestStreamTier(uint8_t tier);
+    void requestAdaptiveQuality();
+    uint8_t getStreamTier() { return streamTier; }
+
+    // 斷線暫存區：容量以 IMA-ADPCM 音訊秒數估計 (不含特徵)
+    float getSpoolCapacitySeconds();
+    float getSpoolBacklogSeconds() { return (float)spool.getBacklogSamples() / audioSampleRate; }
+    size_t getSpoolBacklogBytes() { return spool.getBacklogBytes(); }
+
+    // 即時音訊的替代傳輸：須在 startPublishing() 前註冊
+    bool addAudioSink(AudioSink *sink);
+    AudioStreamManager &getRtpStream() { return rtpStream; }
+    AudioWebSocketServer &getWebSocketStream() { return wsStream; }
+
     // 統計信息
     void getPublishStats(uint32_t *audioPackets, uint32_t *mfccPackets,
                          uint32_t *melPackets, uint32_t *featurePackets);
     uint32_t getReconnectCount() { return stats.reconnectCount; }
+    uint32_t getConnectAttempts() { return stats.connectAttempts; }
+    uint32_t getConnectFailures() { return stats.connectFailures; }
+    uint8_t getConnectionState() { return connectionState; }
     uint32_t getPublishErrors() { return stats.publishErrors; }
+    uint32_t getAudioQueueDrops() { return stats.audioQueueDrops; }
+    uint32_t getPublishHeapAllocs() { return HeapAllocCounter::getCount(); }
+    uint32_t getAudioRingHighWaterMark() { return audioRing.getHighWaterMark(); }
+    uint32_t getFeatureRingHighWaterMark() { return featureRing.getHighWaterMark(); }
+    uint32_t getBlockPoolInUse() { return blockPool.getInUse(); }
+    uint32_t getBlockPoolHighWaterMark() { return blockPool.getHighWaterMark(); }
+    uint32_t getBlockPoolExhausted() { return blockPool.getExhaustedCount(); }
+    uint32_t getFeatureDroppedHops() { return stats.featureDroppedSamples / config.hopSamples; }
+
+    // 延遲直方圖 (µs)：音訊端到端與各階段 (LATENCY_STAGE_*)
+    const LatencyHistogram &getAudioLatency() { return audioLatency; }
+    const LatencyHistogram &getStageLatency(uint8_t stage) { return stageLatency[stage < LATENCY_STAGE_COUNT ? stage : 0]; }
+    static const char *latencyStageName(uint8_t stage);
 
     // 狀態發布
     void publishStatus();
 
     // 工具方法
     void printStatus();
-    void loop(); // 需要在主循環中調用
+    void loop(); // 由 MQTT 任務每 10 ms 呼叫 (持有 mqttMutex)；其他任務不需要也不應呼叫
 };
 
 #endif // AUDIO_MQTT_MANAGER_H
@@ -0,0 +1,26 @@
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include "AudioBlockPool.h"
+
+// 即時音訊的替代傳輸 (UDP/RTP 等)；MQTT 仍負責控制、狀態與特徵
+// AudioMqttManager 在擷取任務中把每塊音訊交給所有已註冊的 sink，不經過發布任務與 TCP，
+// 因此 MQTT 壅塞或重連不會延遲這些傳輸
+class AudioSink
+{
+public:
+    virtual ~AudioSink() {}
+
+    // 擷取任務呼叫：送出一塊音訊。不可阻塞，也不可保留 block 的指標 (呼叫返回後塊可能被重新填寫)
+    // 來不及送出時直接丟棄並回傳 false
+    virtual bool writeBlock(const AudioBlock &block) = 0;
+
+    // 未啟用的 sink 不會收到 writeBlock / writeFeatures
+    virtual bool isActive() = 0;
+
+    // 發布任務呼叫：已編碼的緊湊特徵訊息 (FeatureWireFormat)，只有 wantsFeatures() 為 true 時才會編碼與呼叫
+    virtual bool wantsFeatures() { return false; }
+    virtual bool writeFeatures(const uint8_t *message, size_t length) { return false; }
+};
+
+#endif // AUDIO_SINK_H
@@ -0,0 +1,91 @@
+#ifndef AUDIO_SPOOL_H
+#define AUDIO_SPOOL_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// 斷線暫存區配置
+#define SPOOL_RAM_BYTES (2 * 1024 * 1024) // PSRAM 環形緩衝區
+#define SPOOL_FLASH_BYTES (1024 * 1024)   // LittleFS 溢出記錄檔上限 (另受檔案系統剩餘空間限制)
+#define SPOOL_FLASH_PATH "/spool.bin"
+#define SPOOL_RECORD_HEADER_SIZE 6        // kind、保留、長度 u16、樣本數 u16
+#define SPOOL_RECORD_MAX_BYTES 1024       // 單筆記錄負載上限
+
+// 記錄種類 (決定補發的主題)
+#define SPOOL_RECORD_AUDIO 1    // AudioWireFormat 封包
+#define SPOOL_RECORD_FEATURES 2 // FeatureWireFormat 訊息
+
+// 斷線期間的先進先出暫存：記錄先寫入 PSRAM 環形緩衝區，滿了之後寫入 LittleFS 記錄檔
+// 記錄檔有資料時新記錄一律接在記錄檔後面，讀取時先讀完 PSRAM 再讀記錄檔，整體維持寫入順序
+// 讀取以游標進行：read() 只移動游標，commitRead() 才真正移除，rollbackRead() 回到上次提交的位置
+// 不是執行緒安全的，寫入與讀取都應在同一個任務 (發布任務) 中進行；狀態查詢可在任一任務讀取近似值
+class AudioSpool
+{
+private:
+    // PSRAM 環形緩衝區 (位元組位置單調遞增，取模後為實際位置)
+    uint8_t *ram;
+    size_t ramCapacity;
+    size_t ramHead;   // 寫入位置
+    size_t ramTail;   // 已提交的讀取位置
+    size_t ramCursor; // 讀取游標
+
+    // LittleFS 記錄檔
+    bool flashReady;
+    File flashLog;
+    size_t flashCapacity;
+    size_t flashWriteOffset;
+    size_t flashReadOffset;   // 已提交的讀取位置
+    size_t flashCursor;       // 讀取游標
+
+    // 已提交的積壓 (讀取游標之前的記錄尚未扣除)
+    uint32_t backlogRecords;
+    uint32_t backlogSamples;
+    size_t backlogBytes;
+    uint32_t cursorRecords;
+    uint32_t cursorSamples;
+    size_t cursorBytes;
+
+    uint32_t droppedRecords;
+    uint32_t flashRecords; // 曾寫入記錄檔的記錄數
+
+    void ramWrite(size_t position, const uint8_t *data, size_t length);
+    void ramRead(size_t position, uint8_t *out, size_t length) const;
+    bool appendFlash(const uint8_t *header, const uint8_t *data, size_t length);
+    void resetFlash();
+
+public:
+    AudioSpool();
+    ~AudioSpool();
+
+    // 配置 PSRAM 並掛載 LittleFS (掛載失敗不格式化，只停用快閃記憶體層)；兩者皆不可用時回傳 false
+    bool begin(size_t ramBytes = SPOOL_RAM_BYTES, size_t flashBytes = SPOOL_FLASH_BYTES);
+    void end();
+    bool isReady() const { return ramCapacity > 0 || flashReady; }
+
+    // 附加一筆記錄；空間不足時丟棄並回傳 false
+    bool append(uint8_t kind, const uint8_t *data, size_t length, uint16_t samples);
+
+    // 從游標讀取下一筆記錄並前進；沒有記錄或 capacity 不足時回傳 0
+    size_t read(uint8_t *kind, uint8_t *out, size_t capacity);
+
+    // 游標處下一筆記錄的種類與負載長度 (不移動游標)；沒有記錄時回傳 0
+    size_t peek(uint8_t *kind);
+
+    void commitRead();
+    void rollbackRead();
+    void clear();
+
+    // ===== 狀態 =====
+
+    bool empty() const { return backlogRecords == 0; }
+    uint32_t getBacklogRecords() const { return backlogRecords; }
+    uint32_t getBacklogSamples() const { return backlogSamples; }
+    size_t getBacklogBytes() const { return backlogBytes; }
+    size_t getRamCapacity() const { return ramCapacity; }
+    size_t getFlashCapacity() const { return flashReady ? flashCapacity : 0; }
+    size_t getFlashUsed() const { return flashWriteOffset - flashReadOffset; }
+    uint32_t getDroppedRecords() const { return droppedRecords; }
+    uint32_t getFlashRecords() const { return flashRecords; }
+};
+
+#endif // AUDIO_SPOOL_H
@@ -0,0 +1,66 @@
+#ifndef AUDIO_STREAM_MANAGER_H
+#define AUDIO_STREAM_MANAGER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "AudioSink.h"
+#include "RtpWireFormat.h"
+
+// UDP/RTP 即時音訊串流配置
+#define RTP_DEFAULT_PORT 5004
+#define RTP_TARGET_TEXT_SIZE 16 // 點分十進位 IPv4 位址 (含結尾 0)
+#define RTP_MAX_PACKET_SIZE (RTP_HEADER_SIZE + AUDIO_BLOCK_SAMPLES * 2) // 524 位元組，遠小於 MTU
+
+// 以 RTP/UDP 資料報直接把音訊送到指定的接收端 (每塊一個資料報，L16 負載)
+// 沒有重傳也沒有隊列：遺失的資料報就此遺失，不會像 TCP 一樣阻塞後續封包
+// 目標由 MQTT 控制命令設定；writeBlock() 在擷取任務中執行，以非阻塞 sendto 送出，失敗即丟棄
+class AudioStreamManager : public AudioSink
+{
+private:
+    int socketFd;
+    std::atomic<bool> active;
+    std::atomic<bool> restartPending; // start() → 擷取任務：下一塊開始新的 RTP 串流
+    uint32_t targetAddress; // IPv4，網路位元組順序
+    uint16_t targetPort;
+
+    // 僅擷取任務使用
+    RtpPacketizer rtp; // 序號、時間戳與 M 位元
+    uint8_t packet[RTP_MAX_PACKET_SIZE];
+
+    struct
+    {
+        uint32_t packetsSent;
+        uint32_t bytesSent;
+        uint32_t sendErrors; // 網路堆疊拒絕 (緩衝區不足等) 而丟棄的資料報
+        uint32_t blockGaps;  // 裝置端遺失塊的次數 (以 M 位元標記)
+    } stats;
+
+public:
+    AudioStreamManager();
+    ~AudioStreamManager();
+
+    // 建立 UDP socket；成功後仍需 start() 才開始送出
+    bool begin();
+    void end();
+
+    // 開始送往 host (IPv4 位址字串) 的 port；新的 SSRC 與序號，第一個資料報帶 M 位元
+    bool start(const char *host, uint16_t port = RTP_DEFAULT_PORT);
+    void stop();
+
+    // AudioSink
+    bool writeBlock(const AudioBlock &block) override;
+    bool isActive() override { return active; }
+
+    // ===== 狀態 =====
+
+    // 目標位址寫入 out (至少 RTP_TARGET_TEXT_SIZE 位元組)，不配置記憶體
+    void getTarget(char *out, size_t size);
+    uint16_t getTargetPort() { return targetPort; }
+    uint32_t getSsrc() { return rtp.getSsrc(); }
+    uint32_t getPacketsSent() { return stats.packetsSent; }
+    uint32_t getBytesSent() { return stats.bytesSent; }
+    uint32_t getSendErrors() { return stats.sendErrors; }
+    uint32_t getBlockGaps() { return stats.blockGaps; }
+};
+
+#endif // AUDIO_STREAM_MANAGER_H
@@ -0,0 +1,57 @@
+#ifndef AUDIO_WEBSOCKET_SERVER_H
+#define AUDIO_WEBSOCKET_SERVER_H
+
+#include <Arduino.h>
+#include <WebSocketsServer.h>
+#include "AudioSink.h"
+#include "WebSocketStreamCore.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// 裝置端 WebSocket 串流伺服器配置
+#define WS_SERVER_PORT 81
+#define WS_TASK_STACK_SIZE 4096
+#define WS_TASK_PRIORITY 2
+#define WS_TASK_CORE 0
+#define WS_SEND_BUDGET 4       // 每輪每個客戶端最多送出的訊息數 (輪流送出，慢客戶端不會獨佔任務)
+#define WS_TASK_INTERVAL_MS 5  // 沒有待送訊息時的輪詢間隔
+
+// 讓本地儀表板不經過 MQTT 服務器直接接收二進位音訊與特徵
+// 連線路徑決定訂閱 (見 WebSocketStreamCore.h)：ws://<裝置>:81/pcm、/adpcm、/features，可用 + 組合
+// 每則 WebSocket 二進位訊息即一個 AudioWireFormat 封包 (magic 0xA5) 或一則 FeatureWireFormat 訊息 (magic 0xA6)
+// 擷取任務與發布任務只把訊息放入各客戶端的隊列 (已滿時丟棄最舊的)，由獨立的 WebSocket 任務送出，
+// 因此慢客戶端只會遺失自己的訊息，不會延遲擷取或其他傳輸
+class AudioWebSocketServer : public AudioSink
+{
+private:
+    WebSocketsServer server;
+    WebSocketStreamCore core;
+    TaskHandle_t taskHandle;
+    uint16_t port;
+    volatile bool running;
+    uint32_t sampleRate;
+    uint8_t sendBuffer[WS_STREAM_SLOT_BYTES]; // 僅 WebSocket 任務使用
+
+    void onEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length);
+    static void serverTask(void *parameter);
+
+public:
+    AudioWebSocketServer(uint16_t port = WS_SERVER_PORT);
+    ~AudioWebSocketServer();
+
+    bool begin(uint32_t sampleRate);
+    void end();
+
+    // AudioSink (沒有客戶端時不編碼)
+    bool writeBlock(const AudioBlock &block) override;
+    bool isActive() override { return running && core.getClientCount() > 0; }
+    bool wantsFeatures() override { return core.wantsFeatures(); }
+    bool writeFeatures(const uint8_t *message, size_t length) override;
+
+    // ===== 狀態 =====
+
+    uint8_t getClientCount() { return core.getClientCount(); }
+    WebSocketStreamCore &getCore() { return core; }
+};
+
+#endif // AUDIO_WEBSOCKET_SERVER_H
@@ -0,0 +1,89 @@
+#ifndef AUDIO_WIRE_FORMAT_H
+#define AUDIO_WIRE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ImaAdpcm.h"
+
+// 音訊二進位封包格式 (MQTT_TOPIC_AUDIO_BINARY)
+// 固定 28 位元組標頭 + 音訊負載，所有欄位皆為 little-endian，逐位元組讀寫，與主機位元組序無關
+//
+//   偏移  大小  欄位
+//   0     1     magic (0xA5)
+//   1     1     version
+//   2     1     codec (AUDIO_CODEC_*)
+//   3     1     flags (AUDIO_WIRE_FLAG_*)
+//   4     2     sequence       封包序號
+//   6     2     sampleCount    本包樣本數
+//   8     4     sampleRate     取樣率 (Hz)
+//   12    8     samplePosition 第一個樣本在串流樣本時鐘上的位置 (以本包取樣率計，串流開始為 0)
+//   20    8     epochMicros    樣本位置 0 的 Unix 時間 (µs)；0 表示裝置尚未校時
+//   28    ...   負載：PCM16 為 sampleCount 個 int16 little-endian 樣本
+//                 IMA-ADPCM 為 4 位元組起始狀態 (predictor int16、stepIndex uint8、保留 1) + (sampleCount+1)/2 位元組
+//
+// 第一個樣本的時間 = epochMicros + samplePosition · 10^6 / sampleRate，由樣本時鐘推得，不受傳輸抖動影響；
+// 下一包的 samplePosition 應為本包 + sampleCount，跳躍的部分即遺失的樣本 (同時設定 AUDIO_WIRE_FLAG_GAP)
+//
+// 只依賴標準 C++，裝置端與主機端解碼共用
+
+#define AUDIO_WIRE_MAGIC 0xA5
+#define AUDIO_WIRE_VERSION 2 // 版本 1 為 16 位元組標頭與 32 位元 ms 時間戳
+#define AUDIO_WIRE_HEADER_SIZE 28
+
+// 編碼格式
+#define AUDIO_CODEC_PCM16 0
+#define AUDIO_CODEC_IMA_ADPCM 1
+
+// 標頭旗標
+#define AUDIO_WIRE_FLAG_RESYNC 0x01 // 與前一封包不連續 (重新連線、切換編碼)，接收端應重置序號追蹤與播放緩衝
+#define AUDIO_WIRE_FLAG_REPLAY 0x02 // 斷線期間暫存、重新連線後補發的封包 (與即時封包交錯到達)
+#define AUDIO_WIRE_FLAG_GAP 0x04    // 此包之前有樣本未在本串流送出 (samplePosition 跳躍)，接收端可補靜音或等待補發
+
+#define AUDIO_WIRE_ADPCM_STATE_SIZE 4
+
+struct AudioWireHeader
+{
+    uint8_t version;
+    uint8_t codec;
+    uint8_t flags;
+    uint16_t sequence;
+    uint16_t sampleCount;
+    uint32_t sampleRate;
+    uint64_t samplePosition;
+    uint64_t epochMicros;
+};
+
+class AudioWireFormat
+{
+public:
+    // PCM16 封包總長度
+    static size_t pcmPacketSize(uint16_t sampleCount) { return AUDIO_WIRE_HEADER_SIZE + (size_t)sampleCount * 2; }
+
+    // 寫入標頭 (magic/version 由此填入)；空間不足回傳 0，否則回傳 AUDIO_WIRE_HEADER_SIZE
+    static size_t writeHeader(const AudioWireHeader &header, uint8_t *out, size_t capacity);
+
+    // 編碼完整 PCM16 封包 (header.codec 會設為 AUDIO_CODEC_PCM16)；空間不足回傳 0，否則回傳封包長度
+    static size_t encodePcm(const AudioWireHeader &header, const int16_t *samples, uint8_t *out, size_t capacity);
+
+    // IMA-ADPCM 封包總長度
+    static size_t adpcmPacketSize(uint16_t sampleCount)
+    {
+        return AUDIO_WIRE_HEADER_SIZE + AUDIO_WIRE_ADPCM_STATE_SIZE + ImaAdpcmCodec::encodedSize(sampleCount);
+    }
+
+    // 以 encoder 的延續狀態編碼 IMA-ADPCM 封包 (header.codec 會設為 AUDIO_CODEC_IMA_ADPCM)
+    // 負載前先寫入編碼前的狀態；空間不足回傳 0 且不改變 encoder
+    static size_t encodeAdpcm(const AudioWireHeader &header, const int16_t *samples, ImaAdpcmCodec &encoder,
+                              uint8_t *out, size_t capacity);
+
+    // 解析並驗證標頭 (magic、版本、長度)
+    static bool readHeader(const uint8_t *data, size_t length, AudioWireHeader *header);
+
+    // 解碼 PCM16 封包的樣本；格式錯誤或 maxSamples 不足回傳 -1，否則回傳樣本數
+    static int decodePcm(const uint8_t *data, size_t length, int16_t *samples, size_t maxSamples);
+
+    // 解碼 IMA-ADPCM 封包：decoder 先載入封包內的起始狀態，因此遺失封包後也能從下一包重新同步
+    static int decodeAdpcm(const uint8_t *data, size_t length, int16_t *samples, size_t maxSamples, ImaAdpcmCodec &decoder);
+};
+
+#endif // AUDIO_WIRE_FORMAT_H
@@ -0,0 +1,271 @@
+#ifndef FEATURE_TABLES_H
+#define FEATURE_TABLES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 編譯期查表產生器：視窗、DCT、實數 FFT 旋轉因子與稀疏梅爾濾波器
+// 只依賴標準 C++ (C++17)，可在主機端直接編譯驗證
+
+// 編譯期數學函數 (泰勒/反雙曲正切級數，雙精度誤差約 1e-15)
+namespace cxmath
+{
+    constexpr double PI_D = 3.14159265358979323846;
+    constexpr double LN2_D = 0.69314718055994530942;
+    constexpr double LN10_D = 2.30258509299404568402;
+
+    // 將角度約化到 [-π, π]
+    constexpr double reduceAngle(double x)
+    {
+        const double twoPi = 2.0 * PI_D;
+        long long turns = (long long)(x / twoPi);
+        x -= (double)turns * twoPi;
+        if (x > PI_D)
+            x -= twoPi;
+        if (x < -PI_D)
+            x += twoPi;
+        return x;
+    }
+
+    constexpr double sin(double x)
+    {
+        x = reduceAngle(x);
+        double term = x;
+        double sum = x;
+        for (int n = 1; n < 20; n++)
+        {
+            term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double cos(double x)
+    {
+        x = reduceAngle(x);
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n < 20; n++)
+        {
+            term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double sqrt(double x)
+    {
+        if (x <= 0.0)
+            return 0.0;
+        double guess = x > 1.0 ? x : 1.0;
+        for (int i = 0; i < 100; i++)
+        {
+            double next = 0.5 * (guess + x / guess);
+            if (next == guess)
+                break;
+            guess = next;
+        }
+        return guess;
+    }
+
+    // ln(x) = e·ln2 + 2·atanh((m-1)/(m+1))，m ∈ [1, 2)
+    constexpr double log(double x)
+    {
+        if (x <= 0.0)
+            return -1e300;
+        int exponent = 0;
+        while (x >= 2.0)
+        {
+            x *= 0.5;
+            exponent++;
+        }
+        while (x < 1.0)
+        {
+            x *= 2.0;
+            exponent--;
+        }
+        double z = (x - 1.0) / (x + 1.0);
+        double z2 = z * z;
+        double term = z;
+        double sum = 0.0;
+        for (int k = 0; k < 30; k++)
+        {
+            sum += term / (2.0 * k + 1.0);
+            term *= z2;
+        }
+        return exponent * LN2_D + 2.0 * sum;
+    }
+
+    // exp(x) = 2^k · exp(r)，|r| ≤ ln2/2
+    constexpr double exp(double x)
+    {
+        double kf = x / LN2_D;
+        long long k = (long long)(kf >= 0.0 ? kf + 0.5 : kf - 0.5);
+        double r = x - (double)k * LN2_D;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n < 25; n++)
+        {
+            term *= r / n;
+            sum += term;
+        }
+        for (; k > 0; k--)
+            sum *= 2.0;
+        for (; k < 0; k++)
+            sum *= 0.5;
+        return sum;
+    }
+
+    constexpr double log10(double x) { return log(x) / LN10_D; }
+    constexpr double pow10(double x) { return exp(x * LN10_D); }
+}
+
+// 固定大小查表 (可在 constexpr 函數中逐項填值)
+template <typename T, size_t N>
+struct FeatureTable
+{
+    T v[N];
+
+    constexpr const T &operator[](size_t i) const { return v[i]; }
+    constexpr const T *data() const { return v; }
+};
+
+// 稀疏梅爾濾波器：只記錄非零區間的起始頻點與權重位置
+struct MelFilterRange
+{
+    uint16_t startBin;     // 第一個非零頻點
+    uint16_t length;       // 非零頻點數
+    uint16_t weightOffset; // 在權重池中的起始索引
+};
+
+// 三角濾波器相鄰重疊，每個頻點最多落在兩個濾波器的非零區
+template <typename T, uint8_t MelBanks, uint16_t FftSize>
+struct MelFilterBank
+{
+    static constexpr uint16_t WEIGHT_CAPACITY = 2 * (FftSize / 2 + 1);
+
+    MelFilterRange ranges[MelBanks];
+    T weights[WEIGHT_CAPACITY];
+    uint16_t weightCount;
+};
+
+// 漢明視窗並合併 int16 → [-1, 1] 的正規化比例
+template <typename T, uint16_t FrameSize>
+constexpr FeatureTable<T, FrameSize> makeHammingWindow()
+{
+    FeatureTable<T, FrameSize> table{};
+    for (int i = 0; i < FrameSize; i++)
+    {
+        double w = 0.54 - 0.46 * cxmath::cos(2.0 * cxmath::PI_D * i / (FrameSize - 1));
+        table.v[i] = (T)(w / 32768.0);
+    }
+    return table;
+}
+
+// DCT-II 基底 (row-major [MfccCoeffs][MelBanks])：c0 乘 sqrt(1/M)，其餘乘 sqrt(2/M)
+template <typename T, uint8_t MfccCoeffs, uint8_t MelBanks>
+constexpr FeatureTable<T, MfccCoeffs * MelBanks> makeDctTable()
+{
+    FeatureTable<T, MfccCoeffs * MelBanks> table{};
+    for (int i = 0; i < MfccCoeffs; i++)
+    {
+        double scale = cxmath::sqrt((i == 0 ? 1.0 : 2.0) / MelBanks);
+        for (int j = 0; j < MelBanks; j++)
+        {
+            table.v[i * MelBanks + j] = (T)(scale * cxmath::cos(cxmath::PI_D * i * (j + 0.5) / MelBanks));
+        }
+    }
+    return table;
+}
+
+// 實數 FFT 展開用旋轉因子：k 與 FftSize/2-k 成對處理，只需前四分之一週期
+template <typename T, uint16_t FftSize>
+constexpr FeatureTable<T, FftSize / 4 + 1> makeTwiddleCos()
+{
+    FeatureTable<T, FftSize / 4 + 1> table{};
+    for (int k = 0; k <= FftSize / 4; k++)
+    {
+        table.v[k] = (T)cxmath::cos(2.0 * cxmath::PI_D * k / FftSize);
+    }
+    return table;
+}
+
+template <typename T, uint16_t FftSize>
+constexpr FeatureTable<T, FftSize / 4 + 1> makeTwiddleSin()
+{
+    FeatureTable<T, FftSize / 4 + 1> table{};
+    for (int k = 0; k <= FftSize / 4; k++)
+    {
+        table.v[k] = (T)cxmath::sin(2.0 * cxmath::PI_D * k / FftSize);
+    }
+    return table;
+}
+
+constexpr double melScale(double freq)
+{
+    return 2595.0 * cxmath::log10(1.0 + freq / 700.0);
+}
+
+constexpr double invMelScale(double mel)
+{
+    return 700.0 * (cxmath::pow10(mel / 2595.0) - 1.0);
+}
+
+// 在 0 ~ SampleRate/2 間以梅爾刻度等距放置三角形濾波器，只保存非零區間
+template <typename T, uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks>
+constexpr MelFilterBank<T, MelBanks, FftSize> makeMelFilterBank()
+{
+    MelFilterBank<T, MelBanks, FftSize> bank{};
+
+    double lowMel = melScale(0.0);
+    double highMel = melScale(SampleRate / 2.0);
+
+    double freqPoints[MelBanks + 2] = {};
+    for (int i = 0; i < MelBanks + 2; i++)
+    {
+        freqPoints[i] = invMelScale(lowMel + (highMel - lowMel) * i / (MelBanks + 1));
+    }
+
+    for (int m = 0; m < MelBanks; m++)
+    {
+        double leftFreq = freqPoints[m];
+        double centerFreq = freqPoints[m + 1];
+        double rightFreq = freqPoints[m + 2];
+
+        MelFilterRange &range = bank.ranges[m];
+        range.startBin = 0;
+        range.length = 0;
+        range.weightOffset = bank.weightCount;
+
+        for (int k = 0; k <= FftSize / 2; k++)
+        {
+            double freq = k * (double)SampleRate / FftSize;
+            double weight = 0.0;
+
+            if (freq >= leftFreq && freq <= centerFreq)
+            {
+                weight = (freq - leftFreq) / (centerFreq - leftFreq);
+            }
+            else if (freq >= centerFreq && freq <= rightFreq)
+            {
+                weight = (rightFreq - freq) / (rightFreq - centerFreq);
+            }
+
+            if (weight <= 0.0 || bank.weightCount >= bank.WEIGHT_CAPACITY)
+            {
+                continue;
+            }
+
+            if (range.length == 0)
+            {
+                range.startBin = k;
+            }
+            bank.weights[bank.weightCount++] = (T)weight;
+            range.length++;
+        }
+    }
+
+    return bank;
+}
+
+#endif // FEATURE_TABLES_H
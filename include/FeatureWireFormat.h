@@ -0,0 +1,106 @@
+#ifndef FEATURE_WIRE_FORMAT_H
+#define FEATURE_WIRE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 特徵幀二進位封包格式 (MQTT_TOPIC_FEATURE_FRAME)
+// 一則訊息含一個標頭與 frameCount 個連續幀，每幀依序為 MFCC、梅爾能量、頻譜統計，所有欄位皆為 little-endian
+//
+//   偏移  大小  欄位
+//   0     1     magic (0xA6)
+//   1     1     version
+//   2     1     encoding (FEATURE_ENCODING_*)
+//   3     1     frameCount 本訊息幀數
+//   4     1     mfccCount   (0 表示未選取，見 FEATURE_SET_*)
+//   5     1     melCount    (同上)
+//   6     1     statCount   (FEATURE_WIRE_STAT_COUNT，或 0)
+//   7     1     flags (FEATURE_WIRE_FLAG_*)
+//   8     2     sequence    第一幀的幀序號 (後續幀依序 +1)
+//   10    2     hopSamples  幀距 (樣本)，第 i 幀的位置 = samplePosition + i · hopSamples
+//   12    4     sampleRate  取樣率 (Hz)
+//   16    8     samplePosition 第一幀第一個樣本在串流樣本時鐘上的位置 (與音訊封包同一時鐘)
+//   24    8     epochMicros 樣本位置 0 的 Unix 時間 (µs)；0 表示裝置尚未校時
+//   32    1     mfccQ       int16 編碼時 MFCC 的小數位元數：值 = int16 / 2^mfccQ
+//   33    1     melQ        梅爾能量的小數位元數
+//   34    6     statQ[6]    各頻譜統計的小數位元數
+//   40    ...   frameCount × (mfccCount + melCount + statCount) 個 16 位元值
+//                 int16 依上述 Q 值縮放 (飽和)；float16 為 IEEE 754 半精度，不使用 Q 值
+//
+// 頻譜統計順序：centroid (Hz)、bandwidth (Hz)、rolloff (Hz)、flatness、zeroCrossingRate、rmsEnergy
+// 只依賴標準 C++，裝置端與主機端解碼共用
+
+#define FEATURE_WIRE_MAGIC 0xA6
+#define FEATURE_WIRE_VERSION 2 // 版本 1 為 28 位元組標頭與 32 位元 ms 時間戳
+#define FEATURE_WIRE_HEADER_SIZE 40
+#define FEATURE_WIRE_STAT_COUNT 6
+
+// 標頭旗標
+#define FEATURE_WIRE_FLAG_REPLAY 0x01 // 斷線期間暫存、重新連線後補發的訊息
+#define FEATURE_WIRE_FLAG_GAP 0x02    // 此訊息之前有幀未在本串流送出 (samplePosition 跳躍)
+
+// 數值編碼
+#define FEATURE_ENCODING_INT16 0
+#define FEATURE_ENCODING_FLOAT16 1
+
+// int16 編碼的預設小數位元數 (依各特徵的值域選擇)
+#define FEATURE_MFCC_Q 7       // ±256，解析度 0.008
+#define FEATURE_MEL_Q 10       // ±32 (對數能量)，解析度 0.001
+#define FEATURE_HZ_Q 1         // ±16384 Hz，解析度 0.5 Hz
+#define FEATURE_UNIT_Q 14      // ±2 (flatness、過零率、RMS)，解析度 6e-5
+
+struct FeatureWireHeader
+{
+    uint8_t version;
+    uint8_t encoding;
+    uint8_t frameCount;
+    uint8_t mfccCount;
+    uint8_t melCount;
+    uint8_t statCount;
+    uint8_t flags;
+    uint16_t sequence;
+    uint16_t hopSamples;
+    uint32_t sampleRate;
+    uint64_t samplePosition;
+    uint64_t epochMicros;
+    int8_t mfccQ;
+    int8_t melQ;
+    int8_t statQ[FEATURE_WIRE_STAT_COUNT];
+};
+
+class FeatureWireFormat
+{
+public:
+    // 以預設 Q 值初始化標頭 (frameCount、sequence、samplePosition、epochMicros 由呼叫端填寫)
+    static void initHeader(FeatureWireHeader &header, uint8_t encoding, uint8_t mfccCount, uint8_t melCount,
+                           uint16_t hopSamples, uint32_t sampleRate);
+
+    // 單幀位元組數與整則訊息長度
+    static size_t frameSize(const FeatureWireHeader &header)
+    {
+        return ((size_t)header.mfccCount + header.melCount + header.statCount) * 2;
+    }
+    static size_t packetSize(const FeatureWireHeader &header)
+    {
+        return FEATURE_WIRE_HEADER_SIZE + (size_t)header.frameCount * frameSize(header);
+    }
+
+    // 寫入標頭；空間不足回傳 0，否則回傳 FEATURE_WIRE_HEADER_SIZE
+    static size_t writeHeader(const FeatureWireHeader &header, uint8_t *out, size_t capacity);
+
+    // 依標頭的編碼寫入一幀；stats 依上述順序共 statCount 個；空間不足回傳 0，否則回傳 frameSize
+    static size_t writeFrame(const FeatureWireHeader &header, const float *mfcc, const float *mel, const float *stats,
+                             uint8_t *out, size_t capacity);
+
+    // 解析並驗證標頭 (magic、版本、長度)
+    static bool readHeader(const uint8_t *data, size_t length, FeatureWireHeader *header);
+
+    // 解碼第 index 幀的所有值 (mfccCount + melCount + statCount 個，順序同上)；格式錯誤回傳 false
+    static bool readFrame(const uint8_t *data, size_t length, uint8_t index, float *values, size_t maxValues);
+
+    // 半精度浮點轉換 (四捨五入到最接近的偶數，超出範圍飽和為無限大)
+    static uint16_t floatToHalf(float value);
+    static float halfToFloat(uint16_t half);
+};
+
+#endif // FEATURE_WIRE_FORMAT_H
@@ -0,0 +1,236 @@
+#ifndef FIXED_POINT_MFCC_H
+#define FIXED_POINT_MFCC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FeatureTables.h"
+
+// 整數 MFCC 引擎：Q15 樣本/視窗/旋轉因子/梅爾權重/DCT 係數，32 位元 FFT 資料，Q16 對數與 MFCC 輸出
+// 流程：區塊浮點正規化 + 漢明視窗 → 實數打包 FFT_SIZE/2 點 FFT (int32 資料、Q15 旋轉因子、每級右移 1)
+//       → 功率譜 (uint64) → 稀疏梅爾濾波 (uint64 累加) → 查表內插 log2 → DCT-II (int64 累加)
+// computeReference() 是逐項的可攜參考實作，compute() 是最佳化實作 (位元反轉併入加窗、前兩級無乘法、
+// 旋轉因子外提、特例頻點剝離)；兩者每個捨入點相同，輸出逐位元一致，可用 verifyBitExact() 比對
+// 只依賴標準 C++，主機端可直接編譯，與雙精度參考實作比較誤差 (test/test_fixed_point_mfcc.cpp)
+//
+// 與雙精度參考 (直接 DFT) 的最大絕對偏差，主機端實測 (預設設定檔 / 低成本設定檔)：
+//   滿刻度 0.49 fs 正弦：MFCC 0.144 / 0.113，對數梅爾 0.204 / 0.228
+//   滿刻度 100 Hz 正弦：MFCC 0.089 / 0.015，對數梅爾 0.054 / 0.017；440 Hz：MFCC 0.015 / 0.006
+//   雜訊、-20 dB 以下的正弦與靜音：MFCC < 0.006，對數梅爾 < 0.006
+// 主要來源是 Q15 視窗與旋轉因子的量化雜訊，落在高動態範圍幀 (單頻、無雜訊) 中能量很低的梅爾頻帶
+//
+// 數值約定 (N = FFT_SIZE，e = getFrameExponent())：
+//   加窗後 x = x_float · 2^e，e = 36 - msb(幀峰值)，使 |x| < 2^22 (區塊浮點 + 8 位保護位元)
+//   FFT 每級 /2 (四捨五入)、展開時再 /2：X_fixed = X_float · 2^e / N，分量 < 2^22.5 不會溢位
+//   梅爾能量 E_int = E_float · 2^(2e + 15) / N²；由 Parseval 定理 E_int < 2^60，uint64 不會溢位
+//   功率譜與浮點路徑相同，每頻點以 1e-10 (換算到本幀尺度) 為下限，靜音幀的對數能量一致
+// 16 位元資料的 FFT 每級捨入雜訊約為 1 LSB，高動態範圍的幀 (單頻 + 低雜訊) 低能量梅爾頻帶誤差可達 0.2，故資料取 32 位元
+
+// Q 格式常數
+#define Q15_ONE 32768
+#define Q16_ONE 65536
+#define Q16_LN2 45426           // ln(2) · 2^16
+#define FIXED_LOG2_TABLE_BITS 6 // log2 查表 64 段線性內插 (誤差約 3e-5)
+#define FIXED_MIN_EXPONENT 21   // 幀峰值 2^15 時的區塊指數
+#define FIXED_MAX_EXPONENT 36   // 幀峰值 ≤ 1 時的區塊指數
+#define FIXED_POWER_FLOOR 1e-10 // 與浮點路徑相同的功率下限
+
+// log2(1 + i/64) 的 Q16 查表
+constexpr FeatureTable<int32_t, (1 << FIXED_LOG2_TABLE_BITS) + 1> makeLog2TableQ16()
+{
+    FeatureTable<int32_t, (1 << FIXED_LOG2_TABLE_BITS) + 1> table{};
+    for (int i = 0; i <= (1 << FIXED_LOG2_TABLE_BITS); i++)
+    {
+        double value = cxmath::log(1.0 + (double)i / (1 << FIXED_LOG2_TABLE_BITS)) / cxmath::LN2_D;
+        table.v[i] = (int32_t)(value * Q16_ONE + 0.5);
+    }
+    return table;
+}
+
+// 各區塊指數 e 下的功率下限：FIXED_POWER_FLOOR · 2^(2e) / FftSize²
+template <uint16_t FftSize>
+constexpr FeatureTable<uint64_t, FIXED_MAX_EXPONENT - FIXED_MIN_EXPONENT + 1> makePowerFloorTable()
+{
+    FeatureTable<uint64_t, FIXED_MAX_EXPONENT - FIXED_MIN_EXPONENT + 1> table{};
+    for (int e = FIXED_MIN_EXPONENT; e <= FIXED_MAX_EXPONENT; e++)
+    {
+        double floor = FIXED_POWER_FLOOR / ((double)FftSize * FftSize);
+        for (int i = 0; i < 2 * e; i++)
+        {
+            floor *= 2.0;
+        }
+        table.v[e - FIXED_MIN_EXPONENT] = (uint64_t)(floor + 0.5);
+    }
+    return table;
+}
+
+// 將 [-1, 1] 的值量化為 Q15 (四捨五入並飽和，1.0 → 32767)
+constexpr int16_t toQ15(double value)
+{
+    double v = value * Q15_ONE;
+    v = v >= 0 ? v + 0.5 : v - 0.5;
+    if (v > 32767.0)
+        v = 32767.0;
+    if (v < -32768.0)
+        v = -32768.0;
+    return (int16_t)v;
+}
+
+template <size_t N>
+constexpr FeatureTable<int16_t, N> quantizeQ15(const FeatureTable<double, N> &source, double scale = 1.0)
+{
+    FeatureTable<int16_t, N> table{};
+    for (size_t i = 0; i < N; i++)
+    {
+        table.v[i] = toQ15(source.v[i] * scale);
+    }
+    return table;
+}
+
+// 梅爾濾波器組的權重量化為 Q15，區間不變
+template <uint8_t MelBanks, uint16_t FftSize>
+constexpr MelFilterBank<int16_t, MelBanks, FftSize> quantizeMelBankQ15(const MelFilterBank<double, MelBanks, FftSize> &source)
+{
+    MelFilterBank<int16_t, MelBanks, FftSize> bank{};
+    for (int m = 0; m < MelBanks; m++)
+    {
+        bank.ranges[m] = source.ranges[m];
+    }
+    for (int i = 0; i < source.weightCount; i++)
+    {
+        bank.weights[i] = toQ15(source.weights[i]);
+    }
+    bank.weightCount = source.weightCount;
+    return bank;
+}
+
+// Points 點複數 FFT 的旋轉因子 (半週期)：cos/sin(2πk/Points)，k < Points/2
+template <uint16_t Points>
+constexpr FeatureTable<int16_t, Points / 2> makeFftCosQ15()
+{
+    FeatureTable<int16_t, Points / 2> table{};
+    for (int k = 0; k < Points / 2; k++)
+    {
+        table.v[k] = toQ15(cxmath::cos(2.0 * cxmath::PI_D * k / Points));
+    }
+    return table;
+}
+
+template <uint16_t Points>
+constexpr FeatureTable<int16_t, Points / 2> makeFftSinQ15()
+{
+    FeatureTable<int16_t, Points / 2> table{};
+    for (int k = 0; k < Points / 2; k++)
+    {
+        table.v[k] = toQ15(cxmath::sin(2.0 * cxmath::PI_D * k / Points));
+    }
+    return table;
+}
+
+// 位元反轉索引
+template <uint16_t Points>
+constexpr FeatureTable<uint16_t, Points> makeBitReverseTable()
+{
+    FeatureTable<uint16_t, Points> table{};
+    int bits = 0;
+    while ((1 << bits) < Points)
+    {
+        bits++;
+    }
+    for (int i = 0; i < Points; i++)
+    {
+        int reversed = 0;
+        for (int b = 0; b < bits; b++)
+        {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        table.v[i] = (uint16_t)reversed;
+    }
+    return table;
+}
+
+template <uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks, uint8_t MfccCoeffs, uint16_t FrameSize>
+class FixedPointMfccT
+{
+public:
+    static constexpr uint16_t FFT_SIZE = FftSize;
+    static constexpr uint16_t HALF_SIZE = FftSize / 2;
+    static constexpr uint16_t SPECTRUM_BINS = FftSize / 2 + 1;
+
+    static constexpr int log2Of(uint32_t n) { return n <= 1 ? 0 : 1 + log2Of(n / 2); }
+    static constexpr int LOG2_FFT_SIZE = log2Of(FftSize);
+
+    // E_int 相對 E_float 的 log2 偏移 (不含 2e)
+    static constexpr int BASE_LOG2_OFFSET = 15 - 2 * LOG2_FFT_SIZE;
+
+    static_assert((FftSize & (FftSize - 1)) == 0 && FftSize >= 16, "FFT_SIZE 必須是 2 的冪次");
+    static_assert(FrameSize <= FftSize && FrameSize % 2 == 0, "FRAME_SIZE 必須為偶數且不大於 FFT_SIZE");
+
+private:
+    // 編譯期 Q15 查表
+    static constexpr FeatureTable<int16_t, FrameSize> windowTable =
+        quantizeQ15(makeHammingWindow<double, FrameSize>(), 32768.0); // 去掉浮點表內含的 1/32768
+    static constexpr FeatureTable<int16_t, FftSize / 4> fftCos = makeFftCosQ15<FftSize / 2>();
+    static constexpr FeatureTable<int16_t, FftSize / 4> fftSin = makeFftSinQ15<FftSize / 2>();
+    static constexpr FeatureTable<uint16_t, FftSize / 2> bitReverse = makeBitReverseTable<FftSize / 2>();
+    static constexpr FeatureTable<int16_t, FftSize / 4 + 1> unpackCos =
+        quantizeQ15(makeTwiddleCos<double, FftSize>());
+    static constexpr FeatureTable<int16_t, FftSize / 4 + 1> unpackSin =
+        quantizeQ15(makeTwiddleSin<double, FftSize>());
+    static constexpr FeatureTable<int16_t, MfccCoeffs * MelBanks> dctTable =
+        quantizeQ15(makeDctTable<double, MfccCoeffs, MelBanks>());
+    static constexpr MelFilterBank<int16_t, MelBanks, FftSize> melBank =
+        quantizeMelBankQ15(makeMelFilterBank<double, SampleRate, FftSize, MelBanks>());
+    static constexpr FeatureTable<int32_t, (1 << FIXED_LOG2_TABLE_BITS) + 1> log2Table = makeLog2TableQ16();
+    static constexpr FeatureTable<uint64_t, FIXED_MAX_EXPONENT - FIXED_MIN_EXPONENT + 1> powerFloorTable =
+        makePowerFloorTable<FftSize>();
+
+    // 工作緩衝區
+    int32_t fftRe[HALF_SIZE];
+    int32_t fftIm[HALF_SIZE];
+    uint64_t power[SPECTRUM_BINS];
+    int32_t logMelQ16[MelBanks];
+    int32_t mfccQ16[MfccCoeffs];
+    int frameExponent;
+    uint64_t powerFloor;
+
+    // 參考實作
+    void windowReference(const int16_t *frame);
+    void fftReference();
+    void unpackPowerReference();
+    void melLogReference();
+    void dctReference();
+
+    // 最佳化實作
+    void windowOptimized(const int16_t *frame);
+    void fftOptimized();
+    void unpackPowerOptimized();
+    void melLogOptimized();
+    void dctOptimized();
+
+    static int selectExponent(const int16_t *frame);
+    static int32_t scaleSample(int32_t product, int exponent);
+    static int32_t log2Q16(uint64_t value);
+    int32_t toNaturalLogQ16(uint64_t energy) const;
+
+public:
+    FixedPointMfccT();
+
+    // 輸入為 FrameSize 個時間順序的 int16 樣本
+    void computeReference(const int16_t *frame);
+    void compute(const int16_t *frame);
+
+    // 結果 (Q16：值 / 65536 即浮點路徑的 ln 梅爾能量與 MFCC)
+    const int32_t *getMfccQ16() const { return mfccQ16; }
+    const int32_t *getLogMelQ16() const { return logMelQ16; }
+    const uint64_t *getPowerSpectrum() const { return power; }
+    int getFrameExponent() const { return frameExponent; }
+    uint16_t getMelWeightCount() const { return melBank.weightCount; }
+
+    // power[k] · getPowerScale() = 浮點路徑的 |X[k]|²
+    double getPowerScale() const;
+
+    // 以兩種實作處理同一幀並逐位元比較功率譜、對數梅爾能量與 MFCC；結果保留最佳化實作的輸出
+    bool verifyBitExact(const int16_t *frame);
+};
+
+#endif // FIXED_POINT_MFCC_H
@@ -0,0 +1,27 @@
+#ifndef HEAP_ALLOC_COUNTER_H
+#define HEAP_ALLOC_COUNTER_H
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// 熱路徑堆積配置計數：以連結器 --wrap 包裝 malloc/calloc/realloc，
+// 只計算在 beginTracking()/endTracking() 之間、由同一任務發出的配置
+// 需同時在 build_flags 加上 -D HEAP_ALLOC_COUNTER=1 與
+// -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc；未啟用時所有方法皆為空操作，getCount() 恆為 0
+#ifndef HEAP_ALLOC_COUNTER
+#define HEAP_ALLOC_COUNTER 0
+#endif
+
+class HeapAllocCounter
+{
+public:
+    // 開始計算目前任務的配置 (同一時間只追蹤一個任務，呼叫端需以互斥鎖序列化)
+    static void beginTracking();
+    static void endTracking();
+
+    // 追蹤期間累計的配置次數
+    static uint32_t getCount();
+};
+
+#endif // HEAP_ALLOC_COUNTER_H
@@ -0,0 +1,47 @@
+#ifndef JSON_FIELD_READER_H
+#define JSON_FIELD_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 直接讀取輸入緩衝區的 JSON 物件欄位，不使用堆積也不複製輸入 (取代控制訊息的 JsonDocument)
+// 只查詢最上層物件的成員：字串、整數與布林；巢狀物件與陣列會被跳過，但仍檢查語法與括號配對
+// 建構時驗證整則訊息，之後每次查詢從頭掃描 (控制訊息很短)；重複的鍵以第一個為準
+// 只依賴標準 C++，主機端可直接編譯
+#define JSON_READER_MAX_DEPTH 8 // 巢狀容器上限，超過視為格式錯誤
+
+class JsonFieldReader
+{
+private:
+    static const size_t INVALID = (size_t)-1;
+
+    const char *json;
+    size_t length;
+    bool valid;
+
+    size_t skipSpace(size_t pos) const;
+    size_t skipString(size_t pos) const; // pos 為開頭引號，回傳結尾引號之後的位置
+    size_t skipNumber(size_t pos) const;
+    size_t skipLiteral(size_t pos, const char *literal) const;
+    size_t skipValue(size_t pos, int depth) const;
+    size_t skipContainer(size_t pos, int depth) const;
+    size_t find(const char *key) const; // 回傳成員值的起始位置，不存在回傳 INVALID
+
+public:
+    JsonFieldReader(const char *json, size_t length);
+
+    // 輸入是否為語法正確的 JSON 物件 (格式錯誤時所有查詢都回傳 false)
+    bool ok() const { return valid; }
+    bool has(const char *key) const;
+
+    // 字串成員 (處理跳脫字元，\u 只接受 ASCII)；不存在、型別不符或超出 capacity (含結尾 0) 回傳 false
+    bool getString(const char *key, char *out, size_t capacity) const;
+
+    // 整數成員 (不接受小數、指數與超出 int32 的值)
+    bool getInt(const char *key, int32_t *value) const;
+
+    // 布林成員 (true / false)
+    bool getBool(const char *key, bool *value) const;
+};
+
+#endif // JSON_FIELD_READER_H
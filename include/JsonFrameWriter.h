@@ -0,0 +1,59 @@
+#ifndef JSON_FRAME_WRITER_H
+#define JSON_FRAME_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 直接寫入預先配置緩衝區的 JSON 序列化器，不使用堆積 (取代發布路徑上的 JsonDocument + String)
+// 緩衝區不足時停止寫入並設定溢位旗標，呼叫端以 ok() 判斷後丟棄該訊息
+// 浮點數以 7 位有效數字輸出，NaN/Inf 輸出為 null；不經 printf，避免 newlib 浮點格式化配置記憶體
+// 只依賴標準 C++，主機端可直接編譯
+class JsonFrameWriter
+{
+private:
+    char *buffer;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+    bool first;    // 目前容器內尚未寫入任何元素
+    bool afterKey; // 剛寫完物件鍵，下一個值不加逗號
+
+    void put(char c);
+    void put(const char *text);
+    void separator();
+    void writeUnsigned(uint64_t value);
+    void writeFraction(uint64_t fraction, int decimals);
+    void writeFloat(double value);
+    void writeString(const char *text);
+
+public:
+    JsonFrameWriter(char *buffer, size_t capacity);
+
+    void beginObject();
+    void endObject();
+    void beginArray(const char *key);
+    void beginArray();
+    void endArray();
+
+    // 物件成員 (鍵不跳脫，僅用於程式內的固定欄位名稱)
+    void key(const char *name);
+    void member(const char *name, int32_t value);
+    void member(const char *name, uint32_t value);
+    void member(const char *name, uint64_t value);
+    void member(const char *name, double value);
+    void member(const char *name, bool value);
+    void member(const char *name, const char *value); // 字串值會跳脫
+
+    // 陣列元素
+    void value(int32_t value);
+    void value(uint32_t value);
+    void value(uint64_t value);
+    void value(double value);
+    void value(const char *value);
+
+    bool ok() const { return !overflow; }
+    size_t size() const { return length; }
+    const char *data() const { return buffer; }
+};
+
+#endif // JSON_FRAME_WRITER_H
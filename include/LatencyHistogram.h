@@ -0,0 +1,36 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 延遲直方圖 (微秒)：0-3 µs 各一格，之後每個 2 的冪次區間再等分 4 格，相對誤差 ≤ 25%
+// 固定大小、不配置記憶體；單一寫入端，其他任務讀取的結果為近似值
+// 只依賴標準 C++，主機端可直接編譯
+#define LATENCY_HISTOGRAM_OCTAVES 24 // 涵蓋到 2^25 µs (約 33 s)，超出者計入最後一格
+#define LATENCY_HISTOGRAM_BUCKETS (4 + LATENCY_HISTOGRAM_OCTAVES * 4)
+
+class LatencyHistogram
+{
+private:
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint32_t maxValue;
+
+    static int bucketOf(uint32_t micros);
+    static uint32_t bucketLow(int bucket);
+
+public:
+    LatencyHistogram() { reset(); }
+
+    void reset();
+    void record(uint32_t micros);
+
+    uint32_t getCount() const { return count; }
+    uint32_t getMax() const { return maxValue; }
+
+    // 百分位數 (0 < p ≤ 1)，在所在分格內線性內插並以最大值為上限；無樣本時回傳 0
+    uint32_t percentile(float p) const;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,26 @@
+#ifndef MONOTONIC_CLOCK_H
+#define MONOTONIC_CLOCK_H
+
+#include <stdint.h>
+
+// 單調微秒時鐘 (64 位元，不會溢位)，用於量測管線各階段的延遲
+// 裝置上為 esp_timer (開機後起算，各核心一致)；主機端為 std::chrono::steady_clock，方便在主機上驗證
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+
+inline uint64_t monotonicMicros()
+{
+    return (uint64_t)esp_timer_get_time();
+}
+#else
+#include <chrono>
+
+inline uint64_t monotonicMicros()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+#endif
+
+#endif // MONOTONIC_CLOCK_H
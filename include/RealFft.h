@@ -0,0 +1,63 @@
+#ifndef REAL_FFT_H
+#define REAL_FFT_H
+
+#include <stdint.h>
+#include "FeatureTables.h"
+
+// 實數輸入 FFT 的打包與展開：FFT_SIZE 個實數樣本打包成 FFT_SIZE/2 點複數序列，
+// 做完 FFT_SIZE/2 點複數 FFT 後展開成 0 ~ FFT_SIZE/2 的頻譜
+// 中間的複數 FFT 由呼叫端提供 (裝置上為 ArduinoFFT)；只依賴標準 C++，主機端測試與特徵提取器共用同一份實作
+
+// 偶數樣本作實部、奇數樣本作虛部 (就地處理，寫入索引不超過讀取索引)
+template <typename T, uint16_t FftSize>
+inline void packRealFftInput(T *re, T *im)
+{
+    for (int n = 0; n < FftSize / 2; n++)
+    {
+        T even = re[2 * n];
+        T odd = re[2 * n + 1];
+        re[n] = even;
+        im[n] = odd;
+    }
+}
+
+// 展開：X[k] = Fe[k] + W^k * Fo[k]，X[N/2-k] = conj(Fe[k] - W^k * Fo[k])
+// cosTable / sinTable 為 makeTwiddleCos / makeTwiddleSin 產生的前四分之一週期
+template <typename T, uint16_t FftSize>
+inline void unpackRealFftSpectrum(T *re, T *im, const FeatureTable<T, FftSize / 4 + 1> &cosTable,
+                                  const FeatureTable<T, FftSize / 4 + 1> &sinTable)
+{
+    const int half = FftSize / 2;
+    const T h = (T)0.5;
+    T z0r = re[0];
+    T z0i = im[0];
+    re[0] = z0r + z0i;
+    im[0] = 0;
+    re[half] = z0r - z0i;
+    im[half] = 0;
+
+    for (int k = 1; k <= half / 2; k++)
+    {
+        int m = half - k;
+        T ar = re[k], ai = im[k];
+        T br = re[m], bi = im[m];
+
+        T feR = h * (ar + br);
+        T feI = h * (ai - bi);
+        T foR = h * (ai + bi);
+        T foI = h * (br - ar);
+
+        // W^k = cos(θ) - j·sin(θ)
+        T c = cosTable[k];
+        T s = sinTable[k];
+        T tR = c * foR + s * foI;
+        T tI = c * foI - s * foR;
+
+        re[k] = feR + tR;
+        im[k] = feI + tI;
+        re[m] = feR - tR;
+        im[m] = tI - feI;
+    }
+}
+
+#endif // REAL_FFT_H
@@ -0,0 +1,39 @@
+#ifndef RECONNECT_BACKOFF_H
+#define RECONNECT_BACKOFF_H
+
+#include <stdint.h>
+
+// 指數退避：第 n 次失敗後的等待上限為 base·2^n (不超過 max)，實際等待在 [上限/2, 上限] 間均勻抖動
+// 抖動避免多台裝置在服務器恢復時同時重連；隨機數由呼叫端提供 (裝置上為 esp_random())
+// 只依賴標準 C++
+class ReconnectBackoff
+{
+private:
+    uint32_t baseMs;
+    uint32_t maxMs;
+    uint32_t failures; // 連續失敗次數
+
+public:
+    ReconnectBackoff(uint32_t baseMs, uint32_t maxMs) : baseMs(baseMs), maxMs(maxMs), failures(0) {}
+
+    // 連線成功後呼叫，下次斷線從最短等待開始
+    void reset() { failures = 0; }
+
+    // 記錄一次失敗並回傳下次嘗試前的等待時間 (ms)
+    uint32_t next(uint32_t random)
+    {
+        uint64_t ceiling = (uint64_t)baseMs << (failures < 32 ? failures : 32);
+        if (ceiling > maxMs)
+        {
+            ceiling = maxMs;
+        }
+        failures++;
+
+        uint32_t half = (uint32_t)ceiling / 2;
+        return half + random % ((uint32_t)ceiling - half + 1);
+    }
+
+    uint32_t getFailures() const { return failures; }
+};
+
+#endif // RECONNECT_BACKOFF_H
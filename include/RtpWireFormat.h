@@ -0,0 +1,80 @@
+#ifndef RTP_WIRE_FORMAT_H
+#define RTP_WIRE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// RTP (RFC 3550) 音訊封包，所有欄位皆為 big-endian (網路位元組序)
+//
+//   偏移  大小  欄位
+//   0     1     V=2、P=0、X=0、CC=0 (0x80)
+//   1     1     M (位元 7) + 負載類型 (位元 0-6)
+//   2     2     序號 (每個資料報 +1，接收端以缺口計算遺失)
+//   4     4     時間戳 (樣本時鐘，裝置端丟棄的塊會使時間戳跳過對應樣本數)
+//   8     4     SSRC
+//   12    ...   負載：L16 (RFC 3551)，big-endian int16 單聲道樣本
+//
+// M 位元標記串流開始或前一塊之後有音訊遺失 (接收端應重置播放緩衝)
+// 只依賴標準 C++，裝置端與主機端解碼共用
+
+#define RTP_VERSION 2
+#define RTP_HEADER_SIZE 12
+#define RTP_PAYLOAD_TYPE_L16 96 // 動態負載類型：L16 單聲道，取樣率由設定約定 (預設 16 kHz)
+
+struct RtpHeader
+{
+    bool marker;
+    uint8_t payloadType;
+    uint16_t sequence;
+    uint32_t timestamp;
+    uint32_t ssrc;
+};
+
+class RtpWireFormat
+{
+public:
+    static size_t l16PacketSize(size_t sampleCount) { return RTP_HEADER_SIZE + sampleCount * 2; }
+
+    // 寫入 12 位元組固定標頭；空間不足回傳 0
+    static size_t writeHeader(const RtpHeader &header, uint8_t *out, size_t capacity);
+
+    // 編碼完整 L16 封包；空間不足回傳 0，否則回傳封包長度
+    static size_t encodeL16(const RtpHeader &header, const int16_t *samples, size_t sampleCount, uint8_t *out,
+                            size_t capacity);
+
+    // 解析標頭 (略過 CSRC 與擴充標頭)；格式錯誤回傳 0，否則回傳負載起始偏移
+    static size_t readHeader(const uint8_t *data, size_t length, RtpHeader *header);
+};
+
+// RTP 串流狀態：序號、由樣本時鐘推得的時間戳與 M 位元 (AudioStreamManager 在擷取任務中使用)
+// RTP 時間戳 = 樣本位置 + 隨機偏移：來源遺失的樣本 (位置跳躍) 使時間戳跳過對應的樣本數並標記 M 位元；
+// 樣本時鐘重新開始 (位置倒退) 時調整偏移讓時間戳繼續遞增並標記 M 位元。序號每個資料報 +1，只反映網路遺失
+class RtpPacketizer
+{
+private:
+    uint32_t ssrc;
+    uint16_t sequence;
+    uint32_t timestampOffset;
+    uint32_t timestampBase;    // restart() 指定的第一個資料報時間戳
+    uint64_t expectedPosition; // 下一塊的樣本位置
+    bool restartPending;
+    bool markerPending;
+
+public:
+    RtpPacketizer();
+
+    // 新串流 (RFC 3550 建議 SSRC、起始序號與時間戳皆為隨機值)：下一個資料報從這些值開始並帶 M 位元
+    void restart(uint32_t newSsrc, uint16_t firstSequence, uint32_t firstTimestamp);
+
+    // 編碼一塊 L16 音訊；序號不論之後送出成功與否都前進 (接收端把送出失敗視為網路遺失)
+    // sourceGap 回傳本塊之前是否有來源樣本遺失；空間不足回傳 0
+    size_t encode(const int16_t *samples, size_t sampleCount, uint64_t samplePosition, uint8_t *out, size_t capacity,
+                  bool *sourceGap = nullptr);
+
+    // 資料報已送出：清除 M 位元；送出失敗時保留，由下一個資料報帶出
+    void markSent() { markerPending = false; }
+
+    uint32_t getSsrc() const { return ssrc; }
+};
+
+#endif // RTP_WIRE_FORMAT_H
@@ -0,0 +1,130 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// 單生產者/單消費者無鎖環形緩衝區
+// 生產者以 reserve()/commit() 就地填寫槽位，消費者以 front()/release() 就地讀取，不複製整個元素
+// 只依賴標準 C++，可在主機端以兩個執行緒驗證
+template <typename T, uint32_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "容量必須是 2 的冪次");
+
+private:
+    T slots[Capacity];
+
+    // head 只由生產者寫入，tail 只由消費者寫入；兩者單調遞增，以遮罩取索引
+    alignas(4) std::atomic<uint32_t> head;
+    alignas(4) std::atomic<uint32_t> tail;
+
+    // 生產者側統計
+    uint32_t highWaterMark;
+
+public:
+    SpscRing() : head(0), tail(0), highWaterMark(0) {}
+
+    static constexpr uint32_t capacity() { return Capacity; }
+
+    // ===== 生產者 =====
+
+    // 取得下一個可寫槽位；滿時回傳 nullptr
+    T *reserve()
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= Capacity)
+        {
+            return nullptr;
+        }
+        return &slots[h & (Capacity - 1)];
+    }
+
+    // 發布 reserve() 取得的槽位
+    void commit()
+    {
+        uint32_t h = head.load(std::memory_order_relaxed) + 1;
+        head.store(h, std::memory_order_release);
+
+        uint32_t used = h - tail.load(std::memory_order_relaxed);
+        if (used > highWaterMark)
+        {
+            highWaterMark = used;
+        }
+    }
+
+    // 複製寫入一個元素
+    bool push(const T &item)
+    {
+        T *slot = reserve();
+        if (!slot)
+        {
+            return false;
+        }
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // ===== 消費者 =====
+
+    // 取得最舊的已發布槽位；空時回傳 nullptr
+    T *front()
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t)
+        {
+            return nullptr;
+        }
+        return &slots[t & (Capacity - 1)];
+    }
+
+    // 取得第 index 個已發布槽位 (0 即 front())；尚未發布時回傳 nullptr，供就地批次讀取
+    T *peek(uint32_t index)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) - t <= index)
+        {
+            return nullptr;
+        }
+        return &slots[(t + index) & (Capacity - 1)];
+    }
+
+    // 歸還 front() 取得的槽位
+    void release()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // 一次歸還最舊的 count 個槽位 (先前以 peek() 讀取)
+    void release(uint32_t count)
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // 複製讀出一個元素
+    bool pop(T &item)
+    {
+        T *slot = front();
+        if (!slot)
+        {
+            return false;
+        }
+        item = *slot;
+        release();
+        return true;
+    }
+
+    // ===== 狀態 (任一側可讀，結果為近似值) =====
+
+    uint32_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    uint32_t getHighWaterMark() const { return highWaterMark; }
+    void resetHighWaterMark() { highWaterMark = 0; }
+};
+
+#endif // SPSC_RING_H
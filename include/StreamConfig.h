@@ -0,0 +1,104 @@
+#ifndef STREAM_CONFIG_H
+#define STREAM_CONFIG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "AudioWireFormat.h"
+#include "FeatureWireFormat.h"
+#include "JsonFieldReader.h"
+#include "JsonFrameWriter.h"
+
+// 音訊輸出格式 (可組合)：JSON 發布到 MQTT_TOPIC_AUDIO，二進位發布到 MQTT_TOPIC_AUDIO_BINARY
+#define AUDIO_OUTPUT_JSON 0x01
+#define AUDIO_OUTPUT_BINARY 0x02
+#ifndef AUDIO_OUTPUT_DEFAULT
+#define AUDIO_OUTPUT_DEFAULT AUDIO_OUTPUT_JSON
+#endif
+
+// 特徵輸出格式 (可組合)：JSON 分別發布到 MFCC / 梅爾 / 特徵三個主題，緊湊幀發布到 MQTT_TOPIC_FEATURE_FRAME
+#define FEATURE_OUTPUT_JSON 0x01
+#define FEATURE_OUTPUT_FRAME 0x02
+#ifndef FEATURE_OUTPUT_DEFAULT
+#define FEATURE_OUTPUT_DEFAULT FEATURE_OUTPUT_JSON
+#endif
+
+// 特徵集 (可組合)：JSON 只發布選取的主題；緊湊幀省略的部分在標頭中的數量為 0
+#define FEATURE_SET_MFCC 0x01
+#define FEATURE_SET_MEL 0x02
+#define FEATURE_SET_STATS 0x04
+#define FEATURE_SET_ALL (FEATURE_SET_MFCC | FEATURE_SET_MEL | FEATURE_SET_STATS)
+
+// 設定欄位 (可組合)：標示命令修改、需要套用或寫入 NVS 的欄位，名稱見 StreamConfig::fieldName
+#define STREAM_CONFIG_AUDIO_FORMAT 0x0001
+#define STREAM_CONFIG_AUDIO_CODEC 0x0002
+#define STREAM_CONFIG_BATCH_PACKETS 0x0004
+#define STREAM_CONFIG_AUDIO_INTERVAL 0x0008
+#define STREAM_CONFIG_FEATURE_FORMAT 0x0010
+#define STREAM_CONFIG_FEATURE_ENCODING 0x0020
+#define STREAM_CONFIG_FEATURE_SET 0x0040
+#define STREAM_CONFIG_HOP_SAMPLES 0x0080
+#define STREAM_CONFIG_FEATURE_INTERVAL 0x0100
+#define STREAM_CONFIG_FIELD_COUNT 9
+#define STREAM_CONFIG_ALL ((1 << STREAM_CONFIG_FIELD_COUNT) - 1)
+#define STREAM_CONFIG_NAME_MAX 24 // 列舉值字串上限 (含結尾 0)
+
+// 數值欄位的允許範圍 (由使用端依緩衝區大小與特徵提取器設定填寫)
+struct StreamConfigLimits
+{
+    uint8_t maxBatchPackets;
+    uint16_t maxAudioIntervalMs;
+    uint16_t minHopSamples;
+    uint16_t maxHopSamples;
+    uint16_t minFeatureIntervalMs;
+    uint16_t maxFeatureIntervalMs;
+};
+
+// 可在執行期以 configure 命令修改的串流設定
+// 只依賴標準 C++：命令解析、驗證與序列化可在主機端驗證；套用時機與 NVS 儲存由 AudioMqttManager 負責
+struct StreamConfig
+{
+    uint8_t audioFormats;       // AUDIO_OUTPUT_* 組合
+    uint8_t audioCodec;         // 二進位封包編碼 (AUDIO_CODEC_*)
+    uint8_t batchPackets;       // 每則音訊訊息最多合併的包數
+    uint16_t audioIntervalMs;   // 音訊發布間隔上限：最早的包從擷取到發布的最長等待
+    uint8_t featureFormats;     // FEATURE_OUTPUT_* 組合
+    uint8_t featureEncoding;    // 緊湊幀數值編碼 (FEATURE_ENCODING_*)
+    uint8_t featureSet;         // FEATURE_SET_* 組合
+    uint16_t hopSamples;        // 特徵幀距 (樣本)
+    uint16_t featureIntervalMs; // 特徵發布間隔上限：音訊持續到達時特徵的最長等待
+
+    // 欄位名稱 (命令、確認訊息與狀態共用)；field 為單一 STREAM_CONFIG_* 位元
+    static const char *fieldName(uint16_t field);
+
+    // 讀取 reader 中出現的欄位並驗證：全部有效才寫入並回傳出現的欄位遮罩 (可為 0)；
+    // 任一欄位無效時回傳 -1、設定不變，*invalidField 指向該欄位名稱
+    int parse(const JsonFieldReader &reader, const StreamConfigLimits &limits, const char **invalidField);
+
+    // 驗證 fields 中的每個欄位，回傳有效欄位的遮罩 (用於檢查 NVS 讀回的值)
+    uint16_t validFields(uint16_t fields, const StreamConfigLimits &limits) const;
+
+    // 值與 other 不同的欄位
+    uint16_t diff(const StreamConfig &other) const;
+
+    // 從 source 複製 fields 中的欄位
+    void merge(const StreamConfig &source, uint16_t fields);
+
+    // 以命令相同的表示法寫入目前物件的成員 (呼叫端負責 beginObject / endObject)
+    void writeJson(JsonFrameWriter &json) const;
+
+    // 列舉值與名稱對照；名稱無效回傳 -1，值無效回傳 "unknown"
+    static int audioFormatFromName(const char *name);
+    static int audioCodecFromName(const char *name);
+    static int featureFormatFromName(const char *name);
+    static int featureEncodingFromName(const char *name);
+    static const char *audioFormatName(uint8_t formats);
+    static const char *audioCodecName(uint8_t codec);
+    static const char *featureFormatName(uint8_t formats);
+    static const char *featureEncodingName(uint8_t encoding);
+
+    // 特徵集以 + 連接，例如 "mfcc+stats"；名稱無效或為空回傳 -1
+    static int featureSetFromName(const char *name);
+    static size_t featureSetName(uint8_t set, char *out, size_t capacity);
+};
+
+#endif // STREAM_CONFIG_H
@@ -0,0 +1,104 @@
+#ifndef STREAM_QUALITY_CONTROLLER_H
+#define STREAM_QUALITY_CONTROLLER_H
+
+#include <stdint.h>
+
+// 串流品質層級 (由高到低)
+#define STREAM_TIER_RAW 0           // 使用者設定的輸出格式與編碼 (預設 PCM)
+#define STREAM_TIER_ADPCM 1         // 僅二進位主題，IMA-ADPCM (約 1/4 頻寬)
+#define STREAM_TIER_ADPCM_8K 2      // 僅二進位主題，降取樣到一半取樣率後 IMA-ADPCM (約 1/8 頻寬)
+#define STREAM_TIER_FEATURES_ONLY 3 // 停止音訊，只發布特徵
+#define STREAM_TIER_COUNT 4
+
+// 評估視窗與門檻
+#define STREAM_QUALITY_WINDOW_MS 1000         // 每個視窗評估一次
+#define STREAM_QUALITY_DEPTH_HIGH_PERCENT 75  // 視窗內緩衝區最高深度超過此比例視為壅塞
+#define STREAM_QUALITY_DEPTH_LOW_PERCENT 25   // 低於此比例才算健康
+#define STREAM_QUALITY_LATENCY_HIGH_MS 250    // 視窗內平均發布延遲超過此值視為壅塞
+#define STREAM_QUALITY_LATENCY_LOW_MS 100     // 低於此值才算健康
+#define STREAM_QUALITY_ERROR_PERCENT 5        // 發布失敗比例超過此值視為壅塞
+#define STREAM_QUALITY_RECOVER_WINDOWS 5      // 連續健康視窗數達到要求才升一級
+#define STREAM_QUALITY_RECOVER_WINDOWS_MAX 60 // 升級後很快又降級時，要求加倍的上限
+#define STREAM_QUALITY_STABLE_WINDOWS 30      // 升級後連續這麼多視窗沒有壅塞，升級要求減半回到基準
+#define STREAM_QUALITY_SETTLE_WINDOWS 1       // 降級後忽略的視窗數 (前一層級的積壓仍在排空)
+
+// 依緩衝區深度、發布延遲、失敗率與丟包在各品質層級間切換
+// 壅塞時每個視窗降一級；恢復需連續 recoverWindows 個健康視窗才升一級，升級後兩個視窗內又降級則要求加倍
+// 降級後的第一個視窗只觀察不動作，避免前一層級留下的積壓造成連續降級
+// 呼叫端 (發布任務) 負責餵入觀測值並在 update() 回傳 true 時套用新層級
+// 只依賴標準 C++，可在主機端以模擬的慢速傳輸驗證
+class StreamQualityController
+{
+public:
+    // 壅塞原因 (位元旗標，供狀態回報)
+    enum Reason : uint8_t
+    {
+        REASON_NONE = 0,
+        REASON_DROPS = 0x01,
+        REASON_QUEUE_DEPTH = 0x02,
+        REASON_LATENCY = 0x04,
+        REASON_ERRORS = 0x08,
+        REASON_RECOVERED = 0x10,
+        REASON_MANUAL = 0x20
+    };
+
+    StreamQualityController();
+
+    void reset(uint32_t nowMs);
+
+    // 啟用時依觀測值自動切換；停用時停在目前層級
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    // 最低允許層級 (例如特徵提取未啟用時不應降到只剩特徵)
+    void setLowestTier(uint8_t tier);
+
+    // 手動指定層級 (回傳層級是否改變)
+    bool forceTier(uint8_t tier);
+
+    // ===== 觀測值 (皆由發布任務呼叫) =====
+
+    // 每則音訊或特徵訊息發布後呼叫；latencyUs 為該訊息最舊資料的等待時間
+    void recordPublish(uint32_t latencyUs, bool ok);
+
+    // 觀測音訊緩衝區目前深度
+    void observeQueue(uint32_t depth, uint32_t capacity);
+
+    // 視窗結束時評估；dropTotal 為累計丟包數 (取差值)；層級改變時回傳 true
+    bool update(uint32_t nowMs, uint32_t dropTotal);
+
+    // ===== 狀態 =====
+
+    uint8_t getTier() const { return tier; }
+    uint8_t getLastReason() const { return lastReason; }
+    uint32_t getTierChanges() const { return tierChanges; }
+    uint32_t getRecoverWindows() const { return recoverWindows; }
+    static const char *tierName(uint8_t tier);
+
+private:
+    bool enabled;
+    uint8_t tier;
+    uint8_t lowestTier;
+    uint8_t lastReason;
+    uint32_t tierChanges;
+
+    // 目前視窗
+    uint32_t windowStart;
+    uint32_t windowPublishes;
+    uint32_t windowErrors;
+    uint64_t windowLatencyUs;
+    uint32_t windowMaxDepthPercent;
+    uint32_t lastDropTotal;
+
+    // 恢復判斷
+    uint32_t healthyWindows;
+    uint32_t stableWindows; // 升級後連續沒有壅塞的視窗數 (升級不歸零)
+    uint32_t settleWindows;
+    uint32_t windowsSinceUpgrade;
+    uint32_t recoverWindows;
+
+    void setTier(uint8_t newTier, uint8_t reason);
+    void clearWindow(uint32_t nowMs);
+};
+
+#endif // STREAM_QUALITY_CONTROLLER_H
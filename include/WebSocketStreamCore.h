@@ -0,0 +1,102 @@
+#ifndef WEBSOCKET_STREAM_CORE_H
+#define WEBSOCKET_STREAM_CORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+#include "AudioWireFormat.h"
+#include "FeatureWireFormat.h"
+
+// WebSocket 串流核心：每個客戶端一個固定大小的訊息隊列，已滿時丟棄最舊的訊息，
+// 並在同種類的第一則存活訊息設定缺口旗標 (音訊 AUDIO_WIRE_FLAG_GAP、特徵 FEATURE_WIRE_FLAG_GAP；不設定 RESYNC)
+// 生產端 (擷取任務的音訊、發布任務的特徵) 只做編碼與複製，不會因為某個客戶端很慢而等待；
+// 傳輸端 (WebSocket 任務) 以 pop() 取出後送出
+// 與傳輸層無關，只依賴標準 C++，主機端測試見 test/test_websocket_stream_core.cpp
+#define WS_STREAM_MAX_CLIENTS 4
+#define WS_STREAM_QUEUE_DEPTH 16 // 每個客戶端的隊列深度 (PCM 約 256 ms 音訊)
+#define WS_STREAM_SLOT_BYTES (AUDIO_WIRE_HEADER_SIZE + 256 * 2) // 單則訊息上限：256 樣本 PCM16 封包 (AudioWireFormat)
+
+// 客戶端訂閱 (可組合)，由連線路徑決定：/pcm (預設)、/adpcm、/features，可用 + 連接，例如 /adpcm+features
+#define WS_SUBSCRIBE_PCM 0x01
+#define WS_SUBSCRIBE_ADPCM 0x02
+#define WS_SUBSCRIBE_FEATURES 0x04
+#define WS_SUBSCRIBE_DEFAULT (WS_SUBSCRIBE_PCM | WS_SUBSCRIBE_FEATURES)
+
+// 訊息種類 (只在隊列中使用，送出的負載本身以 magic 區分：音訊 0xA5、特徵 0xA6)
+#define WS_MESSAGE_AUDIO 1
+#define WS_MESSAGE_FEATURES 2
+
+class WebSocketStreamCore
+{
+public:
+    struct ClientStats
+    {
+        uint32_t sent;
+        uint32_t dropped;   // 隊列已滿而丟棄的最舊訊息
+        uint32_t highWater; // 隊列最高深度
+    };
+
+private:
+    struct Slot
+    {
+        uint8_t kind;
+        uint16_t length;
+        uint8_t data[WS_STREAM_SLOT_BYTES];
+    };
+
+    struct Client
+    {
+        bool connected;
+        uint8_t subscriptions;
+        uint32_t head; // 下一則要送出的位置 (單調遞增，取模後為實際位置)
+        uint32_t tail; // 下一則寫入的位置
+        ClientStats stats;
+        Slot slots[WS_STREAM_QUEUE_DEPTH];
+    };
+
+    // 丟棄最舊訊息必須同時移動讀寫兩端，因此以互斥鎖保護隊列；鎖內只做 memcpy
+    std::mutex lock;
+    Client clients[WS_STREAM_MAX_CLIENTS];
+    uint8_t subscriptionUnion; // 所有已連線客戶端訂閱的聯集 (決定需要編碼哪些格式)
+
+    // 僅音訊生產端使用
+    ImaAdpcmCodec adpcmEncoder;
+    bool adpcmResyncPending;
+    uint64_t nextPosition; // 預期的下一個樣本位置，跳躍時標記 AUDIO_WIRE_FLAG_GAP
+    uint8_t encodeBuffer[WS_STREAM_SLOT_BYTES];
+
+    void enqueue(uint8_t kind, uint8_t subscription, const uint8_t *data, size_t length);
+    static void markGap(Slot &slot);
+    void updateSubscriptionUnion();
+
+public:
+    WebSocketStreamCore();
+
+    // 連線與斷線 (id 為傳輸層的客戶端編號，0 ≤ id < WS_STREAM_MAX_CLIENTS)
+    bool addClient(uint8_t id, uint8_t subscriptions);
+    void removeClient(uint8_t id);
+    static uint8_t parseSubscriptions(const char *path);
+
+    // 有任何客戶端訂閱時才需要呼叫 (生產端先檢查，避免無人觀看時仍在編碼)
+    bool wantsAudio() const { return (subscriptionUnion & (WS_SUBSCRIBE_PCM | WS_SUBSCRIBE_ADPCM)) != 0; }
+    bool wantsFeatures() const { return (subscriptionUnion & WS_SUBSCRIBE_FEATURES) != 0; }
+
+    // 音訊生產端：依訂閱編碼成 PCM16 及/或 IMA-ADPCM 封包 (AudioWireFormat) 後放入各客戶端隊列
+    void pushAudio(const int16_t *samples, uint16_t sampleCount, uint16_t sequence, uint64_t samplePosition,
+                   uint64_t epochMicros, uint32_t sampleRate);
+
+    // 特徵生產端：已編碼的緊湊特徵訊息 (FeatureWireFormat)
+    void pushFeatures(const uint8_t *message, size_t length);
+
+    // 傳輸端：取出客戶端 id 最舊的一則訊息 (capacity 至少 WS_STREAM_SLOT_BYTES)；沒有訊息時回傳 0
+    size_t pop(uint8_t id, uint8_t *out, size_t capacity);
+
+    // ===== 狀態 (近似值) =====
+
+    uint8_t getClientCount() const;
+    bool isConnected(uint8_t id) const { return id < WS_STREAM_MAX_CLIENTS && clients[id].connected; }
+    uint32_t getQueueDepth(uint8_t id) const;
+    ClientStats getClientStats(uint8_t id) const;
+};
+
+#endif // WEBSOCKET_STREAM_CORE_H
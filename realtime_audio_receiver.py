@@ -15,6 +15,7 @@ import numpy as np
 import sounddevice as sd
 import wave
 import threading
+import struct
 import time
 from collections import deque
 from datetime import datetime
@@ -43,6 +44,7 @@ class ESP32AudioReceiver:
         # 音訊緩衝區
         self.audio_buffer = deque()
         self.play_buffer = deque(maxlen=8000)  # 0.5秒緩衝
+        self.next_position = None  # 預期的下一個樣本位置 (播放取樣率)，用於以靜音補上遺失的樣本
         self.wave_buffer = deque(maxlen=1600)  # 0.1秒顯示緩衝
         
         # 控制變數
@@ -56,6 +58,7 @@ class ESP32AudioReceiver:
             'packets_received': 0,
             'samples_received': 0,
             'start_time': time.time(),
+            'samples_filled': 0,  # 以靜音補上的遺失樣本
             'last_packet_time': 0
         }
           # 音訊保存
@@ -77,6 +80,7 @@ class ESP32AudioReceiver:
             # 訂閱音訊主題
             topics = [
                 "esp32/audio/raw",
+                "esp32/audio/raw/bin",
                 "esp32/audio/status"
             ]
             
@@ -99,6 +103,18 @@ class ESP32AudioReceiver:
             if topic == "esp32/audio/raw":
                 data = json.loads(msg.payload.decode('utf-8'))
                 self.handle_audio_data(data)
+            elif topic == "esp32/audio/raw/bin":
+                # 一則訊息可能串接多個封包，依標頭的樣本數逐一切分
+                offset = 0
+                while offset < len(msg.payload):
+                    data, size = self.decode_binary_audio(msg.payload, offset)
+                    if not data:
+                        break
+                    offset += size
+                    if data['replay']:
+                        # 斷線暫存補發的是過去的音訊，不混入即時播放
+                        continue
+                    self.handle_audio_data(data)
             elif topic == "esp32/audio/status":
                 data = json.loads(msg.payload.decode('utf-8'))
                 self.handle_status_data(data)
@@ -106,12 +122,97 @@ class ESP32AudioReceiver:
         except Exception as e:
             print(f"處理 MQTT 消息時出錯: {e}")
     
+    IMA_STEP_TABLE = [
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+        337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552,
+        1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+        7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385,
+        24623, 27086, 29794, 32767]
+    IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+    def decode_ima_adpcm(self, payload, offset, count):
+        """解碼 IMA-ADPCM 負載 (4 位元組起始狀態 + 每位元組先低 4 位元)"""
+        predictor, index = struct.unpack_from('<hB', payload, offset)
+        if index > 88:
+            return None
+        audio = np.empty(count, dtype=np.int16)
+        data = payload[offset + 4:]
+        for i in range(count):
+            byte = data[i >> 1]
+            code = (byte >> 4) if (i & 1) else (byte & 0x0F)
+            step = self.IMA_STEP_TABLE[index]
+            delta = step >> 3
+            if code & 4:
+                delta += step
+            if code & 2:
+                delta += step >> 1
+            if code & 1:
+                delta += step >> 2
+            predictor += -delta if (code & 8) else delta
+            predictor = max(-32768, min(32767, predictor))
+            index = max(0, min(88, index + self.IMA_INDEX_TABLE[code]))
+            audio[i] = predictor
+        return audio
+
+    def decode_binary_audio(self, payload, offset=0):
+        """解碼 offset 處的二進位音訊封包 (格式見 include/AudioWireFormat.h)，回傳 (數據, 封包長度)"""
+        if len(payload) < offset + 28:
+            return None, 0
+        (magic, version, codec, flags, sequence, count, sample_rate,
+         position, epoch_us) = struct.unpack_from('<BBBBHHIQQ', payload, offset)
+        audio = None
+        size = 0
+        if magic == 0xA5 and version == 2:
+            if codec == 0:
+                size = 28 + count * 2
+                if len(payload) >= offset + size:
+                    audio = np.frombuffer(payload, dtype='<i2', count=count, offset=offset + 28)
+            elif codec == 1:
+                size = 32 + (count + 1) // 2
+                if len(payload) >= offset + size:
+                    audio = self.decode_ima_adpcm(payload, offset + 28, count)
+        if audio is None:
+            print(f"⚠️ 無法解碼的二進位音訊封包 (版本 {version}, 編碼 {codec})")
+            return None, 0
+        if flags & 0x01:
+            print(f"🔄 音訊串流重新同步 (序號 {sequence})")
+        # 樣本位置以本包取樣率計，換算到播放取樣率
+        if sample_rate:
+            position = position * self.sample_rate // sample_rate
+        if sample_rate and sample_rate != self.sample_rate and count > 0:
+            # 降級串流 (例如 8 kHz) 以線性內插還原到播放取樣率
+            target = count * self.sample_rate // sample_rate
+            positions = np.arange(target) * (sample_rate / self.sample_rate)
+            audio = np.interp(positions, np.arange(count), audio.astype(np.float32)).astype(np.int16)
+            count = target
+        # 由樣本時鐘推得的時間 (ms)；裝置尚未校時 (epoch 為 0) 時為串流開始後的時間
+        timestamp = (epoch_us + position * 1000000 // self.sample_rate) // 1000
+        return {'timestamp': timestamp, 'sequence': sequence, 'length': count, 'audio': audio,
+                'samplePosition': position, 'resync': bool(flags & 0x01),
+                'replay': bool(flags & 0x02), 'gap': bool(flags & 0x04)}, size
+
     def handle_audio_data(self, data):
         """處理音訊數據"""
         if 'audio' in data and 'timestamp' in data:
             # 將音訊數據轉換為 numpy 陣列
             audio_samples = np.array(data['audio'], dtype=np.int16)
             timestamp = data['timestamp']
+
+            # 依樣本位置以靜音補上遺失的樣本 (最多 0.5 秒)，時間軸不因遺失而縮短
+            position = data.get('samplePosition')
+            if position is not None:
+                if data.get('resync') or self.next_position is None or position < self.next_position:
+                    self.next_position = position
+                missing = position - self.next_position
+                if 0 < missing <= self.sample_rate // 2:
+                    silence = np.zeros(missing, dtype=np.int16)
+                    self.play_buffer.extend(silence.astype(np.float32))
+                    self.wave_buffer.extend(silence.astype(np.float32))
+                    if self.saving and self.wav_file:
+                        self.wav_file.writeframes(silence.tobytes())
+                    self.stats['samples_filled'] += missing
+                self.next_position = position + len(audio_samples)
             
             # 正規化到 [-1, 1] 範圍供播放使用
             audio_float = audio_samples.astype(np.float32) / 32768.0
@@ -142,6 +243,12 @@ class ESP32AudioReceiver:
     
     def handle_status_data(self, data):
         """處理狀態數據"""
+        if 'ack' in data:
+            # configure / resetConfig 的確認
+            result = "已套用" if data.get('ok') else f"被拒絕 ({data.get('field')})"
+            print(f"⚙️ {data['ack']} {result}")
+            return
+
         status = data.get('status', 'unknown')
         publishing = data.get('publishing', False)
         feature_extraction = data.get('featureExtraction', False)
@@ -1,300 +1,495 @@
 #include "AudioFeatureExtractor.h"
 
-AudioFeatureExtractor::AudioFeatureExtractor()
+// 成員函數定義共用的模板前綴
+#define AFE_TEMPLATE template <uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks, uint8_t MfccCoeffs, uint16_t FrameSize, uint16_t HopSize>
+#define AFE_CLASS AudioFeatureExtractorT<SampleRate, FftSize, MelBanks, MfccCoeffs, FrameSize, HopSize>
+
+AFE_TEMPLATE
+AFE_CLASS::AudioFeatureExtractorT()
 {
-    // 初始化指針
-    vReal = nullptr;
-    vImag = nullptr;
-    powerSpectrum = nullptr;
-    bufferIndex = 0;
+    ringWritePos = 0;
+    samplesUntilFrame = FRAME_SIZE;
+    hopSize = HOP_SIZE;
+    frameCount = 0;
+    frameInputEnd = 0;
+    frameCallback = nullptr;
+    frameCallbackContext = nullptr;
+    useRealFFT = AUDIO_FEATURE_REAL_FFT;
+    useFixedPoint = AUDIO_FEATURE_FIXED_POINT;
 
     // 清零緩衝區
+    memset(vReal, 0, sizeof(vReal));
+    memset(vImag, 0, sizeof(vImag));
+    memset(powerSpectrum, 0, sizeof(powerSpectrum));
+    memset(ringBuffer, 0, sizeof(ringBuffer));
     memset(audioBuffer, 0, sizeof(audioBuffer));
     memset(melEnergies, 0, sizeof(melEnergies));
     memset(mfccCoeffs, 0, sizeof(mfccCoeffs));
+    memset(&timing, 0, sizeof(timing));
 }
 
-AudioFeatureExtractor::~AudioFeatureExtractor()
-{
-    if (vReal)
-    {
-        delete[] vReal;
-        vReal = nullptr;
-    }
-    if (vImag)
-    {
-        delete[] vImag;
-        vImag = nullptr;
-    }
-    if (powerSpectrum)
-    {
-        delete[] powerSpectrum;
-        powerSpectrum = nullptr;
-    }
-}
-
-bool AudioFeatureExtractor::begin()
+AFE_TEMPLATE
+bool AFE_CLASS::begin()
 {
     Serial.println("正在初始化音訊特徵提取器...");
 
-    // 分配FFT內存
-    vReal = new (std::nothrow) double[FFT_SIZE];
-    vImag = new (std::nothrow) double[FFT_SIZE];
-    powerSpectrum = new (std::nothrow) double[FFT_SIZE / 2 + 1];
-
-    if (!vReal || !vImag || !powerSpectrum)
-    {
-        Serial.println("✗ FFT 內存分配失敗");
-        return false;
-    }
-
-    // 初始化FFT數組
-    for (int i = 0; i < FFT_SIZE; i++)
-    {
-        vReal[i] = 0.0;
-        vImag[i] = 0.0;
-    }
-
-    for (int i = 0; i <= FFT_SIZE / 2; i++)
-    {
-        powerSpectrum[i] = 0.0;
-    }
-
-    // 初始化梅爾濾波器組
-    initMelFilters();
+    // 緩衝區為固定大小成員、查表於編譯期產生，這裡只需清零狀態
+    reset();
+    resetTiming();
 
-    Serial.println("✓ 音訊特徵提取器初始化成功");
+    Serial.printf("✓ 音訊特徵提取器初始化成功 (%u Hz, FFT %d, %d 個梅爾濾波器, %d 個非零權重, %s引擎)\n",
+                  (unsigned)SAMPLE_RATE, FFT_SIZE, MEL_FILTER_BANKS, melBank.weightCount,
+                  useFixedPoint ? "整數" : "浮點");
     return true;
 }
 
-void AudioFeatureExtractor::initMelFilters()
+AFE_TEMPLATE
+int AFE_CLASS::processAudioFrame(int16_t *audio, int length)
 {
-    Serial.println("正在初始化梅爾濾波器組...");
+    int frames = 0;
+    int offset = 0;
 
-    // 清零梅爾濾波器
-    for (int i = 0; i < MEL_FILTER_BANKS; i++)
+    while (offset < length)
     {
-        for (int j = 0; j <= FFT_SIZE / 2; j++)
+        // 一次複製到「幀完成」或「環形緩衝區繞回」為止
+        int chunk = min(length - offset, (int)samplesUntilFrame);
+        chunk = min(chunk, (int)(FRAME_SIZE - ringWritePos));
+
+        memcpy(ringBuffer + ringWritePos, audio + offset, chunk * sizeof(int16_t));
+        offset += chunk;
+        ringWritePos += chunk;
+        if (ringWritePos >= FRAME_SIZE)
         {
-            melFilters[i][j] = 0.0;
+            ringWritePos = 0;
         }
-    }
-
-    // 計算梅爾刻度的頻率邊界
-    double lowFreq = 0.0;
-    double highFreq = SAMPLE_RATE / 2.0;
-    double lowMel = melScale(lowFreq);
-    double highMel = melScale(highFreq);
-
-    // 等間距梅爾點
-    double melPoints[MEL_FILTER_BANKS + 2];
-    for (int i = 0; i < MEL_FILTER_BANKS + 2; i++)
-    {
-        melPoints[i] = lowMel + (highMel - lowMel) * i / (MEL_FILTER_BANKS + 1);
-    }
+        samplesUntilFrame -= chunk;
 
-    // 轉換回頻率
-    double freqPoints[MEL_FILTER_BANKS + 2];
-    for (int i = 0; i < MEL_FILTER_BANKS + 2; i++)
-    {
-        freqPoints[i] = invMelScale(melPoints[i]);
-    }
-
-    // 創建三角形濾波器
-    for (int m = 0; m < MEL_FILTER_BANKS; m++)
-    {
-        double leftFreq = freqPoints[m];
-        double centerFreq = freqPoints[m + 1];
-        double rightFreq = freqPoints[m + 2];
-
-        for (int k = 0; k <= FFT_SIZE / 2; k++)
+        if (samplesUntilFrame == 0)
         {
-            double freq = k * SAMPLE_RATE / (double)FFT_SIZE;
-
-            if (freq >= leftFreq && freq <= centerFreq)
+            // 環形緩衝區已滿，寫入位置即最舊樣本；展開成時間順序的線性幀
+            int tail = FRAME_SIZE - ringWritePos;
+            memcpy(audioBuffer, ringBuffer + ringWritePos, tail * sizeof(int16_t));
+            memcpy(audioBuffer + tail, ringBuffer, ringWritePos * sizeof(int16_t));
+            samplesUntilFrame = hopSize;
+            frameInputEnd = offset;
+            frameCount++;
+
+            extractFeatures();
+            frames++;
+
+            if (frameCallback)
             {
-                melFilters[m][k] = (freq - leftFreq) / (centerFreq - leftFreq);
-            }
-            else if (freq >= centerFreq && freq <= rightFreq)
-            {
-                melFilters[m][k] = (rightFreq - freq) / (rightFreq - centerFreq);
+                frameCallback(this, frameCallbackContext);
             }
         }
     }
 
-    Serial.printf("✓ %d 個梅爾濾波器初始化完成\n", MEL_FILTER_BANKS);
+    return frames;
 }
 
-double AudioFeatureExtractor::melScale(double freq)
+AFE_TEMPLATE
+void AFE_CLASS::loadFrame()
 {
-    return 2595.0 * log10(1.0 + freq / 700.0);
-}
+    // 正規化到 [-1, 1] 並套用漢明視窗 (兩者已合併在 windowTable)
+    // 同一次掃描順便累計過零次數與平方和
+    const feature_t scale = (feature_t)1.0 / (feature_t)32768.0;
+    int zeroCrossings = 0;
+    feature_t sumSquares = 0;
+    bool previousNegative = audioBuffer[0] < 0;
 
-double AudioFeatureExtractor::invMelScale(double mel)
-{
-    return 700.0 * (pow(10.0, mel / 2595.0) - 1.0);
-}
+    for (int i = 0; i < FRAME_SIZE; i++)
+    {
+        int16_t sample = audioBuffer[i];
+        vReal[i] = (feature_t)sample * windowTable[i];
+        vImag[i] = 0;
 
-void AudioFeatureExtractor::applyHammingWindow(double *signal, int length)
-{
-    for (int i = 0; i < length; i++)
+        bool negative = sample < 0;
+        zeroCrossings += (negative != previousNegative);
+        previousNegative = negative;
+
+        feature_t normalized = (feature_t)sample * scale;
+        sumSquares += normalized * normalized;
+    }
+
+    stats.zeroCrossingRate = (feature_t)zeroCrossings / (feature_t)(FRAME_SIZE - 1);
+    stats.rmsEnergy = sqrt(sumSquares / (feature_t)FRAME_SIZE);
+
+    // 填充零至FFT大小
+    for (int i = FRAME_SIZE; i < FFT_SIZE; i++)
     {
-        signal[i] *= (0.54 - 0.46 * cos(2.0 * PI * i / (length - 1)));
+        vReal[i] = 0;
+        vImag[i] = 0;
     }
 }
 
-bool AudioFeatureExtractor::processAudioFrame(int16_t *audio, int length)
+AFE_TEMPLATE
+void AFE_CLASS::computeFFT()
 {
-    for (int i = 0; i < length && bufferIndex < FRAME_SIZE; i++)
+    if (useRealFFT)
+    {
+        computeRealFFT();
+    }
+    else
     {
-        audioBuffer[bufferIndex++] = audio[i];
+        computeComplexFFT();
     }
+}
 
-    return isFrameReady();
+AFE_TEMPLATE
+void AFE_CLASS::computeComplexFFT()
+{
+    FFT.windowing(vReal, FFT_SIZE, FFT_WIN_TYP_RECTANGLE, FFT_FORWARD);
+    FFT.compute(vReal, vImag, FFT_SIZE, FFT_FORWARD);
 }
 
-bool AudioFeatureExtractor::isFrameReady()
+AFE_TEMPLATE
+void AFE_CLASS::computeRealFFT()
 {
-    return bufferIndex >= FRAME_SIZE;
+    // 打包 → FFT_SIZE/2 點複數 FFT → 展開 (打包與展開見 RealFft.h)
+    packRealFftInput<feature_t, FftSize>(vReal, vImag);
+    FFT.compute(vReal, vImag, FFT_SIZE / 2, FFT_FORWARD);
+    unpackRealFftSpectrum<feature_t, FftSize>(vReal, vImag, rfftCos, rfftSin);
 }
 
-void AudioFeatureExtractor::extractFeatures()
+AFE_TEMPLATE
+void AFE_CLASS::extractFeatures()
 {
-    if (!isFrameReady())
+    if (frameCount == 0)
     {
-        return;
+        return; // 尚無完整的幀
     }
 
-    // 將音訊數據轉換為double並應用視窗函數
-    for (int i = 0; i < FRAME_SIZE && i < FFT_SIZE; i++)
+    if (useFixedPoint)
     {
-        vReal[i] = (double)audioBuffer[i] / 32768.0; // 正規化到 [-1, 1]
-        vImag[i] = 0.0;
+        extractFeaturesFixedPoint();
+        return;
     }
 
-    // 填充零至FFT大小
-    for (int i = FRAME_SIZE; i < FFT_SIZE; i++)
-    {
-        vReal[i] = 0.0;
-        vImag[i] = 0.0;
-    }
+    uint32_t t0 = ESP.getCycleCount();
 
-    // 應用漢明視窗
-    applyHammingWindow(vReal, FRAME_SIZE);
+    // 轉換並加窗
+    loadFrame();
+    uint32_t t1 = ESP.getCycleCount();
 
     // 執行FFT
-    FFT.windowing(vReal, FFT_SIZE, FFT_WIN_TYP_RECTANGLE, FFT_FORWARD);
-    FFT.compute(vReal, vImag, FFT_SIZE, FFT_FORWARD);
+    computeFFT();
+    uint32_t t2 = ESP.getCycleCount();
 
     // 計算功率譜
     computePowerSpectrum();
+    uint32_t t3 = ESP.getCycleCount();
 
     // 應用梅爾濾波器
     applyMelFilters();
+    uint32_t t4 = ESP.getCycleCount();
 
     // 計算MFCC
     computeMFCC();
+    uint32_t t5 = ESP.getCycleCount();
+
+    timing.windowCycles += t1 - t0;
+    timing.fftCycles += t2 - t1;
+    timing.powerCycles += t3 - t2;
+    timing.melCycles += t4 - t3;
+    timing.dctCycles += t5 - t4;
+    timing.frames++;
+}
+
+AFE_TEMPLATE
+void AFE_CLASS::benchmarkFFT(int iterations)
+{
+    if (iterations <= 0)
+    {
+        return;
+    }
 
-    // 移動緩衝區 (重疊處理)
-    memmove(audioBuffer, audioBuffer + HOP_SIZE, (FRAME_SIZE - HOP_SIZE) * sizeof(int16_t));
-    bufferIndex -= HOP_SIZE;
-    if (bufferIndex < 0)
-        bufferIndex = 0;
+    Serial.printf("=== FFT 基準測試 (%d 次) ===\n", iterations);
+
+    // 完整複數 FFT (原 FFT.compute 路徑)
+    uint32_t complexCycles = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        loadFrame();
+        uint32_t start = ESP.getCycleCount();
+        computeComplexFFT();
+        complexCycles += ESP.getCycleCount() - start;
+    }
+
+    // 實數打包 FFT
+    uint32_t realCycles = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        loadFrame();
+        uint32_t start = ESP.getCycleCount();
+        computeRealFFT();
+        realCycles += ESP.getCycleCount() - start;
+    }
+
+    Serial.printf("複數 FFT: %u 週期/幀\n", complexCycles / iterations);
+    Serial.printf("實數 FFT: %u 週期/幀\n", realCycles / iterations);
+    if (realCycles > 0)
+    {
+        Serial.printf("加速比: %.2fx\n", (double)complexCycles / realCycles);
+    }
+    Serial.println("===============");
 }
 
-void AudioFeatureExtractor::computePowerSpectrum()
+AFE_TEMPLATE
+void AFE_CLASS::computePowerSpectrum()
 {
+    accumulateSpectrum([this](int i) { return vReal[i] * vReal[i] + vImag[i] * vImag[i]; });
+}
+
+AFE_TEMPLATE
+template <typename PowerAt>
+void AFE_CLASS::accumulateSpectrum(PowerAt powerAt)
+{
+    // 第一次掃描：功率譜 + 重心/平坦度/總能量所需的累加量，並保存前綴和供滾降點使用
+    const feature_t binHz = (feature_t)SAMPLE_RATE / (feature_t)FFT_SIZE;
+    feature_t totalEnergy = 0;
+    feature_t weightedSum = 0; // Σ k·P
+    feature_t logMantissa = 1;   // Π P 以 尾數 × 2^指數 累乘，避免逐頻點呼叫 log
+    int logExponent = 0;
+
     for (int i = 0; i <= FFT_SIZE / 2; i++)
     {
-        powerSpectrum[i] = vReal[i] * vReal[i] + vImag[i] * vImag[i];
+        feature_t power = powerAt(i);
 
         // 避免對數運算時的零值
-        if (powerSpectrum[i] < 1e-10)
+        if (power < (feature_t)1e-10)
         {
-            powerSpectrum[i] = 1e-10;
+            power = (feature_t)1e-10;
         }
+        powerSpectrum[i] = power;
+
+        if (i == 0)
+        {
+            cumulativeEnergy[0] = 0;
+            continue;
+        }
+
+        feature_t k = (feature_t)i;
+        totalEnergy += power;
+        weightedSum += k * power;
+        cumulativeEnergy[i] = totalEnergy;
+
+        int exponent;
+        logMantissa = frexp(logMantissa * power, &exponent);
+        logExponent += exponent;
+    }
+
+    const int bins = FFT_SIZE / 2;
+    stats.totalEnergy = totalEnergy;
+
+    if (totalEnergy > 0)
+    {
+        feature_t meanBin = weightedSum / totalEnergy;
+        stats.centroid = meanBin * binHz;
+
+        // 第二次掃描：Σ (k - 重心)²·P。Σ k²·P / E - 重心² 在窄頻訊號 (重心大、帶寬小) 時兩項幾乎相等，
+        // float 相減後只剩捨入誤差，因此以重心為中心重新累加
+        feature_t spreadSum = 0;
+        for (int i = 1; i <= bins; i++)
+        {
+            feature_t offset = (feature_t)i - meanBin;
+            spreadSum += offset * offset * powerSpectrum[i];
+        }
+        stats.bandwidth = sqrt(spreadSum / totalEnergy) * binHz;
+
+        // 幾何平均 = exp((ln(尾數) + 指數·ln2) / N)
+        feature_t logGeoMean = (log(logMantissa) + (feature_t)logExponent * (feature_t)0.69314718) / (feature_t)bins;
+        stats.flatness = exp(logGeoMean) / (totalEnergy / (feature_t)bins);
+
+        // 二分搜尋第一個累積能量達門檻的頻點
+        feature_t threshold = (feature_t)SPECTRAL_ROLLOFF_RATIO * totalEnergy;
+        int low = 1;
+        int high = bins;
+        while (low < high)
+        {
+            int mid = (low + high) / 2;
+            if (cumulativeEnergy[mid] >= threshold)
+            {
+                high = mid;
+            }
+            else
+            {
+                low = mid + 1;
+            }
+        }
+        stats.rolloff = (feature_t)low * binHz;
+    }
+    else
+    {
+        stats.centroid = 0;
+        stats.bandwidth = 0;
+        stats.flatness = 0;
+        stats.rolloff = 0;
     }
 }
 
-void AudioFeatureExtractor::applyMelFilters()
+AFE_TEMPLATE
+void AFE_CLASS::applyMelFilters()
 {
     for (int m = 0; m < MEL_FILTER_BANKS; m++)
     {
-        melEnergies[m] = 0.0;
+        const MelFilterRange &range = melBank.ranges[m];
+        const feature_t *spectrum = powerSpectrum + range.startBin;
+        const feature_t *weights = melBank.weights + range.weightOffset;
 
-        for (int k = 0; k <= FFT_SIZE / 2; k++)
+        feature_t energy = 0;
+        for (int k = 0; k < range.length; k++)
         {
-            melEnergies[m] += powerSpectrum[k] * melFilters[m][k];
+            energy += spectrum[k] * weights[k];
         }
 
         // 轉換為對數能量
-        if (melEnergies[m] > 0)
+        if (energy > 0)
         {
-            melEnergies[m] = log(melEnergies[m]);
+            melEnergies[m] = log(energy);
         }
         else
         {
-            melEnergies[m] = -10.0; // 避免 log(0)
+            melEnergies[m] = (feature_t)-10.0; // 避免 log(0)
         }
     }
 }
 
-void AudioFeatureExtractor::computeMFCC()
+AFE_TEMPLATE
+void AFE_CLASS::computeMFCC()
 {
-    // 離散餘弦變換 (DCT) 計算MFCC係數
+    // 離散餘弦變換 (DCT) 計算MFCC係數，係數全部來自 dctTable
     for (int i = 0; i < MFCC_COEFFS; i++)
     {
-        mfccCoeffs[i] = 0.0;
+        const feature_t *basis = dctTable.data() + i * MEL_FILTER_BANKS;
+        feature_t sum = 0;
 
         for (int j = 0; j < MEL_FILTER_BANKS; j++)
         {
-            mfccCoeffs[i] += melEnergies[j] * cos(PI * i * (j + 0.5) / MEL_FILTER_BANKS);
+            sum += melEnergies[j] * basis[j];
         }
 
-        if (i == 0)
-        {
-            mfccCoeffs[i] *= sqrt(1.0 / MEL_FILTER_BANKS);
-        }
-        else
-        {
-            mfccCoeffs[i] *= sqrt(2.0 / MEL_FILTER_BANKS);
-        }
+        mfccCoeffs[i] = sum;
     }
 }
 
-double AudioFeatureExtractor::computeSpectralCentroid()
+AFE_TEMPLATE
+void AFE_CLASS::extractFeaturesFixedPoint()
 {
-    double weightedSum = 0.0;
-    double totalEnergy = 0.0;
-
-    for (int i = 1; i <= FFT_SIZE / 2; i++)
+    uint32_t t0 = ESP.getCycleCount();
+
+    // 時域統計
+    stats.zeroCrossingRate = computeZeroCrossingRate(audioBuffer, FRAME_SIZE);
+    stats.rmsEnergy = computeRMSEnergy(audioBuffer, FRAME_SIZE);
+    uint32_t t1 = ESP.getCycleCount();
+
+    // 整數引擎：加窗、FFT、功率譜、梅爾濾波、DCT
+    fixedEngine.compute(audioBuffer);
+    uint32_t t2 = ESP.getCycleCount();
+
+    // 整數功率譜換算回浮點尺度，沿用同一次掃描計算頻譜統計
+    const uint64_t *power = fixedEngine.getPowerSpectrum();
+    const feature_t powerScale = (feature_t)fixedEngine.getPowerScale();
+    accumulateSpectrum([power, powerScale](int i) { return (feature_t)power[i] * powerScale; });
+    uint32_t t3 = ESP.getCycleCount();
+
+    // Q16 → feature_t
+    const feature_t q16 = (feature_t)1.0 / (feature_t)Q16_ONE;
+    const int32_t *logMel = fixedEngine.getLogMelQ16();
+    for (int m = 0; m < MEL_FILTER_BANKS; m++)
     {
-        double freq = i * SAMPLE_RATE / (double)FFT_SIZE;
-        weightedSum += freq * powerSpectrum[i];
-        totalEnergy += powerSpectrum[i];
+        melEnergies[m] = (feature_t)logMel[m] * q16;
     }
+    uint32_t t4 = ESP.getCycleCount();
 
-    return (totalEnergy > 0) ? weightedSum / totalEnergy : 0.0;
+    const int32_t *mfcc = fixedEngine.getMfccQ16();
+    for (int i = 0; i < MFCC_COEFFS; i++)
+    {
+        mfccCoeffs[i] = (feature_t)mfcc[i] * q16;
+    }
+    uint32_t t5 = ESP.getCycleCount();
+
+    timing.windowCycles += t1 - t0;
+    timing.fftCycles += t2 - t1;
+    timing.powerCycles += t3 - t2;
+    timing.melCycles += t4 - t3;
+    timing.dctCycles += t5 - t4;
+    timing.frames++;
 }
 
-double AudioFeatureExtractor::computeSpectralBandwidth()
+AFE_TEMPLATE
+void AFE_CLASS::benchmarkFixedPoint(int iterations)
 {
-    double centroid = computeSpectralCentroid();
-    double weightedSum = 0.0;
-    double totalEnergy = 0.0;
+    if (iterations <= 0 || frameCount == 0)
+    {
+        Serial.println("⚠️ 尚無可比較的幀");
+        return;
+    }
+
+    Serial.printf("=== 整數引擎基準測試 (%d 次) ===\n", iterations);
 
-    for (int i = 1; i <= FFT_SIZE / 2; i++)
+    // 浮點路徑 (加窗 ~ DCT)
+    uint32_t floatCycles = 0;
+    for (int i = 0; i < iterations; i++)
     {
-        double freq = i * SAMPLE_RATE / (double)FFT_SIZE;
-        double deviation = freq - centroid;
-        weightedSum += deviation * deviation * powerSpectrum[i];
-        totalEnergy += powerSpectrum[i];
+        uint32_t start = ESP.getCycleCount();
+        loadFrame();
+        computeFFT();
+        computePowerSpectrum();
+        applyMelFilters();
+        computeMFCC();
+        floatCycles += ESP.getCycleCount() - start;
     }
 
-    return (totalEnergy > 0) ? sqrt(weightedSum / totalEnergy) : 0.0;
+    // 整數參考實作與最佳化實作
+    uint32_t referenceCycles = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        uint32_t start = ESP.getCycleCount();
+        fixedEngine.computeReference(audioBuffer);
+        referenceCycles += ESP.getCycleCount() - start;
+    }
+
+    uint32_t fixedCycles = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        uint32_t start = ESP.getCycleCount();
+        fixedEngine.compute(audioBuffer);
+        fixedCycles += ESP.getCycleCount() - start;
+    }
+
+    bool bitExact = fixedEngine.verifyBitExact(audioBuffer);
+
+    // 與浮點路徑 (AUDIO_FEATURE_PRECISION_DOUBLE 時即雙精度參考) 的 MFCC 偏差
+    const int32_t *mfcc = fixedEngine.getMfccQ16();
+    double maxDeviation = 0;
+    for (int i = 0; i < MFCC_COEFFS; i++)
+    {
+        double deviation = fabs((double)mfcc[i] / Q16_ONE - (double)mfccCoeffs[i]);
+        if (deviation > maxDeviation)
+        {
+            maxDeviation = deviation;
+        }
+    }
+
+    Serial.printf("浮點路徑: %u 週期/幀\n", floatCycles / iterations);
+    Serial.printf("整數參考: %u 週期/幀\n", referenceCycles / iterations);
+    Serial.printf("整數最佳化: %u 週期/幀\n", fixedCycles / iterations);
+    if (fixedCycles > 0)
+    {
+        Serial.printf("加速比 (浮點/整數): %.2fx\n", (double)floatCycles / fixedCycles);
+    }
+    Serial.printf("%s 參考與最佳化實作%s\n", bitExact ? "✓" : "✗", bitExact ? "逐位元一致" : "輸出不一致");
+    Serial.printf("MFCC 最大偏差: %.5f (區塊指數 %d)\n", maxDeviation, fixedEngine.getFrameExponent());
+    Serial.println("===============");
+
+    // 依目前引擎重新計算，恢復本幀結果 (不計入階段計時)
+    FeatureStageTiming savedTiming = timing;
+    extractFeatures();
+    timing = savedTiming;
 }
 
-double AudioFeatureExtractor::computeZeroCrossingRate(int16_t *audio, int length)
+AFE_TEMPLATE
+feature_t AFE_CLASS::computeZeroCrossingRate(int16_t *audio, int length)
 {
     int zeroCrossings = 0;
 
@@ -306,23 +501,26 @@ double AudioFeatureExtractor::computeZeroCrossingRate(int16_t *audio, int length
         }
     }
 
-    return (double)zeroCrossings / (length - 1);
+    return (feature_t)zeroCrossings / (feature_t)(length - 1);
 }
 
-double AudioFeatureExtractor::computeRMSEnergy(int16_t *audio, int length)
+AFE_TEMPLATE
+feature_t AFE_CLASS::computeRMSEnergy(int16_t *audio, int length)
 {
-    double sumSquares = 0.0;
+    const feature_t scale = (feature_t)1.0 / (feature_t)32768.0;
+    feature_t sumSquares = 0;
 
     for (int i = 0; i < length; i++)
     {
-        double sample = audio[i] / 32768.0;
+        feature_t sample = (feature_t)audio[i] * scale;
         sumSquares += sample * sample;
     }
 
-    return sqrt(sumSquares / length);
+    return sqrt(sumSquares / (feature_t)length);
 }
 
-void AudioFeatureExtractor::getFeatureVector(double *features, int maxLength)
+AFE_TEMPLATE
+void AFE_CLASS::getFeatureVector(feature_t *features, int maxLength)
 {
     int index = 0;
 
@@ -333,23 +531,24 @@ void AudioFeatureExtractor::getFeatureVector(double *features, int maxLength)
     }
 
     // 梅爾能量 (前幾個)
-    for (int i = 0; i < min(6, MEL_FILTER_BANKS) && index < maxLength; i++)
+    for (int i = 0; i < min(6, (int)MEL_FILTER_BANKS) && index < maxLength; i++)
     {
         features[index++] = melEnergies[i];
     }
 
     // 額外特徵
     if (index < maxLength)
-        features[index++] = computeSpectralCentroid();
+        features[index++] = stats.centroid;
     if (index < maxLength)
-        features[index++] = computeSpectralBandwidth();
+        features[index++] = stats.bandwidth;
     if (index < maxLength)
-        features[index++] = computeZeroCrossingRate(audioBuffer, FRAME_SIZE);
+        features[index++] = stats.zeroCrossingRate;
     if (index < maxLength)
-        features[index++] = computeRMSEnergy(audioBuffer, FRAME_SIZE);
+        features[index++] = stats.rmsEnergy;
 }
 
-void AudioFeatureExtractor::printFeatures()
+AFE_TEMPLATE
+void AFE_CLASS::printFeatures()
 {
     Serial.println("=== 音訊特徵 ===");
 
@@ -361,23 +560,93 @@ void AudioFeatureExtractor::printFeatures()
     Serial.println();
 
     Serial.print("梅爾能量 (前8個): ");
-    for (int i = 0; i < min(8, MEL_FILTER_BANKS); i++)
+    for (int i = 0; i < min(8, (int)MEL_FILTER_BANKS); i++)
     {
         Serial.printf("%.3f ", melEnergies[i]);
     }
     Serial.println();
 
-    Serial.printf("頻譜重心: %.2f Hz\n", computeSpectralCentroid());
-    Serial.printf("頻譜帶寬: %.2f Hz\n", computeSpectralBandwidth());
-    Serial.printf("過零率: %.4f\n", computeZeroCrossingRate(audioBuffer, FRAME_SIZE));
-    Serial.printf("RMS能量: %.4f\n", computeRMSEnergy(audioBuffer, FRAME_SIZE));
+    Serial.printf("頻譜重心: %.2f Hz\n", stats.centroid);
+    Serial.printf("頻譜帶寬: %.2f Hz\n", stats.bandwidth);
+    Serial.printf("頻譜滾降: %.2f Hz\n", stats.rolloff);
+    Serial.printf("頻譜平坦度: %.4f\n", stats.flatness);
+    Serial.printf("過零率: %.4f\n", stats.zeroCrossingRate);
+    Serial.printf("RMS能量: %.4f\n", stats.rmsEnergy);
     Serial.println("===============");
 }
 
-void AudioFeatureExtractor::reset()
+AFE_TEMPLATE
+void AFE_CLASS::printTimingReport()
 {
-    bufferIndex = 0;
+    Serial.println("=== 特徵提取階段計時 ===");
+
+    if (timing.frames == 0)
+    {
+        Serial.println("尚無已處理的幀");
+        Serial.println("===============");
+        return;
+    }
+
+    const double cyclesPerUs = ESP.getCpuFreqMHz();
+    const uint64_t stages[] = {timing.windowCycles, timing.fftCycles, timing.powerCycles,
+                               timing.melCycles, timing.dctCycles};
+    const char *names[] = {"視窗+時域", "FFT", "功率譜+統計", "梅爾濾波", "DCT (查表)"};
+    uint64_t total = 0;
+
+    for (int i = 0; i < 5; i++)
+    {
+        double cycles = (double)stages[i] / timing.frames;
+        Serial.printf("%-12s %8.0f 週期/幀  %7.1f us/幀\n", names[i], cycles, cycles / cyclesPerUs);
+        total += stages[i];
+    }
+
+    double totalCycles = (double)total / timing.frames;
+    Serial.printf("%-12s %8.0f 週期/幀  %7.1f us/幀 (%u 幀)\n", "總計", totalCycles,
+                  totalCycles / cyclesPerUs, timing.frames);
+    if (useFixedPoint)
+    {
+        Serial.println("整數引擎：FFT 列包含加窗~DCT 全流程，梅爾/DCT 列僅為 Q16 轉換");
+    }
+    Serial.println("===============");
+}
+
+AFE_TEMPLATE
+void AFE_CLASS::resetTiming()
+{
+    memset(&timing, 0, sizeof(timing));
+}
+
+AFE_TEMPLATE
+bool AFE_CLASS::setHopSize(uint16_t hop)
+{
+    if (hop == 0 || hop > FRAME_SIZE)
+    {
+        return false;
+    }
+    hopSize = hop;
+    return true;
+}
+
+AFE_TEMPLATE
+void AFE_CLASS::resync()
+{
+    ringWritePos = 0;
+    samplesUntilFrame = FRAME_SIZE;
+}
+
+AFE_TEMPLATE
+void AFE_CLASS::reset()
+{
+    ringWritePos = 0;
+    samplesUntilFrame = FRAME_SIZE;
+    frameCount = 0;
+    memset(ringBuffer, 0, sizeof(ringBuffer));
     memset(audioBuffer, 0, sizeof(audioBuffer));
     memset(melEnergies, 0, sizeof(melEnergies));
     memset(mfccCoeffs, 0, sizeof(mfccCoeffs));
+    memset(&stats, 0, sizeof(stats));
 }
+
+// 顯式實例化支援的設定檔
+template class AudioFeatureExtractorT<16000, 512, 26, 13, 400, 160>;
+template class AudioFeatureExtractorT<8000, 256, 20, 13, 200, 80>;
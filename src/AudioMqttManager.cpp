@@ -1,13 +1,35 @@
 #include "AudioMqttManager.h"
+#include "lwip/sockets.h"
+#include "lwip/dns.h"
+#include "lwip/tcpip.h"
+#include <Preferences.h>
+#include <sys/time.h>
 
 // 靜態實例指針，用於回調函數
 AudioMqttManager *AudioMqttManager_instance = nullptr;
 
+// JSON 訊息的 timestamp (ms)：由樣本位置推得；已校時為 Unix 時間，否則為串流開始後的時間
+static uint64_t sampleClockMillis(uint64_t position, uint64_t epochMicros, uint32_t sampleRate)
+{
+    return (epochMicros + position * 1000000ULL / sampleRate) / 1000;
+}
+
 AudioMqttManager::AudioMqttManager()
-    : mqttClient(wifiClient), featureExtractor(nullptr), audioQueue(nullptr), mfccQueue(nullptr), melQueue(nullptr), featuresQueue(nullptr), mqttMutex(nullptr), mqttTaskHandle(nullptr), audioPublishTaskHandle(nullptr), featurePublishTaskHandle(nullptr), mqttServer(nullptr), mqttPort(1883), mqttUser(nullptr), mqttPassword(nullptr), clientId("ESP32_Audio"), isConnected(false), isPublishing(false), isFeatureExtractionEnabled(false), currentSequence(0), lastAudioPublish(0), lastFeaturePublish(0), lastReconnectAttempt(0)
+    : mqttClient(wifiClient), featureQueue(nullptr), mqttMutex(nullptr), featureDiscontinuity(false), mqttTaskHandle(nullptr), publisherTaskHandle(nullptr), featureTaskHandle(nullptr), publisherExitSemaphore(nullptr), taskExitSemaphore(nullptr), tasksRunning(false), mqttServer(nullptr), mqttPort(1883), mqttUser(nullptr), mqttPassword(nullptr), clientId("ESP32_Audio"), isConnected(false), isPublishing(false), isFeatureExtractionEnabled(false), currentSequence(0), lastAudioPublish(0), lastFeaturePublish(0), connectionState(MQTT_CONN_BACKOFF), backoff(MQTT_BACKOFF_BASE_MS, MQTT_BACKOFF_MAX_MS), connectStart(0), stateStart(0), nextConnectAttempt(0), connectSocket(-1), dnsAttempt(0), dnsStatus(0), resolvedAddress(0), config(defaultConfig()), requestedConfig(config), configSequence(0), appliedConfigSequence(0), featureHopSamples(AudioFeatureExtractor::HOP_SIZE), audioResyncPending(true), audioSampleRate(AudioFeatureExtractor::SAMPLE_RATE), samplePosition(0), streamEpochMicros(0), sampleClockRestart(true), featureInputPosition(0), featureInputEpoch(0), nextAudioPosition(0), nextFeaturePosition(0), nextSinkFeaturePosition(0), streamTier(STREAM_TIER_RAW), streamTierRequest(STREAM_TIER_REQUEST_NONE), featureSequence(0), audioSinkCount(0), spoolResyncPending(true), replayTokens(0), replayLastRefill(0), frameSendMicros(0), rateWindowStart(0), rateWindowPackets(0)
 {
     // 初始化統計信息
     memset(&stats, 0, sizeof(stats));
+    for (MqttDnsRequest &request : dnsRequests)
+    {
+        request.manager = this;
+        request.attempt = 0;
+    }
+    requestedAck = {nullptr, -1, 0, false};
+    quality.setEnabled(STREAM_QUALITY_ADAPTIVE);
+
+    // 內建 UDP/RTP 傳輸 (由控制命令啟動) 與 WebSocket 串流伺服器 (有客戶端時才送出)
+    addAudioSink(&rtpStream);
+    addAudioSink(&wsStream);
 
     // 設置靜態實例指針
     AudioMqttManager_instance = this;
@@ -40,30 +62,70 @@ bool AudioMqttManager::begin(const char *server, int port,
         return false;
     }
 
+    publisherExitSemaphore = xSemaphoreCreateBinary();
+    taskExitSemaphore = xSemaphoreCreateCounting(2, 0);
+    if (!publisherExitSemaphore || !taskExitSemaphore)
+    {
+        Serial.println("✗ 無法創建任務結束信號量");
+        return false;
+    }
+    tasksRunning = true;
+
     // 創建隊列
-    audioQueue = xQueueCreate(10, sizeof(MqttAudioPacket));
-    mfccQueue = xQueueCreate(20, sizeof(MqttMfccPacket));
-    melQueue = xQueueCreate(20, sizeof(MqttMelPacket));
-    featuresQueue = xQueueCreate(20, sizeof(MqttFeaturesPacket));
+    featureQueue = xQueueCreate(FEATURE_QUEUE_DEPTH, sizeof(MqttFeatureFrame));
 
-    if (!audioQueue || !mfccQueue || !melQueue || !featuresQueue)
+    if (!featureQueue)
     {
         Serial.println("✗ 無法創建 MQTT 隊列");
         return false;
     }
 
+    // 斷線暫存區 (不可用時斷線期間的資料直接丟棄，不影響其他功能)
+    if (!spool.begin())
+    {
+        Serial.println("⚠️ 斷線暫存區不可用，斷線期間的資料將被丟棄");
+    }
+
     // 初始化特徵提取器
-    featureExtractor = new AudioFeatureExtractor();
-    if (!featureExtractor || !featureExtractor->begin())
+    if (!featureExtractor.begin())
     {
         Serial.println("✗ 無法初始化音訊特徵提取器");
         return false;
     }
+    featureExtractor.setFrameCallback(staticFeatureFrameCallback, this);
+
+    // 上次以 persist 儲存的串流設定 (特徵任務啟動後第一個輸入塊即套用跳距)
+    loadPersistedConfig();
+
+    // 特徵提取任務：與麥克風擷取任務不同核心，平時阻塞等待通知
+    BaseType_t featureResult = xTaskCreatePinnedToCore(
+        featureExtractionTask,
+        "Feature_Extract",
+        FEATURE_TASK_STACK_SIZE,
+        this,
+        FEATURE_TASK_PRIORITY,
+        &featureTaskHandle,
+        FEATURE_TASK_CORE);
+
+    if (featureResult != pdPASS)
+    {
+        Serial.println("✗ 無法創建特徵提取任務");
+        return false;
+    }
+
+#if AUDIO_WEBSOCKET_ENABLED
+    // 本地儀表板直接連線，不經過 MQTT 服務器 (失敗不影響 MQTT)
+    if (!wsStream.begin(audioSampleRate))
+    {
+        Serial.println("⚠️ WebSocket 串流伺服器不可用");
+    }
+#endif
 
     // 設置 MQTT 客戶端
     mqttClient.setServer(mqttServer, mqttPort);
     mqttClient.setCallback(staticMqttCallback);
     mqttClient.setBufferSize(MQTT_BUFFER_SIZE);
+    mqttClient.setSocketTimeout(MQTT_HANDSHAKE_TIMEOUT_S);
 
     // 創建任務
     BaseType_t result = xTaskCreatePinnedToCore(
@@ -88,83 +150,275 @@ bool AudioMqttManager::begin(const char *server, int port,
 
 void AudioMqttManager::end()
 {
-    // 停止發布
+    // 停止發布 (等待發布任務自行結束)
     stopPublishing();
 
     // 斷開 MQTT 連接
     disconnect();
 
-    // 刪除任務
-    if (mqttTaskHandle)
+    // 請 MQTT 與特徵任務在迴圈邊界自行結束，逐一等待確認
+    tasksRunning = false;
+    if (featureTaskHandle)
     {
-        vTaskDelete(mqttTaskHandle);
-        mqttTaskHandle = nullptr;
+        xTaskNotifyGive(featureTaskHandle);
     }
-    if (audioPublishTaskHandle)
+    int running = (mqttTaskHandle ? 1 : 0) + (featureTaskHandle ? 1 : 0);
+    while (running > 0 && xSemaphoreTake(taskExitSemaphore, pdMS_TO_TICKS(TASK_EXIT_TIMEOUT_MS)) == pdTRUE)
     {
-        vTaskDelete(audioPublishTaskHandle);
-        audioPublishTaskHandle = nullptr;
+        running--;
     }
-    if (featurePublishTaskHandle)
+    if (running > 0 || publisherTaskHandle)
     {
-        vTaskDelete(featurePublishTaskHandle);
-        featurePublishTaskHandle = nullptr;
+        // 任務仍在執行，之後還會使用下列資源：保留不釋放
+        Serial.printf("⚠️ %d 個任務未在 %d ms 內結束，保留其資源\n", running + (publisherTaskHandle ? 1 : 0),
+                      TASK_EXIT_TIMEOUT_MS);
+        return;
     }
+    mqttTaskHandle = nullptr;
+    featureTaskHandle = nullptr;
+
+    spool.end();
+    rtpStream.end();
+    wsStream.end();
 
     // 清理隊列
-    if (audioQueue)
+    if (featureQueue)
     {
-        vQueueDelete(audioQueue);
-        audioQueue = nullptr;
+        vQueueDelete(featureQueue);
+        featureQueue = nullptr;
     }
-    if (mfccQueue)
+
+    // 清理互斥鎖與信號量
+    if (mqttMutex)
     {
-        vQueueDelete(mfccQueue);
-        mfccQueue = nullptr;
+        vSemaphoreDelete(mqttMutex);
+        mqttMutex = nullptr;
     }
-    if (melQueue)
+    if (publisherExitSemaphore)
     {
-        vQueueDelete(melQueue);
-        melQueue = nullptr;
+        vSemaphoreDelete(publisherExitSemaphore);
+        publisherExitSemaphore = nullptr;
     }
-    if (featuresQueue)
+    if (taskExitSemaphore)
     {
-        vQueueDelete(featuresQueue);
-        featuresQueue = nullptr;
+        vSemaphoreDelete(taskExitSemaphore);
+        taskExitSemaphore = nullptr;
     }
+}
 
-    // 清理互斥鎖
-    if (mqttMutex)
+bool AudioMqttManager::connect()
+{
+    if (isConnected)
+        return true;
+
+    // 不在呼叫端等待：跳過退避，MQTT 任務下一輪立即開始嘗試
+    if (connectionState == MQTT_CONN_BACKOFF)
     {
-        vSemaphoreDelete(mqttMutex);
-        mqttMutex = nullptr;
+        nextConnectAttempt = millis();
+    }
+    return false;
+}
+
+void AudioMqttManager::serviceConnection()
+{
+    uint32_t now = millis();
+
+    switch (connectionState)
+    {
+    case MQTT_CONN_BACKOFF:
+        if ((int32_t)(now - nextConnectAttempt) >= 0 && WiFi.status() == WL_CONNECTED)
+        {
+            startConnectAttempt();
+        }
+        break;
+
+    case MQTT_CONN_RESOLVING:
+    {
+        uint32_t status = dnsStatus.load(std::memory_order_acquire);
+        if (status == (dnsAttempt << 2 | MQTT_DNS_RESOLVED))
+        {
+            if (!startTcpConnect())
+            {
+                failConnectAttempt("無法建立 TCP 連線");
+            }
+        }
+        else if (status == (dnsAttempt << 2 | MQTT_DNS_FAILED))
+        {
+            failConnectAttempt("名稱解析失敗");
+        }
+        else if (now - stateStart >= MQTT_DNS_TIMEOUT_MS)
+        {
+            failConnectAttempt("名稱解析逾時");
+        }
+        break;
+    }
+
+    case MQTT_CONN_TCP:
+    {
+        int result = pollTcpConnect();
+        if (result > 0)
+        {
+            if (!completeMqttHandshake())
+            {
+                failConnectAttempt("MQTT 握手失敗");
+            }
+        }
+        else if (result < 0)
+        {
+            failConnectAttempt("TCP 連線被拒絕");
+        }
+        else if (now - stateStart >= MQTT_TCP_TIMEOUT_MS)
+        {
+            failConnectAttempt("TCP 連線逾時");
+        }
+        break;
+    }
+
+    default:
+        break;
     }
+}
 
-    // 清理特徵提取器
-    if (featureExtractor)
+bool AudioMqttManager::startConnectAttempt()
+{
+    stats.connectAttempts++;
+    connectStart = stateStart = millis();
+    Serial.printf("正在連接到 MQTT 服務器 %s:%d (第 %u 次嘗試)...\n", mqttServer, mqttPort,
+                  backoff.getFailures() + 1);
+
+    // 新的嘗試編號使先前嘗試晚到的回調失效
+    dnsAttempt++;
+    uint32_t tag = dnsAttempt << 2;
+    dnsStatus.store(tag | MQTT_DNS_PENDING, std::memory_order_release);
+
+    // IP 位址直接連線；主機名稱交給 lwIP 執行緒非同步解析 (已快取時在該執行緒內立即完成)
+    IPAddress address;
+    if (address.fromString(mqttServer))
+    {
+        resolvedAddress = (uint32_t)address;
+        dnsStatus.store(tag | MQTT_DNS_RESOLVED, std::memory_order_release);
+    }
+    else
     {
-        delete featureExtractor;
-        featureExtractor = nullptr;
+        MqttDnsRequest &request = dnsRequests[dnsAttempt % MQTT_DNS_REQUEST_SLOTS];
+        request.attempt.store(dnsAttempt, std::memory_order_release);
+        if (tcpip_callback(staticDnsStart, &request) != ERR_OK)
+        {
+            failConnectAttempt("無法提交名稱解析");
+            return false;
+        }
     }
+
+    connectionState = MQTT_CONN_RESOLVING;
+    return true;
 }
 
-bool AudioMqttManager::connect()
+void AudioMqttManager::staticDnsStart(void *context)
 {
-    if (isConnected)
-        return true;
+    // 在 lwIP 執行緒中呼叫：dns_gethostbyname 屬於 raw API，不能從其他任務直接呼叫
+    MqttDnsRequest *request = static_cast<MqttDnsRequest *>(context);
+    uint32_t attempt = request->attempt.load(std::memory_order_acquire);
+    ip_addr_t cached;
+    err_t err = dns_gethostbyname(request->manager->mqttServer, &cached, staticDnsFound, request);
+    if (err == ERR_OK)
+    {
+        request->manager->finishDns(attempt, &cached);
+    }
+    else if (err != ERR_INPROGRESS)
+    {
+        request->manager->finishDns(attempt, nullptr);
+    }
+}
 
-    Serial.printf("正在連接到 MQTT 服務器 %s:%d...\n", mqttServer, mqttPort);
+void AudioMqttManager::staticDnsFound(const char *name, const ip_addr_t *address, void *context)
+{
+    // 在 lwIP 執行緒中呼叫；槽位已被較新的嘗試重用時 attempt 為較新的編號，
+    // 解析的是同一個主機名稱，結果仍然有效
+    MqttDnsRequest *request = static_cast<MqttDnsRequest *>(context);
+    request->manager->finishDns(request->attempt.load(std::memory_order_acquire), address);
+}
 
-    // 設置服務器地址和端口
-    mqttClient.setServer(mqttServer, mqttPort);
+void AudioMqttManager::finishDns(uint32_t attempt, const ip_addr_t *address)
+{
+    // 先認領再寫入位址：過期或已結束的嘗試無法認領，不會覆寫 resolvedAddress
+    uint32_t tag = attempt << 2;
+    uint32_t expected = tag | MQTT_DNS_PENDING;
+    if (!dnsStatus.compare_exchange_strong(expected, tag | MQTT_DNS_CLAIMED, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    if (address)
+    {
+        resolvedAddress = address->u_addr.ip4.addr;
+    }
+    // MQTT 任務可能已在認領後開始下一次嘗試，此時不覆寫新的狀態
+    expected = tag | MQTT_DNS_CLAIMED;
+    dnsStatus.compare_exchange_strong(expected, tag | (address ? MQTT_DNS_RESOLVED : MQTT_DNS_FAILED),
+                                      std::memory_order_acq_rel);
+}
 
-    // 設置回調函數
-    mqttClient.setCallback(staticMqttCallback);
+bool AudioMqttManager::startTcpConnect()
+{
+    connectSocket = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (connectSocket < 0)
+    {
+        return false;
+    }
+    lwip_fcntl(connectSocket, F_SETFL, lwip_fcntl(connectSocket, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in server;
+    memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = resolvedAddress;
+    server.sin_port = htons(mqttPort);
+
+    if (lwip_connect(connectSocket, (struct sockaddr *)&server, sizeof(server)) < 0 && errno != EINPROGRESS)
+    {
+        closeConnectSocket();
+        return false;
+    }
+
+    connectionState = MQTT_CONN_TCP;
+    stateStart = millis();
+    return true;
+}
+
+int AudioMqttManager::pollTcpConnect()
+{
+    // 零逾時 select：只檢查，不等待
+    fd_set writeSet;
+    FD_ZERO(&writeSet);
+    FD_SET(connectSocket, &writeSet);
+    struct timeval timeout = {0, 0};
+
+    int ready = lwip_select(connectSocket + 1, nullptr, &writeSet, nullptr, &timeout);
+    if (ready == 0)
+    {
+        return 0;
+    }
 
-    // 短暫延遲確保WiFi穩定
-    vTaskDelay(pdMS_TO_TICKS(500));
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (ready < 0 || lwip_getsockopt(connectSocket, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0)
+    {
+        return -1;
+    }
+    return 1;
+}
 
-    // 嘗試連接
+bool AudioMqttManager::completeMqttHandshake()
+{
+    // 與 WiFiClient::connect 成功後相同的 socket 設定，之後交給 WiFiClient 管理
+    int enable = 1;
+    struct timeval sendTimeout = {MQTT_HANDSHAKE_TIMEOUT_S, 0};
+    lwip_fcntl(connectSocket, F_SETFL, lwip_fcntl(connectSocket, F_GETFL, 0) & ~O_NONBLOCK);
+    lwip_setsockopt(connectSocket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    lwip_setsockopt(connectSocket, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+    lwip_setsockopt(connectSocket, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+    wifiClient = WiFiClient(connectSocket);
+    connectSocket = -1;
+
+    // TCP 已連線時 PubSubClient 直接送出 CONNECT 並等待 CONNACK (上限 MQTT_HANDSHAKE_TIMEOUT_S)
     bool connected = false;
     if (mqttUser && mqttPassword)
     {
@@ -175,23 +429,51 @@ bool AudioMqttManager::connect()
         connected = mqttClient.connect(clientId);
     }
 
-    if (connected)
+    if (!connected)
     {
-        isConnected = true;
-        Serial.println("✓ MQTT 連接成功");
+        Serial.printf("✗ MQTT 連接失敗，錯誤碼: %d\n", mqttClient.state());
+        wifiClient.stop();
+        return false;
+    }
 
-        // 訂閱控制主題
-        mqttClient.subscribe(MQTT_TOPIC_CONTROL);
+    uint32_t elapsed = millis() - connectStart;
+    isConnected = true;
+    connectionState = MQTT_CONN_CONNECTED;
+    backoff.reset();
+    stats.reconnectCount++;
+    stats.lastConnectMs = elapsed;
+    connectLatency.record(elapsed * 1000);
+    Serial.printf("✓ MQTT 連接成功 (%u ms)\n", elapsed);
 
-        // 發布上線狀態
-        publishStatus();
+    // 重新連線後的第一個二進位封包標記為不連續
+    audioResyncPending = true;
 
-        return true;
-    }
-    else
+    // 訂閱控制主題
+    mqttClient.subscribe(MQTT_TOPIC_CONTROL);
+
+    // 發布上線狀態
+    publishStatus();
+
+    return true;
+}
+
+void AudioMqttManager::failConnectAttempt(const char *reason)
+{
+    closeConnectSocket();
+    stats.connectFailures++;
+
+    uint32_t delay = backoff.next(esp_random());
+    nextConnectAttempt = millis() + delay;
+    connectionState = MQTT_CONN_BACKOFF;
+    Serial.printf("✗ MQTT 連接失敗: %s，%u ms 後重試\n", reason, delay);
+}
+
+void AudioMqttManager::closeConnectSocket()
+{
+    if (connectSocket >= 0)
     {
-        Serial.printf("✗ MQTT 連接失敗，錯誤碼: %d\n", mqttClient.state());
-        return false;
+        lwip_close(connectSocket);
+        connectSocket = -1;
     }
 }
 
@@ -201,6 +483,8 @@ void AudioMqttManager::disconnect()
     {
         mqttClient.disconnect();
         isConnected = false;
+        connectionState = MQTT_CONN_BACKOFF;
+        nextConnectAttempt = millis() + MQTT_BACKOFF_BASE_MS;
         Serial.println("MQTT 已斷開連接");
     }
 }
@@ -213,43 +497,45 @@ bool AudioMqttManager::startPublishing()
         return true;
     }
 
-    if (!isConnected)
+    // 上次停止時發布任務未在時限內結束：再等一次，仍未結束就不建立第二個任務
+    if (publisherTaskHandle && !stopPublishing())
     {
-        Serial.println("✗ MQTT 未連接，無法開始發布");
+        Serial.println("✗ 上一個發布任務尚未結束，無法開始發布");
         return false;
     }
+
+    // 未連線也可以開始：發布任務把資料寫入斷線暫存區，連線建立後補發
+    if (!isConnected)
+    {
+        Serial.println("ℹ️ MQTT 尚未連接，連線前的資料先寫入斷線暫存區");
+    }
     Serial.println("🚀 開始創建 MQTT 發布任務...");
 
+    // 每次開始發布都從最高品質重新評估
+    quality.reset(millis());
+    streamTier = STREAM_TIER_RAW;
+
+    // 新的串流：擷取任務下一塊從樣本位置 0 開始並重新錨定紀元，接收端以重新同步旗標得知
+    sampleClockRestart = true;
+    audioResyncPending = true;
+    nextAudioPosition = nextFeaturePosition = nextSinkFeaturePosition = 0;
+
     // 重要：在創建任務之前設置 isPublishing = true
     // 否則任務啟動後會立即退出
     isPublishing = true;
 
-    // 創建音訊發布任務
-    BaseType_t result1 = xTaskCreatePinnedToCore(
-        audioPublishTask,
-        "Audio_Publish",
-        8192, // 增加堆疊大小
+    // 創建發布任務 (音訊與特徵共用，事件驅動)
+    BaseType_t result = xTaskCreatePinnedToCore(
+        publisherTask,
+        "MQTT_Publish",
+        8192,
         this,
         1, // 降低優先級
-        &audioPublishTaskHandle,
+        &publisherTaskHandle,
         0 // Core 0 (與其他任務分開)
     );
 
-    Serial.printf("音訊發布任務創建結果: %s\n", result1 == pdPASS ? "成功" : "失敗");
-
-    // 創建特徵發布任務
-    BaseType_t result2 = xTaskCreatePinnedToCore(
-        featurePublishTask,
-        "Feature_Publish",
-        8192, // 增加堆疊大小
-        this,
-        1, // 降低優先級
-        &featurePublishTaskHandle,
-        0 // Core 0
-    );
-
-    Serial.printf("特徵發布任務創建結果: %s\n", result2 == pdPASS ? "成功" : "失敗");
-    if (result1 == pdPASS && result2 == pdPASS)
+    if (result == pdPASS)
     {
         Serial.println("✓ 音訊發布已開始");
         return true;
@@ -258,29 +544,27 @@ bool AudioMqttManager::startPublishing()
     {
         // 如果任務創建失敗，重置 isPublishing
         isPublishing = false;
-        Serial.printf("✗ 無法創建發布任務 - 音訊: %d, 特徵: %d\n", result1, result2);
+        Serial.printf("✗ 無法創建發布任務: %d\n", result);
         return false;
     }
 }
 
 bool AudioMqttManager::stopPublishing()
 {
-    if (!isPublishing)
-        return true;
-
     isPublishing = false;
+    if (!publisherTaskHandle)
+        return true;
 
-    // 刪除發布任務
-    if (audioPublishTaskHandle)
+    // 發布任務在迴圈邊界看到 isPublishing 已清除後自行結束：
+    // 批次的塊引用與槽位一起歸還、不持有 mqttMutex (它取鎖都有逾時，呼叫端持有鎖時也不會卡住)
+    xTaskNotify(publisherTaskHandle, PUBLISH_EVENT_STOP, eSetBits);
+    if (xSemaphoreTake(publisherExitSemaphore, pdMS_TO_TICKS(TASK_EXIT_TIMEOUT_MS)) != pdTRUE)
     {
-        vTaskDelete(audioPublishTaskHandle);
-        audioPublishTaskHandle = nullptr;
-    }
-    if (featurePublishTaskHandle)
-    {
-        vTaskDelete(featurePublishTaskHandle);
-        featurePublishTaskHandle = nullptr;
+        // 保留控制柄，下次 stopPublishing() / startPublishing() 再等待
+        Serial.printf("⚠️ 發布任務未在 %d ms 內結束\n", TASK_EXIT_TIMEOUT_MS);
+        return false;
     }
+    publisherTaskHandle = nullptr;
 
     Serial.println("音訊發布已停止");
     return true;
@@ -300,245 +584,1164 @@ bool AudioMqttManager::disableFeatureExtraction()
     return true;
 }
 
-bool AudioMqttManager::pushAudioData(int16_t *audioData, size_t length)
+bool AudioMqttManager::pushAudioData(int16_t *audioData, size_t length, uint64_t captureMicros)
 {
     if (!audioData || length == 0)
     {
         Serial.println("⚠️ pushAudioData: 無效的音訊數據或長度為0");
         return false;
     }
+    if (captureMicros == 0)
+    {
+        captureMicros = monotonicMicros();
+    }
 
-    // 創建音訊包
-    MqttAudioPacket packet;
-    packet.timestamp = millis();
-    packet.sequenceNumber = currentSequence++;
-    packet.dataLength = min(length, sizeof(packet.audioData) / sizeof(int16_t));
+    // 樣本時鐘：每個樣本 (包括下面因塊池用盡而遺失的) 都讓位置前進，封包時間由位置推得
+    if (sampleClockRestart.exchange(false))
+    {
+        samplePosition = 0;
+        streamEpochMicros = 0;
+        featureDiscontinuity = true;
+    }
+    if (streamEpochMicros == 0)
+    {
+        streamEpochMicros = anchorSampleClock(captureMicros, length);
+    }
 
-    // 複製音訊數據
-    memcpy(packet.audioData, audioData, packet.dataLength * sizeof(int16_t));
+    bool allQueued = true;
+    size_t offset = 0;
 
-    // 發送到音訊隊列
-    BaseType_t queueResult = xQueueSend(audioQueue, &packet, 0);
-    if (queueResult != pdTRUE)
-    {
-        static uint32_t queueFailCount = 0;
-        queueFailCount++;
-        if (queueFailCount % 100 == 0) // 每100次失敗輸出一次
-        {
-            Serial.printf("⚠️ 音訊隊列發送失敗 %d 次 - 隊列可能已滿\n", queueFailCount);
-            Serial.printf("隊列狀態 - 剩餘空間: %d\n", uxQueueSpacesAvailable(audioQueue));
-        }
-        return false;
-    } // 如果啟用特徵提取，處理特徵
-    if (isFeatureExtractionEnabled && featureExtractor)
+    while (offset < length)
     {
-        if (featureExtractor->processAudioFrame(audioData, length))
-        {
-            // 提取特徵
-            featureExtractor->extractFeatures();
+        size_t chunk = min(length - offset, (size_t)AUDIO_BLOCK_SAMPLES);
 
-            // 創建 MFCC 包
-            MqttMfccPacket mfccPacket;
-            mfccPacket.timestamp = packet.timestamp;
-            double *mfccData = featureExtractor->getMFCCCoeffs();
-            if (mfccData)
+        // 每塊只複製一次到共用池，各消費者各持有一個引用
+        AudioBlock *block = blockPool.acquire();
+        if (!block)
+        {
+            // 池已用盡：所有消費者都遺失這一塊，序號與樣本位置保留缺口，特徵提取下一塊重新對齊
+            currentSequence++;
+            samplePosition += chunk;
+            if (isFeatureExtractionEnabled)
             {
-                memcpy(mfccPacket.mfccCoeffs, mfccData, MFCC_COEFFS * sizeof(double));
-                mfccPacket.isValid = true;
-                xQueueSend(mfccQueue, &mfccPacket, 0);
+                stats.featureDroppedSamples += chunk;
+                featureDiscontinuity = true;
             }
-
-            // 創建梅爾能量包
-            MqttMelPacket melPacket;
-            melPacket.timestamp = packet.timestamp;
-            double *melData = featureExtractor->getMelEnergies();
-            if (melData)
+            if (blockPool.getExhaustedCount() % 100 == 1) // 每100次失敗輸出一次
             {
-                memcpy(melPacket.melEnergies, melData, MEL_FILTER_BANKS * sizeof(double));
-                melPacket.isValid = true;
-                xQueueSend(melQueue, &melPacket, 0);
+                Serial.printf("⚠️ 音訊塊池已用盡 %d 次\n", blockPool.getExhaustedCount());
             }
-
-            // 創建其他特徵包
-            MqttFeaturesPacket featuresPacket;
-            featuresPacket.timestamp = packet.timestamp;
-            featuresPacket.spectralCentroid = featureExtractor->computeSpectralCentroid();
-            featuresPacket.spectralBandwidth = featureExtractor->computeSpectralBandwidth();
-            featuresPacket.zeroCrossingRate = featureExtractor->computeZeroCrossingRate(audioData, length);
-            featuresPacket.rmsEnergy = featureExtractor->computeRMSEnergy(audioData, length);
-            featuresPacket.isValid = true;
-
-            xQueueSend(featuresQueue, &featuresPacket, 0);
+            allQueued = false;
+            offset += chunk;
+            continue;
         }
-    }
 
-    return true;
-}
+        block->samplePosition = samplePosition;
+        block->epochMicros = streamEpochMicros;
+        block->captureMicros = captureMicros;
+        samplePosition += chunk;
+        block->sequenceNumber = currentSequence++;
+        block->dataLength = chunk;
+        memcpy(block->audioData, audioData + offset, chunk * sizeof(int16_t));
 
-bool AudioMqttManager::publishAudioPacket(MqttAudioPacket *packet)
-{
-    if (!isConnected || !packet)
-    {
-        Serial.printf("⚠️ 無法發布音訊包 - 連接狀態: %s, 包有效性: %s\n",
-                      isConnected ? "已連接" : "未連接",
-                      packet ? "有效" : "無效");
-        return false;
-    }
+        // 如果啟用特徵提取，交給特徵提取任務 (不在擷取任務中做 FFT)
+        if (isFeatureExtractionEnabled)
+        {
+            pushFeatureBlock(block);
+        }
+        // 替代傳輸不受 MQTT 串流品質影響，每塊都直接送出
+        for (uint8_t i = 0; i < audioSinkCount; i++)
+        {
+            if (audioSinks[i]->isActive())
+            {
+                audioSinks[i]->writeBlock(*block);
+            }
+        }
 
-    // 創建 JSON 格式的音訊數據
-    JsonDocument doc;
-    doc["timestamp"] = packet->timestamp;
-    doc["sequence"] = packet->sequenceNumber;
-    doc["length"] = packet->dataLength;
+        // 只發布特徵時音訊不進入發布緩衝區，序號仍遞增，恢復後接收端可見缺口
+        if (streamTier != STREAM_TIER_FEATURES_ONLY)
+        {
+            pushAudioBlock(block);
+        }
 
-    JsonArray audioArray = doc["audio"].to<JsonArray>();
-    for (int i = 0; i < packet->dataLength; i++)
-    {
-        audioArray.add(packet->audioData[i]);
+        // 放棄擷取端自己的引用；沒有消費者時塊立即回到池中
+        blockPool.release(block);
+        offset += chunk;
     }
 
-    String jsonString;
-    serializeJson(doc, jsonString);
-
-    bool publishResult = mqttClient.publish(MQTT_TOPIC_AUDIO, jsonString.c_str());
-
-    if (publishResult)
+    if (isFeatureExtractionEnabled && tasksRunning && featureTaskHandle)
     {
-        stats.audioPacketsPublished++;
-        Serial.printf("✓ 音訊包已發布 - 序列: %d, 長度: %d\n",
-                      packet->sequenceNumber, packet->dataLength);
-        return true;
+        xTaskNotifyGive(featureTaskHandle);
     }
-    else
+    // 先檢查 isPublishing：停止後控制柄保留到確認結束為止，不通知正在結束的任務
+    if (isPublishing && publisherTaskHandle)
     {
-        stats.publishErrors++;
-        Serial.printf("✗ 音訊包發布失敗 - 序列: %d\n", packet->sequenceNumber);
-        return false;
+        xTaskNotify(publisherTaskHandle, PUBLISH_EVENT_AUDIO, eSetBits);
     }
+
+    return allQueued;
 }
 
-bool AudioMqttManager::publishMfccPacket(MqttMfccPacket *packet)
+uint64_t AudioMqttManager::anchorSampleClock(uint64_t captureMicros, size_t length)
 {
-    if (!isConnected || !packet || !packet->isValid)
-        return false;
-
-    JsonDocument doc;
-    doc["timestamp"] = packet->timestamp;
-
-    JsonArray mfccArray = doc["mfcc"].to<JsonArray>();
-    for (int i = 0; i < MFCC_COEFFS; i++)
+    // 系統時間尚未由 NTP 校正時不錨定，之後每次讀取再檢查
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    if (now.tv_sec < SAMPLE_CLOCK_MIN_EPOCH_S)
     {
-        mfccArray.add(packet->mfccCoeffs[i]);
+        return 0;
     }
 
-    String jsonString;
-    serializeJson(doc, jsonString);
+    // I2S 讀取完成時，本次讀取的最後一個樣本剛被擷取；往回推算到樣本位置 0
+    uint64_t readWallMicros = (uint64_t)now.tv_sec * 1000000ULL + now.tv_usec - (monotonicMicros() - captureMicros);
+    uint64_t epoch = readWallMicros - (samplePosition + length) * 1000000ULL / audioSampleRate;
+    Serial.printf("🕒 樣本時鐘已錨定：位置 %llu，紀元 %llu ms\n", (unsigned long long)samplePosition,
+                  (unsigned long long)(epoch / 1000));
+    return epoch;
+}
 
-    if (mqttClient.publish(MQTT_TOPIC_MFCC, jsonString.c_str()))
-    {
-        stats.mfccPacketsPublished++;
-        return true;
-    }
-    else
+bool AudioMqttManager::addAudioSink(AudioSink *sink)
+{
+    if (!sink || audioSinkCount >= AUDIO_SINK_MAX)
     {
-        stats.publishErrors++;
         return false;
     }
+    audioSinks[audioSinkCount++] = sink;
+    return true;
 }
 
-bool AudioMqttManager::publishMelPacket(MqttMelPacket *packet)
+void AudioMqttManager::pushAudioBlock(AudioBlock *block)
 {
-    if (!isConnected || !packet || !packet->isValid)
-        return false;
+    AudioBlock **slot = audioRing.reserve();
+    if (!slot)
+    {
+        stats.audioQueueDrops++;
+        if (stats.audioQueueDrops % 100 == 0) // 每100次失敗輸出一次
+        {
+            Serial.printf("⚠️ 音訊環形緩衝區已滿，已丟棄 %d 包\n", stats.audioQueueDrops);
+        }
+        return;
+    }
+
+    // 提交前寫入時間，發布任務取出時一定看得到
+    block->queuedMicros = monotonicMicros();
+    stageLatency[LATENCY_STAGE_CAPTURE].record((uint32_t)(block->queuedMicros - block->captureMicros));
 
-    JsonDocument doc;
-    doc["timestamp"] = packet->timestamp;
+    blockPool.retain(block);
+    *slot = block;
+    audioRing.commit();
+}
 
-    JsonArray melArray = doc["mel"].to<JsonArray>();
-    for (int i = 0; i < MEL_FILTER_BANKS; i++)
+void AudioMqttManager::pushFeatureBlock(AudioBlock *block)
+{
+    FeatureBlockRef *slot = featureRing.reserve();
+    if (!slot)
     {
-        melArray.add(packet->melEnergies[i]);
+        // 特徵任務跟不上：丟棄並標記下一塊不連續，讓特徵提取器重新對齊幀
+        stats.featureDroppedSamples += block->dataLength;
+        featureDiscontinuity = true;
+        return;
     }
 
-    String jsonString;
-    serializeJson(doc, jsonString);
+    blockPool.retain(block);
+    slot->block = block;
+    slot->discontinuity = featureDiscontinuity;
+    featureRing.commit();
+    featureDiscontinuity = false;
+}
 
-    if (mqttClient.publish(MQTT_TOPIC_MEL, jsonString.c_str()))
+void AudioMqttManager::onFeatureFrame(AudioFeatureExtractor *extractor)
+{
+    stats.featureFramesExtracted++;
+
+    // 同一幀的 MFCC、梅爾能量與頻譜統計放在同一筆隊列項目
+    // 幀位置由輸入塊的樣本位置推得：幀結束於本塊第 getFrameInputEnd() 個樣本之前
+    MqttFeatureFrame frame;
+    uint64_t frameEnd = featureInputPosition + extractor->getFrameInputEnd();
+    frame.samplePosition = frameEnd >= AudioFeatureExtractor::FRAME_SIZE ? frameEnd - AudioFeatureExtractor::FRAME_SIZE : 0;
+    frame.epochMicros = featureInputEpoch;
+    frame.extractedMicros = monotonicMicros();
+    frame.sequence = featureSequence++;
+    frame.hopSamples = extractor->getHopSize();
+
+    const feature_t *mfcc = extractor->getMFCCCoeffs();
+    for (int i = 0; i < AudioFeatureExtractor::MFCC_COEFFS; i++)
     {
-        stats.melPacketsPublished++;
-        return true;
+        frame.mfcc[i] = (float)mfcc[i];
     }
-    else
+    const feature_t *mel = extractor->getMelEnergies();
+    for (int i = 0; i < AudioFeatureExtractor::MEL_FILTER_BANKS; i++)
     {
-        stats.publishErrors++;
-        return false;
+        frame.mel[i] = (float)mel[i];
+    }
+    const SpectralStats &frameStats = extractor->getSpectralStats();
+    frame.stats[0] = (float)frameStats.centroid;
+    frame.stats[1] = (float)frameStats.bandwidth;
+    frame.stats[2] = (float)frameStats.rolloff;
+    frame.stats[3] = (float)frameStats.flatness;
+    frame.stats[4] = (float)frameStats.zeroCrossingRate;
+    frame.stats[5] = (float)frameStats.rmsEnergy;
+
+    if (xQueueSend(featureQueue, &frame, 0) != pdTRUE)
+    {
+        // 序號仍遞增，接收端可由序號跳號得知遺失
+        stats.featureQueueDrops++;
+    }
+
+    if (isPublishing && publisherTaskHandle)
+    {
+        xTaskNotify(publisherTaskHandle, PUBLISH_EVENT_FEATURES, eSetBits);
     }
 }
 
-bool AudioMqttManager::publishFeaturesPacket(MqttFeaturesPacket *packet)
+size_t AudioMqttManager::audioPacketCost(const AudioBlock &block)
 {
-    if (!isConnected || !packet || !packet->isValid)
-        return false;
-
-    JsonDocument doc;
-    doc["timestamp"] = packet->timestamp;
-    doc["spectralCentroid"] = packet->spectralCentroid;
-    doc["spectralBandwidth"] = packet->spectralBandwidth;
-    doc["zeroCrossingRate"] = packet->zeroCrossingRate;
-    doc["rmsEnergy"] = packet->rmsEnergy;
-
-    String jsonString;
-    serializeJson(doc, jsonString);
-
-    if (mqttClient.publish(MQTT_TOPIC_FEATURES, jsonString.c_str()))
+    // 各啟用格式中最大的訊息位元組估計，兩種格式都必須放得進 MQTT 緩衝區
+    uint8_t formats = effectiveAudioFormats();
+    uint16_t samples = streamTier == STREAM_TIER_ADPCM_8K ? block.dataLength / 2 : block.dataLength;
+    size_t cost = 0;
+    if (formats & AUDIO_OUTPUT_JSON)
     {
-        stats.featurePacketsPublished++;
-        return true;
+        cost = (size_t)samples * AUDIO_JSON_BYTES_PER_SAMPLE;
     }
-    else
+    if (formats & AUDIO_OUTPUT_BINARY)
     {
-        stats.publishErrors++;
-        return false;
+        size_t binary = effectiveAudioCodec() == AUDIO_CODEC_IMA_ADPCM ? AudioWireFormat::adpcmPacketSize(samples)
+                                                                       : AudioWireFormat::pcmPacketSize(samples);
+        cost = max(cost, binary);
     }
+    return cost;
 }
 
-void AudioMqttManager::publishStatus()
+size_t AudioMqttManager::collectAudioBatch(AudioBlock **batch)
 {
-    if (!isConnected)
-        return;
+    // 環形緩衝區最舊的包已就緒；繼續就地收集序號連續的包，直到位元組或延遲預算用盡
+    // 延遲預算用盡後仍收集已提交的包，積壓時一次清空；不連續或超出預算的包留在緩衝區給下一批
+    batch[0] = *audioRing.front();
+    size_t count = 1;
+    size_t bytes = AUDIO_JSON_OVERHEAD + audioPacketCost(*batch[0]);
+    uint64_t deadline = batch[0]->captureMicros + config.audioIntervalMs * 1000ULL;
+
+    while (count < config.batchPackets)
+    {
+        AudioBlock *const *slot = audioRing.peek(count);
+        if (!slot)
+        {
+            int64_t remaining = (int64_t)(deadline - monotonicMicros());
+            if (remaining <= 0 || !isPublishing)
+            {
+                break;
+            }
+            TickType_t wait = pdMS_TO_TICKS((uint32_t)(remaining / 1000));
+            xTaskNotifyWait(0, 0xFFFFFFFF, nullptr, wait > 0 ? wait : 1);
+            continue;
+        }
 
-    JsonDocument doc;
-    doc["device"] = clientId;
-    doc["status"] = "online";
-    doc["publishing"] = isPublishing;
-    doc["featureExtraction"] = isFeatureExtractionEnabled;
-    doc["timestamp"] = millis();
-    doc["stats"]["audioPackets"] = stats.audioPacketsPublished;
-    doc["stats"]["mfccPackets"] = stats.mfccPacketsPublished;
-    doc["stats"]["melPackets"] = stats.melPacketsPublished;
-    doc["stats"]["featurePackets"] = stats.featurePacketsPublished;
-    doc["stats"]["reconnects"] = stats.reconnectCount;
-    doc["stats"]["errors"] = stats.publishErrors;
+        AudioBlock *next = *slot;
+        size_t cost = audioPacketCost(*next);
+        const AudioBlock *last = batch[count - 1];
+        bool consecutive = next->sequenceNumber == (uint16_t)(last->sequenceNumber + 1) &&
+                           next->samplePosition == last->samplePosition + last->dataLength;
+        if (!consecutive || bytes + cost > AUDIO_BATCH_MAX_BYTES)
+        {
+            break;
+        }
 
-    String jsonString;
-    serializeJson(doc, jsonString);
+        batch[count++] = next;
+        bytes += cost;
+    }
 
-    mqttClient.publish(MQTT_TOPIC_STATUS, jsonString.c_str());
+    return count;
 }
 
-void AudioMqttManager::handleControlMessage(const char *message)
+bool AudioMqttManager::publishAudioBatch(const AudioBlock *const *batch, size_t count)
 {
-    JsonDocument doc;
-    if (deserializeJson(doc, message) != DeserializationError::Ok)
+    if (!isConnected || !batch || count == 0)
     {
-        return;
+        Serial.printf("⚠️ 無法發布音訊包 - 連接狀態: %s, 包數: %d\n",
+                      isConnected ? "已連接" : "未連接", (int)count);
+        return false;
     }
 
-    const char *command = doc["command"];
-    if (!command)
-        return;
+    // 即時串流的樣本位置跳躍 (塊池或環形緩衝區已滿、只發布特徵、發布失敗而暫存)，第一包標記 GAP
+    // 位置倒退表示串流重新開始，由重新同步旗標處理
+    bool gap = batch[0]->samplePosition > nextAudioPosition;
 
-    if (strcmp(command, "startPublishing") == 0)
+    // 依選定格式發布，任一格式成功即計為已發布
+    bool published = false;
+    bool failed = false;
+
+    uint8_t formats = effectiveAudioFormats();
+    if (formats & AUDIO_OUTPUT_JSON)
+    {
+        if (publishAudioJson(batch, count, gap))
+            published = true;
+        else
+            failed = true;
+    }
+    if (formats & AUDIO_OUTPUT_BINARY)
+    {
+        if (publishAudioBinary(batch, count, gap))
+            published = true;
+        else
+            failed = true;
+    }
+
+    if (failed)
+    {
+        stats.publishErrors++;
+        Serial.printf("✗ 音訊批次發布失敗 - 序列: %d, 包數: %d\n", batch[0]->sequenceNumber, (int)count);
+    }
+    if (published)
+    {
+        stats.audioPacketsPublished += count;
+        stats.audioMessagesPublished++;
+        stats.audioGaps += gap ? 1 : 0;
+        nextAudioPosition = batch[count - 1]->samplePosition + batch[count - 1]->dataLength;
+    }
+    return published;
+}
+
+bool AudioMqttManager::publishAudioJson(const AudioBlock *const *batch, size_t count, bool gap)
+{
+    // 批次內的包序號連續，合併為一個包：時間戳與序號取第一包，packets 為合併的包數
+    uint32_t totalLength = 0;
+    for (size_t p = 0; p < count; p++)
+    {
+        totalLength += batch[p]->dataLength;
+    }
+
+    JsonFrameWriter json((char *)frameBuffer, sizeof(frameBuffer));
+    json.beginObject();
+    json.member("timestamp", sampleClockMillis(batch[0]->samplePosition, batch[0]->epochMicros, audioSampleRate));
+    json.member("samplePosition", batch[0]->samplePosition);
+    json.member("gap", gap);
+    json.member("sequence", (uint32_t)batch[0]->sequenceNumber);
+    json.member("length", totalLength);
+    json.member("packets", (uint32_t)count);
+    json.beginArray("audio");
+    for (size_t p = 0; p < count; p++)
+    {
+        for (int i = 0; i < batch[p]->dataLength; i++)
+        {
+            json.value((int32_t)batch[p]->audioData[i]);
+        }
+    }
+    json.endArray();
+    json.endObject();
+
+    if (!json.ok())
+    {
+        stats.frameOverflows++;
+        return false;
+    }
+    return publishFrame(MQTT_TOPIC_AUDIO, frameBuffer, json.size());
+}
+
+bool AudioMqttManager::publishAudioBinary(const AudioBlock *const *batch, size_t count, bool gap)
+{
+    // 每包各自帶完整標頭，依序串接在同一則訊息中，接收端依標頭的樣本數與取樣率切分、還原
+    uint8_t codec = effectiveAudioCodec();
+    bool downsample = streamTier == STREAM_TIER_ADPCM_8K;
+    int16_t decimated[AUDIO_BLOCK_SAMPLES / 2];
+    size_t offset = 0;
+    for (size_t p = 0; p < count; p++)
+    {
+        const int16_t *samples = batch[p]->audioData;
+        AudioWireHeader header;
+        header.version = AUDIO_WIRE_VERSION;
+        header.codec = codec;
+        header.flags = 0;
+        if (p == 0)
+        {
+            header.flags = (audioResyncPending ? AUDIO_WIRE_FLAG_RESYNC : 0) | (gap ? AUDIO_WIRE_FLAG_GAP : 0);
+        }
+        header.sequence = batch[p]->sequenceNumber;
+        header.sampleCount = batch[p]->dataLength;
+        header.sampleRate = audioSampleRate;
+        header.samplePosition = batch[p]->samplePosition;
+        header.epochMicros = batch[p]->epochMicros;
+
+        // 降取樣後位置以本包取樣率計
+        if (downsample)
+        {
+            header.sampleCount = decimator.process(samples, batch[p]->dataLength, decimated);
+            header.sampleRate = audioSampleRate / 2;
+            header.samplePosition /= 2;
+            samples = decimated;
+        }
+
+        size_t length;
+        if (codec == AUDIO_CODEC_IMA_ADPCM)
+        {
+            uint32_t start = ESP.getCycleCount();
+            length = AudioWireFormat::encodeAdpcm(header, samples, adpcmEncoder,
+                                                  frameBuffer + offset, sizeof(frameBuffer) - offset);
+            stats.adpcmEncodeCycles += ESP.getCycleCount() - start;
+            stats.adpcmPacketsEncoded++;
+        }
+        else
+        {
+            length = AudioWireFormat::encodePcm(header, samples,
+                                                frameBuffer + offset, sizeof(frameBuffer) - offset);
+        }
+
+        if (length == 0)
+        {
+            return false;
+        }
+        offset += length;
+    }
+
+    // 發布失敗時編碼器狀態仍已前進；下一包標頭帶有起始狀態，接收端可直接重新同步
+    bool published = publishFrame(MQTT_TOPIC_AUDIO_BINARY, frameBuffer, offset);
+    if (published)
+    {
+        audioResyncPending = false;
+    }
+    return published;
+}
+
+void AudioMqttManager::setAudioCodec(uint8_t codec)
+{
+    StreamConfig next = config;
+    next.audioCodec = codec;
+    requestConfig(next, STREAM_CONFIG_AUDIO_CODEC);
+}
+
+void AudioMqttManager::setAudioOutputFormats(uint8_t formats)
+{
+    StreamConfig next = config;
+    next.audioFormats = formats;
+    requestConfig(next, STREAM_CONFIG_AUDIO_FORMAT);
+}
+
+void AudioMqttManager::setPublishIntervals(int audioInterval, int featureInterval)
+{
+    StreamConfig next = config;
+    next.audioIntervalMs = (uint16_t)constrain(audioInterval, 0, 0xFFFF);
+    next.featureIntervalMs = (uint16_t)constrain(featureInterval, 0, 0xFFFF);
+    requestConfig(next, STREAM_CONFIG_AUDIO_INTERVAL | STREAM_CONFIG_FEATURE_INTERVAL);
+}
+
+bool AudioMqttManager::publishFrame(const char *topic, const uint8_t *data, size_t length)
+{
+    // 標頭與負載直接寫入連線，不再複製到 PubSubClient 的內部緩衝區
+    uint64_t start = monotonicMicros();
+    bool sent = mqttClient.beginPublish(topic, length, false);
+    if (sent)
+    {
+        size_t written = mqttClient.write(data, length);
+        sent = mqttClient.endPublish() && written == length;
+    }
+    frameSendMicros += (uint32_t)(monotonicMicros() - start);
+    return sent;
+}
+
+uint8_t AudioMqttManager::effectiveAudioFormats()
+{
+    // 降級層級只保留二進位主題 (JSON 每樣本約 7 位元組)
+    return streamTier == STREAM_TIER_RAW ? config.audioFormats : AUDIO_OUTPUT_BINARY;
+}
+
+uint8_t AudioMqttManager::effectiveAudioCodec()
+{
+    return streamTier == STREAM_TIER_RAW ? config.audioCodec : AUDIO_CODEC_IMA_ADPCM;
+}
+
+void AudioMqttManager::requestStreamTier(uint8_t tier)
+{
+    if (tier >= STREAM_TIER_COUNT)
+    {
+        Serial.printf("⚠️ 不支援的串流品質層級: %d\n", tier);
+        return;
+    }
+    streamTierRequest = (int8_t)tier;
+}
+
+void AudioMqttManager::requestAdaptiveQuality()
+{
+    streamTierRequest = STREAM_TIER_REQUEST_AUTO;
+}
+
+void AudioMqttManager::updateStreamQuality()
+{
+    // 控制命令只留下請求，控制器狀態一律在發布任務中修改
+    int8_t request = streamTierRequest.exchange(STREAM_TIER_REQUEST_NONE);
+    if (request == STREAM_TIER_REQUEST_AUTO)
+    {
+        quality.setEnabled(true);
+        Serial.println("串流品質: 自動");
+    }
+    else if (request >= 0)
+    {
+        quality.setEnabled(false);
+        quality.forceTier((uint8_t)request);
+    }
+
+    // 沒有特徵可發布時，最低只降到 8 kHz ADPCM
+    quality.setLowestTier(isFeatureExtractionEnabled ? STREAM_TIER_FEATURES_ONLY : STREAM_TIER_ADPCM_8K);
+    quality.observeQueue(audioRing.size(), AUDIO_RING_BLOCKS);
+    quality.update(millis(), stats.audioQueueDrops);
+
+    if (quality.getTier() != streamTier)
+    {
+        applyStreamTier(quality.getTier());
+    }
+}
+
+void AudioMqttManager::applyStreamTier(uint8_t tier)
+{
+    uint8_t previous = streamTier;
+    streamTier = tier;
+
+    // 編碼與取樣率改變：重新開始編碼器與濾波器，下一個二進位封包標記重新同步
+    adpcmEncoder.reset();
+    decimator.reset();
+    audioResyncPending = true;
+
+    Serial.printf("🔄 串流品質: %s → %s (原因 0x%02x)\n", StreamQualityController::tierName(previous),
+                  StreamQualityController::tierName(tier), quality.getLastReason());
+
+    // 立即在狀態主題回報層級變化
+    if (xSemaphoreTake(mqttMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+    {
+        publishStatus();
+        xSemaphoreGive(mqttMutex);
+    }
+}
+
+void AudioMqttManager::setFeatureOutputFormats(uint8_t formats)
+{
+    StreamConfig next = config;
+    next.featureFormats = formats;
+    requestConfig(next, STREAM_CONFIG_FEATURE_FORMAT);
+}
+
+void AudioMqttManager::setFeatureEncoding(uint8_t encoding)
+{
+    StreamConfig next = config;
+    next.featureEncoding = encoding;
+    requestConfig(next, STREAM_CONFIG_FEATURE_ENCODING);
+}
+
+StreamConfig AudioMqttManager::defaultConfig()
+{
+    StreamConfig defaults;
+    defaults.audioFormats = AUDIO_OUTPUT_DEFAULT;
+    defaults.audioCodec = AUDIO_CODEC_PCM16;
+    defaults.batchPackets = AUDIO_BATCH_MAX_PACKETS;
+    defaults.audioIntervalMs = AUDIO_BATCH_MAX_LATENCY_MS;
+    defaults.featureFormats = FEATURE_OUTPUT_DEFAULT;
+    defaults.featureEncoding = FEATURE_ENCODING_INT16;
+    defaults.featureSet = FEATURE_SET_ALL;
+    defaults.hopSamples = AudioFeatureExtractor::HOP_SIZE;
+    defaults.featureIntervalMs = FEATURE_STARVATION_MS;
+    return defaults;
+}
+
+StreamConfigLimits AudioMqttManager::configLimits()
+{
+    // 批次上限受 batch 陣列大小限制；跳距不可超過幀長，否則幀之間會漏掉樣本
+    StreamConfigLimits limits;
+    limits.maxBatchPackets = AUDIO_BATCH_MAX_PACKETS;
+    limits.maxAudioIntervalMs = CONFIG_AUDIO_INTERVAL_MAX_MS;
+    limits.minHopSamples = CONFIG_HOP_MIN_SAMPLES;
+    limits.maxHopSamples = AudioFeatureExtractor::FRAME_SIZE;
+    limits.minFeatureIntervalMs = CONFIG_FEATURE_INTERVAL_MIN_MS;
+    limits.maxFeatureIntervalMs = CONFIG_FEATURE_INTERVAL_MAX_MS;
+    return limits;
+}
+
+bool AudioMqttManager::requestConfig(const StreamConfig &next, uint16_t fields, bool persist)
+{
+    std::lock_guard<std::mutex> guard(configWriteLock);
+
+    uint16_t invalid = fields & ~next.validFields(fields, configLimits());
+    if (invalid)
+    {
+        // 回報編號最小的無效欄位
+        Serial.printf("⚠️ 無效的串流設定: %s，維持原設定\n", StreamConfig::fieldName(invalid & (uint16_t)(~invalid + 1)));
+        return false;
+    }
+
+    // 以最近一次請求為基礎，尚未套用的請求不會被覆蓋
+    StreamConfig merged = requestedConfig;
+    merged.merge(next, fields);
+    StreamConfigAck ack = {nullptr, -1, fields, false};
+    commitConfigRequest(merged, ack, persist);
+    return true;
+}
+
+void AudioMqttManager::handleConfigureCommand(const JsonFieldReader &reader, const char *command, int32_t id)
+{
+    // 在 MQTT 任務中執行 (持有 mqttMutex)，拒絕時直接回覆確認
+    std::lock_guard<std::mutex> guard(configWriteLock);
+
+    StreamConfigAck ack = {command, id, 0, false};
+    StreamConfig next = requestedConfig;
+    bool persist = false;
+    reader.getBool("persist", &persist);
+
+    if (strcmp(command, "resetConfig") == 0)
+    {
+        // 清除 NVS 中的設定並恢復所有欄位的編譯期預設值
+        next = defaultConfig();
+        ack.fields = STREAM_CONFIG_ALL;
+        ack.persisted = clearPersistedConfig();
+        persist = false;
+    }
+    else
+    {
+        const char *invalidField = nullptr;
+        int fields = next.parse(reader, configLimits(), &invalidField);
+        if (fields < 0)
+        {
+            Serial.printf("⚠️ 設定命令無效: %s，維持原設定\n", invalidField);
+            publishConfigAck(ack, invalidField);
+            return;
+        }
+        ack.fields = (uint16_t)fields;
+    }
+
+    commitConfigRequest(next, ack, persist);
+}
+
+void AudioMqttManager::commitConfigRequest(const StreamConfig &next, const StreamConfigAck &ack, bool persist)
+{
+    // 呼叫端持有 configWriteLock；NVS 寫入在發布序號之前完成，確認訊息才能回報結果
+    StreamConfigAck committed = ack;
+    if (persist)
+    {
+        committed.persisted = persistConfig(next, ack.fields);
+    }
+
+    // 序號鎖：寫入期間序號為奇數，讀取端遇到奇數或前後序號不同時重讀
+    uint32_t sequence = configSequence.load(std::memory_order_relaxed);
+    configSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    requestedConfig = next;
+    requestedAck = committed;
+    configSequence.store(sequence + 2, std::memory_order_release);
+
+    // 未發布時沒有進行中的批次，直接套用 (控制命令在 MQTT 任務中，已持有 mqttMutex)
+    StreamConfigAck applied;
+    if (!isPublishing && applyRequestedConfig(&applied) && applied.command)
+    {
+        publishConfigAck(applied, nullptr);
+    }
+}
+
+bool AudioMqttManager::applyRequestedConfig(StreamConfigAck *ack)
+{
+    uint32_t sequence = configSequence.load(std::memory_order_acquire);
+    if (sequence == appliedConfigSequence)
+        return false;
+
+    // 複製完整快照；請求端寫入到一半時讓出 CPU 後重讀，不會取得一半新一半舊的設定
+    StreamConfig next;
+    StreamConfigAck nextAck;
+    while (true)
+    {
+        if (sequence & 1)
+        {
+            taskYIELD();
+            sequence = configSequence.load(std::memory_order_acquire);
+            continue;
+        }
+        next = requestedConfig;
+        nextAck = requestedAck;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t check = configSequence.load(std::memory_order_relaxed);
+        if (check == sequence)
+            break;
+        sequence = check;
+    }
+
+    appliedConfigSequence = sequence;
+    applyConfig(next);
+    if (ack)
+    {
+        *ack = nextAck;
+    }
+    return true;
+}
+
+void AudioMqttManager::applyConfig(const StreamConfig &next)
+{
+    uint16_t changed = config.diff(next);
+    if (changed == 0)
+        return;
+
+    // 編碼改變：重新開始編碼器，下一個二進位封包標記重新同步
+    if (changed & STREAM_CONFIG_AUDIO_CODEC)
+    {
+        adpcmEncoder.reset();
+        audioResyncPending = true;
+    }
+    // 跳距由特徵任務在下一個輸入塊套用，已排隊的幀仍帶舊的跳距
+    if (changed & STREAM_CONFIG_HOP_SAMPLES)
+    {
+        featureHopSamples = next.hopSamples;
+    }
+    config = next;
+
+    char text[STREAM_CONFIG_ACK_BYTES];
+    JsonFrameWriter json(text, sizeof(text));
+    json.beginObject();
+    config.writeJson(json);
+    json.endObject();
+    Serial.printf("⚙️ 串流設定已套用 (欄位 0x%03x): %.*s\n", changed, json.ok() ? (int)json.size() : 0, text);
+}
+
+void AudioMqttManager::publishConfigAck(const StreamConfigAck &ack, const char *invalidField)
+{
+    // 呼叫端持有 mqttMutex；不經過 frameBuffer，MQTT 任務與發布任務都會呼叫
+    if (!isConnected)
+        return;
+
+    char buffer[STREAM_CONFIG_ACK_BYTES];
+    JsonFrameWriter json(buffer, sizeof(buffer));
+    json.beginObject();
+    json.member("device", clientId);
+    json.member("ack", ack.command);
+    if (ack.id >= 0)
+    {
+        json.member("id", ack.id);
+    }
+    json.member("ok", invalidField == nullptr);
+    if (invalidField)
+    {
+        json.member("field", invalidField);
+    }
+    else
+    {
+        json.beginArray("fields");
+        for (uint8_t i = 0; i < STREAM_CONFIG_FIELD_COUNT; i++)
+        {
+            if (ack.fields & (1 << i))
+            {
+                json.value(StreamConfig::fieldName(1 << i));
+            }
+        }
+        json.endArray();
+        json.member("persisted", ack.persisted);
+        json.key("config");
+        json.beginObject();
+        config.writeJson(json);
+        json.endObject();
+    }
+    json.endObject();
+
+    if (!json.ok() || !publishFrame(MQTT_TOPIC_STATUS, (const uint8_t *)buffer, json.size()))
+    {
+        stats.publishErrors++;
+    }
+}
+
+bool AudioMqttManager::persistConfig(const StreamConfig &source, uint16_t fields)
+{
+    // 與先前儲存的欄位合併，只覆寫這次指定的欄位
+    Preferences prefs;
+    if (!prefs.begin(STREAM_CONFIG_NVS_NAMESPACE, false))
+    {
+        Serial.println("⚠️ 無法開啟 NVS，設定未儲存");
+        return false;
+    }
+
+    StreamConfig stored = defaultConfig();
+    uint16_t storedFields = 0;
+    if (prefs.getUChar("version", 0) == STREAM_CONFIG_NVS_VERSION &&
+        prefs.getBytes("config", &stored, sizeof(stored)) == sizeof(stored))
+    {
+        storedFields = prefs.getUShort("fields", 0);
+    }
+    stored.merge(source, fields);
+
+    bool saved = prefs.putBytes("config", &stored, sizeof(stored)) == sizeof(stored) &&
+                 prefs.putUShort("fields", storedFields | fields) > 0 &&
+                 prefs.putUChar("version", STREAM_CONFIG_NVS_VERSION) > 0;
+    prefs.end();
+    if (!saved)
+    {
+        Serial.println("⚠️ 寫入 NVS 失敗，設定未儲存");
+    }
+    return saved;
+}
+
+void AudioMqttManager::loadPersistedConfig()
+{
+    Preferences prefs;
+    if (!prefs.begin(STREAM_CONFIG_NVS_NAMESPACE, true))
+        return; // 尚未儲存過
+
+    StreamConfig stored;
+    uint16_t fields = 0;
+    if (prefs.getUChar("version", 0) == STREAM_CONFIG_NVS_VERSION &&
+        prefs.getBytes("config", &stored, sizeof(stored)) == sizeof(stored))
+    {
+        // 範圍可能隨韌體改變，只載入仍然有效的欄位
+        fields = stored.validFields(prefs.getUShort("fields", 0) & STREAM_CONFIG_ALL, configLimits());
+    }
+    prefs.end();
+    if (fields == 0)
+        return;
+
+    config.merge(stored, fields);
+    requestedConfig = config;
+    featureHopSamples = config.hopSamples;
+    Serial.printf("✓ 已載入儲存的串流設定 (欄位 0x%03x)\n", fields);
+}
+
+bool AudioMqttManager::clearPersistedConfig()
+{
+    Preferences prefs;
+    if (!prefs.begin(STREAM_CONFIG_NVS_NAMESPACE, false))
+        return false;
+    bool cleared = prefs.clear();
+    prefs.end();
+    return cleared;
+}
+
+size_t AudioMqttManager::encodeFeatureFrames(const MqttFeatureFrame *frames, size_t count, uint8_t flags, uint8_t *out,
+                                             size_t capacity)
+{
+    // 一個標頭 + count 幀，每個值 2 位元組；未選取的特徵集數量為 0，不佔位元組
+    uint8_t set = config.featureSet;
+    FeatureWireHeader header;
+    FeatureWireFormat::initHeader(header, config.featureEncoding,
+                                  (set & FEATURE_SET_MFCC) ? AudioFeatureExtractor::MFCC_COEFFS : 0,
+                                  (set & FEATURE_SET_MEL) ? AudioFeatureExtractor::MEL_FILTER_BANKS : 0,
+                                  frames[0].hopSamples, AudioFeatureExtractor::SAMPLE_RATE);
+    if (!(set & FEATURE_SET_STATS))
+    {
+        header.statCount = 0;
+    }
+    header.frameCount = (uint8_t)count;
+    header.flags = flags;
+    header.sequence = frames[0].sequence;
+    header.samplePosition = frames[0].samplePosition;
+    header.epochMicros = frames[0].epochMicros;
+
+    size_t length = FeatureWireFormat::writeHeader(header, out, capacity);
+    for (size_t i = 0; i < count && length > 0; i++)
+    {
+        size_t written = FeatureWireFormat::writeFrame(header, frames[i].mfcc, frames[i].mel, frames[i].stats,
+                                                       out + length, capacity - length);
+        length = written > 0 ? length + written : 0;
+    }
+    return length;
+}
+
+bool AudioMqttManager::publishFeatureFrames(const MqttFeatureFrame *frames, size_t count, uint8_t flags)
+{
+    if (!isConnected || count == 0)
+        return false;
+
+    size_t length = encodeFeatureFrames(frames, count, flags, frameBuffer, sizeof(frameBuffer));
+    if (length == 0)
+    {
+        stats.frameOverflows++;
+        return false;
+    }
+
+    if (publishFrame(MQTT_TOPIC_FEATURE_FRAME, frameBuffer, length))
+    {
+        stats.featureFramesPublished += count;
+        stats.featureMessagesPublished++;
+        return true;
+    }
+    else
+    {
+        stats.publishErrors++;
+        return false;
+    }
+}
+
+bool AudioMqttManager::publishMfccJson(const MqttFeatureFrame &frame)
+{
+    if (!isConnected)
+        return false;
+
+    JsonFrameWriter json((char *)frameBuffer, sizeof(frameBuffer));
+    json.beginObject();
+    json.member("timestamp", sampleClockMillis(frame.samplePosition, frame.epochMicros, audioSampleRate));
+    json.member("samplePosition", frame.samplePosition);
+    json.beginArray("mfcc");
+    for (int i = 0; i < AudioFeatureExtractor::MFCC_COEFFS; i++)
+    {
+        json.value((double)frame.mfcc[i]);
+    }
+    json.endArray();
+    json.endObject();
+
+    if (json.ok() && publishFrame(MQTT_TOPIC_MFCC, frameBuffer, json.size()))
+    {
+        stats.mfccPacketsPublished++;
+        return true;
+    }
+    else
+    {
+        stats.publishErrors++;
+        return false;
+    }
+}
+
+bool AudioMqttManager::publishMelJson(const MqttFeatureFrame &frame)
+{
+    if (!isConnected)
+        return false;
+
+    JsonFrameWriter json((char *)frameBuffer, sizeof(frameBuffer));
+    json.beginObject();
+    json.member("timestamp", sampleClockMillis(frame.samplePosition, frame.epochMicros, audioSampleRate));
+    json.member("samplePosition", frame.samplePosition);
+    json.beginArray("mel");
+    for (int i = 0; i < AudioFeatureExtractor::MEL_FILTER_BANKS; i++)
+    {
+        json.value((double)frame.mel[i]);
+    }
+    json.endArray();
+    json.endObject();
+
+    if (json.ok() && publishFrame(MQTT_TOPIC_MEL, frameBuffer, json.size()))
+    {
+        stats.melPacketsPublished++;
+        return true;
+    }
+    else
+    {
+        stats.publishErrors++;
+        return false;
+    }
+}
+
+bool AudioMqttManager::publishFeaturesJson(const MqttFeatureFrame &frame)
+{
+    if (!isConnected)
+        return false;
+
+    JsonFrameWriter json((char *)frameBuffer, sizeof(frameBuffer));
+    json.beginObject();
+    json.member("timestamp", sampleClockMillis(frame.samplePosition, frame.epochMicros, audioSampleRate));
+    json.member("samplePosition", frame.samplePosition);
+    json.member("spectralCentroid", (double)frame.stats[0]);
+    json.member("spectralBandwidth", (double)frame.stats[1]);
+    json.member("spectralRolloff", (double)frame.stats[2]);
+    json.member("spectralFlatness", (double)frame.stats[3]);
+    json.member("zeroCrossingRate", (double)frame.stats[4]);
+    json.member("rmsEnergy", (double)frame.stats[5]);
+    json.endObject();
+
+    if (json.ok() && publishFrame(MQTT_TOPIC_FEATURES, frameBuffer, json.size()))
+    {
+        stats.featurePacketsPublished++;
+        return true;
+    }
+    else
+    {
+        stats.publishErrors++;
+        return false;
+    }
+}
+
+const char *AudioMqttManager::latencyStageName(uint8_t stage)
+{
+    static const char *const names[LATENCY_STAGE_COUNT] = {"capture", "queue", "lock", "encode", "send"};
+    return stage < LATENCY_STAGE_COUNT ? names[stage] : "unknown";
+}
+
+static void writeLatencyJson(JsonFrameWriter &json, const char *name, const LatencyHistogram &histogram)
+{
+    json.key(name);
+    json.beginObject();
+    json.member("count", histogram.getCount());
+    json.member("p50", histogram.percentile(0.50f));
+    json.member("p95", histogram.percentile(0.95f));
+    json.member("p99", histogram.percentile(0.99f));
+    json.member("max", histogram.getMax());
+    json.endObject();
+}
+
+void AudioMqttManager::publishStatus()
+{
+    // 呼叫端持有 mqttMutex (MQTT 任務與發布任務都會呼叫)，序列化到專用的 statusBuffer，不使用堆積
+    if (!isConnected)
+        return;
+
+    uint32_t now = millis();
+    HeapAllocCounter::beginTracking();
+
+    JsonFrameWriter json(statusBuffer, sizeof(statusBuffer));
+    json.beginObject();
+    json.member("device", clientId);
+    json.member("status", "online");
+    json.member("publishing", isPublishing.load());
+    json.member("featureExtraction", isFeatureExtractionEnabled);
+    json.member("audioJson", (config.audioFormats & AUDIO_OUTPUT_JSON) != 0);
+    json.member("audioBinary", (config.audioFormats & AUDIO_OUTPUT_BINARY) != 0);
+    json.member("audioCodec", StreamConfig::audioCodecName(config.audioCodec));
+    json.member("featureJson", (config.featureFormats & FEATURE_OUTPUT_JSON) != 0);
+    json.member("featureFrame", (config.featureFormats & FEATURE_OUTPUT_FRAME) != 0);
+    json.member("featureEncoding", StreamConfig::featureEncodingName(config.featureEncoding));
+
+    // 執行期串流設定 (configure 命令)
+    char featureSet[STREAM_CONFIG_NAME_MAX];
+    StreamConfig::featureSetName(config.featureSet, featureSet, sizeof(featureSet));
+    json.member("batchPackets", (uint32_t)config.batchPackets);
+    json.member("audioIntervalMs", (uint32_t)config.audioIntervalMs);
+    json.member("featureSet", featureSet);
+    json.member("hopSamples", (uint32_t)config.hopSamples);
+    json.member("featureIntervalMs", (uint32_t)config.featureIntervalMs);
+    json.member("streamTier", StreamQualityController::tierName(streamTier));
+    json.member("streamTierReason", (uint32_t)quality.getLastReason());
+    json.member("adaptiveQuality", quality.isEnabled());
+    json.member("timestamp", now);
+
+    json.key("stats");
+    json.beginObject();
+    json.member("audioPackets", stats.audioPacketsPublished);
+    json.member("audioMessages", stats.audioMessagesPublished);
+    json.member("audioQueueDrops", stats.audioQueueDrops);
+    json.member("mfccPackets", stats.mfccPacketsPublished);
+    json.member("melPackets", stats.melPacketsPublished);
+    json.member("featurePackets", stats.featurePacketsPublished);
+    json.member("featureFramesPublished", stats.featureFramesPublished);
+    json.member("featureMessages", stats.featureMessagesPublished);
+    json.member("featureQueueDrops", stats.featureQueueDrops);
+    json.member("reconnects", stats.reconnectCount);
+    json.member("errors", stats.publishErrors);
+    json.member("featureFrames", stats.featureFramesExtracted);
+    json.member("audioRingHighWater", audioRing.getHighWaterMark());
+    json.member("featureRingHighWater", featureRing.getHighWaterMark());
+    json.member("poolInUse", blockPool.getInUse());
+    json.member("poolHighWater", blockPool.getHighWaterMark());
+    json.member("poolExhausted", blockPool.getExhaustedCount());
+    json.member("featureDroppedHops", getFeatureDroppedHops());
+    json.member("adpcmCyclesPerPacket", getAdpcmCyclesPerPacket());
+    json.member("publishHeapAllocs", getPublishHeapAllocs());
+    json.member("frameOverflows", stats.frameOverflows);
+    json.member("streamTierChanges", quality.getTierChanges());
+
+    // 自上次狀態發布以來的實際音訊包速率
+    uint32_t elapsed = now - rateWindowStart;
+    if (rateWindowStart != 0 && elapsed > 0)
+    {
+        json.member("audioPacketsPerSec", (stats.audioPacketsPublished - rateWindowPackets) * 1000.0 / elapsed);
+    }
+    rateWindowStart = now;
+    rateWindowPackets = stats.audioPacketsPublished;
+    json.endObject();
+
+    // 串流樣本時鐘 (epochMs 為樣本位置 0 的 Unix 時間，0 表示尚未校時；gaps 為標記 GAP 的訊息數)
+    json.key("clock");
+    json.beginObject();
+    json.member("epochMs", streamEpochMicros / 1000);
+    json.member("audioGaps", stats.audioGaps);
+    json.member("featureGaps", stats.featureGaps);
+    json.endObject();
+
+    // 斷線暫存區
+    json.key("spool");
+    json.beginObject();
+    json.member("capacitySeconds", (double)getSpoolCapacitySeconds());
+    json.member("backlogSeconds", (double)getSpoolBacklogSeconds());
+    json.member("backlogBytes", (uint32_t)spool.getBacklogBytes());
+    json.member("backlogRecords", spool.getBacklogRecords());
+    json.member("flashBytes", (uint32_t)spool.getFlashUsed());
+    json.member("replayed", stats.spoolReplayedRecords);
+    json.member("dropped", spool.getDroppedRecords());
+    json.endObject();
+
+    // UDP/RTP 即時串流
+    json.key("rtp");
+    json.beginObject();
+    json.member("active", rtpStream.isActive());
+    if (rtpStream.isActive())
+    {
+        char target[RTP_TARGET_TEXT_SIZE];
+        rtpStream.getTarget(target, sizeof(target));
+        json.member("target", target);
+        json.member("port", (uint32_t)rtpStream.getTargetPort());
+    }
+    json.member("packets", rtpStream.getPacketsSent());
+    json.member("bytes", rtpStream.getBytesSent());
+    json.member("sendErrors", rtpStream.getSendErrors());
+    json.member("blockGaps", rtpStream.getBlockGaps());
+    json.endObject();
+
+    // WebSocket 串流 (各客戶端的送出與丟棄)
+    json.key("websocket");
+    json.beginObject();
+    json.member("clients", (uint32_t)wsStream.getClientCount());
+    json.beginArray("queues");
+    for (uint8_t i = 0; i < WS_STREAM_MAX_CLIENTS; i++)
+    {
+        if (wsStream.getCore().isConnected(i))
+        {
+            WebSocketStreamCore::ClientStats clientStats = wsStream.getCore().getClientStats(i);
+            json.beginObject();
+            json.member("id", (uint32_t)i);
+            json.member("depth", wsStream.getCore().getQueueDepth(i));
+            json.member("sent", clientStats.sent);
+            json.member("dropped", clientStats.dropped);
+            json.member("highWater", clientStats.highWater);
+            json.endObject();
+        }
+    }
+    json.endArray();
+    json.endObject();
+
+    // 連線建立統計 (latency 為從開始嘗試到 CONNACK 的耗時，µs)
+    json.key("connection");
+    json.beginObject();
+    json.member("attempts", stats.connectAttempts);
+    json.member("failures", stats.connectFailures);
+    json.member("lastConnectMs", stats.lastConnectMs);
+    writeLatencyJson(json, "latency", connectLatency);
+    json.endObject();
+
+    // 各類訊息的發布延遲與音訊管線各階段 (µs)
+    json.key("latency");
+    json.beginObject();
+    writeLatencyJson(json, "audio", audioLatency);
+    writeLatencyJson(json, "features", featureLatency);
+    json.key("stages");
+    json.beginObject();
+    for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++)
+    {
+        writeLatencyJson(json, latencyStageName(i), stageLatency[i]);
+    }
+    json.endObject();
+    json.endObject();
+    json.endObject();
+
+    // 狀態訊息會超過 MQTT_BUFFER_SIZE，publishFrame 以串流方式寫入連線
+    if (json.ok())
+    {
+        publishFrame(MQTT_TOPIC_STATUS, (const uint8_t *)statusBuffer, json.size());
+    }
+    else
+    {
+        stats.frameOverflows++;
+        Serial.println("⚠️ 狀態訊息超過 STATUS_FRAME_BYTES，已丟棄");
+    }
+    HeapAllocCounter::endTracking();
+}
+
+void AudioMqttManager::handleControlMessage(const char *message, size_t length)
+{
+    // 直接在 PubSubClient 的接收緩衝區上解析，不複製也不配置記憶體
+    JsonFieldReader reader(message, length);
+    char command[32];
+    if (!reader.getString("command", command, sizeof(command)))
+        return;
+
+    int32_t id = -1;
+    reader.getInt("id", &id);
+    char value[STREAM_CONFIG_NAME_MAX];
+
+    if (strcmp(command, "startPublishing") == 0)
     {
         startPublishing();
     }
@@ -558,40 +1761,109 @@ void AudioMqttManager::handleControlMessage(const char *message)
     {
         publishStatus();
     }
-}
-
-bool AudioMqttManager::reconnectMqtt()
-{
-    if (isConnected)
-        return true;
-
-    uint32_t now = millis();
-    if (now - lastReconnectAttempt < MQTT_RECONNECT_INTERVAL)
+    else if (strcmp(command, "configure") == 0)
     {
-        return false;
+        // {"command": "configure", "id": 7, "audioCodec": "adpcm", "hopSamples": 320, ..., "persist": true}
+        handleConfigureCommand(reader, "configure", id);
     }
-
-    lastReconnectAttempt = now;
-
-    if (connect())
+    else if (strcmp(command, "resetConfig") == 0)
     {
-        stats.reconnectCount++;
-        return true;
+        handleConfigureCommand(reader, "resetConfig", id);
+    }
+    else if (strcmp(command, "setAudioFormat") == 0)
+    {
+        // {"command": "setAudioFormat", "format": "json" | "binary" | "both"}
+        int formats = reader.getString("format", value, sizeof(value)) ? StreamConfig::audioFormatFromName(value) : -1;
+        if (formats >= 0)
+            setAudioOutputFormats((uint8_t)formats);
     }
+    else if (strcmp(command, "setAudioCodec") == 0)
+    {
+        // {"command": "setAudioCodec", "codec": "pcm" | "adpcm"}，只影響二進位主題
+        int codec = reader.getString("codec", value, sizeof(value)) ? StreamConfig::audioCodecFromName(value) : -1;
+        if (codec >= 0)
+            setAudioCodec((uint8_t)codec);
+    }
+    else if (strcmp(command, "setStreamQuality") == 0)
+    {
+        // {"command": "setStreamQuality", "tier": "auto" | "raw" | "adpcm" | "adpcm8k" | "features"}
+        if (!reader.getString("tier", value, sizeof(value)))
+            return;
 
-    return false;
+        if (strcmp(value, "auto") == 0)
+        {
+            requestAdaptiveQuality();
+            return;
+        }
+        for (uint8_t t = 0; t < STREAM_TIER_COUNT; t++)
+        {
+            if (strcmp(value, StreamQualityController::tierName(t)) == 0)
+            {
+                requestStreamTier(t);
+            }
+        }
+    }
+    else if (strcmp(command, "setFeatureFormat") == 0)
+    {
+        // {"command": "setFeatureFormat", "format": "json" | "frame" | "both"}
+        int formats = reader.getString("format", value, sizeof(value)) ? StreamConfig::featureFormatFromName(value) : -1;
+        if (formats >= 0)
+            setFeatureOutputFormats((uint8_t)formats);
+    }
+    else if (strcmp(command, "setFeatureEncoding") == 0)
+    {
+        // {"command": "setFeatureEncoding", "encoding": "int16" | "float16"}，只影響緊湊幀主題
+        int encoding = reader.getString("encoding", value, sizeof(value)) ? StreamConfig::featureEncodingFromName(value) : -1;
+        if (encoding >= 0)
+            setFeatureEncoding((uint8_t)encoding);
+    }
+    else if (strcmp(command, "startRtp") == 0)
+    {
+        // {"command": "startRtp", "host": "192.168.1.50", "port": 5004}，host 須為 IP 位址
+        char host[48];
+        int32_t port = RTP_DEFAULT_PORT;
+        reader.getInt("port", &port);
+        if (port <= 0 || port > 0xFFFF)
+            port = RTP_DEFAULT_PORT;
+        if (reader.getString("host", host, sizeof(host)) && rtpStream.start(host, (uint16_t)port))
+        {
+            publishStatus();
+        }
+    }
+    else if (strcmp(command, "stopRtp") == 0)
+    {
+        rtpStream.stop();
+        publishStatus();
+    }
 }
 
 void AudioMqttManager::loop()
 {
+    // 與發布任務共用 MQTT 客戶端；發布任務持有互斥鎖時略過這一輪
+    if (!mqttMutex || xSemaphoreTake(mqttMutex, 0) != pdTRUE)
+    {
+        return;
+    }
+
     if (isConnected)
     {
-        mqttClient.loop();
+        if (!mqttClient.loop())
+        {
+            // 連線中斷：之後的音訊與特徵寫入暫存區，重新連線後補發
+            isConnected = false;
+            Serial.printf("⚠️ MQTT 連線中斷，錯誤碼: %d\n", mqttClient.state());
+
+            // 第一次重試前也隨機等待，避免多台裝置在服務器重啟後同時重連
+            nextConnectAttempt = millis() + esp_random() % MQTT_BACKOFF_BASE_MS;
+            connectionState = MQTT_CONN_BACKOFF;
+        }
     }
     else
     {
-        reconnectMqtt();
+        serviceConnection();
     }
+
+    xSemaphoreGive(mqttMutex);
 }
 
 void AudioMqttManager::printStatus()
@@ -600,12 +1872,68 @@ void AudioMqttManager::printStatus()
     Serial.printf("MQTT 連接: %s\n", isConnected ? "是" : "否");
     Serial.printf("發布狀態: %s\n", isPublishing ? "是" : "否");
     Serial.printf("特徵提取: %s\n", isFeatureExtractionEnabled ? "是" : "否");
-    Serial.printf("音訊包發布: %d\n", stats.audioPacketsPublished);
+    Serial.printf("音訊格式: JSON %s, 二進位 %s\n",
+                  (config.audioFormats & AUDIO_OUTPUT_JSON) ? "是" : "否",
+                  (config.audioFormats & AUDIO_OUTPUT_BINARY) ? "是" : "否");
+    Serial.printf("特徵格式: JSON %s, 緊湊幀 %s (%s)\n",
+                  (config.featureFormats & FEATURE_OUTPUT_JSON) ? "是" : "否",
+                  (config.featureFormats & FEATURE_OUTPUT_FRAME) ? "是" : "否",
+                  StreamConfig::featureEncodingName(config.featureEncoding));
+    char featureSet[STREAM_CONFIG_NAME_MAX];
+    StreamConfig::featureSetName(config.featureSet, featureSet, sizeof(featureSet));
+    Serial.printf("串流設定: 每批最多 %u 包, 音訊間隔 %u ms, 特徵集 %s, 跳距 %u 樣本, 特徵間隔 %u ms\n",
+                  config.batchPackets, config.audioIntervalMs, featureSet, config.hopSamples, config.featureIntervalMs);
+    Serial.printf("串流品質: %s (%s, 切換 %u 次)\n", StreamQualityController::tierName(streamTier),
+                  quality.isEnabled() ? "自動" : "手動", quality.getTierChanges());
+    Serial.printf("二進位編碼: %s", config.audioCodec == AUDIO_CODEC_IMA_ADPCM ? "IMA-ADPCM" : "PCM16");
+    if (stats.adpcmPacketsEncoded > 0)
+    {
+        Serial.printf(" (%u 週期/包)", getAdpcmCyclesPerPacket());
+    }
+    Serial.println();
+    Serial.printf("音訊包發布: %d (%d 則訊息)\n", stats.audioPacketsPublished, stats.audioMessagesPublished);
+    Serial.printf("音訊環形緩衝區高水位: %d/%d 塊, 丟棄: %d\n", audioRing.getHighWaterMark(), AUDIO_RING_BLOCKS, stats.audioQueueDrops);
+    Serial.printf("發布路徑堆積配置: %u\n", getPublishHeapAllocs());
+    Serial.printf("音訊發布延遲: p50 %u ms, p95 %u ms, p99 %u ms, 最大 %u ms (%u 包)\n",
+                  audioLatency.percentile(0.50f) / 1000, audioLatency.percentile(0.95f) / 1000,
+                  audioLatency.percentile(0.99f) / 1000, audioLatency.getMax() / 1000, audioLatency.getCount());
+    Serial.printf("特徵發布延遲: p50 %u ms, p95 %u ms, p99 %u ms, 最大 %u ms (%u 幀)\n",
+                  featureLatency.percentile(0.50f) / 1000, featureLatency.percentile(0.95f) / 1000,
+                  featureLatency.percentile(0.99f) / 1000, featureLatency.getMax() / 1000, featureLatency.getCount());
+    for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++)
+    {
+        const LatencyHistogram &stage = stageLatency[i];
+        Serial.printf("  階段 %-7s: p50 %u µs, p95 %u µs, p99 %u µs, 最大 %u µs\n", latencyStageName(i),
+                      stage.percentile(0.50f), stage.percentile(0.95f), stage.percentile(0.99f), stage.getMax());
+    }
     Serial.printf("MFCC 包發布: %d\n", stats.mfccPacketsPublished);
     Serial.printf("梅爾包發布: %d\n", stats.melPacketsPublished);
     Serial.printf("特徵包發布: %d\n", stats.featurePacketsPublished);
+    Serial.printf("緊湊特徵幀發布: %d (%d 則訊息), 隊列丟棄: %d\n", stats.featureFramesPublished,
+                  stats.featureMessagesPublished, stats.featureQueueDrops);
+    Serial.printf("樣本時鐘: %s, 音訊缺口 %u 次, 特徵缺口 %u 次\n", streamEpochMicros ? "已錨定" : "未校時",
+                  stats.audioGaps, stats.featureGaps);
     Serial.printf("重連次數: %d\n", stats.reconnectCount);
+    Serial.printf("連線嘗試: %u 次 (失敗 %u 次，連續失敗 %u 次)，最近一次連線 %u ms，p95 %u ms\n",
+                  stats.connectAttempts, stats.connectFailures, backoff.getFailures(), stats.lastConnectMs,
+                  connectLatency.percentile(0.95f) / 1000);
     Serial.printf("發布錯誤: %d\n", stats.publishErrors);
+    Serial.printf("特徵幀: %d\n", stats.featureFramesExtracted);
+    Serial.printf("特徵環形緩衝區高水位: %d/%d 塊\n", featureRing.getHighWaterMark(), FEATURE_RING_BLOCKS);
+    Serial.printf("音訊塊池: 使用中 %d, 高水位 %d/%d, 用盡 %d 次\n", blockPool.getInUse(),
+                  blockPool.getHighWaterMark(), AUDIO_POOL_BLOCKS, blockPool.getExhaustedCount());
+    Serial.printf("特徵遺失跳距: %d\n", getFeatureDroppedHops());
+    Serial.printf("斷線暫存: 積壓 %.1f 秒 (%u 位元組, 快閃 %u), 容量 %.0f 秒, 已補發 %u, 丟棄 %u\n",
+                  getSpoolBacklogSeconds(), (unsigned)spool.getBacklogBytes(), (unsigned)spool.getFlashUsed(),
+                  getSpoolCapacitySeconds(), stats.spoolReplayedRecords, spool.getDroppedRecords());
+    if (rtpStream.isActive())
+    {
+        char target[RTP_TARGET_TEXT_SIZE];
+        rtpStream.getTarget(target, sizeof(target));
+        Serial.printf("RTP 串流: → %s:%u, 已送出 %u 包, 送出失敗 %u, 裝置端遺失 %u 次\n",
+                      target, rtpStream.getTargetPort(), rtpStream.getPacketsSent(),
+                      rtpStream.getSendErrors(), rtpStream.getBlockGaps());
+    }
     Serial.println("========================");
 }
 
@@ -614,116 +1942,451 @@ void AudioMqttManager::mqttTask(void *parameter)
 {
     AudioMqttManager *manager = static_cast<AudioMqttManager *>(parameter);
 
-    while (true)
+    while (manager->tasksRunning)
     {
         manager->loop();
         vTaskDelay(pdMS_TO_TICKS(10));
     }
+
+    xSemaphoreGive(manager->taskExitSemaphore);
+    vTaskDelete(nullptr);
 }
 
-void AudioMqttManager::audioPublishTask(void *parameter)
+void AudioMqttManager::publisherTask(void *parameter)
 {
     AudioMqttManager *manager = static_cast<AudioMqttManager *>(parameter);
-    MqttAudioPacket packet;
     uint32_t processedPackets = 0;
+    uint32_t idleCount = 0;
+    uint32_t featurePendingSince = 0;
+    bool featureWaiting = false;
+    AudioBlock *batch[AUDIO_BATCH_MAX_PACKETS];
 
-    Serial.println("🎵 音訊發布任務已啟動");
+    Serial.println("🎵 MQTT 發布任務已啟動");
     Serial.printf("🔍 isPublishing 狀態: %s\n", manager->isPublishing ? "true" : "false");
 
     while (manager->isPublishing)
     {
-        if (xQueueReceive(manager->audioQueue, &packet, pdMS_TO_TICKS(100)) == pdTRUE)
+        // 設定請求在兩批訊息之間 (幀邊界) 一次套用，之後的批次都使用新設定
+        StreamConfigAck ack;
+        if (manager->applyRequestedConfig(&ack) && ack.command &&
+            xSemaphoreTake(manager->mqttMutex, pdMS_TO_TICKS(50)) == pdTRUE)
         {
-            processedPackets++;
+            manager->publishConfigAck(ack, nullptr);
+            xSemaphoreGive(manager->mqttMutex);
+        }
 
-            if (xSemaphoreTake(manager->mqttMutex, pdMS_TO_TICKS(100)) == pdTRUE)
+        // 每次迴圈都觀測緩衝區深度；控制器自行以視窗節流評估
+        manager->updateStreamQuality();
+
+        // 重新連線後限速補發暫存資料，每輪最多一則，與即時資料交錯
+        manager->replayStep();
+
+        bool audioReady = !manager->audioRing.empty();
+        bool featureReady = manager->featuresPending();
+
+        if (!audioReady && !featureReady)
+        {
+            // 等待擷取或特徵任務通知；逾時仍重新檢查一次
+            bool replaying = manager->isConnected && !manager->spool.empty();
+            TickType_t wait = pdMS_TO_TICKS(replaying ? SPOOL_REPLAY_INTERVAL_MS : 100);
+            if (xTaskNotifyWait(0, 0xFFFFFFFF, nullptr, wait) != pdTRUE && !replaying)
             {
-                bool publishResult = manager->publishAudioPacket(&packet);
-                if (publishResult)
+                // 沒有任何待發布訊息時，定期輸出狀態
+                idleCount++;
+                if (idleCount % 100 == 0) // 每10秒輸出一次（100 * 100ms）
                 {
-                    // 每100個包輸出一次成功統計
-                    if (processedPackets % 100 == 0)
-                    {
-                        Serial.printf("✓ 已處理 %d 個音訊包\n", processedPackets);
-                    }
+                    Serial.printf("🔄 MQTT 發布任務等待中 - 已處理: %d 包\n", processedPackets);
                 }
-                xSemaphoreGive(manager->mqttMutex);
             }
-            else
+            continue;
+        }
+
+        uint32_t now = millis();
+        if (featureReady && !featureWaiting)
+        {
+            featureWaiting = true;
+            featurePendingSince = now;
+        }
+        bool featureStarved = featureWaiting && now - featurePendingSince >= manager->config.featureIntervalMs;
+
+        if (audioReady && !featureStarved)
+        {
+            size_t count = manager->collectAudioBatch(batch);
+            manager->publishAudioStep(batch, count);
+
+            // 每100個包輸出一次統計
+            if ((processedPackets + count) / 100 != processedPackets / 100)
             {
-                Serial.println("⚠️ 無法獲取 MQTT 互斥鎖");
+                Serial.printf("✓ 已處理 %d 個音訊包\n", (int)(processedPackets + count));
             }
+            processedPackets += count;
         }
         else
         {
-            // 隊列空的時候，定期輸出狀態
-            static uint32_t idleCount = 0;
-            idleCount++;
-            if (idleCount % 100 == 0) // 每10秒輸出一次（100 * 100ms）
+            // 每次只發布一則特徵訊息 (緊湊格式最多 FEATURE_FRAME_BATCH 幀)，之後重新排程讓音訊優先
+            manager->publishFeatureStep();
+            featureWaiting = false;
+        }
+    }
+
+    Serial.println("🛑 MQTT 發布任務結束");
+    xSemaphoreGive(manager->publisherExitSemaphore);
+    vTaskDelete(nullptr);
+}
+
+void AudioMqttManager::publishAudioStep(AudioBlock **batch, size_t count)
+{
+    // 斷線期間直接寫入暫存區，不計入串流品質觀測
+    bool published = false;
+    uint64_t dequeued = monotonicMicros();
+    if (isConnected && xSemaphoreTake(mqttMutex, pdMS_TO_TICKS(100)) == pdTRUE)
+    {
+        uint64_t locked = monotonicMicros();
+
+        // 發布路徑不應有任何堆積配置 (見 getPublishHeapAllocs)
+        HeapAllocCounter::beginTracking();
+        frameSendMicros = 0;
+        published = publishAudioBatch(batch, count);
+        uint32_t sendMicros = frameSendMicros;
+        HeapAllocCounter::endTracking();
+        xSemaphoreGive(mqttMutex);
+
+        // 各階段只記錄成功發布的批次；批次內各包共用取出之後的階段
+        uint64_t now = monotonicMicros();
+        if (published)
+        {
+            uint32_t publishMicros = (uint32_t)(now - locked);
+            stageLatency[LATENCY_STAGE_LOCK].record((uint32_t)(locked - dequeued));
+            stageLatency[LATENCY_STAGE_ENCODE].record(publishMicros > sendMicros ? publishMicros - sendMicros : 0);
+            stageLatency[LATENCY_STAGE_SEND].record(sendMicros);
+            for (size_t i = 0; i < count; i++)
             {
-                Serial.printf("🔄 音訊發布任務等待中 - 已處理: %d 包\n", processedPackets);
+                stageLatency[LATENCY_STAGE_QUEUE].record((uint32_t)(dequeued - batch[i]->queuedMicros));
+                audioLatency.record((uint32_t)(now - batch[i]->captureMicros));
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(AUDIO_PUBLISH_INTERVAL));
+        quality.recordPublish((uint32_t)(now - batch[0]->captureMicros), published);
+    }
+    else if (isConnected)
+    {
+        Serial.println("⚠️ 無法獲取 MQTT 互斥鎖");
+        quality.recordPublish((uint32_t)(monotonicMicros() - batch[0]->captureMicros), false);
     }
 
-    Serial.println("🛑 音訊發布任務結束");
-    vTaskDelete(nullptr);
+    if (published)
+    {
+        spoolResyncPending = true;
+    }
+    else
+    {
+        spoolAudioBatch(batch, count);
+    }
+
+    // 發布完成後才放棄引用，塊在最後一個消費者釋放前不會被重新填寫
+    for (size_t i = 0; i < count; i++)
+    {
+        blockPool.release(batch[i]);
+    }
+    audioRing.release(count);
 }
 
-void AudioMqttManager::featurePublishTask(void *parameter)
+bool AudioMqttManager::featuresPending()
 {
-    AudioMqttManager *manager = static_cast<AudioMqttManager *>(parameter);
-    MqttMfccPacket mfccPacket;
-    MqttMelPacket melPacket;
-    MqttFeaturesPacket featuresPacket;
+    return uxQueueMessagesWaiting(featureQueue) > 0;
+}
 
-    while (manager->isPublishing)
+size_t AudioMqttManager::collectFeatureBatch()
+{
+    // 取出已排隊的連續幀 (不等待)；序號跳號、樣本位置不連續 (輸入有樣本遺失) 或跳距改變時停止，
+    // 讓下一則訊息從新的序號、位置與跳距開始 (訊息內第 i 幀的位置 = 第一幀 + i · hopSamples)
+    size_t count = 0;
+    MqttFeatureFrame next;
+    while (count < FEATURE_FRAME_BATCH && xQueuePeek(featureQueue, &next, 0) == pdTRUE)
     {
-        // 發布 MFCC
-        if (xQueueReceive(manager->mfccQueue, &mfccPacket, 0) == pdTRUE)
+        if (count > 0)
         {
-            if (xSemaphoreTake(manager->mqttMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+            const MqttFeatureFrame &last = featureBatch[count - 1];
+            if (next.sequence != (uint16_t)(last.sequence + 1) || next.hopSamples != featureBatch[0].hopSamples ||
+                next.samplePosition != last.samplePosition + last.hopSamples)
             {
-                manager->publishMfccPacket(&mfccPacket);
-                xSemaphoreGive(manager->mqttMutex);
+                break;
             }
         }
+        xQueueReceive(featureQueue, &featureBatch[count], 0);
+        count++;
+    }
+    return count;
+}
+
+void AudioMqttManager::publishFeatureStep()
+{
+    // 緊湊格式一次合併多幀；只有 JSON 時每次一幀 (三則訊息)，維持原本的排程粒度
+    size_t count = 0;
+    if (config.featureFormats & FEATURE_OUTPUT_FRAME)
+    {
+        count = collectFeatureBatch();
+    }
+    else if (xQueueReceive(featureQueue, &featureBatch[0], 0) == pdTRUE)
+    {
+        count = 1;
+    }
+    if (count == 0)
+    {
+        return;
+    }
 
-        // 發布梅爾能量
-        if (xQueueReceive(manager->melQueue, &melPacket, 0) == pdTRUE)
+    // 各串流的樣本位置跳躍 (輸入樣本遺失、特徵隊列已滿、MQTT 發布失敗而暫存) 以 GAP 旗標標記；倒退表示串流重新開始
+    uint64_t firstPosition = featureBatch[0].samplePosition;
+    uint64_t endPosition = featureBatch[count - 1].samplePosition + featureBatch[count - 1].hopSamples;
+    uint8_t sinkFlags = firstPosition > nextSinkFeaturePosition ? FEATURE_WIRE_FLAG_GAP : 0;
+    uint8_t mqttFlags = firstPosition > nextFeaturePosition ? FEATURE_WIRE_FLAG_GAP : 0;
+    nextSinkFeaturePosition = endPosition;
+
+    // 替代傳輸 (WebSocket 等) 不經過 MQTT，斷線期間照常送出；訊息只編碼一次
+    size_t sinkLength = 0;
+    for (uint8_t i = 0; i < audioSinkCount; i++)
+    {
+        if (audioSinks[i]->isActive() && audioSinks[i]->wantsFeatures())
         {
-            if (xSemaphoreTake(manager->mqttMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+            if (sinkLength == 0)
             {
-                manager->publishMelPacket(&melPacket);
-                xSemaphoreGive(manager->mqttMutex);
+                sinkLength = encodeFeatureFrames(featureBatch, count, sinkFlags, frameBuffer, sizeof(frameBuffer));
             }
+            if (sinkLength > 0)
+            {
+                audioSinks[i]->writeFeatures(frameBuffer, sinkLength);
+            }
+        }
+    }
+
+    // 斷線或無法取得互斥鎖時寫入暫存區
+    if (!isConnected || xSemaphoreTake(mqttMutex, pdMS_TO_TICKS(50)) != pdTRUE)
+    {
+        spoolFeatureFrames(featureBatch, count);
+        return;
+    }
+
+    HeapAllocCounter::beginTracking();
+    bool published = false;
+    if (config.featureFormats & FEATURE_OUTPUT_FRAME)
+    {
+        published = publishFeatureFrames(featureBatch, count, mqttFlags);
+    }
+    if (config.featureFormats & FEATURE_OUTPUT_JSON)
+    {
+        // JSON 只發布特徵集選取的主題
+        uint8_t set = config.featureSet;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (set & FEATURE_SET_MFCC)
+                published = publishMfccJson(featureBatch[i]) || published;
+            if (set & FEATURE_SET_MEL)
+                published = publishMelJson(featureBatch[i]) || published;
+            if (set & FEATURE_SET_STATS)
+                published = publishFeaturesJson(featureBatch[i]) || published;
+        }
+    }
+    HeapAllocCounter::endTracking();
+
+    xSemaphoreGive(mqttMutex);
+
+    uint64_t now = monotonicMicros();
+    if (published)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            featureLatency.record((uint32_t)(now - featureBatch[i].extractedMicros));
+        }
+        stats.featureGaps += mqttFlags ? 1 : 0;
+        nextFeaturePosition = endPosition;
+    }
+    quality.recordPublish((uint32_t)(now - featureBatch[0].extractedMicros), published);
+
+    if (!published)
+    {
+        spoolFeatureFrames(featureBatch, count);
+    }
+}
+
+void AudioMqttManager::spoolAudioBatch(const AudioBlock *const *batch, size_t count)
+{
+    if (!spool.isReady())
+    {
+        return;
+    }
+
+    // 暫存一律使用 IMA-ADPCM (每包帶起始狀態，可獨立解碼)，補發時發布到二進位主題
+    for (size_t p = 0; p < count; p++)
+    {
+        if (spoolResyncPending)
+        {
+            spoolEncoder.reset();
+        }
+
+        AudioWireHeader header;
+        header.version = AUDIO_WIRE_VERSION;
+        header.codec = AUDIO_CODEC_IMA_ADPCM;
+        header.flags = AUDIO_WIRE_FLAG_REPLAY | (spoolResyncPending ? AUDIO_WIRE_FLAG_RESYNC : 0);
+        header.sequence = batch[p]->sequenceNumber;
+        header.sampleCount = batch[p]->dataLength;
+        header.sampleRate = audioSampleRate;
+        header.samplePosition = batch[p]->samplePosition;
+        header.epochMicros = batch[p]->epochMicros;
+
+        size_t length = AudioWireFormat::encodeAdpcm(header, batch[p]->audioData, spoolEncoder,
+                                                     spoolBuffer, sizeof(spoolBuffer));
+        if (length > 0 && spool.append(SPOOL_RECORD_AUDIO, spoolBuffer, length, header.sampleCount))
+        {
+            spoolResyncPending = false;
         }
+        else
+        {
+            spoolResyncPending = true;
+        }
+    }
+
+    if (spool.getDroppedRecords() % 100 == 1 && spool.getDroppedRecords() > 0)
+    {
+        Serial.printf("⚠️ 斷線暫存區已滿，已丟棄 %u 筆記錄\n", spool.getDroppedRecords());
+    }
+}
+
+void AudioMqttManager::spoolFeatureFrames(const MqttFeatureFrame *frames, size_t count)
+{
+    if (!spool.isReady())
+    {
+        return;
+    }
+
+    // 不論即時輸出格式，暫存的特徵一律以緊湊幀補發
+    size_t length = encodeFeatureFrames(frames, count, FEATURE_WIRE_FLAG_REPLAY, spoolBuffer, sizeof(spoolBuffer));
+    if (length > 0)
+    {
+        spool.append(SPOOL_RECORD_FEATURES, spoolBuffer, length, 0);
+    }
+}
+
+void AudioMqttManager::replayStep()
+{
+    uint32_t now = millis();
+    replayTokens += (now - replayLastRefill) * SPOOL_REPLAY_BYTES_PER_SEC / 1000;
+    replayLastRefill = now;
+    if (replayTokens > SPOOL_REPLAY_BURST_BYTES)
+    {
+        replayTokens = SPOOL_REPLAY_BURST_BYTES;
+    }
+
+    if (!isConnected || spool.empty())
+    {
+        return;
+    }
+
+    // 連續的暫存音訊封包串接成一則訊息 (接收端依標頭切分)，特徵訊息各自發布
+    size_t length = 0;
+    uint8_t messageKind = 0;
+    uint32_t records = 0;
+    while (true)
+    {
+        uint8_t kind;
+        size_t next = spool.peek(&kind);
+        if (next == 0 || length + next > sizeof(frameBuffer) || length + next > replayTokens ||
+            (messageKind != 0 && (kind != messageKind || kind == SPOOL_RECORD_FEATURES)))
+        {
+            break;
+        }
+        if (spool.read(&kind, frameBuffer + length, sizeof(frameBuffer) - length) == 0)
+        {
+            break;
+        }
+        messageKind = kind;
+        length += next;
+        records++;
+    }
+
+    if (records == 0)
+    {
+        return;
+    }
+
+    const char *topic = messageKind == SPOOL_RECORD_AUDIO ? MQTT_TOPIC_AUDIO_BINARY : MQTT_TOPIC_FEATURE_FRAME;
+    bool published = false;
+    if (xSemaphoreTake(mqttMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+    {
+        HeapAllocCounter::beginTracking();
+        published = publishFrame(topic, frameBuffer, length);
+        HeapAllocCounter::endTracking();
+        xSemaphoreGive(mqttMutex);
+    }
+
+    // 發布失敗時記錄留在暫存區，下次重試
+    if (published)
+    {
+        spool.commitRead();
+        replayTokens -= length;
+        stats.spoolReplayedRecords += records;
+        stats.spoolReplayMessages++;
+    }
+    else
+    {
+        spool.rollbackRead();
+        stats.publishErrors++;
+    }
+}
+
+float AudioMqttManager::getSpoolCapacitySeconds()
+{
+    size_t bytesPerBlock = SPOOL_RECORD_HEADER_SIZE + AudioWireFormat::adpcmPacketSize(AUDIO_BLOCK_SAMPLES);
+    size_t capacity = spool.getRamCapacity() + spool.getFlashCapacity();
+    return (float)(capacity / bytesPerBlock) * AUDIO_BLOCK_SAMPLES / audioSampleRate;
+}
+
+void AudioMqttManager::featureExtractionTask(void *parameter)
+{
+    AudioMqttManager *manager = static_cast<AudioMqttManager *>(parameter);
+
+    Serial.printf("🔬 特徵提取任務已啟動 (核心 %d)\n", xPortGetCoreID());
 
-        // 發布其他特徵
-        if (xQueueReceive(manager->featuresQueue, &featuresPacket, 0) == pdTRUE)
+    while (manager->tasksRunning)
+    {
+        // 等待擷取任務通知；逾時仍檢查一次環形緩衝區
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+        FeatureBlockRef *ref;
+        while ((ref = manager->featureRing.front()) != nullptr)
         {
-            if (xSemaphoreTake(manager->mqttMutex, pdMS_TO_TICKS(50)) == pdTRUE)
+            if (ref->discontinuity)
+            {
+                manager->featureExtractor.resync();
+            }
+            // 跳距請求在輸入塊之間套用，下一幀之後生效 (回調中的 getHopSize() 即到下一幀的距離)
+            uint16_t hop = manager->featureHopSamples;
+            if (hop != manager->featureExtractor.getHopSize())
             {
-                manager->publishFeaturesPacket(&featuresPacket);
-                xSemaphoreGive(manager->mqttMutex);
+                manager->featureExtractor.setHopSize(hop);
             }
+            manager->featureInputPosition = ref->block->samplePosition;
+            manager->featureInputEpoch = ref->block->epochMicros;
+            manager->featureExtractor.processAudioFrame(ref->block->audioData, ref->block->dataLength);
+            manager->blockPool.release(ref->block);
+            manager->featureRing.release();
         }
-
-        vTaskDelay(pdMS_TO_TICKS(FEATURE_PUBLISH_INTERVAL));
     }
 
+    xSemaphoreGive(manager->taskExitSemaphore);
     vTaskDelete(nullptr);
 }
 
 // 靜態回調函數
+void AudioMqttManager::staticFeatureFrameCallback(AudioFeatureExtractor *extractor, void *context)
+{
+    static_cast<AudioMqttManager *>(context)->onFeatureFrame(extractor);
+}
+
 void AudioMqttManager::staticMqttCallback(char *topic, byte *payload, unsigned int length)
 {
     if (AudioMqttManager_instance)
     {
-        char message[length + 1];
-        memcpy(message, payload, length);
-        message[length] = '\0';
-        AudioMqttManager_instance->handleControlMessage(message);
+        // 解析器以長度為界，不需要複製成以 0 結尾的字串
+        AudioMqttManager_instance->handleControlMessage((const char *)payload, length);
     }
 }
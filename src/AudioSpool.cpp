@@ -0,0 +1,264 @@
+#include "AudioSpool.h"
+#include <LittleFS.h>
+#include "esp_heap_caps.h"
+
+AudioSpool::AudioSpool()
+    : ram(nullptr), ramCapacity(0), ramHead(0), ramTail(0), ramCursor(0), flashReady(false), flashCapacity(0),
+      flashWriteOffset(0), flashReadOffset(0), flashCursor(0), backlogRecords(0), backlogSamples(0),
+      backlogBytes(0), cursorRecords(0), cursorSamples(0), cursorBytes(0), droppedRecords(0), flashRecords(0)
+{
+}
+
+AudioSpool::~AudioSpool()
+{
+    end();
+}
+
+bool AudioSpool::begin(size_t ramBytes, size_t flashBytes)
+{
+    end();
+
+    // PSRAM 環形緩衝區 (開機時配置一次)
+    if (ramBytes > 0)
+    {
+        ram = (uint8_t *)heap_caps_malloc(ramBytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (ram)
+        {
+            ramCapacity = ramBytes;
+        }
+        else
+        {
+            Serial.printf("⚠️ 無法配置 %u KB PSRAM 暫存區\n", (unsigned)(ramBytes / 1024));
+        }
+    }
+
+    // LittleFS 溢出記錄檔：保留 10% 檔案系統空間
+    // 掛載失敗時不格式化 (分割區可能存有其他資料)，只停用快閃記憶體層
+    if (flashBytes > 0 && LittleFS.begin(false))
+    {
+        LittleFS.remove(SPOOL_FLASH_PATH);
+        size_t available = LittleFS.totalBytes() - LittleFS.usedBytes();
+        available -= available / 10;
+        flashCapacity = flashBytes < available ? flashBytes : available;
+        flashReady = flashCapacity > 0;
+    }
+    else if (flashBytes > 0)
+    {
+        Serial.println("⚠️ 無法掛載 LittleFS (不自動格式化)，暫存區只使用 PSRAM");
+    }
+
+    if (isReady())
+    {
+        Serial.printf("✓ 斷線暫存區: PSRAM %u KB, 快閃記憶體 %u KB\n", (unsigned)(ramCapacity / 1024),
+                      (unsigned)(getFlashCapacity() / 1024));
+    }
+    return isReady();
+}
+
+void AudioSpool::end()
+{
+    if (flashReady)
+    {
+        resetFlash();
+        flashReady = false;
+    }
+    if (ram)
+    {
+        heap_caps_free(ram);
+        ram = nullptr;
+    }
+    ramCapacity = 0;
+    clear();
+}
+
+void AudioSpool::clear()
+{
+    ramHead = ramTail = ramCursor = 0;
+    if (flashReady)
+    {
+        resetFlash();
+    }
+    backlogRecords = backlogSamples = 0;
+    backlogBytes = 0;
+    cursorRecords = cursorSamples = 0;
+    cursorBytes = 0;
+}
+
+void AudioSpool::resetFlash()
+{
+    if (flashLog)
+    {
+        flashLog.close();
+    }
+    LittleFS.remove(SPOOL_FLASH_PATH);
+    flashWriteOffset = flashReadOffset = flashCursor = 0;
+}
+
+void AudioSpool::ramWrite(size_t position, const uint8_t *data, size_t length)
+{
+    size_t offset = position % ramCapacity;
+    size_t first = ramCapacity - offset < length ? ramCapacity - offset : length;
+    memcpy(ram + offset, data, first);
+    memcpy(ram, data + first, length - first);
+}
+
+void AudioSpool::ramRead(size_t position, uint8_t *out, size_t length) const
+{
+    size_t offset = position % ramCapacity;
+    size_t first = ramCapacity - offset < length ? ramCapacity - offset : length;
+    memcpy(out, ram + offset, first);
+    memcpy(out + first, ram, length - first);
+}
+
+bool AudioSpool::appendFlash(const uint8_t *header, const uint8_t *data, size_t length)
+{
+    if (!flashReady || flashWriteOffset + SPOOL_RECORD_HEADER_SIZE + length > flashCapacity)
+    {
+        return false;
+    }
+    if (!flashLog)
+    {
+        flashLog = LittleFS.open(SPOOL_FLASH_PATH, "w+");
+        if (!flashLog)
+        {
+            return false;
+        }
+    }
+
+    flashLog.seek(flashWriteOffset);
+    if (flashLog.write(header, SPOOL_RECORD_HEADER_SIZE) != SPOOL_RECORD_HEADER_SIZE ||
+        flashLog.write(data, length) != length)
+    {
+        return false;
+    }
+    flashWriteOffset += SPOOL_RECORD_HEADER_SIZE + length;
+    flashRecords++;
+    return true;
+}
+
+bool AudioSpool::append(uint8_t kind, const uint8_t *data, size_t length, uint16_t samples)
+{
+    if (!data || length == 0 || length > SPOOL_RECORD_MAX_BYTES)
+    {
+        droppedRecords++;
+        return false;
+    }
+
+    uint8_t header[SPOOL_RECORD_HEADER_SIZE] = {kind, 0, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8),
+                                                (uint8_t)(samples & 0xFF), (uint8_t)(samples >> 8)};
+    size_t recordSize = SPOOL_RECORD_HEADER_SIZE + length;
+
+    // 記錄檔有資料時必須接在後面，否則會比 PSRAM 中的新記錄更晚讀到
+    bool stored = false;
+    if (flashWriteOffset == 0 && ramCapacity - (ramHead - ramTail) >= recordSize)
+    {
+        ramWrite(ramHead, header, SPOOL_RECORD_HEADER_SIZE);
+        ramWrite(ramHead + SPOOL_RECORD_HEADER_SIZE, data, length);
+        ramHead += recordSize;
+        stored = true;
+    }
+    else
+    {
+        stored = appendFlash(header, data, length);
+    }
+
+    if (!stored)
+    {
+        droppedRecords++;
+        return false;
+    }
+    backlogRecords++;
+    backlogSamples += samples;
+    backlogBytes += recordSize;
+    return true;
+}
+
+size_t AudioSpool::peek(uint8_t *kind)
+{
+    uint8_t header[SPOOL_RECORD_HEADER_SIZE];
+    if (ramCursor < ramHead)
+    {
+        ramRead(ramCursor, header, SPOOL_RECORD_HEADER_SIZE);
+    }
+    else if (flashCursor < flashWriteOffset)
+    {
+        flashLog.seek(flashCursor);
+        if (flashLog.read(header, SPOOL_RECORD_HEADER_SIZE) != SPOOL_RECORD_HEADER_SIZE)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+    *kind = header[0];
+    return header[2] | (header[3] << 8);
+}
+
+size_t AudioSpool::read(uint8_t *kind, uint8_t *out, size_t capacity)
+{
+    uint8_t header[SPOOL_RECORD_HEADER_SIZE];
+    size_t length;
+
+    if (ramCursor < ramHead)
+    {
+        ramRead(ramCursor, header, SPOOL_RECORD_HEADER_SIZE);
+        length = header[2] | (header[3] << 8);
+        if (length > capacity)
+        {
+            return 0;
+        }
+        ramRead(ramCursor + SPOOL_RECORD_HEADER_SIZE, out, length);
+        ramCursor += SPOOL_RECORD_HEADER_SIZE + length;
+    }
+    else if (flashCursor < flashWriteOffset)
+    {
+        flashLog.seek(flashCursor);
+        if (flashLog.read(header, SPOOL_RECORD_HEADER_SIZE) != SPOOL_RECORD_HEADER_SIZE)
+        {
+            return 0;
+        }
+        length = header[2] | (header[3] << 8);
+        if (length > capacity || flashLog.read(out, length) != length)
+        {
+            return 0;
+        }
+        flashCursor += SPOOL_RECORD_HEADER_SIZE + length;
+    }
+    else
+    {
+        return 0;
+    }
+
+    *kind = header[0];
+    cursorRecords++;
+    cursorSamples += header[4] | (header[5] << 8);
+    cursorBytes += SPOOL_RECORD_HEADER_SIZE + length;
+    return length;
+}
+
+void AudioSpool::commitRead()
+{
+    ramTail = ramCursor;
+    flashReadOffset = flashCursor;
+    backlogRecords -= cursorRecords;
+    backlogSamples -= cursorSamples;
+    backlogBytes -= cursorBytes;
+    cursorRecords = cursorSamples = 0;
+    cursorBytes = 0;
+
+    // 記錄檔讀完即刪除，之後的新記錄回到 PSRAM
+    if (flashWriteOffset > 0 && flashReadOffset == flashWriteOffset)
+    {
+        resetFlash();
+    }
+}
+
+void AudioSpool::rollbackRead()
+{
+    ramCursor = ramTail;
+    flashCursor = flashReadOffset;
+    cursorRecords = cursorSamples = 0;
+    cursorBytes = 0;
+}
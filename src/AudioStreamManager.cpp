@@ -0,0 +1,120 @@
+#include "AudioStreamManager.h"
+#include <WiFi.h>
+#include "lwip/sockets.h"
+
+AudioStreamManager::AudioStreamManager()
+    : socketFd(-1), active(false), restartPending(false), targetAddress(0), targetPort(RTP_DEFAULT_PORT)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+AudioStreamManager::~AudioStreamManager()
+{
+    end();
+}
+
+bool AudioStreamManager::begin()
+{
+    if (socketFd >= 0)
+    {
+        return true;
+    }
+
+    socketFd = lwip_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (socketFd < 0)
+    {
+        Serial.println("✗ 無法建立 RTP UDP socket");
+        return false;
+    }
+    return true;
+}
+
+void AudioStreamManager::end()
+{
+    stop();
+    if (socketFd >= 0)
+    {
+        lwip_close(socketFd);
+        socketFd = -1;
+    }
+}
+
+bool AudioStreamManager::start(const char *host, uint16_t port)
+{
+    // 只接受 IP 位址：名稱解析可能阻塞，而目標由 MQTT 任務設定
+    IPAddress address;
+    if (!host || port == 0 || !address.fromString(host))
+    {
+        Serial.printf("✗ 無效的 RTP 目標: %s:%u\n", host ? host : "(null)", port);
+        return false;
+    }
+    if (!begin())
+    {
+        return false;
+    }
+
+    active = false;
+    targetAddress = (uint32_t)address;
+    targetPort = port;
+    restartPending = true;
+    active = true;
+
+    Serial.printf("✓ RTP 串流已啟動 → %s:%u\n", host, port);
+    return true;
+}
+
+void AudioStreamManager::stop()
+{
+    if (active)
+    {
+        active = false;
+        Serial.println("RTP 串流已停止");
+    }
+}
+
+bool AudioStreamManager::writeBlock(const AudioBlock &block)
+{
+    if (!active || socketFd < 0)
+    {
+        return false;
+    }
+
+    // 新串流：隨機的 SSRC、起始序號與時間戳 (RFC 3550)，第一個資料報帶 M 位元
+    if (restartPending.exchange(false))
+    {
+        rtp.restart(esp_random(), (uint16_t)esp_random(), esp_random());
+    }
+
+    // 裝置端遺失的樣本 (塊池用盡) 使時間戳跳過對應的樣本數並標記 M 位元 (見 RtpPacketizer)
+    bool sourceGap = false;
+    size_t length = rtp.encode(block.audioData, block.dataLength, block.samplePosition, packet, sizeof(packet),
+                               &sourceGap);
+    if (sourceGap)
+    {
+        stats.blockGaps++;
+    }
+
+    struct sockaddr_in target;
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_addr.s_addr = targetAddress;
+    target.sin_port = htons(targetPort);
+
+    if (length == 0 ||
+        lwip_sendto(socketFd, packet, length, MSG_DONTWAIT, (struct sockaddr *)&target, sizeof(target)) < 0)
+    {
+        stats.sendErrors++;
+        return false;
+    }
+
+    rtp.markSent();
+    stats.packetsSent++;
+    stats.bytesSent += length;
+    return true;
+}
+
+void AudioStreamManager::getTarget(char *out, size_t size)
+{
+    snprintf(out, size, "%u.%u.%u.%u", (unsigned)(targetAddress & 0xFF), (unsigned)((targetAddress >> 8) & 0xFF),
+             (unsigned)((targetAddress >> 16) & 0xFF), (unsigned)(targetAddress >> 24));
+}
@@ -0,0 +1,144 @@
+#include "AudioWebSocketServer.h"
+
+AudioWebSocketServer::AudioWebSocketServer(uint16_t port)
+    : server(port), taskHandle(nullptr), port(port), running(false), sampleRate(16000)
+{
+}
+
+AudioWebSocketServer::~AudioWebSocketServer()
+{
+    end();
+}
+
+bool AudioWebSocketServer::begin(uint32_t sampleRate)
+{
+    if (running)
+    {
+        return true;
+    }
+
+    this->sampleRate = sampleRate;
+    server.onEvent([this](uint8_t num, WStype_t type, uint8_t *payload, size_t length)
+                   { onEvent(num, type, payload, length); });
+    server.begin();
+
+    // 伺服器的 loop() 與 sendBIN() 都在這個任務中執行 (函式庫不是執行緒安全的)
+    running = true;
+    BaseType_t result = xTaskCreatePinnedToCore(
+        serverTask,
+        "WS_Stream",
+        WS_TASK_STACK_SIZE,
+        this,
+        WS_TASK_PRIORITY,
+        &taskHandle,
+        WS_TASK_CORE);
+
+    if (result != pdPASS)
+    {
+        running = false;
+        server.close();
+        Serial.println("✗ 無法創建 WebSocket 串流任務");
+        return false;
+    }
+
+    Serial.printf("✓ WebSocket 串流伺服器已啟動 (埠 %u)\n", port);
+    return true;
+}
+
+void AudioWebSocketServer::end()
+{
+    if (!running)
+    {
+        return;
+    }
+
+    running = false;
+    if (taskHandle)
+    {
+        vTaskDelete(taskHandle);
+        taskHandle = nullptr;
+    }
+    server.close();
+    for (uint8_t i = 0; i < WS_STREAM_MAX_CLIENTS; i++)
+    {
+        core.removeClient(i);
+    }
+}
+
+void AudioWebSocketServer::onEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length)
+{
+    switch (type)
+    {
+    case WStype_CONNECTED:
+    {
+        uint8_t subscriptions = WebSocketStreamCore::parseSubscriptions((const char *)payload);
+        if (!core.addClient(num, subscriptions))
+        {
+            // 超過隊列數量的客戶端直接拒絕
+            server.disconnect(num);
+            return;
+        }
+        Serial.printf("🔌 WebSocket 客戶端 %u 已連線: %s (訂閱 0x%02X)\n", num, (const char *)payload,
+                      subscriptions);
+        break;
+    }
+
+    case WStype_DISCONNECTED:
+    {
+        WebSocketStreamCore::ClientStats stats = core.getClientStats(num);
+        core.removeClient(num);
+        Serial.printf("🔌 WebSocket 客戶端 %u 已斷線 (送出 %u, 丟棄 %u)\n", num, stats.sent, stats.dropped);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void AudioWebSocketServer::serverTask(void *parameter)
+{
+    AudioWebSocketServer *manager = static_cast<AudioWebSocketServer *>(parameter);
+
+    while (manager->running)
+    {
+        manager->server.loop();
+
+        // 每個客戶端輪流送出最多 WS_SEND_BUDGET 則，隊列中剩下的留到下一輪
+        bool pending = false;
+        for (uint8_t id = 0; id < WS_STREAM_MAX_CLIENTS; id++)
+        {
+            for (uint8_t n = 0; n < WS_SEND_BUDGET; n++)
+            {
+                size_t length = manager->core.pop(id, manager->sendBuffer, sizeof(manager->sendBuffer));
+                if (length == 0)
+                {
+                    break;
+                }
+                manager->server.sendBIN(id, manager->sendBuffer, length);
+            }
+            pending = pending || manager->core.getQueueDepth(id) > 0;
+        }
+
+        vTaskDelay(pending ? 1 : pdMS_TO_TICKS(WS_TASK_INTERVAL_MS));
+    }
+
+    vTaskDelete(nullptr);
+}
+
+bool AudioWebSocketServer::writeBlock(const AudioBlock &block)
+{
+    if (!core.wantsAudio())
+    {
+        return false;
+    }
+    core.pushAudio(block.audioData, block.dataLength, block.sequenceNumber, block.samplePosition, block.epochMicros,
+                   sampleRate);
+    return true;
+}
+
+bool AudioWebSocketServer::writeFeatures(const uint8_t *message, size_t length)
+{
+    core.pushFeatures(message, length);
+    return true;
+}
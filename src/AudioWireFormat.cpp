@@ -0,0 +1,166 @@
+#include "AudioWireFormat.h"
+
+static inline void putU16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static inline void putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)((value >> 8) & 0xFF);
+    out[2] = (uint8_t)((value >> 16) & 0xFF);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static inline void putU64(uint8_t *out, uint64_t value)
+{
+    putU32(out, (uint32_t)value);
+    putU32(out + 4, (uint32_t)(value >> 32));
+}
+
+static inline uint16_t getU16(const uint8_t *in)
+{
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static inline uint32_t getU32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static inline uint64_t getU64(const uint8_t *in)
+{
+    return (uint64_t)getU32(in) | ((uint64_t)getU32(in + 4) << 32);
+}
+
+size_t AudioWireFormat::writeHeader(const AudioWireHeader &header, uint8_t *out, size_t capacity)
+{
+    if (!out || capacity < AUDIO_WIRE_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    out[0] = AUDIO_WIRE_MAGIC;
+    out[1] = AUDIO_WIRE_VERSION;
+    out[2] = header.codec;
+    out[3] = header.flags;
+    putU16(out + 4, header.sequence);
+    putU16(out + 6, header.sampleCount);
+    putU32(out + 8, header.sampleRate);
+    putU64(out + 12, header.samplePosition);
+    putU64(out + 20, header.epochMicros);
+    return AUDIO_WIRE_HEADER_SIZE;
+}
+
+size_t AudioWireFormat::encodePcm(const AudioWireHeader &header, const int16_t *samples, uint8_t *out, size_t capacity)
+{
+    size_t total = pcmPacketSize(header.sampleCount);
+    if (!samples || capacity < total)
+    {
+        return 0;
+    }
+
+    AudioWireHeader pcmHeader = header;
+    pcmHeader.codec = AUDIO_CODEC_PCM16;
+    writeHeader(pcmHeader, out, capacity);
+
+    uint8_t *payload = out + AUDIO_WIRE_HEADER_SIZE;
+    for (uint16_t i = 0; i < header.sampleCount; i++)
+    {
+        putU16(payload + 2 * i, (uint16_t)samples[i]);
+    }
+    return total;
+}
+
+size_t AudioWireFormat::encodeAdpcm(const AudioWireHeader &header, const int16_t *samples, ImaAdpcmCodec &encoder,
+                                    uint8_t *out, size_t capacity)
+{
+    size_t total = adpcmPacketSize(header.sampleCount);
+    if (!samples || capacity < total)
+    {
+        return 0;
+    }
+
+    AudioWireHeader adpcmHeader = header;
+    adpcmHeader.codec = AUDIO_CODEC_IMA_ADPCM;
+    writeHeader(adpcmHeader, out, capacity);
+
+    uint8_t *payload = out + AUDIO_WIRE_HEADER_SIZE;
+    const ImaAdpcmState &state = encoder.getState();
+    putU16(payload, (uint16_t)state.predictor);
+    payload[2] = state.stepIndex;
+    payload[3] = 0;
+
+    encoder.encode(samples, header.sampleCount, payload + AUDIO_WIRE_ADPCM_STATE_SIZE);
+    return total;
+}
+
+bool AudioWireFormat::readHeader(const uint8_t *data, size_t length, AudioWireHeader *header)
+{
+    if (!data || !header || length < AUDIO_WIRE_HEADER_SIZE)
+    {
+        return false;
+    }
+    if (data[0] != AUDIO_WIRE_MAGIC || data[1] != AUDIO_WIRE_VERSION)
+    {
+        return false;
+    }
+
+    header->version = data[1];
+    header->codec = data[2];
+    header->flags = data[3];
+    header->sequence = getU16(data + 4);
+    header->sampleCount = getU16(data + 6);
+    header->sampleRate = getU32(data + 8);
+    header->samplePosition = getU64(data + 12);
+    header->epochMicros = getU64(data + 20);
+    return true;
+}
+
+int AudioWireFormat::decodePcm(const uint8_t *data, size_t length, int16_t *samples, size_t maxSamples)
+{
+    AudioWireHeader header;
+    if (!readHeader(data, length, &header) || header.codec != AUDIO_CODEC_PCM16)
+    {
+        return -1;
+    }
+    if (length < pcmPacketSize(header.sampleCount) || header.sampleCount > maxSamples || !samples)
+    {
+        return -1;
+    }
+
+    const uint8_t *payload = data + AUDIO_WIRE_HEADER_SIZE;
+    for (uint16_t i = 0; i < header.sampleCount; i++)
+    {
+        samples[i] = (int16_t)getU16(payload + 2 * i);
+    }
+    return header.sampleCount;
+}
+
+int AudioWireFormat::decodeAdpcm(const uint8_t *data, size_t length, int16_t *samples, size_t maxSamples, ImaAdpcmCodec &decoder)
+{
+    AudioWireHeader header;
+    if (!readHeader(data, length, &header) || header.codec != AUDIO_CODEC_IMA_ADPCM)
+    {
+        return -1;
+    }
+    if (length < adpcmPacketSize(header.sampleCount) || header.sampleCount > maxSamples || !samples)
+    {
+        return -1;
+    }
+
+    const uint8_t *payload = data + AUDIO_WIRE_HEADER_SIZE;
+    ImaAdpcmState state;
+    state.predictor = (int16_t)getU16(payload);
+    state.stepIndex = payload[2];
+    if (state.stepIndex > 88)
+    {
+        return -1;
+    }
+    decoder.setState(state);
+
+    decoder.decode(payload + AUDIO_WIRE_ADPCM_STATE_SIZE, header.sampleCount, samples);
+    return header.sampleCount;
+}
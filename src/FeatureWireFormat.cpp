@@ -0,0 +1,294 @@
+#include "FeatureWireFormat.h"
+#include <string.h>
+#include <math.h>
+
+static inline void putU16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static inline void putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)((value >> 8) & 0xFF);
+    out[2] = (uint8_t)((value >> 16) & 0xFF);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static inline void putU64(uint8_t *out, uint64_t value)
+{
+    putU32(out, (uint32_t)value);
+    putU32(out + 4, (uint32_t)(value >> 32));
+}
+
+static inline uint16_t getU16(const uint8_t *in)
+{
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static inline uint32_t getU32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static inline uint64_t getU64(const uint8_t *in)
+{
+    return (uint64_t)getU32(in) | ((uint64_t)getU32(in + 4) << 32);
+}
+
+// 四捨五入並飽和到 int16
+static inline int16_t quantize(float value, int8_t q)
+{
+    float scaled = ldexpf(value, q);
+    if (!(scaled == scaled))
+    {
+        return 0; // NaN
+    }
+    scaled = scaled >= 0 ? scaled + 0.5f : scaled - 0.5f;
+    if (scaled > 32767.0f)
+        return 32767;
+    if (scaled < -32768.0f)
+        return -32768;
+    return (int16_t)scaled;
+}
+
+void FeatureWireFormat::initHeader(FeatureWireHeader &header, uint8_t encoding, uint8_t mfccCount, uint8_t melCount,
+                                   uint16_t hopSamples, uint32_t sampleRate)
+{
+    header.version = FEATURE_WIRE_VERSION;
+    header.encoding = encoding;
+    header.frameCount = 0;
+    header.mfccCount = mfccCount;
+    header.melCount = melCount;
+    header.statCount = FEATURE_WIRE_STAT_COUNT;
+    header.flags = 0;
+    header.sequence = 0;
+    header.hopSamples = hopSamples;
+    header.sampleRate = sampleRate;
+    header.samplePosition = 0;
+    header.epochMicros = 0;
+    header.mfccQ = FEATURE_MFCC_Q;
+    header.melQ = FEATURE_MEL_Q;
+    header.statQ[0] = FEATURE_HZ_Q;   // centroid
+    header.statQ[1] = FEATURE_HZ_Q;   // bandwidth
+    header.statQ[2] = FEATURE_HZ_Q;   // rolloff
+    header.statQ[3] = FEATURE_UNIT_Q; // flatness
+    header.statQ[4] = FEATURE_UNIT_Q; // zeroCrossingRate
+    header.statQ[5] = FEATURE_UNIT_Q; // rmsEnergy
+}
+
+size_t FeatureWireFormat::writeHeader(const FeatureWireHeader &header, uint8_t *out, size_t capacity)
+{
+    if (!out || capacity < FEATURE_WIRE_HEADER_SIZE ||
+        (header.statCount != FEATURE_WIRE_STAT_COUNT && header.statCount != 0))
+    {
+        return 0;
+    }
+
+    out[0] = FEATURE_WIRE_MAGIC;
+    out[1] = FEATURE_WIRE_VERSION;
+    out[2] = header.encoding;
+    out[3] = header.frameCount;
+    out[4] = header.mfccCount;
+    out[5] = header.melCount;
+    out[6] = header.statCount;
+    out[7] = header.flags;
+    putU16(out + 8, header.sequence);
+    putU16(out + 10, header.hopSamples);
+    putU32(out + 12, header.sampleRate);
+    putU64(out + 16, header.samplePosition);
+    putU64(out + 24, header.epochMicros);
+    out[32] = (uint8_t)header.mfccQ;
+    out[33] = (uint8_t)header.melQ;
+    for (int i = 0; i < FEATURE_WIRE_STAT_COUNT; i++)
+    {
+        out[34 + i] = (uint8_t)header.statQ[i];
+    }
+    return FEATURE_WIRE_HEADER_SIZE;
+}
+
+size_t FeatureWireFormat::writeFrame(const FeatureWireHeader &header, const float *mfcc, const float *mel,
+                                     const float *stats, uint8_t *out, size_t capacity)
+{
+    size_t size = frameSize(header);
+    if (!out || !mfcc || !mel || !stats || capacity < size)
+    {
+        return 0;
+    }
+
+    bool half = header.encoding == FEATURE_ENCODING_FLOAT16;
+    uint8_t *p = out;
+    for (int i = 0; i < header.mfccCount; i++, p += 2)
+    {
+        putU16(p, half ? floatToHalf(mfcc[i]) : (uint16_t)quantize(mfcc[i], header.mfccQ));
+    }
+    for (int i = 0; i < header.melCount; i++, p += 2)
+    {
+        putU16(p, half ? floatToHalf(mel[i]) : (uint16_t)quantize(mel[i], header.melQ));
+    }
+    for (int i = 0; i < header.statCount; i++, p += 2)
+    {
+        putU16(p, half ? floatToHalf(stats[i]) : (uint16_t)quantize(stats[i], header.statQ[i]));
+    }
+    return size;
+}
+
+bool FeatureWireFormat::readHeader(const uint8_t *data, size_t length, FeatureWireHeader *header)
+{
+    if (!data || !header || length < FEATURE_WIRE_HEADER_SIZE)
+    {
+        return false;
+    }
+    if (data[0] != FEATURE_WIRE_MAGIC || data[1] != FEATURE_WIRE_VERSION ||
+        (data[6] != FEATURE_WIRE_STAT_COUNT && data[6] != 0))
+    {
+        return false;
+    }
+
+    header->version = data[1];
+    header->encoding = data[2];
+    header->frameCount = data[3];
+    header->mfccCount = data[4];
+    header->melCount = data[5];
+    header->statCount = data[6];
+    header->flags = data[7];
+    header->sequence = getU16(data + 8);
+    header->hopSamples = getU16(data + 10);
+    header->sampleRate = getU32(data + 12);
+    header->samplePosition = getU64(data + 16);
+    header->epochMicros = getU64(data + 24);
+    header->mfccQ = (int8_t)data[32];
+    header->melQ = (int8_t)data[33];
+    for (int i = 0; i < FEATURE_WIRE_STAT_COUNT; i++)
+    {
+        header->statQ[i] = (int8_t)data[34 + i];
+    }
+    return length >= packetSize(*header);
+}
+
+bool FeatureWireFormat::readFrame(const uint8_t *data, size_t length, uint8_t index, float *values, size_t maxValues)
+{
+    FeatureWireHeader header;
+    if (!readHeader(data, length, &header) || index >= header.frameCount || !values)
+    {
+        return false;
+    }
+
+    size_t count = (size_t)header.mfccCount + header.melCount + header.statCount;
+    if (count > maxValues)
+    {
+        return false;
+    }
+
+    bool half = header.encoding == FEATURE_ENCODING_FLOAT16;
+    const uint8_t *p = data + FEATURE_WIRE_HEADER_SIZE + index * frameSize(header);
+    for (size_t i = 0; i < count; i++, p += 2)
+    {
+        uint16_t raw = getU16(p);
+        if (half)
+        {
+            values[i] = halfToFloat(raw);
+            continue;
+        }
+
+        int8_t q;
+        if (i < header.mfccCount)
+            q = header.mfccQ;
+        else if (i < (size_t)header.mfccCount + header.melCount)
+            q = header.melQ;
+        else
+            q = header.statQ[i - header.mfccCount - header.melCount];
+        values[i] = ldexpf((float)(int16_t)raw, -q);
+    }
+    return true;
+}
+
+uint16_t FeatureWireFormat::floatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF);
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF)
+    {
+        // Inf / NaN
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    }
+
+    int32_t halfExponent = exponent - 127 + 15;
+    if (halfExponent >= 31)
+    {
+        return (uint16_t)(sign | 0x7C00); // 溢位 → 無限大
+    }
+
+    if (halfExponent <= 0)
+    {
+        // 次正規數或 0
+        if (halfExponent < -10)
+        {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - halfExponent;
+        uint32_t halfMantissa = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (halfMantissa & 1)))
+        {
+            halfMantissa++;
+        }
+        return (uint16_t)(sign | halfMantissa);
+    }
+
+    uint32_t halfBits = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (halfBits & 1)))
+    {
+        halfBits++; // 進位可能溢入指數，結果仍正確 (最大值進位成無限大)
+    }
+    return (uint16_t)(sign | halfBits);
+}
+
+float FeatureWireFormat::halfToFloat(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    int32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+
+    if (exponent == 0)
+    {
+        if (mantissa == 0)
+        {
+            bits = sign;
+        }
+        else
+        {
+            // 次正規數：正規化
+            exponent = 1;
+            while ((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            mantissa &= 0x3FF;
+            bits = sign | ((uint32_t)(exponent - 15 + 127) << 23) | (mantissa << 13);
+        }
+    }
+    else if (exponent == 31)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((uint32_t)(exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
@@ -0,0 +1,509 @@
+#include "FixedPointMfcc.h"
+#include <string.h>
+#include <math.h>
+
+// 成員函數定義共用的模板前綴
+#define FPM_TEMPLATE template <uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks, uint8_t MfccCoeffs, uint16_t FrameSize>
+#define FPM_CLASS FixedPointMfccT<SampleRate, FftSize, MelBanks, MfccCoeffs, FrameSize>
+
+// Q15 乘法四捨五入常數
+#define Q15_ROUND (1 << 14)
+
+FPM_TEMPLATE
+FPM_CLASS::FixedPointMfccT()
+{
+    memset(fftRe, 0, sizeof(fftRe));
+    memset(fftIm, 0, sizeof(fftIm));
+    memset(power, 0, sizeof(power));
+    memset(logMelQ16, 0, sizeof(logMelQ16));
+    memset(mfccQ16, 0, sizeof(mfccQ16));
+    frameExponent = FIXED_MIN_EXPONENT;
+    powerFloor = 0;
+}
+
+FPM_TEMPLATE
+int FPM_CLASS::selectExponent(const int16_t *frame)
+{
+    // 峰值的最高位元決定比例，使加窗後 |x| < 2^22
+    int32_t peak = 1;
+    for (int i = 0; i < FrameSize; i++)
+    {
+        int32_t magnitude = frame[i] < 0 ? -(int32_t)frame[i] : frame[i];
+        if (magnitude > peak)
+        {
+            peak = magnitude;
+        }
+    }
+    int msb = 31 - __builtin_clz((uint32_t)peak);
+    return FIXED_MAX_EXPONENT - msb;
+}
+
+FPM_TEMPLATE
+int32_t FPM_CLASS::scaleSample(int32_t product, int exponent)
+{
+    // product = s·w (Q30)，乘上 2^(exponent-30)；右移時四捨五入
+    int shift = exponent - 30;
+    if (shift >= 0)
+    {
+        return product << shift;
+    }
+    return (product + (1 << (-shift - 1))) >> -shift;
+}
+
+FPM_TEMPLATE
+int32_t FPM_CLASS::log2Q16(uint64_t value)
+{
+    // value = 2^msb · (1 + f)，f 取 22 位元：高 6 位查表、低 16 位線性內插
+    int msb = 63 - __builtin_clzll(value);
+    uint32_t fraction;
+    if (msb >= 22)
+    {
+        fraction = (uint32_t)(value >> (msb - 22)) & 0x3FFFFF;
+    }
+    else
+    {
+        fraction = (uint32_t)(value << (22 - msb)) & 0x3FFFFF;
+    }
+
+    uint32_t index = fraction >> 16;
+    int32_t interp = (int32_t)(fraction & 0xFFFF);
+    int32_t low = log2Table[index];
+    int32_t high = log2Table[index + 1];
+    int32_t mantissa = low + (int32_t)(((int64_t)(high - low) * interp + 0x8000) >> 16);
+
+    return (msb << 16) + mantissa;
+}
+
+FPM_TEMPLATE
+int32_t FPM_CLASS::toNaturalLogQ16(uint64_t energy) const
+{
+    if (energy == 0)
+    {
+        energy = 1;
+    }
+    int32_t log2Value = log2Q16(energy) - ((BASE_LOG2_OFFSET + 2 * frameExponent) << 16);
+    return (int32_t)(((int64_t)log2Value * Q16_LN2 + 0x8000) >> 16);
+}
+
+FPM_TEMPLATE
+double FPM_CLASS::getPowerScale() const
+{
+    return ldexp(1.0, 2 * LOG2_FFT_SIZE - 2 * frameExponent);
+}
+
+// ===== 參考實作 =====
+
+FPM_TEMPLATE
+void FPM_CLASS::windowReference(const int16_t *frame)
+{
+    frameExponent = selectExponent(frame);
+    powerFloor = powerFloorTable[frameExponent - FIXED_MIN_EXPONENT];
+
+    // 偶數樣本作實部、奇數樣本作虛部，不足 FFT_SIZE 補零
+    for (int n = 0; n < HALF_SIZE; n++)
+    {
+        int i = 2 * n;
+        if (i < FrameSize)
+        {
+            fftRe[n] = scaleSample((int32_t)frame[i] * windowTable[i], frameExponent);
+            fftIm[n] = scaleSample((int32_t)frame[i + 1] * windowTable[i + 1], frameExponent);
+        }
+        else
+        {
+            fftRe[n] = 0;
+            fftIm[n] = 0;
+        }
+    }
+
+    // 位元反轉重排
+    for (int n = 0; n < HALF_SIZE; n++)
+    {
+        int r = bitReverse[n];
+        if (r > n)
+        {
+            int32_t t = fftRe[n];
+            fftRe[n] = fftRe[r];
+            fftRe[r] = t;
+            t = fftIm[n];
+            fftIm[n] = fftIm[r];
+            fftIm[r] = t;
+        }
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::fftReference()
+{
+    // 基 2 時間抽取：t = W·b (W 為 1 或 -j 時精確，不經乘法)，a' = (a + t + 1) >> 1，b' = (a - t + 1) >> 1
+    for (int len = 2; len <= HALF_SIZE; len <<= 1)
+    {
+        int half = len / 2;
+        int step = HALF_SIZE / len;
+
+        for (int start = 0; start < HALF_SIZE; start += len)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                int a = start + k;
+                int b = a + half;
+                int t = k * step;
+                int32_t br = fftRe[b];
+                int32_t bi = fftIm[b];
+                int32_t tr, ti;
+
+                if (t == 0)
+                {
+                    tr = br;
+                    ti = bi;
+                }
+                else if (t == HALF_SIZE / 4)
+                {
+                    tr = bi;
+                    ti = -br;
+                }
+                else
+                {
+                    // W = cos - j·sin
+                    int32_t c = fftCos[t];
+                    int32_t s = fftSin[t];
+                    tr = (int32_t)(((int64_t)br * c + (int64_t)bi * s + Q15_ROUND) >> 15);
+                    ti = (int32_t)(((int64_t)bi * c - (int64_t)br * s + Q15_ROUND) >> 15);
+                }
+
+                int32_t ar = fftRe[a];
+                int32_t ai = fftIm[a];
+                fftRe[a] = (ar + tr + 1) >> 1;
+                fftIm[a] = (ai + ti + 1) >> 1;
+                fftRe[b] = (ar - tr + 1) >> 1;
+                fftIm[b] = (ai - ti + 1) >> 1;
+            }
+        }
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::unpackPowerReference()
+{
+    // X[k] = (Fe + W^k·Fo) / 2，X[N/2-k] = conj(Fe - W^k·Fo) / 2，Fe/Fo 取未除 2 的和差
+    for (int k = 0; k <= HALF_SIZE / 2; k++)
+    {
+        int m = (HALF_SIZE - k) & (HALF_SIZE - 1); // k = 0 時對應 Z[0]
+        int32_t zr = fftRe[k], zi = fftIm[k];
+        int32_t yr = fftRe[m], yi = fftIm[m];
+
+        int32_t er = zr + yr;
+        int32_t ei = zi - yi;
+        int32_t fr = zi + yi;
+        int32_t fi = yr - zr;
+        int32_t tr, ti;
+
+        if (k == 0)
+        {
+            tr = fr;
+            ti = fi;
+        }
+        else if (k == HALF_SIZE / 2)
+        {
+            tr = fi;
+            ti = -fr;
+        }
+        else
+        {
+            int32_t c = unpackCos[k];
+            int32_t s = unpackSin[k];
+            tr = (int32_t)(((int64_t)fr * c + (int64_t)fi * s + Q15_ROUND) >> 15);
+            ti = (int32_t)(((int64_t)fi * c - (int64_t)fr * s + Q15_ROUND) >> 15);
+        }
+
+        int32_t xr = (er + tr) >> 2;
+        int32_t xi = (ei + ti) >> 2;
+        uint64_t p = (uint64_t)((int64_t)xr * xr) + (uint64_t)((int64_t)xi * xi);
+        power[k] = p < powerFloor ? powerFloor : p;
+
+        int32_t mr = (er - tr) >> 2;
+        int32_t mi = (ti - ei) >> 2;
+        p = (uint64_t)((int64_t)mr * mr) + (uint64_t)((int64_t)mi * mi);
+        power[HALF_SIZE - k] = p < powerFloor ? powerFloor : p;
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::melLogReference()
+{
+    for (int m = 0; m < MelBanks; m++)
+    {
+        const MelFilterRange &range = melBank.ranges[m];
+        uint64_t energy = 0;
+        for (int k = 0; k < range.length; k++)
+        {
+            energy += power[range.startBin + k] * (uint16_t)melBank.weights[range.weightOffset + k];
+        }
+        logMelQ16[m] = toNaturalLogQ16(energy);
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::dctReference()
+{
+    for (int i = 0; i < MfccCoeffs; i++)
+    {
+        int64_t sum = 0;
+        for (int j = 0; j < MelBanks; j++)
+        {
+            sum += (int64_t)logMelQ16[j] * dctTable[i * MelBanks + j];
+        }
+        mfccQ16[i] = (int32_t)((sum + Q15_ROUND) >> 15);
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::computeReference(const int16_t *frame)
+{
+    windowReference(frame);
+    fftReference();
+    unpackPowerReference();
+    melLogReference();
+    dctReference();
+}
+
+// ===== 最佳化實作 =====
+// 與參考實作逐個捨入點相同；迴圈皆為連續存取、固定步長，方便編譯器展開與 SIMD 化
+
+FPM_TEMPLATE
+void FPM_CLASS::windowOptimized(const int16_t *frame)
+{
+    frameExponent = selectExponent(frame);
+    powerFloor = powerFloorTable[frameExponent - FIXED_MIN_EXPONENT];
+    const int exponent = frameExponent;
+    const int16_t *window = windowTable.data();
+    const uint16_t *reverse = bitReverse.data();
+
+    // 加窗時直接寫入位元反轉位置，省去獨立的重排掃描
+    int n = 0;
+    for (; n < FrameSize / 2; n++)
+    {
+        int r = reverse[n];
+        fftRe[r] = scaleSample((int32_t)frame[2 * n] * window[2 * n], exponent);
+        fftIm[r] = scaleSample((int32_t)frame[2 * n + 1] * window[2 * n + 1], exponent);
+    }
+    for (; n < HALF_SIZE; n++)
+    {
+        int r = reverse[n];
+        fftRe[r] = 0;
+        fftIm[r] = 0;
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::fftOptimized()
+{
+    int32_t *re = fftRe;
+    int32_t *im = fftIm;
+
+    // 第 1 級 (W = 1) 與第 2 級 (W = 1, -j)：純加減與移位
+    for (int a = 0; a < HALF_SIZE; a += 2)
+    {
+        int32_t ar = re[a], ai = im[a];
+        int32_t br = re[a + 1], bi = im[a + 1];
+        re[a] = (ar + br + 1) >> 1;
+        im[a] = (ai + bi + 1) >> 1;
+        re[a + 1] = (ar - br + 1) >> 1;
+        im[a + 1] = (ai - bi + 1) >> 1;
+    }
+    for (int a = 0; a < HALF_SIZE; a += 4)
+    {
+        int32_t ar = re[a], ai = im[a];
+        int32_t br = re[a + 2], bi = im[a + 2];
+        re[a] = (ar + br + 1) >> 1;
+        im[a] = (ai + bi + 1) >> 1;
+        re[a + 2] = (ar - br + 1) >> 1;
+        im[a + 2] = (ai - bi + 1) >> 1;
+
+        ar = re[a + 1];
+        ai = im[a + 1];
+        br = im[a + 3]; // W = -j：t = (bi, -br)
+        bi = -re[a + 3];
+        re[a + 1] = (ar + br + 1) >> 1;
+        im[a + 1] = (ai + bi + 1) >> 1;
+        re[a + 3] = (ar - br + 1) >> 1;
+        im[a + 3] = (ai - bi + 1) >> 1;
+    }
+
+    // 其餘各級：外層固定旋轉因子，內層走訪所有群組
+    for (int len = 8; len <= HALF_SIZE; len <<= 1)
+    {
+        const int half = len / 2;
+        const int step = HALF_SIZE / len;
+
+        for (int k = 0; k < half; k++)
+        {
+            const int t = k * step;
+
+            if (t == 0 || t == HALF_SIZE / 4)
+            {
+                const bool minusJ = t != 0;
+                for (int a = k; a < HALF_SIZE; a += len)
+                {
+                    int b = a + half;
+                    int32_t tr = minusJ ? im[b] : re[b];
+                    int32_t ti = minusJ ? -re[b] : im[b];
+                    int32_t ar = re[a], ai = im[a];
+                    re[a] = (ar + tr + 1) >> 1;
+                    im[a] = (ai + ti + 1) >> 1;
+                    re[b] = (ar - tr + 1) >> 1;
+                    im[b] = (ai - ti + 1) >> 1;
+                }
+                continue;
+            }
+
+            const int32_t c = fftCos[t];
+            const int32_t s = fftSin[t];
+            for (int a = k; a < HALF_SIZE; a += len)
+            {
+                int b = a + half;
+                int32_t br = re[b], bi = im[b];
+                int32_t tr = (int32_t)(((int64_t)br * c + (int64_t)bi * s + Q15_ROUND) >> 15);
+                int32_t ti = (int32_t)(((int64_t)bi * c - (int64_t)br * s + Q15_ROUND) >> 15);
+                int32_t ar = re[a], ai = im[a];
+                re[a] = (ar + tr + 1) >> 1;
+                im[a] = (ai + ti + 1) >> 1;
+                re[b] = (ar - tr + 1) >> 1;
+                im[b] = (ai - ti + 1) >> 1;
+            }
+        }
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::unpackPowerOptimized()
+{
+    const uint64_t minPower = powerFloor;
+
+    // k = 0 (DC 與 Nyquist) 與 k = N/4 不需乘法，剝離出迴圈
+    {
+        int32_t zr = fftRe[0], zi = fftIm[0];
+        int32_t dc = (2 * zr + 2 * zi) >> 2;
+        int32_t nyquist = (2 * zr - 2 * zi) >> 2;
+        uint64_t p = (uint64_t)((int64_t)dc * dc);
+        power[0] = p < minPower ? minPower : p;
+        p = (uint64_t)((int64_t)nyquist * nyquist);
+        power[HALF_SIZE] = p < minPower ? minPower : p;
+    }
+    {
+        const int q = HALF_SIZE / 2;
+        int32_t xr = (2 * fftRe[q]) >> 2;
+        int32_t xi = (-2 * fftIm[q]) >> 2;
+        uint64_t p = (uint64_t)((int64_t)xr * xr) + (uint64_t)((int64_t)xi * xi);
+        power[q] = p < minPower ? minPower : p;
+    }
+
+    const int16_t *cosTable = unpackCos.data();
+    const int16_t *sinTable = unpackSin.data();
+    for (int k = 1; k < HALF_SIZE / 2; k++)
+    {
+        int m = HALF_SIZE - k;
+        int32_t zr = fftRe[k], zi = fftIm[k];
+        int32_t yr = fftRe[m], yi = fftIm[m];
+
+        int32_t er = zr + yr;
+        int32_t ei = zi - yi;
+        int32_t fr = zi + yi;
+        int32_t fi = yr - zr;
+
+        int32_t c = cosTable[k];
+        int32_t s = sinTable[k];
+        int32_t tr = (int32_t)(((int64_t)fr * c + (int64_t)fi * s + Q15_ROUND) >> 15);
+        int32_t ti = (int32_t)(((int64_t)fi * c - (int64_t)fr * s + Q15_ROUND) >> 15);
+
+        int32_t xr = (er + tr) >> 2;
+        int32_t xi = (ei + ti) >> 2;
+        int32_t mr = (er - tr) >> 2;
+        int32_t mi = (ti - ei) >> 2;
+        uint64_t pk = (uint64_t)((int64_t)xr * xr) + (uint64_t)((int64_t)xi * xi);
+        uint64_t pm = (uint64_t)((int64_t)mr * mr) + (uint64_t)((int64_t)mi * mi);
+        power[k] = pk < minPower ? minPower : pk;
+        power[m] = pm < minPower ? minPower : pm;
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::melLogOptimized()
+{
+    // 整數加法滿足結合律，雙累加器展開不影響結果
+    for (int m = 0; m < MelBanks; m++)
+    {
+        const MelFilterRange &range = melBank.ranges[m];
+        const uint64_t *spectrum = power + range.startBin;
+        const int16_t *weights = melBank.weights + range.weightOffset;
+        const int length = range.length;
+
+        uint64_t even = 0;
+        uint64_t odd = 0;
+        int k = 0;
+        for (; k + 1 < length; k += 2)
+        {
+            even += spectrum[k] * (uint16_t)weights[k];
+            odd += spectrum[k + 1] * (uint16_t)weights[k + 1];
+        }
+        if (k < length)
+        {
+            even += spectrum[k] * (uint16_t)weights[k];
+        }
+        logMelQ16[m] = toNaturalLogQ16(even + odd);
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::dctOptimized()
+{
+    for (int i = 0; i < MfccCoeffs; i++)
+    {
+        const int16_t *basis = dctTable.data() + i * MelBanks;
+        int64_t even = 0;
+        int64_t odd = 0;
+        int j = 0;
+        for (; j + 1 < MelBanks; j += 2)
+        {
+            even += (int64_t)logMelQ16[j] * basis[j];
+            odd += (int64_t)logMelQ16[j + 1] * basis[j + 1];
+        }
+        if (j < MelBanks)
+        {
+            even += (int64_t)logMelQ16[j] * basis[j];
+        }
+        mfccQ16[i] = (int32_t)((even + odd + Q15_ROUND) >> 15);
+    }
+}
+
+FPM_TEMPLATE
+void FPM_CLASS::compute(const int16_t *frame)
+{
+    windowOptimized(frame);
+    fftOptimized();
+    unpackPowerOptimized();
+    melLogOptimized();
+    dctOptimized();
+}
+
+FPM_TEMPLATE
+bool FPM_CLASS::verifyBitExact(const int16_t *frame)
+{
+    computeReference(frame);
+
+    uint64_t referencePower[SPECTRUM_BINS];
+    int32_t referenceLogMel[MelBanks];
+    int32_t referenceMfcc[MfccCoeffs];
+    memcpy(referencePower, power, sizeof(power));
+    memcpy(referenceLogMel, logMelQ16, sizeof(logMelQ16));
+    memcpy(referenceMfcc, mfccQ16, sizeof(mfccQ16));
+
+    compute(frame);
+
+    return memcmp(referencePower, power, sizeof(power)) == 0 &&
+           memcmp(referenceLogMel, logMelQ16, sizeof(logMelQ16)) == 0 &&
+           memcmp(referenceMfcc, mfccQ16, sizeof(mfccQ16)) == 0;
+}
+
+// 顯式實例化支援的設定檔 (與 AudioFeatureExtractor 相同)
+template class FixedPointMfccT<16000, 512, 26, 13, 400>;
+template class FixedPointMfccT<8000, 256, 20, 13, 200>;
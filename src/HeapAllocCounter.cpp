@@ -0,0 +1,64 @@
+#include "HeapAllocCounter.h"
+#include <stddef.h>
+
+#if HEAP_ALLOC_COUNTER
+
+static volatile TaskHandle_t trackedTask = nullptr;
+static volatile uint32_t allocCount = 0;
+
+static inline void countAllocation()
+{
+    // 排程器啟動前 trackedTask 為 nullptr，不會呼叫 FreeRTOS
+    if (trackedTask != nullptr && xTaskGetCurrentTaskHandle() == trackedTask)
+    {
+        allocCount = allocCount + 1;
+    }
+}
+
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+
+    void *__wrap_malloc(size_t size)
+    {
+        countAllocation();
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t count, size_t size)
+    {
+        countAllocation();
+        return __real_calloc(count, size);
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+        countAllocation();
+        return __real_realloc(ptr, size);
+    }
+}
+
+void HeapAllocCounter::beginTracking()
+{
+    trackedTask = xTaskGetCurrentTaskHandle();
+}
+
+void HeapAllocCounter::endTracking()
+{
+    trackedTask = nullptr;
+}
+
+uint32_t HeapAllocCounter::getCount()
+{
+    return allocCount;
+}
+
+#else
+
+void HeapAllocCounter::beginTracking() {}
+void HeapAllocCounter::endTracking() {}
+uint32_t HeapAllocCounter::getCount() { return 0; }
+
+#endif
@@ -0,0 +1,115 @@
+#include "ImaAdpcm.h"
+
+const int16_t ImaAdpcmCodec::stepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+const int8_t ImaAdpcmCodec::indexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8};
+
+void ImaAdpcmCodec::setState(const ImaAdpcmState &newState)
+{
+    state.predictor = newState.predictor;
+    state.stepIndex = newState.stepIndex > 88 ? 88 : newState.stepIndex;
+}
+
+uint8_t ImaAdpcmCodec::encodeSample(int16_t sample)
+{
+    int32_t step = stepTable[state.stepIndex];
+    int32_t diff = (int32_t)sample - state.predictor;
+    uint8_t code = 0;
+
+    if (diff < 0)
+    {
+        code = 8;
+        diff = -diff;
+    }
+
+    // 逐位元逼近，重建量與解碼端完全相同的差值
+    int32_t delta = step >> 3;
+    if (diff >= step)
+    {
+        code |= 4;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        code |= 2;
+        diff -= step;
+        delta += step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        code |= 1;
+        delta += step;
+    }
+
+    int32_t predictor = state.predictor + ((code & 8) ? -delta : delta);
+    if (predictor > 32767)
+        predictor = 32767;
+    if (predictor < -32768)
+        predictor = -32768;
+    state.predictor = (int16_t)predictor;
+
+    int index = state.stepIndex + indexTable[code];
+    state.stepIndex = index < 0 ? 0 : (index > 88 ? 88 : index);
+
+    return code;
+}
+
+int16_t ImaAdpcmCodec::decodeSample(uint8_t code)
+{
+    int32_t step = stepTable[state.stepIndex];
+    int32_t delta = step >> 3;
+    if (code & 4)
+        delta += step;
+    if (code & 2)
+        delta += step >> 1;
+    if (code & 1)
+        delta += step >> 2;
+
+    int32_t predictor = state.predictor + ((code & 8) ? -delta : delta);
+    if (predictor > 32767)
+        predictor = 32767;
+    if (predictor < -32768)
+        predictor = -32768;
+    state.predictor = (int16_t)predictor;
+
+    int index = state.stepIndex + indexTable[code & 0x0F];
+    state.stepIndex = index < 0 ? 0 : (index > 88 ? 88 : index);
+
+    return state.predictor;
+}
+
+size_t ImaAdpcmCodec::encode(const int16_t *samples, size_t sampleCount, uint8_t *out)
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < sampleCount; i += 2)
+    {
+        uint8_t low = encodeSample(samples[i]);
+        uint8_t high = (i + 1 < sampleCount) ? encodeSample(samples[i + 1]) : 0;
+        out[bytes++] = (uint8_t)(low | (high << 4));
+    }
+    return bytes;
+}
+
+size_t ImaAdpcmCodec::decode(const uint8_t *data, size_t sampleCount, int16_t *samples)
+{
+    for (size_t i = 0; i < sampleCount; i++)
+    {
+        uint8_t byte = data[i / 2];
+        samples[i] = decodeSample((i & 1) ? (byte >> 4) : (byte & 0x0F));
+    }
+    return sampleCount;
+}
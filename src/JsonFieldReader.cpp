@@ -0,0 +1,309 @@
+#include "JsonFieldReader.h"
+#include <string.h>
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+JsonFieldReader::JsonFieldReader(const char *json, size_t length)
+    : json(json), length(json ? length : 0), valid(false)
+{
+    // 最上層必須是物件，之後只允許空白
+    size_t pos = skipSpace(0);
+    if (pos < this->length && json[pos] == '{')
+    {
+        pos = skipContainer(pos, 0);
+        valid = pos != INVALID && skipSpace(pos) == this->length;
+    }
+}
+
+size_t JsonFieldReader::skipSpace(size_t pos) const
+{
+    while (pos < length && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\n' || json[pos] == '\r'))
+    {
+        pos++;
+    }
+    return pos;
+}
+
+size_t JsonFieldReader::skipString(size_t pos) const
+{
+    if (pos >= length || json[pos] != '"')
+        return INVALID;
+
+    for (pos++; pos < length; pos++)
+    {
+        char c = json[pos];
+        if (c == '"')
+            return pos + 1;
+        if ((unsigned char)c < 0x20)
+            return INVALID;
+        if (c == '\\')
+        {
+            // 只接受 JSON 定義的跳脫字元；\u 的值範圍在 getString 時檢查
+            pos++;
+            if (pos >= length || json[pos] == '\0' || !strchr("\"\\/bfnrtu", json[pos]))
+                return INVALID;
+            if (json[pos] == 'u')
+            {
+                if (pos + 4 >= length)
+                    return INVALID;
+                for (int i = 1; i <= 4; i++)
+                {
+                    if (hexValue(json[pos + i]) < 0)
+                        return INVALID;
+                }
+                pos += 4;
+            }
+        }
+    }
+    return INVALID;
+}
+
+size_t JsonFieldReader::skipNumber(size_t pos) const
+{
+    size_t start = pos;
+    if (pos < length && json[pos] == '-')
+        pos++;
+    size_t digits = pos;
+    while (pos < length && isDigit(json[pos]))
+        pos++;
+    if (pos == digits)
+        return INVALID;
+    if (pos < length && json[pos] == '.')
+    {
+        size_t fraction = ++pos;
+        while (pos < length && isDigit(json[pos]))
+            pos++;
+        if (pos == fraction)
+            return INVALID;
+    }
+    if (pos < length && (json[pos] == 'e' || json[pos] == 'E'))
+    {
+        pos++;
+        if (pos < length && (json[pos] == '+' || json[pos] == '-'))
+            pos++;
+        size_t exponent = pos;
+        while (pos < length && isDigit(json[pos]))
+            pos++;
+        if (pos == exponent)
+            return INVALID;
+    }
+    return pos > start ? pos : INVALID;
+}
+
+size_t JsonFieldReader::skipLiteral(size_t pos, const char *literal) const
+{
+    size_t n = strlen(literal);
+    if (pos + n > length || memcmp(json + pos, literal, n) != 0)
+        return INVALID;
+    return pos + n;
+}
+
+size_t JsonFieldReader::skipValue(size_t pos, int depth) const
+{
+    if (pos >= length)
+        return INVALID;
+
+    switch (json[pos])
+    {
+    case '"':
+        return skipString(pos);
+    case '{':
+    case '[':
+        return skipContainer(pos, depth + 1);
+    case 't':
+        return skipLiteral(pos, "true");
+    case 'f':
+        return skipLiteral(pos, "false");
+    case 'n':
+        return skipLiteral(pos, "null");
+    default:
+        return skipNumber(pos);
+    }
+}
+
+size_t JsonFieldReader::skipContainer(size_t pos, int depth) const
+{
+    if (depth > JSON_READER_MAX_DEPTH)
+        return INVALID;
+
+    bool object = json[pos] == '{';
+    char close = object ? '}' : ']';
+    pos = skipSpace(pos + 1);
+    if (pos < length && json[pos] == close)
+        return pos + 1;
+
+    while (pos < length)
+    {
+        if (object)
+        {
+            pos = skipString(pos);
+            if (pos == INVALID)
+                return INVALID;
+            pos = skipSpace(pos);
+            if (pos >= length || json[pos] != ':')
+                return INVALID;
+            pos = skipSpace(pos + 1);
+        }
+
+        pos = skipValue(pos, depth);
+        if (pos == INVALID)
+            return INVALID;
+        pos = skipSpace(pos);
+        if (pos >= length)
+            return INVALID;
+        if (json[pos] == close)
+            return pos + 1;
+        if (json[pos] != ',')
+            return INVALID;
+        pos = skipSpace(pos + 1);
+    }
+    return INVALID;
+}
+
+size_t JsonFieldReader::find(const char *key) const
+{
+    if (!valid || !key)
+        return INVALID;
+
+    // 建構時已驗證語法，這裡只需逐一走過最上層成員
+    size_t keyLength = strlen(key);
+    size_t pos = skipSpace(skipSpace(0) + 1);
+    while (pos < length && json[pos] == '"')
+    {
+        size_t keyEnd = skipString(pos);
+        bool match = keyEnd - pos - 2 == keyLength && memcmp(json + pos + 1, key, keyLength) == 0;
+        size_t value = skipSpace(skipSpace(keyEnd) + 1);
+        if (match)
+            return value;
+
+        pos = skipSpace(skipValue(value, 0));
+        if (pos >= length || json[pos] != ',')
+            break;
+        pos = skipSpace(pos + 1);
+    }
+    return INVALID;
+}
+
+bool JsonFieldReader::has(const char *key) const
+{
+    return find(key) != INVALID;
+}
+
+bool JsonFieldReader::getString(const char *key, char *out, size_t capacity) const
+{
+    size_t pos = find(key);
+    if (pos == INVALID || json[pos] != '"' || !out || capacity == 0)
+        return false;
+
+    size_t n = 0;
+    for (pos++; json[pos] != '"'; pos++)
+    {
+        char c = json[pos];
+        if (c == '\\')
+        {
+            c = json[++pos];
+            switch (c)
+            {
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'n':
+                c = '\n';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'u':
+            {
+                int code = 0;
+                for (int i = 1; i <= 4; i++)
+                {
+                    int digit = hexValue(json[pos + i]);
+                    if (digit < 0)
+                        return false;
+                    code = code * 16 + digit;
+                }
+                if (code == 0 || code > 0x7F)
+                    return false;
+                c = (char)code;
+                pos += 4;
+                break;
+            }
+            default:
+                break; // \" \\ \/
+            }
+        }
+        if (n + 1 >= capacity)
+            return false;
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+bool JsonFieldReader::getInt(const char *key, int32_t *value) const
+{
+    size_t pos = find(key);
+    if (pos == INVALID || !value)
+        return false;
+
+    size_t end = skipNumber(pos);
+    if (end == INVALID)
+        return false;
+
+    bool negative = json[pos] == '-';
+    int64_t result = 0;
+    for (size_t i = negative ? pos + 1 : pos; i < end; i++)
+    {
+        if (!isDigit(json[i]))
+            return false; // 小數或指數
+        result = result * 10 + (json[i] - '0');
+        if (result > 2147483648LL)
+            return false;
+    }
+    result = negative ? -result : result;
+    if (result > INT32_MAX || result < INT32_MIN)
+        return false;
+
+    *value = (int32_t)result;
+    return true;
+}
+
+bool JsonFieldReader::getBool(const char *key, bool *value) const
+{
+    size_t pos = find(key);
+    if (pos == INVALID || !value)
+        return false;
+
+    if (skipLiteral(pos, "true") != INVALID)
+    {
+        *value = true;
+        return true;
+    }
+    if (skipLiteral(pos, "false") != INVALID)
+    {
+        *value = false;
+        return true;
+    }
+    return false;
+}
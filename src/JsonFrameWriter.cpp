@@ -0,0 +1,280 @@
+#include "JsonFrameWriter.h"
+#include <math.h>
+
+#define JSON_FLOAT_DIGITS 7
+
+static const uint64_t POWERS_OF_TEN[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL};
+
+JsonFrameWriter::JsonFrameWriter(char *buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), length(0), overflow(buffer == nullptr || capacity == 0), first(true), afterKey(false)
+{
+}
+
+void JsonFrameWriter::put(char c)
+{
+    if (overflow || length >= capacity)
+    {
+        overflow = true;
+        return;
+    }
+    buffer[length++] = c;
+}
+
+void JsonFrameWriter::put(const char *text)
+{
+    while (*text)
+    {
+        put(*text++);
+    }
+}
+
+void JsonFrameWriter::separator()
+{
+    // 鍵之後直接接值
+    if (afterKey)
+    {
+        afterKey = false;
+        return;
+    }
+    if (!first)
+    {
+        put(',');
+    }
+    first = false;
+}
+
+void JsonFrameWriter::beginObject()
+{
+    separator();
+    put('{');
+    first = true;
+}
+
+void JsonFrameWriter::endObject()
+{
+    put('}');
+    first = false;
+}
+
+void JsonFrameWriter::beginArray(const char *name)
+{
+    key(name);
+    beginArray();
+}
+
+void JsonFrameWriter::beginArray()
+{
+    separator();
+    put('[');
+    first = true;
+}
+
+void JsonFrameWriter::endArray()
+{
+    put(']');
+    first = false;
+}
+
+void JsonFrameWriter::key(const char *name)
+{
+    separator();
+    put('"');
+    put(name);
+    put("\":");
+    afterKey = true;
+}
+
+void JsonFrameWriter::member(const char *name, int32_t value)
+{
+    key(name);
+    this->value(value);
+}
+
+void JsonFrameWriter::member(const char *name, uint32_t value)
+{
+    key(name);
+    this->value(value);
+}
+
+void JsonFrameWriter::member(const char *name, uint64_t value)
+{
+    key(name);
+    this->value(value);
+}
+
+void JsonFrameWriter::member(const char *name, double value)
+{
+    key(name);
+    this->value(value);
+}
+
+void JsonFrameWriter::member(const char *name, bool value)
+{
+    key(name);
+    separator();
+    put(value ? "true" : "false");
+}
+
+void JsonFrameWriter::member(const char *name, const char *value)
+{
+    key(name);
+    this->value(value);
+}
+
+void JsonFrameWriter::value(int32_t value)
+{
+    separator();
+    if (value < 0)
+    {
+        put('-');
+        writeUnsigned((uint64_t)(-(int64_t)value));
+    }
+    else
+    {
+        writeUnsigned((uint64_t)value);
+    }
+}
+
+void JsonFrameWriter::value(uint32_t value)
+{
+    separator();
+    writeUnsigned(value);
+}
+
+void JsonFrameWriter::value(uint64_t value)
+{
+    separator();
+    writeUnsigned(value);
+}
+
+void JsonFrameWriter::value(double value)
+{
+    separator();
+    writeFloat(value);
+}
+
+void JsonFrameWriter::value(const char *value)
+{
+    separator();
+    writeString(value ? value : "");
+}
+
+void JsonFrameWriter::writeString(const char *text)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    put('"');
+    for (; *text; text++)
+    {
+        unsigned char c = (unsigned char)*text;
+        if (c == '"' || c == '\\')
+        {
+            put('\\');
+            put((char)c);
+        }
+        else if (c < 0x20)
+        {
+            put("\\u00");
+            put(HEX_DIGITS[c >> 4]);
+            put(HEX_DIGITS[c & 0x0F]);
+        }
+        else
+        {
+            put((char)c);
+        }
+    }
+    put('"');
+}
+
+void JsonFrameWriter::writeUnsigned(uint64_t value)
+{
+    char digits[20];
+    int count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0)
+    {
+        put(digits[--count]);
+    }
+}
+
+void JsonFrameWriter::writeFraction(uint64_t fraction, int decimals)
+{
+    // fraction 為 decimals 位小數；去掉尾端的 0，前導 0 依位數補齊
+    if (fraction == 0)
+    {
+        return;
+    }
+    while (fraction % 10 == 0)
+    {
+        fraction /= 10;
+        decimals--;
+    }
+    put('.');
+    for (int d = decimals - 1; d > 0 && fraction < POWERS_OF_TEN[d]; d--)
+    {
+        put('0');
+    }
+    writeUnsigned(fraction);
+}
+
+void JsonFrameWriter::writeFloat(double value)
+{
+    if (isnan(value) || isinf(value))
+    {
+        put("null");
+        return;
+    }
+    if (value == 0.0)
+    {
+        put('0');
+        return;
+    }
+    if (value < 0)
+    {
+        put('-');
+        value = -value;
+    }
+
+    // 取 JSON_FLOAT_DIGITS 位有效數字的整數尾數 mantissa，value ≈ mantissa · 10^(exponent - DIGITS + 1)
+    int exponent = (int)floor(log10(value));
+    uint64_t mantissa = (uint64_t)(value * pow(10.0, JSON_FLOAT_DIGITS - 1 - exponent) + 0.5);
+    if (mantissa >= POWERS_OF_TEN[JSON_FLOAT_DIGITS])
+    {
+        // 四捨五入進位 (例如 9.9999999 → 10.00000)
+        mantissa /= 10;
+        exponent++;
+    }
+
+    if (exponent >= -5 && exponent < JSON_FLOAT_DIGITS + 2)
+    {
+        // 定點格式：小數位數 = 有效數字 - 1 - exponent
+        int decimals = JSON_FLOAT_DIGITS - 1 - exponent;
+        if (decimals <= 0)
+        {
+            writeUnsigned(mantissa * POWERS_OF_TEN[-decimals]);
+            return;
+        }
+
+        writeUnsigned(mantissa / POWERS_OF_TEN[decimals]);
+        writeFraction(mantissa % POWERS_OF_TEN[decimals], decimals);
+        return;
+    }
+
+    // 科學記號：d.dddddde±x
+    writeUnsigned(mantissa / POWERS_OF_TEN[JSON_FLOAT_DIGITS - 1]);
+    writeFraction(mantissa % POWERS_OF_TEN[JSON_FLOAT_DIGITS - 1], JSON_FLOAT_DIGITS - 1);
+    put('e');
+    if (exponent < 0)
+    {
+        put('-');
+        exponent = -exponent;
+    }
+    writeUnsigned((uint64_t)exponent);
+}
@@ -0,0 +1,78 @@
+#include "LatencyHistogram.h"
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+        buckets[i] = 0;
+    }
+    count = 0;
+    maxValue = 0;
+}
+
+int LatencyHistogram::bucketOf(uint32_t micros)
+{
+    if (micros < 4)
+    {
+        return (int)micros;
+    }
+
+    // 最高位元 msb ≥ 2，其後兩位元決定區間內的子格
+    int msb = 31 - __builtin_clz(micros);
+    int bucket = 4 + (msb - 2) * 4 + (int)((micros >> (msb - 2)) & 3);
+    return bucket < LATENCY_HISTOGRAM_BUCKETS ? bucket : LATENCY_HISTOGRAM_BUCKETS - 1;
+}
+
+uint32_t LatencyHistogram::bucketLow(int bucket)
+{
+    if (bucket < 4)
+    {
+        return (uint32_t)bucket;
+    }
+    int msb = (bucket - 4) / 4 + 2;
+    int sub = (bucket - 4) % 4;
+    return (uint32_t)(4 + sub) << (msb - 2);
+}
+
+void LatencyHistogram::record(uint32_t micros)
+{
+    buckets[bucketOf(micros)]++;
+    count++;
+    if (micros > maxValue)
+    {
+        maxValue = micros;
+    }
+}
+
+uint32_t LatencyHistogram::percentile(float p) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // 目標名次 (1 起算)
+    uint32_t rank = (uint32_t)(p * count + 0.999f);
+    if (rank < 1)
+        rank = 1;
+    if (rank > count)
+        rank = count;
+
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+        if (buckets[i] == 0)
+        {
+            continue;
+        }
+        if (seen + buckets[i] >= rank)
+        {
+            uint32_t low = bucketLow(i);
+            uint32_t high = (i == LATENCY_HISTOGRAM_BUCKETS - 1) ? maxValue : bucketLow(i + 1);
+            uint32_t value = low + (uint32_t)((uint64_t)(high - low) * (rank - seen) / buckets[i]);
+            return value < maxValue ? value : maxValue;
+        }
+        seen += buckets[i];
+    }
+    return maxValue;
+}
@@ -0,0 +1,140 @@
+#include "RtpWireFormat.h"
+
+static inline void putU16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)(value & 0xFF);
+}
+
+static inline void putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)((value >> 16) & 0xFF);
+    out[2] = (uint8_t)((value >> 8) & 0xFF);
+    out[3] = (uint8_t)(value & 0xFF);
+}
+
+static inline uint16_t getU16(const uint8_t *in)
+{
+    return (uint16_t)((in[0] << 8) | in[1]);
+}
+
+static inline uint32_t getU32(const uint8_t *in)
+{
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | (uint32_t)in[3];
+}
+
+size_t RtpWireFormat::writeHeader(const RtpHeader &header, uint8_t *out, size_t capacity)
+{
+    if (!out || capacity < RTP_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    out[0] = RTP_VERSION << 6;
+    out[1] = (uint8_t)((header.marker ? 0x80 : 0) | (header.payloadType & 0x7F));
+    putU16(out + 2, header.sequence);
+    putU32(out + 4, header.timestamp);
+    putU32(out + 8, header.ssrc);
+    return RTP_HEADER_SIZE;
+}
+
+size_t RtpWireFormat::encodeL16(const RtpHeader &header, const int16_t *samples, size_t sampleCount, uint8_t *out,
+                                size_t capacity)
+{
+    size_t total = l16PacketSize(sampleCount);
+    if (!samples || capacity < total)
+    {
+        return 0;
+    }
+
+    writeHeader(header, out, capacity);
+
+    uint8_t *payload = out + RTP_HEADER_SIZE;
+    for (size_t i = 0; i < sampleCount; i++)
+    {
+        putU16(payload + 2 * i, (uint16_t)samples[i]);
+    }
+    return total;
+}
+
+size_t RtpWireFormat::readHeader(const uint8_t *data, size_t length, RtpHeader *header)
+{
+    if (!data || !header || length < RTP_HEADER_SIZE || (data[0] >> 6) != RTP_VERSION)
+    {
+        return 0;
+    }
+
+    size_t offset = RTP_HEADER_SIZE + 4 * (data[0] & 0x0F);
+    if ((data[0] & 0x10) != 0)
+    {
+        // 擴充標頭：2 位元組識別碼 + 2 位元組長度 (以 32 位元字為單位)
+        if (length < offset + 4)
+        {
+            return 0;
+        }
+        offset += 4 + 4 * (size_t)getU16(data + offset + 2);
+    }
+    if (length < offset)
+    {
+        return 0;
+    }
+
+    header->marker = (data[1] & 0x80) != 0;
+    header->payloadType = data[1] & 0x7F;
+    header->sequence = getU16(data + 2);
+    header->timestamp = getU32(data + 4);
+    header->ssrc = getU32(data + 8);
+    return offset;
+}
+
+RtpPacketizer::RtpPacketizer()
+    : ssrc(0), sequence(0), timestampOffset(0), timestampBase(0), expectedPosition(0), restartPending(true),
+      markerPending(true)
+{
+}
+
+void RtpPacketizer::restart(uint32_t newSsrc, uint16_t firstSequence, uint32_t firstTimestamp)
+{
+    ssrc = newSsrc;
+    sequence = firstSequence;
+    timestampBase = firstTimestamp;
+    restartPending = true;
+    markerPending = true;
+}
+
+size_t RtpPacketizer::encode(const int16_t *samples, size_t sampleCount, uint64_t samplePosition, uint8_t *out,
+                             size_t capacity, bool *sourceGap)
+{
+    bool gap = false;
+    if (restartPending)
+    {
+        timestampOffset = timestampBase - (uint32_t)samplePosition;
+        expectedPosition = samplePosition;
+        restartPending = false;
+    }
+
+    if (samplePosition > expectedPosition)
+    {
+        markerPending = true;
+        gap = true;
+    }
+    else if (samplePosition < expectedPosition)
+    {
+        timestampOffset += (uint32_t)(expectedPosition - samplePosition);
+        markerPending = true;
+    }
+    expectedPosition = samplePosition + sampleCount;
+    if (sourceGap)
+    {
+        *sourceGap = gap;
+    }
+
+    RtpHeader header;
+    header.marker = markerPending;
+    header.payloadType = RTP_PAYLOAD_TYPE_L16;
+    header.sequence = sequence++;
+    header.timestamp = timestampOffset + (uint32_t)samplePosition;
+    header.ssrc = ssrc;
+    return RtpWireFormat::encodeL16(header, samples, sampleCount, out, capacity);
+}
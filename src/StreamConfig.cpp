@@ -0,0 +1,332 @@
+#include "StreamConfig.h"
+#include <string.h>
+
+struct NamedValue
+{
+    const char *name;
+    uint8_t value;
+};
+
+static const NamedValue AUDIO_FORMATS[] = {
+    {"json", AUDIO_OUTPUT_JSON},
+    {"binary", AUDIO_OUTPUT_BINARY},
+    {"both", AUDIO_OUTPUT_JSON | AUDIO_OUTPUT_BINARY}};
+
+static const NamedValue AUDIO_CODECS[] = {
+    {"pcm", AUDIO_CODEC_PCM16},
+    {"adpcm", AUDIO_CODEC_IMA_ADPCM}};
+
+static const NamedValue FEATURE_FORMATS[] = {
+    {"json", FEATURE_OUTPUT_JSON},
+    {"frame", FEATURE_OUTPUT_FRAME},
+    {"both", FEATURE_OUTPUT_JSON | FEATURE_OUTPUT_FRAME}};
+
+static const NamedValue FEATURE_ENCODINGS[] = {
+    {"int16", FEATURE_ENCODING_INT16},
+    {"float16", FEATURE_ENCODING_FLOAT16}};
+
+static const NamedValue FEATURE_SETS[] = {
+    {"mfcc", FEATURE_SET_MFCC},
+    {"mel", FEATURE_SET_MEL},
+    {"stats", FEATURE_SET_STATS}};
+
+// 依 STREAM_CONFIG_* 位元順序
+static const char *const FIELD_NAMES[STREAM_CONFIG_FIELD_COUNT] = {
+    "audioFormat", "audioCodec", "batchPackets", "audioIntervalMs", "featureFormat",
+    "featureEncoding", "featureSet", "hopSamples", "featureIntervalMs"};
+
+#define COUNT_OF(table) (sizeof(table) / sizeof(table[0]))
+
+static int valueFromName(const NamedValue *table, size_t count, const char *name)
+{
+    for (size_t i = 0; name && i < count; i++)
+    {
+        if (strcmp(name, table[i].name) == 0)
+            return table[i].value;
+    }
+    return -1;
+}
+
+static const char *nameFromValue(const NamedValue *table, size_t count, uint8_t value)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (table[i].value == value)
+            return table[i].name;
+    }
+    return "unknown";
+}
+
+const char *StreamConfig::fieldName(uint16_t field)
+{
+    for (int i = 0; i < STREAM_CONFIG_FIELD_COUNT; i++)
+    {
+        if (field == (1 << i))
+            return FIELD_NAMES[i];
+    }
+    return "unknown";
+}
+
+int StreamConfig::audioFormatFromName(const char *name)
+{
+    return valueFromName(AUDIO_FORMATS, COUNT_OF(AUDIO_FORMATS), name);
+}
+
+int StreamConfig::audioCodecFromName(const char *name)
+{
+    return valueFromName(AUDIO_CODECS, COUNT_OF(AUDIO_CODECS), name);
+}
+
+int StreamConfig::featureFormatFromName(const char *name)
+{
+    return valueFromName(FEATURE_FORMATS, COUNT_OF(FEATURE_FORMATS), name);
+}
+
+int StreamConfig::featureEncodingFromName(const char *name)
+{
+    return valueFromName(FEATURE_ENCODINGS, COUNT_OF(FEATURE_ENCODINGS), name);
+}
+
+const char *StreamConfig::audioFormatName(uint8_t formats)
+{
+    return nameFromValue(AUDIO_FORMATS, COUNT_OF(AUDIO_FORMATS), formats);
+}
+
+const char *StreamConfig::audioCodecName(uint8_t codec)
+{
+    return nameFromValue(AUDIO_CODECS, COUNT_OF(AUDIO_CODECS), codec);
+}
+
+const char *StreamConfig::featureFormatName(uint8_t formats)
+{
+    return nameFromValue(FEATURE_FORMATS, COUNT_OF(FEATURE_FORMATS), formats);
+}
+
+const char *StreamConfig::featureEncodingName(uint8_t encoding)
+{
+    return nameFromValue(FEATURE_ENCODINGS, COUNT_OF(FEATURE_ENCODINGS), encoding);
+}
+
+int StreamConfig::featureSetFromName(const char *name)
+{
+    if (!name)
+        return -1;
+
+    // 以 + 分隔，例如 "mfcc+mel+stats"；任何一段無效即整個無效
+    int set = 0;
+    const char *token = name;
+    while (*token)
+    {
+        const char *end = strchr(token, '+');
+        size_t length = end ? (size_t)(end - token) : strlen(token);
+        int value = -1;
+        for (size_t i = 0; i < COUNT_OF(FEATURE_SETS); i++)
+        {
+            if (strlen(FEATURE_SETS[i].name) == length && strncmp(token, FEATURE_SETS[i].name, length) == 0)
+                value = FEATURE_SETS[i].value;
+        }
+        if (value < 0)
+            return -1;
+        set |= value;
+        token += end ? length + 1 : length;
+        if (end && *token == '\0')
+            return -1; // 結尾的 +
+    }
+    return set ? set : -1;
+}
+
+size_t StreamConfig::featureSetName(uint8_t set, char *out, size_t capacity)
+{
+    if (!out || capacity == 0)
+        return 0;
+
+    size_t length = 0;
+    out[0] = '\0';
+    for (size_t i = 0; i < COUNT_OF(FEATURE_SETS); i++)
+    {
+        if (!(set & FEATURE_SETS[i].value))
+            continue;
+
+        size_t part = strlen(FEATURE_SETS[i].name) + (length ? 1 : 0);
+        if (length + part + 1 > capacity)
+            break;
+        if (length)
+            out[length++] = '+';
+        strcpy(out + length, FEATURE_SETS[i].name);
+        length += strlen(FEATURE_SETS[i].name);
+    }
+    return length;
+}
+
+uint16_t StreamConfig::validFields(uint16_t fields, const StreamConfigLimits &limits) const
+{
+    uint16_t valid = 0;
+    for (int i = 0; i < STREAM_CONFIG_FIELD_COUNT; i++)
+    {
+        uint16_t field = 1 << i;
+        if (!(fields & field))
+            continue;
+
+        bool ok = false;
+        switch (field)
+        {
+        case STREAM_CONFIG_AUDIO_FORMAT:
+            ok = strcmp(audioFormatName(audioFormats), "unknown") != 0;
+            break;
+        case STREAM_CONFIG_AUDIO_CODEC:
+            ok = strcmp(audioCodecName(audioCodec), "unknown") != 0;
+            break;
+        case STREAM_CONFIG_BATCH_PACKETS:
+            ok = batchPackets >= 1 && batchPackets <= limits.maxBatchPackets;
+            break;
+        case STREAM_CONFIG_AUDIO_INTERVAL:
+            ok = audioIntervalMs <= limits.maxAudioIntervalMs;
+            break;
+        case STREAM_CONFIG_FEATURE_FORMAT:
+            ok = strcmp(featureFormatName(featureFormats), "unknown") != 0;
+            break;
+        case STREAM_CONFIG_FEATURE_ENCODING:
+            ok = strcmp(featureEncodingName(featureEncoding), "unknown") != 0;
+            break;
+        case STREAM_CONFIG_FEATURE_SET:
+            ok = featureSet != 0 && (featureSet & ~FEATURE_SET_ALL) == 0;
+            break;
+        case STREAM_CONFIG_HOP_SAMPLES:
+            ok = hopSamples >= limits.minHopSamples && hopSamples <= limits.maxHopSamples;
+            break;
+        case STREAM_CONFIG_FEATURE_INTERVAL:
+            ok = featureIntervalMs >= limits.minFeatureIntervalMs && featureIntervalMs <= limits.maxFeatureIntervalMs;
+            break;
+        }
+        if (ok)
+            valid |= field;
+    }
+    return valid;
+}
+
+int StreamConfig::parse(const JsonFieldReader &reader, const StreamConfigLimits &limits, const char **invalidField)
+{
+    StreamConfig next = *this;
+    uint16_t present = 0;
+    char text[STREAM_CONFIG_NAME_MAX];
+
+    for (int i = 0; i < STREAM_CONFIG_FIELD_COUNT; i++)
+    {
+        uint16_t field = 1 << i;
+        const char *name = FIELD_NAMES[i];
+        if (!reader.has(name))
+            continue;
+
+        // 列舉欄位為字串，其餘為整數；型別不符或名稱無效時先設為超出範圍的值，交給 validFields 判斷
+        int32_t number = -1;
+        bool isText = reader.getString(name, text, sizeof(text));
+        bool isNumber = !isText && reader.getInt(name, &number);
+        switch (field)
+        {
+        case STREAM_CONFIG_AUDIO_FORMAT:
+            next.audioFormats = isText ? (uint8_t)audioFormatFromName(text) : 0xFF;
+            break;
+        case STREAM_CONFIG_AUDIO_CODEC:
+            next.audioCodec = isText ? (uint8_t)audioCodecFromName(text) : 0xFF;
+            break;
+        case STREAM_CONFIG_FEATURE_FORMAT:
+            next.featureFormats = isText ? (uint8_t)featureFormatFromName(text) : 0xFF;
+            break;
+        case STREAM_CONFIG_FEATURE_ENCODING:
+            next.featureEncoding = isText ? (uint8_t)featureEncodingFromName(text) : 0xFF;
+            break;
+        case STREAM_CONFIG_FEATURE_SET:
+            next.featureSet = isText ? (uint8_t)featureSetFromName(text) : 0xFF;
+            break;
+        default:
+            if (!isNumber || number < 0 || number > 0xFFFF)
+            {
+                if (invalidField)
+                    *invalidField = name;
+                return -1;
+            }
+            if (field == STREAM_CONFIG_BATCH_PACKETS)
+                next.batchPackets = number > 0xFF ? 0 : (uint8_t)number;
+            else if (field == STREAM_CONFIG_AUDIO_INTERVAL)
+                next.audioIntervalMs = (uint16_t)number;
+            else if (field == STREAM_CONFIG_HOP_SAMPLES)
+                next.hopSamples = (uint16_t)number;
+            else
+                next.featureIntervalMs = (uint16_t)number;
+            break;
+        }
+
+        if (next.validFields(field, limits) != field)
+        {
+            if (invalidField)
+                *invalidField = name;
+            return -1;
+        }
+        present |= field;
+    }
+
+    *this = next;
+    return present;
+}
+
+uint16_t StreamConfig::diff(const StreamConfig &other) const
+{
+    uint16_t fields = 0;
+    if (audioFormats != other.audioFormats)
+        fields |= STREAM_CONFIG_AUDIO_FORMAT;
+    if (audioCodec != other.audioCodec)
+        fields |= STREAM_CONFIG_AUDIO_CODEC;
+    if (batchPackets != other.batchPackets)
+        fields |= STREAM_CONFIG_BATCH_PACKETS;
+    if (audioIntervalMs != other.audioIntervalMs)
+        fields |= STREAM_CONFIG_AUDIO_INTERVAL;
+    if (featureFormats != other.featureFormats)
+        fields |= STREAM_CONFIG_FEATURE_FORMAT;
+    if (featureEncoding != other.featureEncoding)
+        fields |= STREAM_CONFIG_FEATURE_ENCODING;
+    if (featureSet != other.featureSet)
+        fields |= STREAM_CONFIG_FEATURE_SET;
+    if (hopSamples != other.hopSamples)
+        fields |= STREAM_CONFIG_HOP_SAMPLES;
+    if (featureIntervalMs != other.featureIntervalMs)
+        fields |= STREAM_CONFIG_FEATURE_INTERVAL;
+    return fields;
+}
+
+void StreamConfig::merge(const StreamConfig &source, uint16_t fields)
+{
+    if (fields & STREAM_CONFIG_AUDIO_FORMAT)
+        audioFormats = source.audioFormats;
+    if (fields & STREAM_CONFIG_AUDIO_CODEC)
+        audioCodec = source.audioCodec;
+    if (fields & STREAM_CONFIG_BATCH_PACKETS)
+        batchPackets = source.batchPackets;
+    if (fields & STREAM_CONFIG_AUDIO_INTERVAL)
+        audioIntervalMs = source.audioIntervalMs;
+    if (fields & STREAM_CONFIG_FEATURE_FORMAT)
+        featureFormats = source.featureFormats;
+    if (fields & STREAM_CONFIG_FEATURE_ENCODING)
+        featureEncoding = source.featureEncoding;
+    if (fields & STREAM_CONFIG_FEATURE_SET)
+        featureSet = source.featureSet;
+    if (fields & STREAM_CONFIG_HOP_SAMPLES)
+        hopSamples = source.hopSamples;
+    if (fields & STREAM_CONFIG_FEATURE_INTERVAL)
+        featureIntervalMs = source.featureIntervalMs;
+}
+
+void StreamConfig::writeJson(JsonFrameWriter &json) const
+{
+    char set[STREAM_CONFIG_NAME_MAX];
+    featureSetName(featureSet, set, sizeof(set));
+
+    json.member("audioFormat", audioFormatName(audioFormats));
+    json.member("audioCodec", audioCodecName(audioCodec));
+    json.member("batchPackets", (uint32_t)batchPackets);
+    json.member("audioIntervalMs", (uint32_t)audioIntervalMs);
+    json.member("featureFormat", featureFormatName(featureFormats));
+    json.member("featureEncoding", featureEncodingName(featureEncoding));
+    json.member("featureSet", (const char *)set);
+    json.member("hopSamples", (uint32_t)hopSamples);
+    json.member("featureIntervalMs", (uint32_t)featureIntervalMs);
+}
@@ -0,0 +1,188 @@
+#include "StreamQualityController.h"
+
+static const char *const TIER_NAMES[STREAM_TIER_COUNT] = {"raw", "adpcm", "adpcm8k", "features"};
+
+StreamQualityController::StreamQualityController()
+    : enabled(true), tier(STREAM_TIER_RAW), lowestTier(STREAM_TIER_FEATURES_ONLY), lastReason(REASON_NONE),
+      tierChanges(0)
+{
+    reset(0);
+}
+
+void StreamQualityController::reset(uint32_t nowMs)
+{
+    tier = STREAM_TIER_RAW;
+    lastReason = REASON_NONE;
+    lastDropTotal = 0;
+    healthyWindows = 0;
+    stableWindows = 0;
+    settleWindows = 0;
+    windowsSinceUpgrade = STREAM_QUALITY_RECOVER_WINDOWS_MAX;
+    recoverWindows = STREAM_QUALITY_RECOVER_WINDOWS;
+    clearWindow(nowMs);
+}
+
+void StreamQualityController::setLowestTier(uint8_t tier)
+{
+    lowestTier = tier < STREAM_TIER_COUNT ? tier : STREAM_TIER_FEATURES_ONLY;
+    if (this->tier > lowestTier)
+    {
+        setTier(lowestTier, REASON_MANUAL);
+    }
+}
+
+bool StreamQualityController::forceTier(uint8_t tier)
+{
+    if (tier >= STREAM_TIER_COUNT || tier == this->tier)
+    {
+        return false;
+    }
+    setTier(tier, REASON_MANUAL);
+    healthyWindows = 0;
+    return true;
+}
+
+void StreamQualityController::recordPublish(uint32_t latencyUs, bool ok)
+{
+    windowPublishes++;
+    windowLatencyUs += latencyUs;
+    if (!ok)
+    {
+        windowErrors++;
+    }
+}
+
+void StreamQualityController::observeQueue(uint32_t depth, uint32_t capacity)
+{
+    if (capacity == 0)
+    {
+        return;
+    }
+    uint32_t percent = depth * 100 / capacity;
+    if (percent > windowMaxDepthPercent)
+    {
+        windowMaxDepthPercent = percent;
+    }
+}
+
+bool StreamQualityController::update(uint32_t nowMs, uint32_t dropTotal)
+{
+    if (nowMs - windowStart < STREAM_QUALITY_WINDOW_MS)
+    {
+        return false;
+    }
+
+    uint32_t drops = dropTotal - lastDropTotal;
+    lastDropTotal = dropTotal;
+    uint32_t meanLatencyMs = windowPublishes ? (uint32_t)(windowLatencyUs / windowPublishes / 1000) : 0;
+    uint32_t errorPercent = windowPublishes ? windowErrors * 100 / windowPublishes : 0;
+
+    // 任一指標超過高門檻即為壅塞；全部低於低門檻才算健康，介於兩者之間維持現狀
+    uint8_t congestion = REASON_NONE;
+    if (drops > 0)
+        congestion |= REASON_DROPS;
+    if (windowMaxDepthPercent >= STREAM_QUALITY_DEPTH_HIGH_PERCENT)
+        congestion |= REASON_QUEUE_DEPTH;
+    if (meanLatencyMs >= STREAM_QUALITY_LATENCY_HIGH_MS)
+        congestion |= REASON_LATENCY;
+    if (errorPercent > STREAM_QUALITY_ERROR_PERCENT)
+        congestion |= REASON_ERRORS;
+
+    bool healthy = congestion == REASON_NONE && windowErrors == 0 &&
+                   windowMaxDepthPercent <= STREAM_QUALITY_DEPTH_LOW_PERCENT &&
+                   meanLatencyMs <= STREAM_QUALITY_LATENCY_LOW_MS;
+
+    clearWindow(nowMs);
+    if (windowsSinceUpgrade < STREAM_QUALITY_RECOVER_WINDOWS_MAX)
+    {
+        windowsSinceUpgrade++;
+    }
+
+    if (!enabled)
+    {
+        return false;
+    }
+    if (settleWindows > 0)
+    {
+        settleWindows--;
+        return false;
+    }
+
+    if (congestion != REASON_NONE)
+    {
+        healthyWindows = 0;
+        stableWindows = 0;
+        if (tier >= lowestTier)
+        {
+            return false;
+        }
+
+        // 剛升級就再度壅塞：鏈路尚未真正恢復，延長下次升級前的觀察期
+        if (windowsSinceUpgrade <= 2)
+        {
+            recoverWindows *= 2;
+            if (recoverWindows > STREAM_QUALITY_RECOVER_WINDOWS_MAX)
+            {
+                recoverWindows = STREAM_QUALITY_RECOVER_WINDOWS_MAX;
+            }
+        }
+        setTier(tier + 1, congestion);
+        return true;
+    }
+
+    // 升級後 (或在最高層級) 沒有壅塞才計入穩定期；穩定夠久後逐步放寬升級要求
+    // 降級後等待升級的期間不計入：較低層級健康不代表鏈路已恢復，否則減半會抵銷加倍，反覆試探升級
+    if (tier == STREAM_TIER_RAW || lastReason == REASON_RECOVERED)
+    {
+        stableWindows++;
+    }
+    if (stableWindows >= STREAM_QUALITY_STABLE_WINDOWS)
+    {
+        stableWindows = 0;
+        recoverWindows /= 2;
+        if (recoverWindows < STREAM_QUALITY_RECOVER_WINDOWS)
+        {
+            recoverWindows = STREAM_QUALITY_RECOVER_WINDOWS;
+        }
+    }
+
+    if (!healthy)
+    {
+        healthyWindows = 0;
+        return false;
+    }
+
+    healthyWindows++;
+
+    if (tier > STREAM_TIER_RAW && healthyWindows >= recoverWindows)
+    {
+        setTier(tier - 1, REASON_RECOVERED);
+        healthyWindows = 0;
+        windowsSinceUpgrade = 0;
+        return true;
+    }
+    return false;
+}
+
+const char *StreamQualityController::tierName(uint8_t tier)
+{
+    return tier < STREAM_TIER_COUNT ? TIER_NAMES[tier] : "unknown";
+}
+
+void StreamQualityController::setTier(uint8_t newTier, uint8_t reason)
+{
+    // 降級後前一層級的積壓仍在排空，先觀察；升級後若過載應立即退回，不等待
+    settleWindows = newTier > tier ? STREAM_QUALITY_SETTLE_WINDOWS : 0;
+    tier = newTier;
+    lastReason = reason;
+    tierChanges++;
+}
+
+void StreamQualityController::clearWindow(uint32_t nowMs)
+{
+    windowStart = nowMs;
+    windowPublishes = 0;
+    windowErrors = 0;
+    windowLatencyUs = 0;
+    windowMaxDepthPercent = 0;
+}
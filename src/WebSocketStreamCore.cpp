@@ -0,0 +1,241 @@
+#include "WebSocketStreamCore.h"
+#include <string.h>
+#include <ctype.h>
+
+WebSocketStreamCore::WebSocketStreamCore() : subscriptionUnion(0), adpcmResyncPending(true), nextPosition(0)
+{
+    for (uint8_t i = 0; i < WS_STREAM_MAX_CLIENTS; i++)
+    {
+        clients[i].connected = false;
+        clients[i].subscriptions = 0;
+        clients[i].head = clients[i].tail = 0;
+        memset(&clients[i].stats, 0, sizeof(ClientStats));
+    }
+}
+
+uint8_t WebSocketStreamCore::parseSubscriptions(const char *path)
+{
+    if (!path)
+    {
+        return WS_SUBSCRIBE_DEFAULT;
+    }
+
+    // 路徑以非英數字元分隔成多個名稱，例如 "/adpcm+features"
+    uint8_t subscriptions = 0;
+    const char *token = path;
+    while (*token)
+    {
+        size_t length = 0;
+        while (isalnum((unsigned char)token[length]))
+        {
+            length++;
+        }
+        if (length == 3 && strncmp(token, "pcm", 3) == 0)
+            subscriptions |= WS_SUBSCRIBE_PCM;
+        else if (length == 5 && strncmp(token, "adpcm", 5) == 0)
+            subscriptions |= WS_SUBSCRIBE_ADPCM;
+        else if (length == 8 && strncmp(token, "features", 8) == 0)
+            subscriptions |= WS_SUBSCRIBE_FEATURES;
+        token += length ? length : 1;
+    }
+    return subscriptions ? subscriptions : WS_SUBSCRIBE_DEFAULT;
+}
+
+bool WebSocketStreamCore::addClient(uint8_t id, uint8_t subscriptions)
+{
+    if (id >= WS_STREAM_MAX_CLIENTS)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    Client &client = clients[id];
+    client.connected = true;
+    client.subscriptions = subscriptions;
+    client.head = client.tail = 0;
+    memset(&client.stats, 0, sizeof(ClientStats));
+    updateSubscriptionUnion();
+    return true;
+}
+
+void WebSocketStreamCore::removeClient(uint8_t id)
+{
+    if (id >= WS_STREAM_MAX_CLIENTS)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    clients[id].connected = false;
+    clients[id].head = clients[id].tail = 0;
+    updateSubscriptionUnion();
+}
+
+void WebSocketStreamCore::updateSubscriptionUnion()
+{
+    uint8_t subscriptions = 0;
+    for (uint8_t i = 0; i < WS_STREAM_MAX_CLIENTS; i++)
+    {
+        if (clients[i].connected)
+        {
+            subscriptions |= clients[i].subscriptions;
+        }
+    }
+
+    // 沒有 ADPCM 訂閱者時編碼器停止，下一次有人訂閱時從頭開始並標記不連續
+    if (!(subscriptions & WS_SUBSCRIBE_ADPCM))
+    {
+        adpcmResyncPending = true;
+    }
+    subscriptionUnion = subscriptions;
+}
+
+void WebSocketStreamCore::pushAudio(const int16_t *samples, uint16_t sampleCount, uint16_t sequence,
+                                    uint64_t samplePosition, uint64_t epochMicros, uint32_t sampleRate)
+{
+    // 裝置端遺失的樣本 (塊池用盡) 使位置跳躍，所有客戶端的這一包都標記 GAP
+    AudioWireHeader header;
+    header.version = AUDIO_WIRE_VERSION;
+    header.flags = samplePosition > nextPosition ? AUDIO_WIRE_FLAG_GAP : 0;
+    header.sequence = sequence;
+    header.sampleCount = sampleCount;
+    header.sampleRate = sampleRate;
+    header.samplePosition = samplePosition;
+    header.epochMicros = epochMicros;
+    nextPosition = samplePosition + sampleCount;
+
+    if (subscriptionUnion & WS_SUBSCRIBE_PCM)
+    {
+        size_t length = AudioWireFormat::encodePcm(header, samples, encodeBuffer, sizeof(encodeBuffer));
+        enqueue(WS_MESSAGE_AUDIO, WS_SUBSCRIBE_PCM, encodeBuffer, length);
+    }
+
+    if (subscriptionUnion & WS_SUBSCRIBE_ADPCM)
+    {
+        if (adpcmResyncPending)
+        {
+            adpcmEncoder.reset();
+            header.flags |= AUDIO_WIRE_FLAG_RESYNC;
+            adpcmResyncPending = false;
+        }
+        size_t length = AudioWireFormat::encodeAdpcm(header, samples, adpcmEncoder, encodeBuffer, sizeof(encodeBuffer));
+        enqueue(WS_MESSAGE_AUDIO, WS_SUBSCRIBE_ADPCM, encodeBuffer, length);
+    }
+}
+
+void WebSocketStreamCore::pushFeatures(const uint8_t *message, size_t length)
+{
+    enqueue(WS_MESSAGE_FEATURES, WS_SUBSCRIBE_FEATURES, message, length);
+}
+
+void WebSocketStreamCore::enqueue(uint8_t kind, uint8_t subscription, const uint8_t *data, size_t length)
+{
+    if (length == 0 || length > WS_STREAM_SLOT_BYTES)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (uint8_t i = 0; i < WS_STREAM_MAX_CLIENTS; i++)
+    {
+        Client &client = clients[i];
+        if (!client.connected || !(client.subscriptions & subscription))
+        {
+            continue;
+        }
+
+        // 客戶端跟不上：丟棄最舊的訊息，保留最新的資料
+        uint8_t droppedKind = 0;
+        if (client.tail - client.head >= WS_STREAM_QUEUE_DEPTH)
+        {
+            droppedKind = client.slots[client.head % WS_STREAM_QUEUE_DEPTH].kind;
+            client.head++;
+            client.stats.dropped++;
+        }
+
+        Slot &slot = client.slots[client.tail % WS_STREAM_QUEUE_DEPTH];
+        slot.kind = kind;
+        slot.length = (uint16_t)length;
+        memcpy(slot.data, data, length);
+        client.tail++;
+
+        // 同種類的下一則訊息 (可能就是剛放入的這則) 標記 GAP，接收端依樣本位置補上缺口
+        for (uint32_t n = client.head; droppedKind && n != client.tail; n++)
+        {
+            Slot &next = client.slots[n % WS_STREAM_QUEUE_DEPTH];
+            if (next.kind == droppedKind)
+            {
+                markGap(next);
+                break;
+            }
+        }
+
+        uint32_t depth = client.tail - client.head;
+        if (depth > client.stats.highWater)
+        {
+            client.stats.highWater = depth;
+        }
+    }
+}
+
+void WebSocketStreamCore::markGap(Slot &slot)
+{
+    // 旗標位置：音訊標頭第 3 位元組、特徵標頭第 7 位元組
+    if (slot.kind == WS_MESSAGE_AUDIO)
+    {
+        slot.data[3] |= AUDIO_WIRE_FLAG_GAP;
+    }
+    else if (slot.kind == WS_MESSAGE_FEATURES)
+    {
+        slot.data[7] |= FEATURE_WIRE_FLAG_GAP;
+    }
+}
+
+size_t WebSocketStreamCore::pop(uint8_t id, uint8_t *out, size_t capacity)
+{
+    if (id >= WS_STREAM_MAX_CLIENTS)
+    {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    Client &client = clients[id];
+    if (!client.connected || client.head == client.tail)
+    {
+        return 0;
+    }
+
+    Slot &slot = client.slots[client.head % WS_STREAM_QUEUE_DEPTH];
+    if (slot.length > capacity)
+    {
+        return 0;
+    }
+    memcpy(out, slot.data, slot.length);
+    client.head++;
+    client.stats.sent++;
+    return slot.length;
+}
+
+uint8_t WebSocketStreamCore::getClientCount() const
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < WS_STREAM_MAX_CLIENTS; i++)
+    {
+        if (clients[i].connected)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t WebSocketStreamCore::getQueueDepth(uint8_t id) const
+{
+    return id < WS_STREAM_MAX_CLIENTS ? clients[id].tail - clients[id].head : 0;
+}
+
+WebSocketStreamCore::ClientStats WebSocketStreamCore::getClientStats(uint8_t id) const
+{
+    ClientStats empty = {0, 0, 0};
+    return id < WS_STREAM_MAX_CLIENTS ? clients[id].stats : empty;
+}
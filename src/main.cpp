@@ -1137,6 +1137,7 @@ void microphoneTask(void *pvParameters)
         {
             // 從麥克風讀取音頻數據
             esp_err_t result = i2s_read(MIC_I2S_PORT, micAudioBuf, micBufLenBytes, &bytesRead, 100);
+            uint64_t readMicros = monotonicMicros(); // 端到端延遲的起點
             if (result == ESP_OK && bytesRead > 0)
             {
                 // 對講模式暫時停用，直接處理音訊輸出
@@ -1174,7 +1175,7 @@ void microphoneTask(void *pvParameters)
                 // MQTT 音訊傳遞：如果啟用了 MQTT 音訊，將數據發送到 MQTT 管理器
                 if (mqttAudioEnabled && audioMqttManager.isPublishingActive())
                 {
-                    bool pushResult = audioMqttManager.pushAudioData(micAudioBuf, bytesRead / sizeof(int16_t));
+                    bool pushResult = audioMqttManager.pushAudioData(micAudioBuf, bytesRead / sizeof(int16_t), readMicros);
                     if (!pushResult)
                     {
                         Serial.println("⚠️ MQTT 音訊數據推送失敗");
@@ -1505,33 +1506,21 @@ void setup()
         {
             Serial.println("✓ MQTT 音訊管理器初始化成功");
 
-            // 延遲後再嘗試連接
-            vTaskDelay(1000 / portTICK_PERIOD_MS);
+            // connect() 不阻塞：只要求 MQTT 任務立即開始連線，之後在後台自動重試
+            audioMqttManager.connect();
+            mqttAudioEnabled = true;
 
-            // 連接到 MQTT 服務器
-            Serial.println("正在嘗試連接到 MQTT 服務器...");
-            if (audioMqttManager.connect())
+            // 預設啟用特徵提取
+            if (audioMqttManager.enableFeatureExtraction())
             {
-                mqttAudioEnabled = true;
-                Serial.printf("✓ MQTT 服務器連接成功: %s:%d\n", mqttServer, mqttPort);
-
-                // 預設啟用特徵提取
-                if (audioMqttManager.enableFeatureExtraction())
-                {
-                    mqttFeatureExtractionEnabled = true;
-                    Serial.println("✓ MQTT 特徵提取已啟用");
-                }
-
-                // 啟動音訊發布
-                if (audioMqttManager.startPublishing())
-                {
-                    Serial.println("✓ MQTT 音訊發布已啟動");
-                }
+                mqttFeatureExtractionEnabled = true;
+                Serial.println("✓ MQTT 特徵提取已啟用");
             }
-            else
+
+            // 不等待連線即啟動發布：連上之前的資料寫入斷線暫存區，連線後補發
+            if (audioMqttManager.startPublishing())
             {
-                Serial.println("⚠️ MQTT 服務器連接失敗，將在後台重試");
-                // 不阻塞，讓系統繼續運行
+                Serial.printf("✓ MQTT 音訊發布已啟動 (服務器 %s:%d，連線在後台建立)\n", mqttServer, mqttPort);
             }
         }
         else
@@ -1610,11 +1599,7 @@ void loop()
     // 在使用 FreeRTOS 時，主循環可以保持空白或執行低優先級任務
     // 所有主要功能都已在任務中完成
 
-    // 非阻塞式處理 MQTT 循環
-    if (mqttAudioEnabled)
-    {
-        audioMqttManager.loop();
-    }
+    // MQTT 連線與 mqttClient.loop() 由 AudioMqttManager 的 MQTT 任務處理，主循環不需要呼叫
 
     // 減少檢查頻率，避免看門狗問題
     vTaskDelay(100 / portTICK_PERIOD_MS); // 100ms 延遲
@@ -0,0 +1,31 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+// 主機端測試共用的最小斷言工具 (不依賴測試框架)：失敗時印出位置並計數，
+// main 以 hostTestResult() 的回傳值結束，make 依結束碼判斷成敗
+static int hostTestFailures = 0;
+
+#define CHECK(cond)                                                      \
+    do                                                                   \
+    {                                                                    \
+        if (!(cond))                                                     \
+        {                                                                \
+            printf("✗ %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+            hostTestFailures++;                                          \
+        }                                                                \
+    } while (0)
+
+static inline int hostTestResult(const char *name)
+{
+    if (hostTestFailures > 0)
+    {
+        printf("✗ %s: %d 項檢查失敗\n", name, hostTestFailures);
+        return 1;
+    }
+    printf("✓ %s: 全部通過\n", name);
+    return 0;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,119 @@
+// MFCC 主機端測試共用：雙精度參考實作與具名測試訊號
+// test_fixed_point_mfcc (整數引擎) 與 test_float_mfcc (float / double 引擎) 以同一組參考與訊號量測偏差
+#ifndef MFCC_REFERENCE_H
+#define MFCC_REFERENCE_H
+
+#include "FeatureTables.h"
+#include <math.h>
+#include <stdint.h>
+#include <random>
+#include <vector>
+
+// 雙精度參考：與浮點路徑相同的定義 (視窗含 1/32768 正規化、補零、功率下限 1e-10、ln 梅爾能量、正交 DCT-II)
+template <uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks, uint8_t MfccCoeffs, uint16_t FrameSize>
+struct DoubleReference
+{
+    FeatureTable<double, FrameSize> window = makeHammingWindow<double, FrameSize>();
+    FeatureTable<double, MfccCoeffs * MelBanks> dct = makeDctTable<double, MfccCoeffs, MelBanks>();
+    MelFilterBank<double, MelBanks, FftSize> melBank = makeMelFilterBank<double, SampleRate, FftSize, MelBanks>();
+    std::vector<double> cosTable, sinTable;
+    double logMel[MelBanks];
+    double mfcc[MfccCoeffs];
+
+    DoubleReference() : cosTable(FftSize), sinTable(FftSize)
+    {
+        for (int i = 0; i < FftSize; i++)
+        {
+            cosTable[i] = cos(2.0 * M_PI * i / FftSize);
+            sinTable[i] = sin(2.0 * M_PI * i / FftSize);
+        }
+    }
+
+    void compute(const int16_t *frame)
+    {
+        double x[FrameSize];
+        for (int n = 0; n < FrameSize; n++)
+        {
+            x[n] = frame[n] * window[n];
+        }
+
+        double power[FftSize / 2 + 1];
+        for (int k = 0; k <= FftSize / 2; k++)
+        {
+            double re = 0, im = 0;
+            for (int n = 0; n < FrameSize; n++)
+            {
+                int index = (int)(((uint32_t)k * n) % FftSize);
+                re += x[n] * cosTable[index];
+                im -= x[n] * sinTable[index];
+            }
+            power[k] = fmax(re * re + im * im, 1e-10);
+        }
+
+        for (int m = 0; m < MelBanks; m++)
+        {
+            const MelFilterRange &range = melBank.ranges[m];
+            double energy = 0;
+            for (int k = 0; k < range.length; k++)
+            {
+                energy += power[range.startBin + k] * melBank.weights[range.weightOffset + k];
+            }
+            logMel[m] = energy > 0 ? log(energy) : -10.0;
+        }
+
+        for (int i = 0; i < MfccCoeffs; i++)
+        {
+            double sum = 0;
+            for (int j = 0; j < MelBanks; j++)
+            {
+                sum += logMel[j] * dct[i * MelBanks + j];
+            }
+            mfcc[i] = sum;
+        }
+    }
+};
+
+static int16_t clampSample(double value)
+{
+    value = round(value);
+    if (value > 32767)
+        return 32767;
+    if (value < -32768)
+        return -32768;
+    return (int16_t)value;
+}
+
+// 具名訊號：每個設定檔都以這組訊號量測偏差，標頭檔中引用的上限即來自這些訊號
+struct MfccTestSignal
+{
+    const char *name;
+    double frequency; // 0 表示不含正弦；負值表示 Nyquist 的倍數 (-0.98 = 0.49 fs)
+    double amplitude;
+    double noise; // 高斯雜訊標準差 (LSB)
+};
+
+static const MfccTestSignal MFCC_TEST_SIGNALS[] = {
+    {"正弦 100 Hz 滿刻度", 100, 32767, 0},
+    {"正弦 440 Hz 滿刻度", 440, 32767, 0},
+    {"正弦 1 kHz -20 dB", 1000, 3277, 0},
+    {"正弦 3 kHz + 雜訊", 3000, 16000, 300},
+    {"正弦 0.49 fs 滿刻度", -0.98, 32767, 0},
+    {"白雜訊 σ=8000", 0, 0, 8000},
+    {"白雜訊 σ=30", 0, 0, 30},
+    {"正弦 440 Hz 峰值 100", 440, 100, 0},
+    {"靜音", 0, 0, 0},
+};
+
+template <uint32_t SampleRate, uint16_t FrameSize>
+static void fillTestSignal(int16_t *frame, const MfccTestSignal &signal, std::mt19937 &rng,
+                           std::normal_distribution<double> &gaussian)
+{
+    double frequency = signal.frequency < 0 ? -signal.frequency * SampleRate / 2.0 : signal.frequency;
+    for (int n = 0; n < FrameSize; n++)
+    {
+        double value = signal.amplitude * sin(2.0 * M_PI * frequency * n / SampleRate);
+        frame[n] = clampSample(value + signal.noise * gaussian(rng));
+    }
+}
+
+#endif // MFCC_REFERENCE_H
@@ -0,0 +1,193 @@
+// 二進位音訊封包 (AudioWireFormat v2) 的主機端往返測試
+// 標頭欄位與位元組佈局、64 位元樣本時鐘、GAP / REPLAY / RESYNC 旗標、PCM16 與 IMA-ADPCM 負載、格式錯誤的拒絕
+#include "AudioWireFormat.h"
+#include "HostTest.h"
+#include <string.h>
+
+#define PACKET_SAMPLES 256
+
+static AudioWireHeader makeHeader(uint16_t sequence, uint64_t position, uint8_t flags)
+{
+    AudioWireHeader header;
+    memset(&header, 0, sizeof(header));
+    header.flags = flags;
+    header.sequence = sequence;
+    header.sampleCount = PACKET_SAMPLES;
+    header.sampleRate = 16000;
+    header.samplePosition = position;
+    header.epochMicros = 1760000000123456ULL; // 2025 年的 Unix 時間 (µs)，超過 32 位元
+    return header;
+}
+
+static void testHeaderLayout()
+{
+    // 樣本位置超過 2^32 (16 kHz 約 3 天)，確認高位元組不被截斷
+    AudioWireHeader header = makeHeader(0xBEEF, 0x0123456789ABCDEFULL,
+                                        AUDIO_WIRE_FLAG_GAP | AUDIO_WIRE_FLAG_REPLAY | AUDIO_WIRE_FLAG_RESYNC);
+    uint8_t out[AUDIO_WIRE_HEADER_SIZE];
+    CHECK(AudioWireFormat::writeHeader(header, out, sizeof(out)) == AUDIO_WIRE_HEADER_SIZE);
+    CHECK(AudioWireFormat::writeHeader(header, out, sizeof(out) - 1) == 0);
+
+    // little-endian 佈局 (與 include/AudioWireFormat.h 的表格一致)
+    CHECK(out[0] == AUDIO_WIRE_MAGIC);
+    CHECK(out[1] == 2);
+    CHECK(out[3] == 0x07);
+    CHECK(out[4] == 0xEF && out[5] == 0xBE);
+    CHECK(out[6] == (PACKET_SAMPLES & 0xFF) && out[7] == (PACKET_SAMPLES >> 8));
+    CHECK(out[8] == 0x80 && out[9] == 0x3E && out[10] == 0 && out[11] == 0);
+    CHECK(out[12] == 0xEF && out[19] == 0x01);
+    CHECK(out[20] == (uint8_t)(header.epochMicros & 0xFF) && out[27] == (uint8_t)(header.epochMicros >> 56));
+
+    AudioWireHeader decoded;
+    CHECK(AudioWireFormat::readHeader(out, sizeof(out), &decoded));
+    CHECK(decoded.version == AUDIO_WIRE_VERSION);
+    CHECK(decoded.flags == header.flags);
+    CHECK(decoded.sequence == header.sequence);
+    CHECK(decoded.sampleCount == header.sampleCount);
+    CHECK(decoded.sampleRate == header.sampleRate);
+    CHECK(decoded.samplePosition == header.samplePosition);
+    CHECK(decoded.epochMicros == header.epochMicros);
+}
+
+static void testRejects()
+{
+    int16_t samples[PACKET_SAMPLES] = {};
+    uint8_t packet[AUDIO_WIRE_HEADER_SIZE + 2 * PACKET_SAMPLES];
+    AudioWireHeader header = makeHeader(1, 0, 0);
+    size_t length = AudioWireFormat::encodePcm(header, samples, packet, sizeof(packet));
+    CHECK(length == AudioWireFormat::pcmPacketSize(PACKET_SAMPLES));
+    CHECK(AudioWireFormat::encodePcm(header, samples, packet, length - 1) == 0);
+
+    int16_t decoded[PACKET_SAMPLES];
+    AudioWireHeader parsed;
+    CHECK(!AudioWireFormat::readHeader(packet, AUDIO_WIRE_HEADER_SIZE - 1, &parsed));
+    CHECK(AudioWireFormat::decodePcm(packet, length - 1, decoded, PACKET_SAMPLES) == -1);
+    CHECK(AudioWireFormat::decodePcm(packet, length, decoded, PACKET_SAMPLES - 1) == -1);
+
+    ImaAdpcmCodec decoder;
+    CHECK(AudioWireFormat::decodeAdpcm(packet, length, decoded, PACKET_SAMPLES, decoder) == -1); // 編碼不符
+
+    packet[1] = 1; // 版本 1 (16 位元組標頭) 不再接受
+    CHECK(!AudioWireFormat::readHeader(packet, length, &parsed));
+    packet[1] = AUDIO_WIRE_VERSION;
+    packet[0] = 0xA6; // 緊湊特徵幀的 magic
+    CHECK(!AudioWireFormat::readHeader(packet, length, &parsed));
+}
+
+static void testPcmRoundTrip()
+{
+    int16_t samples[PACKET_SAMPLES];
+    for (int i = 0; i < PACKET_SAMPLES; i++)
+    {
+        samples[i] = (int16_t)(i * 257 - 32768); // 涵蓋 -32768 ~ 32767
+    }
+    samples[PACKET_SAMPLES - 1] = 32767;
+
+    uint8_t packet[AUDIO_WIRE_HEADER_SIZE + 2 * PACKET_SAMPLES];
+    AudioWireHeader header = makeHeader(7, 123456789012ULL, AUDIO_WIRE_FLAG_REPLAY);
+    header.codec = AUDIO_CODEC_IMA_ADPCM; // encodePcm 會改為 PCM16
+    size_t length = AudioWireFormat::encodePcm(header, samples, packet, sizeof(packet));
+
+    int16_t decoded[PACKET_SAMPLES];
+    CHECK(AudioWireFormat::decodePcm(packet, length, decoded, PACKET_SAMPLES) == PACKET_SAMPLES);
+    CHECK(memcmp(samples, decoded, sizeof(samples)) == 0);
+
+    AudioWireHeader parsed;
+    CHECK(AudioWireFormat::readHeader(packet, length, &parsed));
+    CHECK(parsed.codec == AUDIO_CODEC_PCM16);
+    CHECK(parsed.flags == AUDIO_WIRE_FLAG_REPLAY);
+}
+
+static void testAdpcmStreamWithLoss()
+{
+    // 連續編碼 8 包，接收端遺失第 3 包：其餘各包以封包內的起始狀態解碼，結果與無遺失時相同
+    const int packets = 8;
+    const int lost = 3;
+    uint8_t stream[packets][AUDIO_WIRE_HEADER_SIZE + AUDIO_WIRE_ADPCM_STATE_SIZE + PACKET_SAMPLES / 2];
+    size_t lengths[packets];
+    ImaAdpcmCodec encoder;
+    uint32_t seed = 1;
+
+    for (int p = 0; p < packets; p++)
+    {
+        int16_t samples[PACKET_SAMPLES];
+        for (int i = 0; i < PACKET_SAMPLES; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            samples[i] = (int16_t)((int)((seed >> 16) & 0x3FFF) - 0x2000 + 12000 * ((p * PACKET_SAMPLES + i) / 40 % 2));
+        }
+        AudioWireHeader header = makeHeader((uint16_t)p, (uint64_t)p * PACKET_SAMPLES, 0);
+        lengths[p] = AudioWireFormat::encodeAdpcm(header, samples, encoder, stream[p], sizeof(stream[p]));
+        CHECK(lengths[p] == AudioWireFormat::adpcmPacketSize(PACKET_SAMPLES));
+    }
+
+    // 空間不足時不改變編碼器狀態
+    ImaAdpcmState before = encoder.getState();
+    int16_t silence[PACKET_SAMPLES] = {};
+    uint8_t small[16];
+    CHECK(AudioWireFormat::encodeAdpcm(makeHeader(0, 0, 0), silence, encoder, small, sizeof(small)) == 0);
+    CHECK(encoder.getState().predictor == before.predictor && encoder.getState().stepIndex == before.stepIndex);
+
+    ImaAdpcmCodec continuous, lossy;
+    uint64_t expectedPosition = 0;
+    int gaps = 0;
+    uint64_t missing = 0;
+    for (int p = 0; p < packets; p++)
+    {
+        int16_t reference[PACKET_SAMPLES], decoded[PACKET_SAMPLES];
+        CHECK(AudioWireFormat::decodeAdpcm(stream[p], lengths[p], reference, PACKET_SAMPLES, continuous) ==
+              PACKET_SAMPLES);
+        if (p == lost)
+        {
+            continue;
+        }
+        CHECK(AudioWireFormat::decodeAdpcm(stream[p], lengths[p], decoded, PACKET_SAMPLES, lossy) == PACKET_SAMPLES);
+        CHECK(memcmp(reference, decoded, sizeof(decoded)) == 0);
+
+        // 接收端以樣本位置偵測缺口
+        AudioWireHeader header;
+        AudioWireFormat::readHeader(stream[p], lengths[p], &header);
+        if (header.samplePosition > expectedPosition)
+        {
+            gaps++;
+            missing += header.samplePosition - expectedPosition;
+        }
+        expectedPosition = header.samplePosition + header.sampleCount;
+    }
+    CHECK(gaps == 1);
+    CHECK(missing == PACKET_SAMPLES);
+
+    // 起始狀態的步階索引超出範圍視為格式錯誤
+    stream[0][AUDIO_WIRE_HEADER_SIZE + 2] = 89;
+    int16_t decoded[PACKET_SAMPLES];
+    CHECK(AudioWireFormat::decodeAdpcm(stream[0], lengths[0], decoded, PACKET_SAMPLES, lossy) == -1);
+}
+
+static void testSampleClock()
+{
+    // 第一個樣本的時間 = epochMicros + samplePosition · 10^6 / sampleRate；跨越 2^32 樣本仍精確到 µs
+    AudioWireHeader header = makeHeader(0, (1ULL << 32) + 16000, 0);
+    uint8_t out[AUDIO_WIRE_HEADER_SIZE];
+    AudioWireFormat::writeHeader(header, out, sizeof(out));
+    AudioWireHeader parsed;
+    CHECK(AudioWireFormat::readHeader(out, sizeof(out), &parsed));
+    uint64_t micros = parsed.epochMicros + parsed.samplePosition * 1000000ULL / parsed.sampleRate;
+    CHECK(micros == header.epochMicros + 268435456000ULL + 1000000ULL);
+
+    // 8 kHz 封包 (降級層級) 以自己的取樣率計算位置
+    header.sampleRate = 8000;
+    header.samplePosition = 8000;
+    AudioWireFormat::writeHeader(header, out, sizeof(out));
+    AudioWireFormat::readHeader(out, sizeof(out), &parsed);
+    CHECK(parsed.epochMicros + parsed.samplePosition * 1000000ULL / parsed.sampleRate == header.epochMicros + 1000000ULL);
+}
+
+int main()
+{
+    testHeaderLayout();
+    testRejects();
+    testPcmRoundTrip();
+    testAdpcmStreamWithLoss();
+    testSampleClock();
+    return hostTestResult("test_audio_wire_format");
+}
@@ -0,0 +1,362 @@
+// 特徵幀封包 (FeatureWireFormat v2) 的主機端測試
+// 40 位元組標頭的位元組佈局與拒絕條件；半精度轉換：全部 65536 個半精度值往返、
+// floatToHalf 與獨立參考 (雙精度計算最接近值，平手取偶數) 逐一比對，含次正規數、溢位與平手；
+// int16 / float16 幀往返 (量化誤差、飽和、NaN)
+#include "FeatureWireFormat.h"
+#include "HostTest.h"
+#include <math.h>
+#include <string.h>
+#include <random>
+
+#define MFCC_COUNT 13
+#define MEL_COUNT 26
+#define VALUE_COUNT (MFCC_COUNT + MEL_COUNT + FEATURE_WIRE_STAT_COUNT)
+#define RANDOM_FLOATS 2000000
+
+// 半精度位元 → 數值 (只用 ldexp，不經 halfToFloat)
+static double halfValue(uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1F;
+    int mantissa = half & 0x3FF;
+    double magnitude = exponent == 0 ? ldexp(mantissa, -24) : ldexp(1024 + mantissa, exponent - 25);
+    return (half & 0x8000) ? -magnitude : magnitude;
+}
+
+// 參考實作：在有限的半精度值中找最接近的值，平手取尾數為偶數者；超過 65520 (最大值與 2^16 的中點) 為無限大
+static uint16_t referenceHalf(float value)
+{
+    uint16_t sign = signbit(value) ? 0x8000 : 0;
+    double magnitude = fabs((double)value);
+    uint16_t low = 0, high = 0x7C00; // halfValue(0x7C00) = 2^16，作為溢位的上界
+    while (high - low > 1)
+    {
+        uint16_t mid = (uint16_t)((low + high) / 2);
+        if (halfValue(mid) <= magnitude)
+            low = mid;
+        else
+            high = mid;
+    }
+    if (magnitude >= halfValue(high))
+        return (uint16_t)(sign | high);
+
+    double below = magnitude - halfValue(low);
+    double above = halfValue(high) - magnitude;
+    uint16_t nearest = below < above ? low : above < below ? high : ((low & 1) ? high : low);
+    return (uint16_t)(sign | nearest);
+}
+
+static float floatFromBits(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint32_t bitsFromFloat(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static void testHalfRoundTrip()
+{
+    // 每個半精度值轉成 float 再轉回，位元相同 (NaN 只要求仍為 NaN)
+    int mismatches = 0;
+    for (uint32_t half = 0; half <= 0xFFFF; half++)
+    {
+        float value = FeatureWireFormat::halfToFloat((uint16_t)half);
+        bool nan = (half & 0x7C00) == 0x7C00 && (half & 0x3FF) != 0;
+        if (nan)
+        {
+            mismatches += isnan(value) && (FeatureWireFormat::floatToHalf(value) & 0x7FFF) > 0x7C00 ? 0 : 1;
+            continue;
+        }
+        bool infinite = (half & 0x7FFF) == 0x7C00;
+        mismatches += (infinite ? isinf(value) : (double)value == halfValue((uint16_t)half)) ? 0 : 1;
+        mismatches += FeatureWireFormat::floatToHalf(value) == half ? 0 : 1;
+    }
+    printf("半精度往返: 65536 個值, 不一致 %d\n", mismatches);
+    CHECK(mismatches == 0);
+
+    // 次正規數邊界
+    CHECK(FeatureWireFormat::halfToFloat(0x0001) == ldexpf(1.0f, -24));
+    CHECK(FeatureWireFormat::halfToFloat(0x03FF) == ldexpf(1023.0f, -24));
+    CHECK(FeatureWireFormat::halfToFloat(0x0400) == ldexpf(1.0f, -14));
+    CHECK(FeatureWireFormat::halfToFloat(0x7BFF) == 65504.0f);
+    CHECK(FeatureWireFormat::halfToFloat(0x7C00) == INFINITY);
+    CHECK(FeatureWireFormat::halfToFloat(0xFC00) == -INFINITY);
+    CHECK(signbit(FeatureWireFormat::halfToFloat(0x8000)));
+}
+
+static void testFloatToHalfRounding()
+{
+    struct Case
+    {
+        float value;
+        uint16_t half;
+    };
+    const Case cases[] = {
+        {1.0f, 0x3C00},
+        {-2.0f, 0xC000},
+        {0.0f, 0x0000},
+        {-0.0f, 0x8000},
+        {1.0f + ldexpf(1.0f, -11), 0x3C00},                        // 平手：尾數 0 為偶數，捨去
+        {1.0f + 3 * ldexpf(1.0f, -11), 0x3C02},                    // 平手：尾數 1 為奇數，進位
+        {1.0f + ldexpf(1.0f, -11) + ldexpf(1.0f, -20), 0x3C01},    // 略高於平手
+        {2047.0f / 1024.0f + ldexpf(1.0f, -11), 0x4000},           // 尾數全 1 進位到下一個指數
+        {65504.0f, 0x7BFF},
+        {65519.996f, 0x7BFF},                                      // 低於溢位門檻
+        {65520.0f, 0x7C00},                                        // 平手：進位成無限大
+        {1e10f, 0x7C00},
+        {-1e10f, 0xFC00},
+        {INFINITY, 0x7C00},
+        {ldexpf(1.0f, -24), 0x0001},                               // 最小次正規數
+        {ldexpf(1.0f, -25), 0x0000},                               // 最小次正規數的一半：平手取 0
+        {ldexpf(1.0f, -25) + ldexpf(1.0f, -40), 0x0001},           // 略高於一半
+        {ldexpf(3.0f, -25), 0x0002},                               // 1.5 × 最小：平手取偶數 2
+        {ldexpf(5.0f, -25), 0x0002},                               // 2.5 × 最小：平手取偶數 2
+        {ldexpf(1.0f, -26), 0x0000},
+        {-ldexpf(1.0f, -26), 0x8000},                              // 保留符號
+        {ldexpf(2047.0f, -25), 0x0400},                            // 最大次正規數 + 半格：平手進位成最小正規數
+        {ldexpf(1.0f, -14), 0x0400},
+        {floatFromBits(0x00000001), 0x0000},                       // float 的次正規數
+    };
+    int failures = 0;
+    for (const Case &c : cases)
+    {
+        uint16_t half = FeatureWireFormat::floatToHalf(c.value);
+        if (half != c.half || referenceHalf(c.value) != c.half)
+        {
+            printf("  %.9g: floatToHalf 0x%04X 參考 0x%04X 預期 0x%04X\n", c.value, half, referenceHalf(c.value),
+                   c.half);
+            failures++;
+        }
+    }
+    CHECK(failures == 0);
+    CHECK(FeatureWireFormat::floatToHalf(NAN) != 0x7C00 && (FeatureWireFormat::floatToHalf(NAN) & 0x7C00) == 0x7C00);
+
+    // 隨機 float：指數涵蓋次正規數到溢位 (2^-30 ~ 2^17)，尾數隨機，逐一與參考比對
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<uint32_t> mantissa(0, 0x7FFFFF);
+    std::uniform_int_distribution<int> exponent(127 - 30, 127 + 17);
+    int mismatches = 0;
+    for (int i = 0; i < RANDOM_FLOATS; i++)
+    {
+        uint32_t bits = ((uint32_t)(i & 1) << 31) | ((uint32_t)exponent(rng) << 23) | mantissa(rng);
+        // 每 4 個把被捨去的低位設成剛好平手
+        if (i % 4 == 2)
+            bits = (bits & ~0x1FFFu) | 0x1000u;
+        float value = floatFromBits(bits);
+        mismatches += FeatureWireFormat::floatToHalf(value) == referenceHalf(value) ? 0 : 1;
+    }
+    printf("floatToHalf 隨機比對: %d 個值, 不一致 %d\n", RANDOM_FLOATS, mismatches);
+    CHECK(mismatches == 0);
+
+    // 次正規數範圍內的每個平手點 (k + 0.5) × 2^-24
+    int tieMismatches = 0;
+    for (int k = 0; k < 1024; k++)
+    {
+        float tie = ldexpf(2.0f * k + 1, -25);
+        uint16_t expected = (uint16_t)((k & 1) ? k + 1 : k);
+        tieMismatches += FeatureWireFormat::floatToHalf(tie) == expected ? 0 : 1;
+        tieMismatches += FeatureWireFormat::floatToHalf(-tie) == (0x8000 | expected) ? 0 : 1;
+    }
+    CHECK(tieMismatches == 0);
+    CHECK(bitsFromFloat(FeatureWireFormat::halfToFloat(FeatureWireFormat::floatToHalf(-0.0f))) == 0x80000000u);
+}
+
+static FeatureWireHeader makeHeader(uint8_t encoding)
+{
+    FeatureWireHeader header;
+    FeatureWireFormat::initHeader(header, encoding, MFCC_COUNT, MEL_COUNT, 160, 16000);
+    header.frameCount = 2;
+    header.flags = FEATURE_WIRE_FLAG_GAP;
+    header.sequence = 0xFFFF;
+    header.samplePosition = 0x0123456789ABCDEFULL;
+    header.epochMicros = 1760000000123456ULL;
+    return header;
+}
+
+static void testHeaderLayout()
+{
+    FeatureWireHeader header = makeHeader(FEATURE_ENCODING_INT16);
+    uint8_t out[FEATURE_WIRE_HEADER_SIZE];
+    CHECK(FEATURE_WIRE_HEADER_SIZE == 40);
+    CHECK(FeatureWireFormat::writeHeader(header, out, sizeof(out)) == FEATURE_WIRE_HEADER_SIZE);
+    CHECK(FeatureWireFormat::writeHeader(header, out, sizeof(out) - 1) == 0);
+
+    // little-endian 佈局 (與 include/FeatureWireFormat.h 的表格一致)
+    CHECK(out[0] == FEATURE_WIRE_MAGIC && out[1] == FEATURE_WIRE_VERSION);
+    CHECK(out[2] == FEATURE_ENCODING_INT16 && out[3] == 2);
+    CHECK(out[4] == MFCC_COUNT && out[5] == MEL_COUNT && out[6] == FEATURE_WIRE_STAT_COUNT);
+    CHECK(out[7] == FEATURE_WIRE_FLAG_GAP);
+    CHECK(out[8] == 0xFF && out[9] == 0xFF);
+    CHECK(out[10] == 160 && out[11] == 0);
+    CHECK(out[12] == 0x80 && out[13] == 0x3E && out[14] == 0 && out[15] == 0);
+    CHECK(out[16] == 0xEF && out[23] == 0x01);
+    CHECK(out[24] == (uint8_t)(header.epochMicros & 0xFF) && out[31] == (uint8_t)(header.epochMicros >> 56));
+    CHECK(out[32] == FEATURE_MFCC_Q && out[33] == FEATURE_MEL_Q);
+    CHECK(out[34] == FEATURE_HZ_Q && out[36] == FEATURE_HZ_Q && out[37] == FEATURE_UNIT_Q && out[39] == FEATURE_UNIT_Q);
+
+    // 只有標頭時 frameCount 為 2 的訊息長度不足
+    FeatureWireHeader decoded;
+    CHECK(!FeatureWireFormat::readHeader(out, sizeof(out), &decoded));
+    header.frameCount = 0;
+    FeatureWireFormat::writeHeader(header, out, sizeof(out));
+    CHECK(FeatureWireFormat::readHeader(out, sizeof(out), &decoded));
+    CHECK(decoded.sequence == 0xFFFF && decoded.hopSamples == 160 && decoded.sampleRate == 16000);
+    CHECK(decoded.samplePosition == header.samplePosition && decoded.epochMicros == header.epochMicros);
+    CHECK(decoded.mfccQ == FEATURE_MFCC_Q && decoded.statQ[5] == FEATURE_UNIT_Q);
+
+    // magic、版本、統計數量錯誤
+    out[0] ^= 0xFF;
+    CHECK(!FeatureWireFormat::readHeader(out, sizeof(out), &decoded));
+    out[0] ^= 0xFF;
+    out[1] = 1;
+    CHECK(!FeatureWireFormat::readHeader(out, sizeof(out), &decoded));
+    out[1] = FEATURE_WIRE_VERSION;
+    out[6] = 3;
+    CHECK(!FeatureWireFormat::readHeader(out, sizeof(out), &decoded));
+    header.statCount = 3;
+    CHECK(FeatureWireFormat::writeHeader(header, out, sizeof(out)) == 0);
+}
+
+// 寫入兩幀再逐幀讀回；回傳讀回的值
+static bool encodeFrames(const FeatureWireHeader &header, const float (*frames)[VALUE_COUNT], float (*decoded)[VALUE_COUNT])
+{
+    uint8_t packet[FEATURE_WIRE_HEADER_SIZE + 2 * VALUE_COUNT * 2];
+    size_t length = FeatureWireFormat::writeHeader(header, packet, sizeof(packet));
+    for (int f = 0; f < header.frameCount; f++)
+    {
+        const float *values = frames[f];
+        size_t written = FeatureWireFormat::writeFrame(header, values, values + MFCC_COUNT,
+                                                       values + MFCC_COUNT + MEL_COUNT, packet + length,
+                                                       sizeof(packet) - length);
+        if (written != FeatureWireFormat::frameSize(header))
+            return false;
+        length += written;
+    }
+    if (length != FeatureWireFormat::packetSize(header))
+        return false;
+
+    for (int f = 0; f < header.frameCount; f++)
+    {
+        if (!FeatureWireFormat::readFrame(packet, length, (uint8_t)f, decoded[f], VALUE_COUNT))
+            return false;
+    }
+    // 超出幀數、容量不足與截斷的訊息
+    float spare[VALUE_COUNT];
+    CHECK(!FeatureWireFormat::readFrame(packet, length, header.frameCount, spare, VALUE_COUNT));
+    CHECK(!FeatureWireFormat::readFrame(packet, length, 0, spare, FeatureWireFormat::frameSize(header) / 2 - 1));
+    CHECK(!FeatureWireFormat::readFrame(packet, length - 1, 0, spare, VALUE_COUNT));
+    return true;
+}
+
+static int8_t valueQ(const FeatureWireHeader &header, int i)
+{
+    if (i < MFCC_COUNT)
+        return header.mfccQ;
+    if (i < MFCC_COUNT + MEL_COUNT)
+        return header.melQ;
+    return header.statQ[i - MFCC_COUNT - MEL_COUNT];
+}
+
+static void testInt16Frames()
+{
+    FeatureWireHeader header = makeHeader(FEATURE_ENCODING_INT16);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    float frames[2][VALUE_COUNT];
+    float decoded[2][VALUE_COUNT];
+    for (int trial = 0; trial < 1000; trial++)
+    {
+        // 值域內的隨機值：每個欄位的量化誤差不超過半個 LSB
+        for (int f = 0; f < 2; f++)
+        {
+            for (int i = 0; i < VALUE_COUNT; i++)
+            {
+                frames[f][i] = unit(rng) * ldexpf(32767.0f, -valueQ(header, i));
+            }
+        }
+        CHECK(encodeFrames(header, frames, decoded));
+        double worst = 0;
+        for (int f = 0; f < 2; f++)
+        {
+            for (int i = 0; i < VALUE_COUNT; i++)
+            {
+                worst = fmax(worst, fabs(decoded[f][i] - frames[f][i]) / ldexp(1.0, -valueQ(header, i)));
+            }
+        }
+        CHECK(worst <= 0.5 + 1e-3);
+    }
+
+    // 飽和、NaN、平手 (±0.5 LSB 遠離 0)、已量化的值精確往返
+    for (int i = 0; i < VALUE_COUNT; i++)
+    {
+        frames[0][i] = 1e9f;
+        frames[1][i] = -1e9f;
+    }
+    frames[0][0] = NAN;
+    frames[0][1] = ldexpf(0.5f, -FEATURE_MFCC_Q);
+    frames[0][2] = -ldexpf(0.5f, -FEATURE_MFCC_Q);
+    frames[0][3] = ldexpf(-12345.0f, -FEATURE_MFCC_Q);
+    frames[0][MFCC_COUNT] = -ldexpf(32768.0f, -FEATURE_MEL_Q);
+    CHECK(encodeFrames(header, frames, decoded));
+    CHECK(decoded[0][0] == 0);
+    CHECK(decoded[0][1] == ldexpf(1.0f, -FEATURE_MFCC_Q));
+    CHECK(decoded[0][2] == -ldexpf(1.0f, -FEATURE_MFCC_Q));
+    CHECK(decoded[0][3] == frames[0][3]);
+    CHECK(decoded[0][MFCC_COUNT] == frames[0][MFCC_COUNT]);
+    for (int i = 4; i < VALUE_COUNT; i++)
+    {
+        if (i != MFCC_COUNT)
+            CHECK(decoded[0][i] == ldexpf(32767.0f, -valueQ(header, i)));
+        CHECK(decoded[1][i] == ldexpf(-32768.0f, -valueQ(header, i)));
+    }
+}
+
+static void testFloat16Frames()
+{
+    FeatureWireHeader header = makeHeader(FEATURE_ENCODING_FLOAT16);
+    header.statCount = 0; // 未選取頻譜統計
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> logMagnitude(-20.0f, 15.0f);
+
+    float frames[2][VALUE_COUNT] = {};
+    float decoded[2][VALUE_COUNT];
+    for (int trial = 0; trial < 1000; trial++)
+    {
+        for (int f = 0; f < 2; f++)
+        {
+            for (int i = 0; i < MFCC_COUNT + MEL_COUNT; i++)
+            {
+                float value = exp2f(logMagnitude(rng));
+                frames[f][i] = (i & 1) ? -value : value;
+            }
+        }
+        CHECK(encodeFrames(header, frames, decoded));
+        for (int f = 0; f < 2; f++)
+        {
+            for (int i = 0; i < MFCC_COUNT + MEL_COUNT; i++)
+            {
+                // 與逐值 floatToHalf → halfToFloat 完全一致；正規數相對誤差不超過 2^-11
+                float expected = FeatureWireFormat::halfToFloat(FeatureWireFormat::floatToHalf(frames[f][i]));
+                CHECK(decoded[f][i] == expected);
+                if (fabsf(frames[f][i]) >= ldexpf(1.0f, -14))
+                    CHECK(fabsf(decoded[f][i] - frames[f][i]) <= fabsf(frames[f][i]) * ldexpf(1.0f, -11));
+            }
+        }
+    }
+}
+
+int main()
+{
+    testHalfRoundTrip();
+    testFloatToHalfRounding();
+    testHeaderLayout();
+    testInt16Frames();
+    testFloat16Frames();
+    return hostTestResult("test_feature_wire_format");
+}
@@ -0,0 +1,80 @@
+// 整數 MFCC 引擎 (FixedPointMfcc) 的主機端測試
+// 1. 參考實作 computeReference() 與最佳化實作 compute() 逐位元一致 (具名訊號 + 隨機幀)
+// 2. 與雙精度參考 (直接 DFT，同一組視窗/梅爾/DCT 定義) 比較對數梅爾能量與 MFCC 的最大絕對偏差
+#include "FixedPointMfcc.h"
+#include "HostTest.h"
+#include "MfccReference.h"
+
+// 實測上限 (兩個設定檔、下列所有訊號)；FixedPointMfcc.h 的說明引用同一組數字
+#define MAX_MFCC_DEVIATION 0.15
+#define MAX_LOG_MEL_DEVIATION 0.25
+#define RANDOM_FRAMES 2000
+
+template <uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks, uint8_t MfccCoeffs, uint16_t FrameSize>
+static void runProfile(const char *profile)
+{
+    typedef FixedPointMfccT<SampleRate, FftSize, MelBanks, MfccCoeffs, FrameSize> Engine;
+    static Engine engine;
+    static DoubleReference<SampleRate, FftSize, MelBanks, MfccCoeffs, FrameSize> reference;
+    std::mt19937 rng(12345);
+    std::normal_distribution<double> gaussian(0.0, 1.0);
+    int16_t frame[FrameSize];
+
+    printf("=== %s (%u Hz, FFT %u, %u 梅爾, %u MFCC) ===\n", profile, (unsigned)SampleRate, FftSize, MelBanks,
+           MfccCoeffs);
+    printf("%-26s %10s %10s %5s\n", "訊號", "MFCC 偏差", "對數梅爾", "指數");
+
+    const double nyquist = SampleRate / 2.0;
+    double worstMfcc = 0, worstMel = 0;
+    for (const MfccTestSignal &signal : MFCC_TEST_SIGNALS)
+    {
+        fillTestSignal<SampleRate, FrameSize>(frame, signal, rng, gaussian);
+
+        CHECK(engine.verifyBitExact(frame));
+        reference.compute(frame);
+
+        double mfccDeviation = 0, melDeviation = 0;
+        for (int i = 0; i < MfccCoeffs; i++)
+        {
+            mfccDeviation = fmax(mfccDeviation, fabs(engine.getMfccQ16()[i] / (double)Q16_ONE - reference.mfcc[i]));
+        }
+        for (int m = 0; m < MelBanks; m++)
+        {
+            melDeviation = fmax(melDeviation, fabs(engine.getLogMelQ16()[m] / (double)Q16_ONE - reference.logMel[m]));
+        }
+        printf("%-26s %10.4f %10.4f %5d\n", signal.name, mfccDeviation, melDeviation, engine.getFrameExponent());
+
+        CHECK(mfccDeviation <= MAX_MFCC_DEVIATION);
+        CHECK(melDeviation <= MAX_LOG_MEL_DEVIATION);
+        worstMfcc = fmax(worstMfcc, mfccDeviation);
+        worstMel = fmax(worstMel, melDeviation);
+    }
+
+    // 隨機幀：振幅橫跨 2^0 ~ 2^15，正弦、雜訊與方波混合，只檢查逐位元一致
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    int mismatches = 0;
+    for (int f = 0; f < RANDOM_FRAMES; f++)
+    {
+        double peak = pow(2.0, 15.0 * uniform(rng));
+        double frequency = nyquist * uniform(rng);
+        double noise = peak * uniform(rng) * 0.3;
+        bool square = f % 7 == 0;
+        for (int n = 0; n < FrameSize; n++)
+        {
+            double phase = sin(2.0 * M_PI * frequency * n / SampleRate);
+            double value = square ? (phase >= 0 ? peak : -peak) : peak * phase;
+            frame[n] = clampSample(value + noise * gaussian(rng));
+        }
+        mismatches += engine.verifyBitExact(frame) ? 0 : 1;
+    }
+    printf("隨機幀逐位元比對: %d 幀, 不一致 %d\n", RANDOM_FRAMES, mismatches);
+    printf("最大偏差: MFCC %.4f, 對數梅爾 %.4f\n", worstMfcc, worstMel);
+    CHECK(mismatches == 0);
+}
+
+int main()
+{
+    runProfile<16000, 512, 26, 13, 400>("預設設定檔");
+    runProfile<8000, 256, 20, 13, 200>("低成本設定檔");
+    return hostTestResult("test_fixed_point_mfcc");
+}
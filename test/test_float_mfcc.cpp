@@ -0,0 +1,186 @@
+// 浮點 MFCC 路徑 (AUDIO_FEATURE_PRECISION 為 FLOAT / DOUBLE) 的主機端測試
+// 以特徵提取器相同的流程計算：feature_t 查表 (FeatureTables.h) → 實數打包 FFT (RealFft.h) → 功率下限 →
+// 稀疏梅爾濾波 → ln → DCT 查表；與雙精度參考 (直接 DFT，MfccReference.h) 比較對數梅爾能量與 MFCC 的最大絕對偏差
+// 中間的 FFT_SIZE/2 點複數 FFT 在裝置上是 ArduinoFFT；這裡以相同的 radix-2 流程與旋轉因子遞推 (每級以 sqrt 求半角) 代替
+#include "RealFft.h"
+#include "HostTest.h"
+#include "MfccReference.h"
+
+// 實測上限 (兩個設定檔、具名訊號)；AudioFeatureExtractor.h 的說明引用同一組數字
+#define MAX_FLOAT_MFCC_DEVIATION 0.015
+#define MAX_FLOAT_LOG_MEL_DEVIATION 0.06
+#define MAX_DOUBLE_DEVIATION 1e-9
+
+// ArduinoFFT::compute 的流程：位元反轉後逐級蝶形運算，旋轉因子以複數乘法遞推，級間以半角公式更新
+template <typename T>
+static void radix2Fft(T *re, T *im, int samples)
+{
+    int j = 0;
+    for (int i = 0; i < samples - 1; i++)
+    {
+        if (i < j)
+        {
+            T tr = re[i], ti = im[i];
+            re[i] = re[j];
+            im[i] = im[j];
+            re[j] = tr;
+            im[j] = ti;
+        }
+        int k = samples >> 1;
+        while (k <= j)
+        {
+            j -= k;
+            k >>= 1;
+        }
+        j += k;
+    }
+
+    T c1 = -1, c2 = 0;
+    for (int l2 = 1; l2 < samples;)
+    {
+        int l1 = l2;
+        l2 <<= 1;
+        T u1 = 1, u2 = 0;
+        for (j = 0; j < l1; j++)
+        {
+            for (int i = j; i < samples; i += l2)
+            {
+                int i1 = i + l1;
+                T t1 = u1 * re[i1] - u2 * im[i1];
+                T t2 = u1 * im[i1] + u2 * re[i1];
+                re[i1] = re[i] - t1;
+                im[i1] = im[i] - t2;
+                re[i] += t1;
+                im[i] += t2;
+            }
+            T z = u1 * c1 - u2 * c2;
+            u2 = u1 * c2 + u2 * c1;
+            u1 = z;
+        }
+        c2 = -sqrt((1 - c1) / 2); // 正向 FFT
+        c1 = sqrt((1 + c1) / 2);
+    }
+}
+
+// 與 AudioFeatureExtractorT 的 loadFrame / computeRealFFT / computePowerSpectrum / applyMelFilters / computeMFCC 相同
+template <typename T, uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks, uint8_t MfccCoeffs, uint16_t FrameSize>
+struct FeaturePipeline
+{
+    static constexpr FeatureTable<T, FrameSize> window = makeHammingWindow<T, FrameSize>();
+    static constexpr FeatureTable<T, MfccCoeffs * MelBanks> dct = makeDctTable<T, MfccCoeffs, MelBanks>();
+    static constexpr FeatureTable<T, FftSize / 4 + 1> rfftCos = makeTwiddleCos<T, FftSize>();
+    static constexpr FeatureTable<T, FftSize / 4 + 1> rfftSin = makeTwiddleSin<T, FftSize>();
+    static constexpr MelFilterBank<T, MelBanks, FftSize> melBank =
+        makeMelFilterBank<T, SampleRate, FftSize, MelBanks>();
+
+    T re[FftSize];
+    T im[FftSize];
+    T power[FftSize / 2 + 1];
+    T logMel[MelBanks];
+    T mfcc[MfccCoeffs];
+
+    void compute(const int16_t *frame)
+    {
+        for (int i = 0; i < FftSize; i++)
+        {
+            re[i] = i < FrameSize ? (T)frame[i] * window[i] : 0;
+            im[i] = 0;
+        }
+
+        packRealFftInput<T, FftSize>(re, im);
+        radix2Fft(re, im, FftSize / 2);
+        unpackRealFftSpectrum<T, FftSize>(re, im, rfftCos, rfftSin);
+
+        for (int i = 0; i <= FftSize / 2; i++)
+        {
+            T p = re[i] * re[i] + im[i] * im[i];
+            power[i] = p < (T)1e-10 ? (T)1e-10 : p;
+        }
+
+        for (int m = 0; m < MelBanks; m++)
+        {
+            const MelFilterRange &range = melBank.ranges[m];
+            T energy = 0;
+            for (int k = 0; k < range.length; k++)
+            {
+                energy += power[range.startBin + k] * melBank.weights[range.weightOffset + k];
+            }
+            logMel[m] = energy > 0 ? log(energy) : (T)-10.0;
+        }
+
+        for (int i = 0; i < MfccCoeffs; i++)
+        {
+            T sum = 0;
+            for (int j = 0; j < MelBanks; j++)
+            {
+                sum += logMel[j] * dct[i * MelBanks + j];
+            }
+            mfcc[i] = sum;
+        }
+    }
+};
+
+struct Deviation
+{
+    double mfcc = 0;
+    double logMel = 0;
+};
+
+template <typename Pipeline, typename Reference>
+static Deviation measure(const Pipeline &pipeline, const Reference &reference, int mfccCoeffs, int melBanks)
+{
+    Deviation deviation;
+    for (int i = 0; i < mfccCoeffs; i++)
+    {
+        deviation.mfcc = fmax(deviation.mfcc, fabs((double)pipeline.mfcc[i] - reference.mfcc[i]));
+    }
+    for (int m = 0; m < melBanks; m++)
+    {
+        deviation.logMel = fmax(deviation.logMel, fabs((double)pipeline.logMel[m] - reference.logMel[m]));
+    }
+    return deviation;
+}
+
+template <uint32_t SampleRate, uint16_t FftSize, uint8_t MelBanks, uint8_t MfccCoeffs, uint16_t FrameSize>
+static void runProfile(const char *profile)
+{
+    static FeaturePipeline<float, SampleRate, FftSize, MelBanks, MfccCoeffs, FrameSize> floatPipeline;
+    static FeaturePipeline<double, SampleRate, FftSize, MelBanks, MfccCoeffs, FrameSize> doublePipeline;
+    static DoubleReference<SampleRate, FftSize, MelBanks, MfccCoeffs, FrameSize> reference;
+    std::mt19937 rng(12345);
+    std::normal_distribution<double> gaussian(0.0, 1.0);
+    int16_t frame[FrameSize];
+
+    printf("=== %s (%u Hz, FFT %u, %u 梅爾, %u MFCC) ===\n", profile, (unsigned)SampleRate, FftSize, MelBanks,
+           MfccCoeffs);
+    printf("%-26s %12s %12s %12s\n", "訊號", "float MFCC", "float 梅爾", "double MFCC");
+
+    Deviation worstFloat, worstDouble;
+    for (const MfccTestSignal &signal : MFCC_TEST_SIGNALS)
+    {
+        fillTestSignal<SampleRate, FrameSize>(frame, signal, rng, gaussian);
+        reference.compute(frame);
+        floatPipeline.compute(frame);
+        doublePipeline.compute(frame);
+
+        Deviation single = measure(floatPipeline, reference, MfccCoeffs, MelBanks);
+        Deviation full = measure(doublePipeline, reference, MfccCoeffs, MelBanks);
+        printf("%-26s %12.6f %12.6f %12.2e\n", signal.name, single.mfcc, single.logMel, full.mfcc);
+
+        CHECK(single.mfcc <= MAX_FLOAT_MFCC_DEVIATION);
+        CHECK(single.logMel <= MAX_FLOAT_LOG_MEL_DEVIATION);
+        CHECK(full.mfcc <= MAX_DOUBLE_DEVIATION && full.logMel <= MAX_DOUBLE_DEVIATION);
+        worstFloat.mfcc = fmax(worstFloat.mfcc, single.mfcc);
+        worstFloat.logMel = fmax(worstFloat.logMel, single.logMel);
+        worstDouble.mfcc = fmax(worstDouble.mfcc, fmax(full.mfcc, full.logMel));
+    }
+    printf("最大偏差: float MFCC %.6f, 對數梅爾 %.6f; double %.2e\n", worstFloat.mfcc, worstFloat.logMel,
+           worstDouble.mfcc);
+}
+
+int main()
+{
+    runProfile<16000, 512, 26, 13, 400>("預設設定檔");
+    runProfile<8000, 256, 20, 13, 200>("低成本設定檔");
+    return hostTestResult("test_float_mfcc");
+}
@@ -0,0 +1,218 @@
+// IMA-ADPCM 編解碼 (ImaAdpcmCodec) 的主機端測試
+// 以 256 樣本封包編碼整段音訊 (狀態跨封包延續)，模擬遺失一包，解碼端從下一包的起始狀態重新同步
+// 報告 SNR 與每包編碼週期數；SNR 不含遺失的封包 (該包直接以靜音補上，另外列出)
+//   test/build/test_ima_adpcm path/to/file.wav   以指定的 16 位元 PCM WAV 測試 (多聲道只取第一聲道)
+//   未指定時使用固定種子產生的雙音 + 雜訊訊號，結果可重現
+#include "ImaAdpcm.h"
+#include "HostTest.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC 1
+#endif
+
+#define PACKET_SAMPLES 256
+#define LOST_PACKET 10
+// 內建訊號的實測 SNR 為 29.0 dB (x86-64 g++)，留 1 dB 餘裕
+#define MIN_SNR_DB 28.0
+
+static uint32_t readLe32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t readLe16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+// 只支援 PCM (格式 1) 16 位元；失敗回傳 false
+static bool loadWav(const char *path, std::vector<int16_t> &samples, uint32_t &sampleRate)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+    {
+        printf("❌ 無法開啟 %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(file);
+
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0)
+    {
+        printf("❌ %s 不是 WAV 檔\n", path);
+        return false;
+    }
+    uint16_t channels = 0, bits = 0, format = 0;
+    for (size_t pos = 12; pos + 8 <= data.size();)
+    {
+        uint32_t chunkSize = readLe32(&data[pos + 4]);
+        const uint8_t *chunk = &data[pos + 8];
+        size_t available = data.size() - pos - 8;
+        if (memcmp(&data[pos], "fmt ", 4) == 0 && chunkSize >= 16 && available >= 16)
+        {
+            format = readLe16(chunk);
+            channels = readLe16(chunk + 2);
+            sampleRate = readLe32(chunk + 4);
+            bits = readLe16(chunk + 14);
+        }
+        else if (memcmp(&data[pos], "data", 4) == 0)
+        {
+            if (format != 1 || bits != 16 || channels == 0)
+            {
+                printf("❌ 只支援 16 位元 PCM WAV (格式 %u, %u 位元)\n", format, bits);
+                return false;
+            }
+            size_t frames = (chunkSize < available ? chunkSize : available) / (2 * channels);
+            samples.resize(frames);
+            for (size_t i = 0; i < frames; i++)
+            {
+                samples[i] = (int16_t)readLe16(chunk + i * 2 * channels);
+            }
+            return true;
+        }
+        pos += 8 + chunkSize + (chunkSize & 1);
+    }
+    printf("❌ %s 沒有 data 區塊\n", path);
+    return false;
+}
+
+// 440 Hz + 1.3 kHz 雙音 (各約 -10 dBFS) 加上 σ=300 的高斯雜訊，16 kHz、5 秒
+static void generateSignal(std::vector<int16_t> &samples, uint32_t &sampleRate)
+{
+    sampleRate = 16000;
+    samples.resize(sampleRate * 5);
+    std::mt19937 rng(2024);
+    std::normal_distribution<double> gaussian(0.0, 300.0);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        double t = (double)i / sampleRate;
+        double value = 10000 * sin(2 * M_PI * 440 * t) + 8000 * sin(2 * M_PI * 1300 * t) + gaussian(rng);
+        samples[i] = (int16_t)fmax(-32768.0, fmin(32767.0, round(value)));
+    }
+}
+
+static double snrDb(double signal, double noise)
+{
+    return noise > 0 ? 10 * log10(signal / noise) : INFINITY;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int16_t> samples;
+    uint32_t sampleRate = 0;
+    const char *source = "內建雙音 + 雜訊";
+    if (argc > 1)
+    {
+        source = argv[1];
+        if (!loadWav(argv[1], samples, sampleRate))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        generateSignal(samples, sampleRate);
+    }
+
+    size_t packets = samples.size() / PACKET_SAMPLES;
+    if (packets <= LOST_PACKET + 1)
+    {
+        printf("❌ 音訊太短: %zu 樣本\n", samples.size());
+        return 1;
+    }
+
+    // 編碼：每包記下起始狀態，等同 AudioWireFormat 封包內的 4 位元組狀態欄位
+    ImaAdpcmCodec encoder;
+    std::vector<ImaAdpcmState> startStates(packets);
+    std::vector<uint8_t> encoded(packets * ImaAdpcmCodec::encodedSize(PACKET_SAMPLES));
+    double totalTicks = 0;
+    for (size_t p = 0; p < packets; p++)
+    {
+        startStates[p] = encoder.getState();
+        uint8_t *out = &encoded[p * ImaAdpcmCodec::encodedSize(PACKET_SAMPLES)];
+#ifdef HAVE_RDTSC
+        uint64_t start = __rdtsc();
+        encoder.encode(&samples[p * PACKET_SAMPLES], PACKET_SAMPLES, out);
+        totalTicks += (double)(__rdtsc() - start);
+#else
+        auto start = std::chrono::steady_clock::now();
+        encoder.encode(&samples[p * PACKET_SAMPLES], PACKET_SAMPLES, out);
+        totalTicks += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+#endif
+    }
+
+    // 解碼：第 LOST_PACKET 包遺失 (補靜音)，其餘每包先套用封包內的起始狀態
+    ImaAdpcmCodec decoder;
+    std::vector<int16_t> decoded(packets * PACKET_SAMPLES, 0);
+    for (size_t p = 0; p < packets; p++)
+    {
+        if (p == LOST_PACKET)
+        {
+            continue;
+        }
+        decoder.setState(startStates[p]);
+        decoder.decode(&encoded[p * ImaAdpcmCodec::encodedSize(PACKET_SAMPLES)], PACKET_SAMPLES,
+                       &decoded[p * PACKET_SAMPLES]);
+    }
+
+    double signal = 0, noise = 0, resyncSignal = 0, resyncNoise = 0;
+    for (size_t p = 0; p < packets; p++)
+    {
+        if (p == LOST_PACKET)
+        {
+            continue;
+        }
+        for (size_t i = p * PACKET_SAMPLES; i < (p + 1) * PACKET_SAMPLES; i++)
+        {
+            double s = samples[i];
+            double e = (double)samples[i] - decoded[i];
+            signal += s * s;
+            noise += e * e;
+            if (p == LOST_PACKET + 1)
+            {
+                resyncSignal += s * s;
+                resyncNoise += e * e;
+            }
+        }
+    }
+    double snr = snrDb(signal, noise);
+    double resyncSnr = snrDb(resyncSignal, resyncNoise);
+
+    // 不遺失時與逐包重新同步的結果必須一致 (狀態欄位足以還原解碼器)
+    ImaAdpcmCodec continuous;
+    std::vector<int16_t> reference(PACKET_SAMPLES);
+    int mismatches = 0;
+    for (size_t p = 0; p < packets; p++)
+    {
+        continuous.decode(&encoded[p * ImaAdpcmCodec::encodedSize(PACKET_SAMPLES)], PACKET_SAMPLES, reference.data());
+        if (p != LOST_PACKET && memcmp(reference.data(), &decoded[p * PACKET_SAMPLES], PACKET_SAMPLES * 2) != 0)
+        {
+            mismatches++;
+        }
+    }
+
+    printf("來源: %s (%u Hz, %zu 樣本, %zu 包 × %d 樣本, 遺失第 %d 包)\n", source, (unsigned)sampleRate,
+           samples.size(), packets, PACKET_SAMPLES, LOST_PACKET);
+    printf("SNR (不含遺失封包): %.1f dB\n", snr);
+    printf("遺失後第一包 SNR: %.1f dB\n", resyncSnr);
+#ifdef HAVE_RDTSC
+    printf("編碼: 平均 %.0f 週期/包 (TSC，主機 CPU)\n", totalTicks / packets);
+#else
+    printf("編碼: 平均 %.0f ns/包 (主機 CPU)\n", totalTicks / packets);
+#endif
+    printf("與連續解碼不一致的封包: %d\n", mismatches);
+
+    CHECK(mismatches == 0);
+    if (argc <= 1)
+    {
+        // 外部 WAV 的 SNR 取決於內容，只報告不檢查
+        CHECK(snr >= MIN_SNR_DB);
+        CHECK(resyncSnr >= MIN_SNR_DB);
+    }
+    return hostTestResult("test_ima_adpcm");
+}
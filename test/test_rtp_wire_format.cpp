@@ -0,0 +1,287 @@
+// RTP 封包 (RtpWireFormat + RtpPacketizer) 的主機端回環測試
+// 以 AudioStreamManager 相同的流程編碼 L16 資料報，經 127.0.0.1 的 UDP socket 送出再接收解碼：
+// 標頭欄位與 big-endian 負載、序號連續 (含 0xFFFF 迴繞)、串流開始與來源遺失的 M 位元、
+// 時間戳跳過遺失的樣本數、送出失敗的序號缺口、樣本時鐘重新開始後時間戳仍遞增、格式錯誤的拒絕
+#include "RtpWireFormat.h"
+#include "HostTest.h"
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#define BLOCK_SAMPLES 256
+#define PACKET_CAPACITY (RTP_HEADER_SIZE + BLOCK_SAMPLES * 2)
+
+struct Loopback
+{
+    int sender = -1;
+    int receiver = -1;
+    struct sockaddr_in target;
+
+    bool open()
+    {
+        receiver = socket(AF_INET, SOCK_DGRAM, 0);
+        sender = socket(AF_INET, SOCK_DGRAM, 0);
+        if (receiver < 0 || sender < 0)
+        {
+            return false;
+        }
+
+        memset(&target, 0, sizeof(target));
+        target.sin_family = AF_INET;
+        target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        target.sin_port = 0; // 由核心指定埠
+        socklen_t length = sizeof(target);
+        if (bind(receiver, (struct sockaddr *)&target, sizeof(target)) < 0 ||
+            getsockname(receiver, (struct sockaddr *)&target, &length) < 0)
+        {
+            return false;
+        }
+
+        struct timeval timeout = {1, 0};
+        return setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0;
+    }
+
+    void close()
+    {
+        if (sender >= 0)
+        {
+            ::close(sender);
+        }
+        if (receiver >= 0)
+        {
+            ::close(receiver);
+        }
+    }
+};
+
+// 接收端解碼後的資料報
+struct Received
+{
+    RtpHeader header;
+    size_t sampleCount;
+    int16_t samples[BLOCK_SAMPLES];
+};
+
+static void fillBlock(int16_t *samples, uint64_t position)
+{
+    for (int i = 0; i < BLOCK_SAMPLES; i++)
+    {
+        // 包含負值與 0x8000 / 0x7FFF，檢查 big-endian 的符號位元
+        samples[i] = (int16_t)(uint16_t)((position + i) * 2654435761u >> 16);
+    }
+    samples[0] = INT16_MIN;
+    samples[BLOCK_SAMPLES - 1] = INT16_MAX;
+}
+
+// 與 AudioStreamManager::writeBlock 相同：編碼 → sendto → 成功才 markSent()
+static bool sendBlock(Loopback &loopback, RtpPacketizer &rtp, uint64_t position, bool *sourceGap = nullptr)
+{
+    int16_t samples[BLOCK_SAMPLES];
+    uint8_t packet[PACKET_CAPACITY];
+    fillBlock(samples, position);
+    size_t length = rtp.encode(samples, BLOCK_SAMPLES, position, packet, sizeof(packet), sourceGap);
+    if (length != RtpWireFormat::l16PacketSize(BLOCK_SAMPLES) ||
+        sendto(loopback.sender, packet, length, 0, (struct sockaddr *)&loopback.target, sizeof(loopback.target)) !=
+            (ssize_t)length)
+    {
+        return false;
+    }
+    rtp.markSent();
+    return true;
+}
+
+// 送出失敗：序號已前進，但資料報沒有離開裝置 (不呼叫 markSent)
+static void dropBlock(RtpPacketizer &rtp, uint64_t position)
+{
+    int16_t samples[BLOCK_SAMPLES];
+    uint8_t packet[PACKET_CAPACITY];
+    fillBlock(samples, position);
+    CHECK(rtp.encode(samples, BLOCK_SAMPLES, position, packet, sizeof(packet)) == PACKET_CAPACITY);
+}
+
+static bool receive(Loopback &loopback, Received *out)
+{
+    uint8_t packet[PACKET_CAPACITY + 64];
+    ssize_t length = recv(loopback.receiver, packet, sizeof(packet), 0);
+    if (length <= 0)
+    {
+        return false;
+    }
+
+    size_t offset = RtpWireFormat::readHeader(packet, (size_t)length, &out->header);
+    if (offset == 0 || ((size_t)length - offset) % 2 != 0 || (size_t)length - offset > sizeof(out->samples))
+    {
+        return false;
+    }
+    out->sampleCount = ((size_t)length - offset) / 2;
+    for (size_t i = 0; i < out->sampleCount; i++)
+    {
+        out->samples[i] = (int16_t)(uint16_t)((packet[offset + 2 * i] << 8) | packet[offset + 2 * i + 1]);
+    }
+    return true;
+}
+
+// 傳送一塊並接收，檢查負載與固定欄位
+static bool roundTrip(Loopback &loopback, RtpPacketizer &rtp, uint64_t position, Received *out,
+                      bool *sourceGap = nullptr)
+{
+    if (!sendBlock(loopback, rtp, position, sourceGap) || !receive(loopback, out))
+    {
+        return false;
+    }
+
+    int16_t expected[BLOCK_SAMPLES];
+    fillBlock(expected, position);
+    CHECK(out->sampleCount == BLOCK_SAMPLES);
+    CHECK(memcmp(out->samples, expected, sizeof(expected)) == 0);
+    CHECK(out->header.payloadType == RTP_PAYLOAD_TYPE_L16);
+    CHECK(out->header.ssrc == rtp.getSsrc());
+    return true;
+}
+
+static void testContinuousStream(Loopback &loopback)
+{
+    // 起始序號與時間戳接近上限，前幾個資料報就會迴繞
+    RtpPacketizer rtp;
+    rtp.restart(0x12345678, 0xFFFE, 0xFFFFFF80);
+
+    Received packet;
+    const uint64_t start = 5ULL << 32; // 樣本位置超過 32 位元，時間戳只取低位
+    for (int i = 0; i < 6; i++)
+    {
+        bool sourceGap = true;
+        CHECK(roundTrip(loopback, rtp, start + (uint64_t)i * BLOCK_SAMPLES, &packet, &sourceGap));
+        CHECK(!sourceGap);
+        CHECK(packet.header.marker == (i == 0)); // 只有串流開始帶 M 位元
+        CHECK(packet.header.sequence == (uint16_t)(0xFFFE + i));
+        CHECK(packet.header.timestamp == (uint32_t)(0xFFFFFF80u + (uint32_t)i * BLOCK_SAMPLES));
+    }
+    CHECK(packet.header.ssrc == 0x12345678);
+}
+
+static void testSourceGap(Loopback &loopback)
+{
+    RtpPacketizer rtp;
+    rtp.restart(0xCAFEF00D, 100, 1000);
+
+    Received first, second, third;
+    bool sourceGap = false;
+    CHECK(roundTrip(loopback, rtp, 0, &first, &sourceGap));
+    CHECK(roundTrip(loopback, rtp, BLOCK_SAMPLES, &second, &sourceGap));
+    CHECK(!second.header.marker);
+
+    // 裝置端遺失 3 塊 (塊池用盡)：序號連續，時間戳跳過 3 塊的樣本數，M 位元標記
+    CHECK(roundTrip(loopback, rtp, 5 * BLOCK_SAMPLES, &third, &sourceGap));
+    CHECK(sourceGap);
+    CHECK(third.header.marker);
+    CHECK(third.header.sequence == (uint16_t)(second.header.sequence + 1));
+    CHECK(third.header.timestamp - second.header.timestamp == 4 * BLOCK_SAMPLES);
+
+    // 之後恢復正常
+    Received fourth;
+    CHECK(roundTrip(loopback, rtp, 6 * BLOCK_SAMPLES, &fourth, &sourceGap));
+    CHECK(!sourceGap && !fourth.header.marker);
+    CHECK(fourth.header.timestamp - third.header.timestamp == BLOCK_SAMPLES);
+}
+
+static void testSendFailure(Loopback &loopback)
+{
+    RtpPacketizer rtp;
+    rtp.restart(7, 0, 0);
+
+    // 第一個資料報 (帶 M 位元) 送出失敗：M 位元由下一個資料報帶出，序號缺口讓接收端計為網路遺失
+    dropBlock(rtp, 0);
+    Received first;
+    CHECK(roundTrip(loopback, rtp, BLOCK_SAMPLES, &first));
+    CHECK(first.header.marker);
+    CHECK(first.header.sequence == 1);
+    CHECK(first.header.timestamp == BLOCK_SAMPLES);
+
+    // 一般資料報送出失敗：只留下序號缺口，時間戳照樣本時鐘前進，不標記 M 位元
+    dropBlock(rtp, 2 * BLOCK_SAMPLES);
+    Received second;
+    CHECK(roundTrip(loopback, rtp, 3 * BLOCK_SAMPLES, &second));
+    CHECK(!second.header.marker);
+    CHECK(second.header.sequence == (uint16_t)(first.header.sequence + 2));
+    CHECK(second.header.timestamp - first.header.timestamp == 2 * BLOCK_SAMPLES);
+}
+
+static void testClockRestart(Loopback &loopback)
+{
+    RtpPacketizer rtp;
+    rtp.restart(42, 500, 123456);
+
+    Received before, after, next;
+    CHECK(roundTrip(loopback, rtp, 9000, &before));
+    // 樣本時鐘重新從 0 開始 (擷取重新啟動)：時間戳接續上一塊，M 位元標記
+    bool sourceGap = true;
+    CHECK(roundTrip(loopback, rtp, 0, &after, &sourceGap));
+    CHECK(!sourceGap);
+    CHECK(after.header.marker);
+    CHECK(after.header.sequence == (uint16_t)(before.header.sequence + 1));
+    CHECK(after.header.timestamp - before.header.timestamp == BLOCK_SAMPLES);
+    CHECK(roundTrip(loopback, rtp, BLOCK_SAMPLES, &next));
+    CHECK(!next.header.marker);
+    CHECK(next.header.timestamp - after.header.timestamp == BLOCK_SAMPLES);
+
+    // start() 開始新串流：新的 SSRC、序號與時間戳，M 位元
+    rtp.restart(43, 9, 77);
+    CHECK(roundTrip(loopback, rtp, 2 * BLOCK_SAMPLES, &next));
+    CHECK(next.header.marker);
+    CHECK(next.header.ssrc == 43 && next.header.sequence == 9 && next.header.timestamp == 77);
+}
+
+static void testRejects()
+{
+    int16_t samples[BLOCK_SAMPLES];
+    uint8_t packet[PACKET_CAPACITY + 16];
+    fillBlock(samples, 0);
+    RtpPacketizer rtp;
+    CHECK(rtp.encode(samples, BLOCK_SAMPLES, 0, packet, PACKET_CAPACITY - 1) == 0);
+
+    RtpHeader header = {true, RTP_PAYLOAD_TYPE_L16, 1, 2, 3};
+    size_t length = RtpWireFormat::encodeL16(header, samples, BLOCK_SAMPLES, packet, sizeof(packet));
+    CHECK(length == PACKET_CAPACITY);
+    CHECK(packet[0] == 0x80 && packet[1] == (0x80 | RTP_PAYLOAD_TYPE_L16));
+
+    RtpHeader decoded;
+    CHECK(RtpWireFormat::readHeader(packet, RTP_HEADER_SIZE - 1, &decoded) == 0);
+    packet[0] = 0x40; // 版本 1
+    CHECK(RtpWireFormat::readHeader(packet, length, &decoded) == 0);
+
+    // CSRC 與擴充標頭 (其他傳送端可能使用) 被略過，回傳負載偏移；長度不足則拒絕
+    packet[0] = 0x82; // CC = 2
+    CHECK(RtpWireFormat::readHeader(packet, length, &decoded) == RTP_HEADER_SIZE + 8);
+    CHECK(RtpWireFormat::readHeader(packet, RTP_HEADER_SIZE + 7, &decoded) == 0);
+    packet[0] = 0x91; // X = 1、CC = 1：擴充標頭位於 16 位元組處，長度 2 個字
+    packet[18] = 0;
+    packet[19] = 2;
+    CHECK(RtpWireFormat::readHeader(packet, length, &decoded) == RTP_HEADER_SIZE + 4 + 4 + 8);
+    CHECK(RtpWireFormat::readHeader(packet, RTP_HEADER_SIZE + 4 + 3, &decoded) == 0);
+    CHECK(RtpWireFormat::readHeader(packet, RTP_HEADER_SIZE + 4 + 4 + 7, &decoded) == 0);
+    CHECK(decoded.marker && decoded.sequence == 1 && decoded.timestamp == 2 && decoded.ssrc == 3);
+}
+
+int main()
+{
+    Loopback loopback;
+    if (!loopback.open())
+    {
+        printf("✗ 無法建立 127.0.0.1 的 UDP socket\n");
+        loopback.close();
+        return 1;
+    }
+    printf("回環埠 %u\n", (unsigned)ntohs(loopback.target.sin_port));
+
+    testContinuousStream(loopback);
+    testSourceGap(loopback);
+    testSendFailure(loopback);
+    testClockRestart(loopback);
+    testRejects();
+
+    loopback.close();
+    return hostTestResult("test_rtp_wire_format");
+}
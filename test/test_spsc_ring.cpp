@@ -0,0 +1,302 @@
+// SpscRing 與 AudioBlockPool 的主機端多執行緒壓力測試
+// 1. 兩個執行緒以 SpscRing 傳遞數百萬個序號，消費端必須依序、不重複、不遺漏地收到
+// 2. 仿照 AudioMqttManager 的拓撲：擷取執行緒從池取得塊並放入音訊與特徵兩個環形緩衝區，
+//    發布執行緒以 peek() 批次讀取後一次 release(count)，特徵執行緒逐塊 front()/release()；
+//    檢查每個消費者收到的序號遞增、塊內容在持有期間未被覆寫、結束後所有引用都已歸還
+#include "SpscRing.h"
+#include "AudioBlockPool.h"
+#include "HostTest.h"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+
+#define RING_ITEMS 10000000u
+#define PIPELINE_BLOCKS 2000000u
+#define RING_BLOCKS 16 // 與 AUDIO_RING_BLOCKS / FEATURE_RING_BLOCKS 相同
+#define POOL_BLOCKS (RING_BLOCKS + RING_BLOCKS + 2)
+#define BATCH_MAX 8
+
+static void testRingOrdering()
+{
+    static SpscRing<uint32_t, 64> ring;
+    uint32_t errors = 0;
+
+    std::thread producer([] {
+        for (uint32_t i = 0; i < RING_ITEMS;)
+        {
+            if (i % 3 == 0)
+            {
+                uint32_t *slot = ring.reserve();
+                if (!slot)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                *slot = i++;
+                ring.commit();
+            }
+            else if (ring.push(i))
+            {
+                i++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // 消費端交替使用 pop()、front()/release() 與 peek()/release(count)
+    uint32_t expected = 0;
+    while (expected < RING_ITEMS)
+    {
+        uint32_t available = 0;
+        while (ring.peek(available) && available < 5)
+        {
+            available++;
+        }
+        if (available == 0)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if (expected % 2 == 0)
+        {
+            for (uint32_t i = 0; i < available; i++)
+            {
+                errors += *ring.peek(i) != expected + i;
+            }
+            ring.release(available);
+            expected += available;
+        }
+        else
+        {
+            uint32_t value = 0;
+            ring.pop(value);
+            errors += value != expected;
+            expected++;
+        }
+    }
+    producer.join();
+
+    printf("環形緩衝區: %u 個序號, 順序錯誤 %u, 高水位 %u/%u\n", RING_ITEMS, errors, ring.getHighWaterMark(),
+           ring.capacity());
+    CHECK(errors == 0);
+    CHECK(ring.empty());
+    CHECK(ring.getHighWaterMark() <= ring.capacity());
+}
+
+struct FeatureRef
+{
+    AudioBlock *block;
+};
+
+static AudioBlockPool<POOL_BLOCKS> pool;
+static SpscRing<AudioBlock *, RING_BLOCKS> audioRing;
+static SpscRing<FeatureRef, RING_BLOCKS> featureRing;
+static std::atomic<bool> producerDone(false);
+
+// 塊內容由序號決定，消費者持有期間若被重新取得並覆寫就會不一致
+static void fillBlock(AudioBlock *block, uint32_t sequence)
+{
+    block->sequenceNumber = (uint16_t)sequence;
+    block->dataLength = AUDIO_BLOCK_SAMPLES;
+    block->samplePosition = (uint64_t)sequence * AUDIO_BLOCK_SAMPLES;
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+    {
+        block->audioData[i] = (int16_t)(block->sequenceNumber * 31 + i);
+    }
+}
+
+static bool blockIntact(const AudioBlock *block)
+{
+    if (block->refCount.load(std::memory_order_relaxed) == 0 || block->dataLength != AUDIO_BLOCK_SAMPLES)
+    {
+        return false;
+    }
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i += 37)
+    {
+        if (block->audioData[i] != (int16_t)(block->sequenceNumber * 31 + i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool dropWhenFull(uint32_t sequence)
+{
+    return sequence % 16 == 0;
+}
+
+struct ConsumerResult
+{
+    uint32_t received = 0;
+    uint32_t orderErrors = 0;
+    uint32_t corrupt = 0;
+};
+
+// 以 32 位元展開 16 位元序號後必須嚴格遞增 (允許生產端丟棄造成的缺口)
+static void checkOrder(ConsumerResult &result, uint32_t &last, const AudioBlock *block)
+{
+    uint32_t position = (uint32_t)(block->samplePosition / AUDIO_BLOCK_SAMPLES);
+    if (result.received > 0 && position <= last)
+    {
+        result.orderErrors++;
+    }
+    if ((uint16_t)position != block->sequenceNumber)
+    {
+        result.orderErrors++;
+    }
+    if (!blockIntact(block))
+    {
+        result.corrupt++;
+    }
+    last = position;
+    result.received++;
+}
+
+static void testBlockPipeline()
+{
+    uint32_t audioDrops = 0, featureDrops = 0, poolDrops = 0;
+    ConsumerResult publisher, feature;
+
+    // 發布執行緒：peek() 批次讀取，先釋放塊引用，最後一次歸還槽位 (與 publishAudioStep 相同)
+    std::thread publisherThread([&] {
+        uint32_t last = 0;
+        for (;;)
+        {
+            AudioBlock *batch[BATCH_MAX];
+            uint32_t count = 0;
+            AudioBlock *const *slot;
+            while (count < BATCH_MAX && (slot = audioRing.peek(count)) != nullptr)
+            {
+                batch[count++] = *slot;
+            }
+            if (count == 0)
+            {
+                if (producerDone.load(std::memory_order_acquire) && audioRing.empty())
+                {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            for (uint32_t i = 0; i < count; i++)
+            {
+                checkOrder(publisher, last, batch[i]);
+                pool.release(batch[i]);
+            }
+            audioRing.release(count);
+        }
+    });
+
+    // 特徵執行緒：逐塊 front()/release()
+    std::thread featureThread([&] {
+        uint32_t last = 0;
+        for (;;)
+        {
+            FeatureRef *ref = featureRing.front();
+            if (!ref)
+            {
+                if (producerDone.load(std::memory_order_acquire) && featureRing.empty())
+                {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            checkOrder(feature, last, ref->block);
+            pool.release(ref->block);
+            featureRing.release();
+        }
+    });
+
+    // 擷取執行緒 (本執行緒)：環形緩衝區滿時大多等待消費者，讓數百萬塊都實際經過消費者；
+    // 部分塊與 pushAudioData 的環形緩衝區滿分支 (pushAudioBlock / pushFeatureBlock 的 reserve() 失敗) 相同直接丟棄，涵蓋丟棄路徑
+    for (uint32_t sequence = 0; sequence < PIPELINE_BLOCKS; sequence++)
+    {
+        AudioBlock *block = pool.acquire();
+        if (!block)
+        {
+            poolDrops++;
+            std::this_thread::yield();
+            continue;
+        }
+        fillBlock(block, sequence);
+
+        FeatureRef *featureSlot;
+        while (!(featureSlot = featureRing.reserve()) && !dropWhenFull(sequence))
+        {
+            std::this_thread::yield();
+        }
+        if (featureSlot)
+        {
+            pool.retain(block);
+            featureSlot->block = block;
+            featureRing.commit();
+        }
+        else
+        {
+            featureDrops++;
+        }
+
+        AudioBlock **audioSlot;
+        while (!(audioSlot = audioRing.reserve()) && !dropWhenFull(sequence))
+        {
+            std::this_thread::yield();
+        }
+        if (audioSlot)
+        {
+            pool.retain(block);
+            *audioSlot = block;
+            audioRing.commit();
+        }
+        else
+        {
+            audioDrops++;
+        }
+
+        pool.release(block);
+    }
+    producerDone.store(true, std::memory_order_release);
+    publisherThread.join();
+    featureThread.join();
+
+    uint32_t acquired = PIPELINE_BLOCKS - poolDrops;
+    printf("塊管線: %u 塊, 池用盡 %u, 音訊丟棄 %u, 特徵丟棄 %u\n", PIPELINE_BLOCKS, poolDrops, audioDrops,
+           featureDrops);
+    printf("  發布: 收到 %u, 順序錯誤 %u, 內容被覆寫 %u\n", publisher.received, publisher.orderErrors,
+           publisher.corrupt);
+    printf("  特徵: 收到 %u, 順序錯誤 %u, 內容被覆寫 %u\n", feature.received, feature.orderErrors, feature.corrupt);
+    printf("  池: 使用中 %u, 高水位 %u/%u\n", pool.getInUse(), pool.getHighWaterMark(), pool.capacity());
+
+    CHECK(publisher.orderErrors == 0 && feature.orderErrors == 0);
+    CHECK(publisher.corrupt == 0 && feature.corrupt == 0);
+    CHECK(publisher.received + audioDrops == acquired);
+    CHECK(feature.received + featureDrops == acquired);
+    CHECK(pool.getInUse() == 0);
+    CHECK(pool.getHighWaterMark() <= pool.capacity());
+
+    // 所有塊都必須回到閒置 (引用計數 0)：能一次全部取得，且取得後計數恰為 1
+    AudioBlock *all[POOL_BLOCKS];
+    uint32_t reacquired = 0;
+    while (reacquired < POOL_BLOCKS && (all[reacquired] = pool.acquire()) != nullptr)
+    {
+        CHECK(all[reacquired]->refCount.load() == 1);
+        reacquired++;
+    }
+    CHECK(reacquired == POOL_BLOCKS);
+    for (uint32_t i = 0; i < reacquired; i++)
+    {
+        pool.release(all[i]);
+    }
+    CHECK(pool.getInUse() == 0);
+}
+
+int main()
+{
+    testRingOrdering();
+    testBlockPipeline();
+    return hostTestResult("test_spsc_ring");
+}
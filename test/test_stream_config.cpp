@@ -0,0 +1,361 @@
+// 控制命令解析 (JsonFieldReader) 與串流設定 (StreamConfig) 的主機端測試
+// 格式錯誤與截斷的 JSON、巢狀深度上限、字串跳脫、int32 溢位、
+// configure 命令的驗證 (混合有效與無效欄位時整則拒絕、設定不變)、NVS 讀回值的 validFields 與序列化往返
+#include "StreamConfig.h"
+#include "HostTest.h"
+#include <string.h>
+#include <string>
+
+// 與 AudioMqttManager::configLimits() 相同的數值
+static StreamConfigLimits makeLimits()
+{
+    StreamConfigLimits limits;
+    limits.maxBatchPackets = 8;
+    limits.maxAudioIntervalMs = 200;
+    limits.minHopSamples = 80;
+    limits.maxHopSamples = 400;
+    limits.minFeatureIntervalMs = 10;
+    limits.maxFeatureIntervalMs = 1000;
+    return limits;
+}
+
+static StreamConfig makeDefaults()
+{
+    StreamConfig config;
+    config.audioFormats = AUDIO_OUTPUT_JSON;
+    config.audioCodec = AUDIO_CODEC_PCM16;
+    config.batchPackets = 8;
+    config.audioIntervalMs = 50;
+    config.featureFormats = FEATURE_OUTPUT_JSON;
+    config.featureEncoding = FEATURE_ENCODING_INT16;
+    config.featureSet = FEATURE_SET_ALL;
+    config.hopSamples = 160;
+    config.featureIntervalMs = 100;
+    return config;
+}
+
+static bool parses(const char *json)
+{
+    return JsonFieldReader(json, strlen(json)).ok();
+}
+
+static void testMalformed()
+{
+    const char *valid[] = {
+        "{}",
+        " \t\r\n{ } \n",
+        "{\"command\":\"configure\",\"batchPackets\":4}",
+        "{\"a\":[1,-2.5,3e+2,true,false,null,{\"b\":[]}],\"c\":\"\"}",
+        "{\"s\":\"\\\"\\\\\\/\\b\\f\\n\\r\\t\\u0041\"}",
+    };
+    for (const char *json : valid)
+    {
+        CHECK(parses(json));
+    }
+
+    const char *invalid[] = {
+        "",
+        "   ",
+        "[]",                    // 最上層必須是物件
+        "\"text\"",
+        "{}{}",                  // 結尾多餘內容
+        "{} x",
+        "{\"a\":1,}",            // 結尾逗號
+        "{\"a\":[1,]}",
+        "{\"a\" 1}",             // 缺少冒號
+        "{\"a\":1 \"b\":2}",     // 缺少逗號
+        "{a:1}",                 // 鍵未加引號
+        "{\"a\":01x}",
+        "{\"a\":-}",
+        "{\"a\":1.}",
+        "{\"a\":1e}",
+        "{\"a\":tru}",
+        "{\"a\":nul}",
+        "{\"a\":[1,2}",          // 括號不配對
+        "{\"a\":{\"b\":1]}",
+        "{\"a\":\"x\ny\"}",      // 字串內的控制字元
+        "{\"a\":\"\\x\"}",       // 未定義的跳脫字元
+        "{\"a\":\"\\u00G1\"}",   // \u 後不是 4 位十六進位
+        "{\"a\":\"\\u41\"}",
+    };
+    for (const char *json : invalid)
+    {
+        bool ok = parses(json);
+        if (ok)
+            printf("  誤判為有效: %s\n", json);
+        CHECK(!ok);
+    }
+
+    // 格式錯誤的訊息所有查詢都失敗
+    JsonFieldReader broken("{\"batchPackets\":4,", 18);
+    int32_t number = 0;
+    CHECK(!broken.ok() && !broken.has("batchPackets") && !broken.getInt("batchPackets", &number));
+
+    // 空指標
+    JsonFieldReader none(nullptr, 10);
+    CHECK(!none.ok());
+}
+
+static void testTruncated()
+{
+    // 完整命令的每個前綴都必須被拒絕，且不讀取長度之外的位元組
+    const char *command =
+        "{\"command\":\"configure\",\"audioFormat\":\"both\",\"featureSet\":\"mfcc+stats\","
+        "\"hopSamples\":160,\"extra\":{\"list\":[1,2,{\"x\":\"\\u0041\"}],\"flag\":true}}";
+    size_t full = strlen(command);
+    int accepted = 0;
+    for (size_t length = 0; length < full; length++)
+    {
+        // 複製到剛好 length 大小的堆積緩衝區 (不含結尾 0)，越界讀取會被 ASan / valgrind 發現
+        char *copy = new char[length ? length : 1];
+        memcpy(copy, command, length);
+        accepted += JsonFieldReader(copy, length).ok() ? 1 : 0;
+        delete[] copy;
+    }
+    CHECK(accepted == 0);
+    CHECK(JsonFieldReader(command, full).ok());
+}
+
+static void testDepth()
+{
+    // 最上層物件為深度 0；巢狀容器到 JSON_READER_MAX_DEPTH 層仍有效，再多一層即格式錯誤
+    for (int depth = 1; depth <= JSON_READER_MAX_DEPTH + 2; depth++)
+    {
+        std::string arrays = "{\"a\":" + std::string(depth, '[') + std::string(depth, ']') + ",\"b\":1}";
+        std::string objects = "{";
+        for (int i = 0; i < depth; i++)
+            objects += "\"k\":{";
+        objects += std::string(depth + 1, '}');
+
+        bool expected = depth <= JSON_READER_MAX_DEPTH;
+        JsonFieldReader reader(arrays.data(), arrays.size());
+        CHECK(reader.ok() == expected);
+        CHECK(JsonFieldReader(objects.data(), objects.size()).ok() == expected);
+
+        // 被跳過的巢狀內容不影響後面的最上層成員
+        int32_t b = 0;
+        CHECK(!expected || (reader.getInt("b", &b) && b == 1));
+    }
+}
+
+static void testGetString()
+{
+    const char *json = "{\"plain\":\"abc\",\"escaped\":\"a\\\"b\\\\c\\/d\\te\\nf\",\"unicode\":\"\\u0041\\u007e\","
+                       "\"nul\":\"\\u0000\",\"wide\":\"\\u00e9\",\"number\":12,\"empty\":\"\","
+                       "\"nested\":{\"plain\":\"inner\"}}";
+    JsonFieldReader reader(json, strlen(json));
+    CHECK(reader.ok());
+
+    char text[16];
+    CHECK(reader.getString("plain", text, sizeof(text)) && strcmp(text, "abc") == 0);
+    CHECK(reader.getString("escaped", text, sizeof(text)) && strcmp(text, "a\"b\\c/d\te\nf") == 0);
+    CHECK(reader.getString("unicode", text, sizeof(text)) && strcmp(text, "A~") == 0);
+    CHECK(reader.getString("empty", text, sizeof(text)) && text[0] == '\0');
+
+    // \u0000 會截斷字串，非 ASCII 不支援
+    CHECK(!reader.getString("nul", text, sizeof(text)));
+    CHECK(!reader.getString("wide", text, sizeof(text)));
+
+    // 容量：剛好容納 (含結尾 0) 成功，少一個位元組失敗；跳脫字元以解碼後長度計算
+    CHECK(reader.getString("plain", text, 4));
+    CHECK(!reader.getString("plain", text, 3));
+    CHECK(reader.getString("escaped", text, 12));
+    CHECK(!reader.getString("escaped", text, 11));
+    CHECK(!reader.getString("plain", text, 0));
+
+    // 型別不符、不存在、只查最上層
+    CHECK(!reader.getString("number", text, sizeof(text)));
+    CHECK(!reader.getString("missing", text, sizeof(text)));
+    CHECK(!reader.getString("nested", text, sizeof(text)));
+    CHECK(reader.has("nested") && !reader.has("inner"));
+
+    // 重複的鍵以第一個為準
+    const char *duplicate = "{\"k\":\"first\",\"k\":\"second\"}";
+    JsonFieldReader first(duplicate, strlen(duplicate));
+    CHECK(first.getString("k", text, sizeof(text)) && strcmp(text, "first") == 0);
+}
+
+static void testGetInt()
+{
+    const char *json = "{\"zero\":0,\"negativeZero\":-0,\"max\":2147483647,\"min\":-2147483648,"
+                       "\"overMax\":2147483648,\"underMin\":-2147483649,\"huge\":99999999999999999999999,"
+                       "\"fraction\":1.5,\"exponent\":1e3,\"text\":\"7\",\"flag\":true}";
+    JsonFieldReader reader(json, strlen(json));
+    CHECK(reader.ok());
+
+    int32_t value = 12345;
+    CHECK(reader.getInt("zero", &value) && value == 0);
+    CHECK(reader.getInt("negativeZero", &value) && value == 0);
+    CHECK(reader.getInt("max", &value) && value == INT32_MAX);
+    CHECK(reader.getInt("min", &value) && value == INT32_MIN);
+
+    // 失敗時不修改輸出
+    value = 12345;
+    CHECK(!reader.getInt("overMax", &value));
+    CHECK(!reader.getInt("underMin", &value));
+    CHECK(!reader.getInt("huge", &value));
+    CHECK(!reader.getInt("fraction", &value));
+    CHECK(!reader.getInt("exponent", &value));
+    CHECK(!reader.getInt("text", &value));
+    CHECK(!reader.getInt("flag", &value));
+    CHECK(!reader.getInt("missing", &value));
+    CHECK(value == 12345);
+
+    bool flag = false;
+    CHECK(reader.getBool("flag", &flag) && flag);
+    CHECK(!reader.getBool("zero", &flag));
+}
+
+static int parseConfig(StreamConfig &config, const char *json, const char **invalidField)
+{
+    JsonFieldReader reader(json, strlen(json));
+    CHECK(reader.ok());
+    *invalidField = nullptr;
+    return config.parse(reader, makeLimits(), invalidField);
+}
+
+static void testParse()
+{
+    const StreamConfig defaults = makeDefaults();
+    const char *invalidField = nullptr;
+
+    // 沒有設定欄位：回傳 0，設定不變
+    StreamConfig config = defaults;
+    CHECK(parseConfig(config, "{\"command\":\"configure\"}", &invalidField) == 0);
+    CHECK(config.diff(defaults) == 0);
+
+    // 全部有效：回傳出現的欄位並寫入
+    int fields = parseConfig(config,
+                             "{\"command\":\"configure\",\"audioFormat\":\"both\",\"audioCodec\":\"adpcm\","
+                             "\"batchPackets\":2,\"featureSet\":\"mfcc+stats\",\"hopSamples\":400}",
+                             &invalidField);
+    CHECK(fields == (STREAM_CONFIG_AUDIO_FORMAT | STREAM_CONFIG_AUDIO_CODEC | STREAM_CONFIG_BATCH_PACKETS |
+                     STREAM_CONFIG_FEATURE_SET | STREAM_CONFIG_HOP_SAMPLES));
+    CHECK(config.diff(defaults) == fields);
+    CHECK(config.audioFormats == (AUDIO_OUTPUT_JSON | AUDIO_OUTPUT_BINARY));
+    CHECK(config.audioCodec == AUDIO_CODEC_IMA_ADPCM);
+    CHECK(config.batchPackets == 2);
+    CHECK(config.featureSet == (FEATURE_SET_MFCC | FEATURE_SET_STATS));
+    CHECK(config.hopSamples == 400);
+
+    // 混合有效與無效欄位：整則拒絕，指出第一個無效欄位，先出現的有效欄位也不寫入
+    struct Rejected
+    {
+        const char *json;
+        const char *field;
+    };
+    const Rejected rejected[] = {
+        {"{\"batchPackets\":4,\"hopSamples\":401}", "hopSamples"},
+        {"{\"audioFormat\":\"json\",\"audioCodec\":\"mp3\"}", "audioCodec"},
+        {"{\"featureFormat\":\"frame\",\"batchPackets\":0}", "batchPackets"},
+        {"{\"featureFormat\":\"frame\",\"batchPackets\":9}", "batchPackets"},
+        {"{\"featureFormat\":\"frame\",\"batchPackets\":257}", "batchPackets"}, // 不可被 uint8_t 截斷成 1
+        {"{\"audioIntervalMs\":10,\"featureIntervalMs\":65546}", "featureIntervalMs"}, // 不可被 uint16_t 截斷成 10
+        {"{\"audioIntervalMs\":-1}", "audioIntervalMs"},
+        {"{\"audioIntervalMs\":201}", "audioIntervalMs"},
+        {"{\"hopSamples\":79}", "hopSamples"},
+        {"{\"featureIntervalMs\":9}", "featureIntervalMs"},
+        {"{\"featureIntervalMs\":1001}", "featureIntervalMs"},
+        {"{\"hopSamples\":160.5}", "hopSamples"},
+        {"{\"hopSamples\":\"160\"}", "hopSamples"},
+        {"{\"hopSamples\":4294967456}", "hopSamples"},
+        {"{\"audioFormat\":1}", "audioFormat"},
+        {"{\"featureEncoding\":\"float32\"}", "featureEncoding"},
+        {"{\"featureSet\":\"\"}", "featureSet"},
+        {"{\"featureSet\":\"mfcc+\"}", "featureSet"},
+        {"{\"featureSet\":\"+mfcc\"}", "featureSet"},
+        {"{\"featureSet\":\"mfcc+pitch\"}", "featureSet"},
+        {"{\"featureSet\":\"mfcc+stats+mel+mfcc+stats+mel\"}", "featureSet"}, // 超過 STREAM_CONFIG_NAME_MAX
+    };
+    for (const Rejected &entry : rejected)
+    {
+        config = defaults;
+        int result = parseConfig(config, entry.json, &invalidField);
+        bool ok = result == -1 && invalidField && strcmp(invalidField, entry.field) == 0 &&
+                  config.diff(defaults) == 0;
+        if (!ok)
+            printf("  未正確拒絕: %s (回傳 %d, 欄位 %s)\n", entry.json, result, invalidField ? invalidField : "-");
+        CHECK(ok);
+    }
+
+    // 重複的 + 段落合併 (mfcc+mfcc = mfcc)
+    config = defaults;
+    CHECK(parseConfig(config, "{\"featureSet\":\"mel+mel\"}", &invalidField) == STREAM_CONFIG_FEATURE_SET);
+    CHECK(config.featureSet == FEATURE_SET_MEL);
+}
+
+static void testValidFields()
+{
+    // NVS 讀回的值逐欄位檢查，無效的欄位不在遮罩中 (由呼叫端改用預設值)
+    const StreamConfigLimits limits = makeLimits();
+    StreamConfig stored = makeDefaults();
+    CHECK(stored.validFields(STREAM_CONFIG_ALL, limits) == STREAM_CONFIG_ALL);
+
+    stored.audioFormats = 0;
+    stored.audioCodec = 7;
+    stored.batchPackets = 9;
+    stored.featureSet = 0x08;
+    stored.hopSamples = 401;
+    uint16_t invalid = STREAM_CONFIG_AUDIO_FORMAT | STREAM_CONFIG_AUDIO_CODEC | STREAM_CONFIG_BATCH_PACKETS |
+                       STREAM_CONFIG_FEATURE_SET | STREAM_CONFIG_HOP_SAMPLES;
+    CHECK(stored.validFields(STREAM_CONFIG_ALL, limits) == (STREAM_CONFIG_ALL & ~invalid));
+    CHECK(stored.validFields(invalid, limits) == 0);
+
+    // 只檢查要求的欄位
+    CHECK(stored.validFields(STREAM_CONFIG_FEATURE_INTERVAL, limits) == STREAM_CONFIG_FEATURE_INTERVAL);
+
+    // merge 只複製指定欄位
+    StreamConfig merged = makeDefaults();
+    merged.merge(stored, STREAM_CONFIG_ALL & ~invalid);
+    CHECK(merged.diff(makeDefaults()) == 0);
+    merged.merge(stored, STREAM_CONFIG_HOP_SAMPLES);
+    CHECK(merged.diff(makeDefaults()) == STREAM_CONFIG_HOP_SAMPLES);
+}
+
+static void testRoundTrip()
+{
+    // writeJson 的輸出 (狀態與確認訊息) 可以原樣作為 configure 命令
+    StreamConfig source = makeDefaults();
+    source.audioFormats = AUDIO_OUTPUT_BINARY;
+    source.audioCodec = AUDIO_CODEC_IMA_ADPCM;
+    source.batchPackets = 3;
+    source.audioIntervalMs = 0;
+    source.featureFormats = FEATURE_OUTPUT_JSON | FEATURE_OUTPUT_FRAME;
+    source.featureEncoding = FEATURE_ENCODING_FLOAT16;
+    source.featureSet = FEATURE_SET_MEL | FEATURE_SET_STATS;
+    source.hopSamples = 80;
+    source.featureIntervalMs = 1000;
+
+    char buffer[512];
+    JsonFrameWriter json(buffer, sizeof(buffer));
+    json.beginObject();
+    source.writeJson(json);
+    json.endObject();
+    CHECK(json.ok());
+
+    JsonFieldReader reader(json.data(), json.size());
+    CHECK(reader.ok());
+    StreamConfig parsed = makeDefaults();
+    const char *invalidField = nullptr;
+    CHECK(parsed.parse(reader, makeLimits(), &invalidField) == STREAM_CONFIG_ALL);
+    CHECK(parsed.diff(source) == 0);
+
+    for (int i = 0; i < STREAM_CONFIG_FIELD_COUNT; i++)
+    {
+        CHECK(reader.has(StreamConfig::fieldName(1 << i)));
+    }
+    CHECK(strcmp(StreamConfig::fieldName(0x0003), "unknown") == 0);
+}
+
+int main()
+{
+    testMalformed();
+    testTruncated();
+    testDepth();
+    testGetString();
+    testGetInt();
+    testParse();
+    testValidFields();
+    testRoundTrip();
+    return hostTestResult("test_stream_config");
+}
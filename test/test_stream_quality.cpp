@@ -0,0 +1,325 @@
+// 串流品質控制器 (StreamQualityController) 的主機端模擬測試
+// 以 1 ms 步進模擬擷取 → 環形緩衝區 → 限速傳輸，依目前層級決定每包大小，驗證：
+// 壅塞時逐級降級、降級後的觀察視窗、滯後區間不動作、升級後立即壅塞時 recoverWindows 加倍 (上限)、
+// 長期穩定後減半回到基準、lowestTier 限制與 forceTier
+#include "StreamQualityController.h"
+#include "HostTest.h"
+#include <stdio.h>
+#include <vector>
+
+#define RING_CAPACITY 16      // 與 AUDIO_RING_BLOCKS 相同
+#define PACKET_INTERVAL_US 16000 // 16 kHz、每包 256 樣本
+
+// 各層級每包在傳輸上的位元組數 (含主題與標頭的估計值)
+static const uint32_t TIER_PACKET_BYTES[STREAM_TIER_COUNT] = {
+    1100, // raw：JSON/Base64 與二進位 PCM
+    180,  // adpcm：28 位元組標頭 + 4 位元組狀態 + 128 位元組
+    110,  // adpcm8k：取樣率減半
+    60,   // features：平均到每包的特徵訊息
+};
+
+struct Simulation
+{
+    StreamQualityController controller;
+    std::vector<uint64_t> ring; // 每包的入列時間 (µs)
+    uint64_t nowUs = 0;
+    uint64_t nextPacketUs = 0;
+    double creditBytes = 0;
+    uint32_t drops = 0;
+    uint32_t downgrades = 0;
+    uint32_t upgrades = 0;
+    uint32_t lastChangeMs = 0;
+    uint32_t minDowngradeGapMs = UINT32_MAX;
+    uint8_t lowestSeen = STREAM_TIER_RAW;
+
+    Simulation() { controller.reset(0); }
+
+    // 以 bytesPerSecond 的鏈路執行 seconds 秒
+    void run(double seconds, double bytesPerSecond)
+    {
+        uint64_t end = nowUs + (uint64_t)(seconds * 1e6);
+        for (; nowUs < end; nowUs += 1000)
+        {
+            if (nowUs >= nextPacketUs)
+            {
+                nextPacketUs += PACKET_INTERVAL_US;
+                if (ring.size() < RING_CAPACITY)
+                {
+                    ring.push_back(nowUs);
+                }
+                else
+                {
+                    drops++;
+                }
+            }
+
+            // 鏈路每 ms 取得固定額度，閒置時最多累積 4 KB
+            creditBytes += bytesPerSecond / 1000.0;
+            if (creditBytes > 4096)
+            {
+                creditBytes = 4096;
+            }
+            controller.observeQueue(ring.size(), RING_CAPACITY);
+            uint32_t size = TIER_PACKET_BYTES[controller.getTier()];
+            while (!ring.empty() && creditBytes >= size)
+            {
+                creditBytes -= size;
+                controller.recordPublish((uint32_t)(nowUs - ring.front()), true);
+                ring.erase(ring.begin());
+            }
+
+            uint8_t before = controller.getTier();
+            uint32_t nowMs = (uint32_t)(nowUs / 1000);
+            if (controller.update(nowMs, drops))
+            {
+                if (controller.getTier() > before)
+                {
+                    downgrades++;
+                    if (downgrades > 1 && nowMs - lastChangeMs < minDowngradeGapMs)
+                    {
+                        minDowngradeGapMs = nowMs - lastChangeMs;
+                    }
+                }
+                else
+                {
+                    upgrades++;
+                }
+                lastChangeMs = nowMs;
+                if (controller.getTier() > lowestSeen)
+                {
+                    lowestSeen = controller.getTier();
+                }
+            }
+        }
+    }
+};
+
+#define FAST_LINK 100000.0 // 足夠原始格式 (約 69 KB/s)
+#define SLOW_LINK 20000.0  // 只夠 ADPCM (約 11 KB/s)
+
+// 穩定的快鏈路：一直維持原始格式
+static void testStableLink()
+{
+    Simulation sim;
+    sim.run(60, FAST_LINK);
+    printf("快鏈路 60 s: 層級 %s, 切換 %u 次, 丟包 %u\n", StreamQualityController::tierName(sim.controller.getTier()),
+           sim.controller.getTierChanges(), sim.drops);
+    CHECK(sim.controller.getTier() == STREAM_TIER_RAW);
+    CHECK(sim.controller.getTierChanges() == 0);
+    CHECK(sim.drops == 0);
+}
+
+// 鏈路變慢：降到剛好能承載的層級 (觀察視窗讓積壓排空，不連降兩級)；
+// 在 ADPCM 健康 recoverWindows 個視窗後試探升級，原始格式隨即壅塞退回，要求加倍；鏈路恢復後升回
+static void testSlowdownAndRecovery()
+{
+    Simulation sim;
+    sim.run(5, FAST_LINK);
+    sim.run(4, SLOW_LINK);
+    printf("慢鏈路 4 s: 層級 %s, 降級 %u 次, 原因 0x%02x\n", StreamQualityController::tierName(sim.controller.getTier()),
+           sim.downgrades, sim.controller.getLastReason());
+    CHECK(sim.controller.getTier() == STREAM_TIER_ADPCM);
+    CHECK(sim.downgrades == 1);
+    CHECK(sim.controller.getLastReason() & StreamQualityController::REASON_QUEUE_DEPTH);
+
+    sim.run(10, SLOW_LINK);
+    printf("  慢鏈路再 10 s: 層級 %s, 升級 %u 次, 降級 %u 次, recoverWindows %u, 最低 %s\n",
+           StreamQualityController::tierName(sim.controller.getTier()), sim.upgrades, sim.downgrades,
+           sim.controller.getRecoverWindows(), StreamQualityController::tierName(sim.lowestSeen));
+    CHECK(sim.upgrades == 1);
+    CHECK(sim.downgrades == 2);
+    CHECK(sim.controller.getTier() == STREAM_TIER_ADPCM);
+    CHECK(sim.controller.getRecoverWindows() == 2 * STREAM_QUALITY_RECOVER_WINDOWS);
+    CHECK(sim.lowestSeen == STREAM_TIER_ADPCM);
+
+    // 鏈路恢復：等待加倍後的 recoverWindows 個健康視窗 (加上排空積壓的視窗) 升回原始格式
+    sim.run(2 * STREAM_QUALITY_RECOVER_WINDOWS + 3, FAST_LINK);
+    printf("  快鏈路恢復: 層級 %s, 升級 %u 次\n", StreamQualityController::tierName(sim.controller.getTier()),
+           sim.upgrades);
+    CHECK(sim.controller.getTier() == STREAM_TIER_RAW);
+    CHECK(sim.upgrades == 2);
+    CHECK(sim.controller.getLastReason() == StreamQualityController::REASON_RECOVERED);
+}
+
+// 升級後總是立即壅塞：recoverWindows 5 → 10 → 20 → 40 → 60 (上限)
+// 之後鏈路恢復並升級，每 STREAM_QUALITY_STABLE_WINDOWS 個無壅塞視窗減半，回到基準
+static void testRecoverWindowsDoublingAndHalving()
+{
+    Simulation sim;
+    sim.run(3, FAST_LINK);
+    std::vector<uint32_t> progression;
+    uint32_t last = sim.controller.getRecoverWindows();
+    progression.push_back(last);
+    for (int second = 0; second < 300; second++)
+    {
+        sim.run(1, SLOW_LINK);
+        if (sim.controller.getRecoverWindows() != last)
+        {
+            last = sim.controller.getRecoverWindows();
+            progression.push_back(last);
+        }
+    }
+    printf("反覆試探升級 300 s: recoverWindows");
+    for (uint32_t value : progression)
+    {
+        printf(" %u", value);
+    }
+    printf(", 最低層級 %s\n", StreamQualityController::tierName(sim.lowestSeen));
+
+    const uint32_t expected[] = {5, 10, 20, 40, 60};
+    CHECK(progression.size() == sizeof(expected) / sizeof(expected[0]));
+    for (size_t i = 0; i < progression.size() && i < 5; i++)
+    {
+        CHECK(progression[i] == expected[i]);
+    }
+    CHECK(sim.lowestSeen == STREAM_TIER_ADPCM);
+
+    // 對齊到下一次試探失敗後的降級，健康計數從 0 開始
+    uint32_t downgrades = sim.downgrades;
+    for (int second = 0; second < 2 * STREAM_QUALITY_RECOVER_WINDOWS_MAX && sim.downgrades == downgrades; second++)
+    {
+        sim.run(1, SLOW_LINK);
+    }
+    CHECK(sim.downgrades == downgrades + 1);
+
+    // 降級等待期間不放寬要求：鏈路恢復後仍需上限個健康視窗才升級
+    int elapsed = 0;
+    while (sim.controller.getTier() != STREAM_TIER_RAW && elapsed < 2 * STREAM_QUALITY_RECOVER_WINDOWS_MAX)
+    {
+        sim.run(1, FAST_LINK);
+        elapsed++;
+    }
+    printf("  鏈路恢復後 %d s 升級\n", elapsed);
+    CHECK(sim.controller.getTier() == STREAM_TIER_RAW);
+    CHECK(elapsed >= STREAM_QUALITY_RECOVER_WINDOWS_MAX);
+    CHECK(elapsed <= STREAM_QUALITY_RECOVER_WINDOWS_MAX + STREAM_QUALITY_SETTLE_WINDOWS + 2);
+
+    // 升級後每 STREAM_QUALITY_STABLE_WINDOWS 個無壅塞視窗減半：60 → 30 → 15 → 7 → 基準 5
+    sim.run(STREAM_QUALITY_STABLE_WINDOWS - 2, FAST_LINK);
+    CHECK(sim.controller.getRecoverWindows() == STREAM_QUALITY_RECOVER_WINDOWS_MAX);
+    sim.run(2, FAST_LINK);
+    printf("  升級後 %d s: recoverWindows %u\n", STREAM_QUALITY_STABLE_WINDOWS, sim.controller.getRecoverWindows());
+    CHECK(sim.controller.getRecoverWindows() == STREAM_QUALITY_RECOVER_WINDOWS_MAX / 2);
+    sim.run(3 * STREAM_QUALITY_STABLE_WINDOWS, FAST_LINK);
+    printf("  再 %d s: recoverWindows %u\n", 3 * STREAM_QUALITY_STABLE_WINDOWS, sim.controller.getRecoverWindows());
+    CHECK(sim.controller.getRecoverWindows() == STREAM_QUALITY_RECOVER_WINDOWS);
+}
+
+// 直接餵入視窗觀測值 (不經過模擬)
+struct WindowFeeder
+{
+    StreamQualityController controller;
+    uint32_t nowMs = 0;
+    uint32_t dropTotal = 0;
+
+    WindowFeeder() { controller.reset(0); }
+
+    bool feed(uint32_t depthPercent, uint32_t latencyMs, uint32_t drops = 0)
+    {
+        dropTotal += drops;
+        controller.observeQueue(depthPercent, 100);
+        controller.recordPublish(latencyMs * 1000, true);
+        nowMs += STREAM_QUALITY_WINDOW_MS;
+        return controller.update(nowMs, dropTotal);
+    }
+};
+
+// 降級後的第一個視窗只觀察：連續壅塞時每兩個視窗降一級
+static void testSettleWindows()
+{
+    WindowFeeder feeder;
+    StreamQualityController &controller = feeder.controller;
+
+    CHECK(feeder.feed(100, 400));
+    CHECK(controller.getTier() == STREAM_TIER_ADPCM);
+    CHECK(controller.getLastReason() == (StreamQualityController::REASON_QUEUE_DEPTH |
+                                         StreamQualityController::REASON_LATENCY));
+    for (int i = 0; i < STREAM_QUALITY_SETTLE_WINDOWS; i++)
+    {
+        CHECK(!feeder.feed(100, 400));
+        CHECK(controller.getTier() == STREAM_TIER_ADPCM);
+    }
+    CHECK(feeder.feed(0, 0, 3)); // 只有丟包也算壅塞
+    CHECK(controller.getTier() == STREAM_TIER_ADPCM_8K);
+    CHECK(controller.getLastReason() == StreamQualityController::REASON_DROPS);
+
+    // 升級沒有觀察視窗：升級後下一個視窗壅塞即退回
+    controller.forceTier(STREAM_TIER_ADPCM);
+    CHECK(controller.getLastReason() == StreamQualityController::REASON_MANUAL);
+    CHECK(feeder.feed(90, 0));
+    CHECK(controller.getTier() == STREAM_TIER_ADPCM_8K);
+
+    // 視窗未結束時不評估
+    CHECK(!controller.update(feeder.nowMs + STREAM_QUALITY_WINDOW_MS - 1, 1000));
+}
+
+// 介於高低門檻之間的視窗既不降級也不計入健康視窗
+static void testHysteresis()
+{
+    WindowFeeder feeder;
+    StreamQualityController &controller = feeder.controller;
+    controller.forceTier(STREAM_TIER_ADPCM);
+    feeder.feed(0, 0); // 手動切換到較低層級同樣有觀察視窗
+
+    for (int i = 0; i < 3 * STREAM_QUALITY_RECOVER_WINDOWS; i++)
+    {
+        CHECK(!feeder.feed(50, 150)); // 深度 50%、延遲 150 ms
+    }
+    CHECK(controller.getTier() == STREAM_TIER_ADPCM);
+
+    // 中間夾一個不健康的視窗：健康計數重新開始
+    for (int i = 0; i < STREAM_QUALITY_RECOVER_WINDOWS - 1; i++)
+    {
+        CHECK(!feeder.feed(10, 20));
+    }
+    CHECK(!feeder.feed(50, 20));
+    for (int i = 0; i < STREAM_QUALITY_RECOVER_WINDOWS - 1; i++)
+    {
+        CHECK(!feeder.feed(10, 20));
+    }
+    CHECK(feeder.feed(10, 20));
+    CHECK(controller.getTier() == STREAM_TIER_RAW);
+    CHECK(controller.getLastReason() == StreamQualityController::REASON_RECOVERED);
+}
+
+// lowestTier 限制：完全斷流也不低於限制；收緊限制時立即拉回
+static void testLowestTierClamp()
+{
+    Simulation sim;
+    sim.controller.setLowestTier(STREAM_TIER_ADPCM_8K);
+    sim.run(30, 0);
+    printf("斷流 30 s (最低 adpcm8k): 層級 %s\n", StreamQualityController::tierName(sim.controller.getTier()));
+    CHECK(sim.controller.getTier() == STREAM_TIER_ADPCM_8K);
+    CHECK(sim.lowestSeen == STREAM_TIER_ADPCM_8K);
+    CHECK(sim.minDowngradeGapMs >= (1 + STREAM_QUALITY_SETTLE_WINDOWS) * STREAM_QUALITY_WINDOW_MS);
+
+    sim.controller.setLowestTier(STREAM_TIER_ADPCM);
+    CHECK(sim.controller.getTier() == STREAM_TIER_ADPCM);
+    CHECK(sim.controller.getLastReason() == StreamQualityController::REASON_MANUAL);
+
+    sim.controller.setLowestTier(STREAM_TIER_COUNT); // 無效值視為不限制
+    sim.run(30, 0);
+    CHECK(sim.controller.getTier() == STREAM_TIER_FEATURES_ONLY);
+
+    CHECK(!sim.controller.forceTier(STREAM_TIER_COUNT));
+    CHECK(!sim.controller.forceTier(STREAM_TIER_FEATURES_ONLY));
+    CHECK(sim.controller.forceTier(STREAM_TIER_RAW));
+
+    // 停用時停在目前層級
+    sim.controller.setEnabled(false);
+    uint32_t changes = sim.controller.getTierChanges();
+    sim.run(10, 0);
+    CHECK(sim.controller.getTier() == STREAM_TIER_RAW);
+    CHECK(sim.controller.getTierChanges() == changes);
+}
+
+int main()
+{
+    testStableLink();
+    testSlowdownAndRecovery();
+    testRecoverWindowsDoublingAndHalving();
+    testSettleWindows();
+    testHysteresis();
+    testLowestTierClamp();
+    return hostTestResult("test_stream_quality");
+}
@@ -0,0 +1,322 @@
+// WebSocket 串流核心 (WebSocketStreamCore) 的主機端測試
+// 訂閱路徑解析、每客戶端隊列丟棄最舊訊息、dropped / highWater / sent 統計、
+// 丟棄後同類第一則存活訊息的 GAP 旗標、樣本位置跳躍的 GAP 與 ADPCM 的 RESYNC、生產端與傳輸端並行
+#include "WebSocketStreamCore.h"
+#include "HostTest.h"
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+#define PACKET_SAMPLES 256
+#define SAMPLE_RATE 16000
+#define CONCURRENT_PACKETS 200000u
+
+static int16_t samples[PACKET_SAMPLES];
+
+static void pushPacket(WebSocketStreamCore &core, uint32_t index)
+{
+    for (int i = 0; i < PACKET_SAMPLES; i++)
+    {
+        samples[i] = (int16_t)(index * 7 + i);
+    }
+    core.pushAudio(samples, PACKET_SAMPLES, (uint16_t)index, (uint64_t)index * PACKET_SAMPLES, 0, SAMPLE_RATE);
+}
+
+static size_t makeFeatureMessage(uint16_t sequence, uint8_t *out, size_t capacity)
+{
+    FeatureWireHeader header;
+    FeatureWireFormat::initHeader(header, FEATURE_ENCODING_INT16, 0, 0, 160, SAMPLE_RATE);
+    header.frameCount = 0;
+    header.sequence = sequence;
+    header.samplePosition = (uint64_t)sequence * 160;
+    header.epochMicros = 0;
+    return FeatureWireFormat::writeHeader(header, out, capacity);
+}
+
+// 取出一則訊息並解析；音訊回傳 AUDIO_WIRE_MAGIC，特徵回傳 FEATURE_WIRE_MAGIC，沒有訊息回傳 0
+struct Popped
+{
+    uint8_t magic;
+    uint8_t flags;
+    uint16_t sequence;
+    uint64_t samplePosition;
+    uint8_t codec;
+    bool samplesIntact;
+};
+
+static Popped popMessage(WebSocketStreamCore &core, uint8_t id)
+{
+    static uint8_t buffer[WS_STREAM_SLOT_BYTES];
+    Popped result;
+    memset(&result, 0, sizeof(result));
+    size_t length = core.pop(id, buffer, sizeof(buffer));
+    if (length == 0)
+    {
+        return result;
+    }
+
+    result.magic = buffer[0];
+    if (result.magic == AUDIO_WIRE_MAGIC)
+    {
+        AudioWireHeader header;
+        CHECK(AudioWireFormat::readHeader(buffer, length, &header));
+        result.flags = header.flags;
+        result.sequence = header.sequence;
+        result.samplePosition = header.samplePosition;
+        result.codec = header.codec;
+        if (header.codec == AUDIO_CODEC_PCM16)
+        {
+            int16_t decoded[PACKET_SAMPLES];
+            result.samplesIntact = AudioWireFormat::decodePcm(buffer, length, decoded, PACKET_SAMPLES) == PACKET_SAMPLES;
+            for (int i = 0; result.samplesIntact && i < PACKET_SAMPLES; i++)
+            {
+                result.samplesIntact = decoded[i] == (int16_t)(header.sequence * 7 + i);
+            }
+        }
+    }
+    else if (result.magic == FEATURE_WIRE_MAGIC)
+    {
+        FeatureWireHeader header;
+        CHECK(FeatureWireFormat::readHeader(buffer, length, &header));
+        result.flags = header.flags;
+        result.sequence = header.sequence;
+        result.samplePosition = header.samplePosition;
+    }
+    return result;
+}
+
+static void testParseSubscriptions()
+{
+    CHECK(WebSocketStreamCore::parseSubscriptions(nullptr) == WS_SUBSCRIBE_DEFAULT);
+    CHECK(WebSocketStreamCore::parseSubscriptions("") == WS_SUBSCRIBE_DEFAULT);
+    CHECK(WebSocketStreamCore::parseSubscriptions("/") == WS_SUBSCRIBE_DEFAULT);
+    CHECK(WebSocketStreamCore::parseSubscriptions("/pcm") == WS_SUBSCRIBE_PCM);
+    CHECK(WebSocketStreamCore::parseSubscriptions("/adpcm") == WS_SUBSCRIBE_ADPCM);
+    CHECK(WebSocketStreamCore::parseSubscriptions("/features") == WS_SUBSCRIBE_FEATURES);
+    CHECK(WebSocketStreamCore::parseSubscriptions("/adpcm+features") == (WS_SUBSCRIBE_ADPCM | WS_SUBSCRIBE_FEATURES));
+    CHECK(WebSocketStreamCore::parseSubscriptions("/pcm+adpcm+features") ==
+          (WS_SUBSCRIBE_PCM | WS_SUBSCRIBE_ADPCM | WS_SUBSCRIBE_FEATURES));
+
+    // 名稱必須完整相符 (大小寫敏感)；未知名稱略過，全部未知時使用預設
+    CHECK(WebSocketStreamCore::parseSubscriptions("/pcmx") == WS_SUBSCRIBE_DEFAULT);
+    CHECK(WebSocketStreamCore::parseSubscriptions("/PCM") == WS_SUBSCRIBE_DEFAULT);
+    CHECK(WebSocketStreamCore::parseSubscriptions("/foo+adpcm") == WS_SUBSCRIBE_ADPCM);
+    CHECK(WebSocketStreamCore::parseSubscriptions("/features?x=pcm") == (WS_SUBSCRIBE_FEATURES | WS_SUBSCRIBE_PCM));
+    CHECK(WebSocketStreamCore::parseSubscriptions("//adpcm//") == WS_SUBSCRIBE_ADPCM);
+}
+
+static void testClients()
+{
+    static WebSocketStreamCore core;
+    CHECK(!core.wantsAudio() && !core.wantsFeatures());
+    CHECK(!core.addClient(WS_STREAM_MAX_CLIENTS, WS_SUBSCRIBE_PCM));
+
+    // 沒有客戶端時推入不留下任何訊息
+    pushPacket(core, 0);
+    CHECK(core.getQueueDepth(0) == 0);
+
+    CHECK(core.addClient(0, WS_SUBSCRIBE_FEATURES));
+    CHECK(!core.wantsAudio() && core.wantsFeatures());
+    CHECK(core.addClient(2, WS_SUBSCRIBE_ADPCM));
+    CHECK(core.wantsAudio());
+    CHECK(core.getClientCount() == 2);
+
+    // 只放入有訂閱的客戶端
+    pushPacket(core, 1);
+    CHECK(core.getQueueDepth(0) == 0);
+    CHECK(core.getQueueDepth(2) == 1);
+
+    // 輸出緩衝區不足時不取出
+    uint8_t small[16];
+    CHECK(core.pop(2, small, sizeof(small)) == 0);
+    CHECK(core.getQueueDepth(2) == 1);
+    CHECK(core.pop(1, small, sizeof(small)) == 0); // 未連線
+
+    // 斷線清空隊列；重新連線時統計歸零
+    core.removeClient(2);
+    CHECK(core.getClientCount() == 1);
+    CHECK(!core.wantsAudio());
+    CHECK(core.getQueueDepth(2) == 0);
+    CHECK(core.addClient(2, WS_SUBSCRIBE_PCM));
+    CHECK(core.getClientStats(2).highWater == 0 && core.getClientStats(2).dropped == 0);
+    core.removeClient(0);
+    core.removeClient(2);
+}
+
+// 快客戶端逐則取出，慢客戶端從不取出：慢客戶端只丟自己的訊息，留下最新的 WS_STREAM_QUEUE_DEPTH 則
+static void testDropOldestPerClient()
+{
+    static WebSocketStreamCore core;
+    core.addClient(0, WS_SUBSCRIBE_PCM);
+    core.addClient(1, WS_SUBSCRIBE_PCM);
+
+    const uint32_t total = WS_STREAM_QUEUE_DEPTH + 24;
+    uint32_t fastErrors = 0;
+    for (uint32_t i = 0; i < total; i++)
+    {
+        pushPacket(core, i);
+        Popped fast = popMessage(core, 0);
+        fastErrors += fast.magic != AUDIO_WIRE_MAGIC || fast.sequence != i || fast.flags != 0 || !fast.samplesIntact;
+    }
+    CHECK(fastErrors == 0);
+
+    WebSocketStreamCore::ClientStats fast = core.getClientStats(0);
+    WebSocketStreamCore::ClientStats slow = core.getClientStats(1);
+    printf("快客戶端: 送出 %u, 丟棄 %u, 高水位 %u; 慢客戶端: 丟棄 %u, 高水位 %u, 深度 %u\n", fast.sent, fast.dropped,
+           fast.highWater, slow.dropped, slow.highWater, core.getQueueDepth(1));
+    CHECK(fast.sent == total && fast.dropped == 0 && fast.highWater == 1);
+    CHECK(slow.sent == 0 && slow.dropped == total - WS_STREAM_QUEUE_DEPTH);
+    CHECK(slow.highWater == WS_STREAM_QUEUE_DEPTH);
+    CHECK(core.getQueueDepth(1) == WS_STREAM_QUEUE_DEPTH);
+
+    // 慢客戶端依序收到最新的訊息；只有第一則 (緊接在被丟棄的訊息之後) 帶 GAP，不帶 RESYNC
+    uint32_t first = total - WS_STREAM_QUEUE_DEPTH;
+    uint32_t errors = 0;
+    for (uint32_t i = first; i < total; i++)
+    {
+        Popped message = popMessage(core, 1);
+        errors += message.sequence != i || !message.samplesIntact;
+        errors += message.flags != (i == first ? AUDIO_WIRE_FLAG_GAP : 0);
+    }
+    CHECK(errors == 0);
+    CHECK(popMessage(core, 1).magic == 0);
+    CHECK(core.getClientStats(1).sent == WS_STREAM_QUEUE_DEPTH);
+
+    // 取出後不再丟棄：下一則沒有旗標
+    pushPacket(core, total);
+    CHECK(popMessage(core, 1).flags == 0);
+}
+
+// 音訊與特徵交錯：丟棄音訊時標記下一則音訊，不影響特徵；丟棄特徵時標記下一則特徵
+static void testGapMarksFirstSurvivorOfDroppedKind()
+{
+    static WebSocketStreamCore core;
+    core.addClient(3, WS_SUBSCRIBE_PCM | WS_SUBSCRIBE_FEATURES);
+    uint8_t feature[WS_STREAM_SLOT_BYTES];
+
+    // A0 F0 A1 F1 ... A7 F7 (16 則，隊列全滿)
+    for (uint16_t i = 0; i < WS_STREAM_QUEUE_DEPTH / 2; i++)
+    {
+        pushPacket(core, i);
+        core.pushFeatures(feature, makeFeatureMessage(i, feature, sizeof(feature)));
+    }
+    pushPacket(core, WS_STREAM_QUEUE_DEPTH / 2); // 丟棄 A0 → A1 標記 GAP
+    core.pushFeatures(feature, makeFeatureMessage(WS_STREAM_QUEUE_DEPTH / 2, feature, sizeof(feature))); // 丟棄 F0 → F1
+    CHECK(core.getClientStats(3).dropped == 2);
+
+    uint32_t errors = 0;
+    for (uint16_t i = 1; i <= WS_STREAM_QUEUE_DEPTH / 2; i++)
+    {
+        Popped audio = popMessage(core, 3);
+        Popped features = popMessage(core, 3);
+        errors += audio.magic != AUDIO_WIRE_MAGIC || audio.sequence != i;
+        errors += audio.flags != (i == 1 ? AUDIO_WIRE_FLAG_GAP : 0);
+        errors += features.magic != FEATURE_WIRE_MAGIC || features.sequence != i;
+        errors += features.flags != (i == 1 ? FEATURE_WIRE_FLAG_GAP : 0);
+    }
+    CHECK(errors == 0);
+
+    // 放入的種類與被丟棄的不同：標記同種類的下一則 (F101)，而不是剛放入的音訊
+    for (uint16_t i = 0; i < WS_STREAM_QUEUE_DEPTH; i++)
+    {
+        core.pushFeatures(feature, makeFeatureMessage(100 + i, feature, sizeof(feature)));
+    }
+    pushPacket(core, 200); // 丟棄 F100
+    Popped next = popMessage(core, 3);
+    CHECK(next.magic == FEATURE_WIRE_MAGIC && next.sequence == 101 && next.flags == FEATURE_WIRE_FLAG_GAP);
+    core.removeClient(3);
+}
+
+// 裝置端遺失樣本 (位置跳躍) 時所有客戶端的下一包都帶 GAP；ADPCM 訂閱開始時第一包帶 RESYNC
+static void testSourceGapAndAdpcmResync()
+{
+    static WebSocketStreamCore core;
+    core.addClient(0, WS_SUBSCRIBE_PCM);
+    core.addClient(1, WS_SUBSCRIBE_ADPCM);
+
+    pushPacket(core, 0);
+    Popped pcm = popMessage(core, 0);
+    Popped adpcm = popMessage(core, 1);
+    CHECK(pcm.flags == 0 && pcm.codec == AUDIO_CODEC_PCM16);
+    CHECK(adpcm.flags == AUDIO_WIRE_FLAG_RESYNC && adpcm.codec == AUDIO_CODEC_IMA_ADPCM);
+
+    pushPacket(core, 1);
+    CHECK(popMessage(core, 1).flags == 0);
+    popMessage(core, 0);
+
+    pushPacket(core, 5); // 跳過 3 包
+    pcm = popMessage(core, 0);
+    adpcm = popMessage(core, 1);
+    CHECK(pcm.flags == AUDIO_WIRE_FLAG_GAP && pcm.samplePosition == 5 * PACKET_SAMPLES);
+    CHECK(adpcm.flags == AUDIO_WIRE_FLAG_GAP);
+
+    // 最後一個 ADPCM 訂閱者離開後編碼器停止；重新訂閱的第一包再帶 RESYNC
+    core.removeClient(1);
+    pushPacket(core, 6);
+    core.addClient(1, WS_SUBSCRIBE_ADPCM);
+    pushPacket(core, 7);
+    CHECK(popMessage(core, 1).flags == AUDIO_WIRE_FLAG_RESYNC);
+}
+
+// 生產端與傳輸端並行 (擷取任務 / WS_Stream 任務)：每則訊息不是送出就是計入丟棄，送出的依序且內容完整
+static void testConcurrentProducer()
+{
+    static WebSocketStreamCore core;
+    core.addClient(0, WS_SUBSCRIBE_PCM);
+    std::atomic<bool> done(false);
+    uint32_t received = 0, orderErrors = 0, corrupt = 0, gaps = 0, gapMismatches = 0;
+
+    std::thread consumer([&] {
+        int64_t last = -1;
+        for (;;)
+        {
+            // 先讀 done 再取出：生產端已結束且取不到訊息時隊列必定為空
+            bool finished = done.load();
+            Popped message = popMessage(core, 0);
+            if (message.magic == 0)
+            {
+                if (finished)
+                {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            int64_t position = (int64_t)(message.samplePosition / PACKET_SAMPLES);
+            orderErrors += position <= last;
+            corrupt += !message.samplesIntact;
+            bool skipped = position != last + 1;
+            gaps += (message.flags & AUDIO_WIRE_FLAG_GAP) != 0;
+            gapMismatches += skipped != ((message.flags & AUDIO_WIRE_FLAG_GAP) != 0);
+            last = position;
+            received++;
+        }
+    });
+
+    for (uint32_t i = 0; i < CONCURRENT_PACKETS; i++)
+    {
+        pushPacket(core, i);
+    }
+    done.store(true);
+    consumer.join();
+
+    WebSocketStreamCore::ClientStats stats = core.getClientStats(0);
+    printf("並行: 推入 %u, 送出 %u, 丟棄 %u, 高水位 %u, GAP %u\n", CONCURRENT_PACKETS, stats.sent, stats.dropped,
+           stats.highWater, gaps);
+    CHECK(stats.sent == received);
+    CHECK(stats.sent + stats.dropped == CONCURRENT_PACKETS);
+    CHECK(stats.highWater <= WS_STREAM_QUEUE_DEPTH);
+    CHECK(orderErrors == 0 && corrupt == 0);
+    CHECK(gapMismatches == 0);
+}
+
+int main()
+{
+    testParseSubscriptions();
+    testClients();
+    testDropOldestPerClient();
+    testGapMarksFirstSurvivorOfDroppedKind();
+    testSourceGapAndAdpcmResync();
+    testConcurrentProducer();
+    return hostTestResult("test_websocket_stream_core");
+}
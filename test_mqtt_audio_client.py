@@ -6,6 +6,7 @@ ESP32 MQTT 音訊客戶端
 
 import paho.mqtt.client as mqtt
 import json
+import struct
 import numpy as np
 import matplotlib.pyplot as plt
 from collections import deque
@@ -13,6 +14,59 @@ import time
 import threading
 from datetime import datetime
 
+# 緊湊特徵幀格式 (esp32/audio/frame)，與 include/FeatureWireFormat.h 一致
+FEATURE_WIRE_MAGIC = 0xA6
+FEATURE_WIRE_VERSION = 2
+FEATURE_WIRE_HEADER = struct.Struct('<BBBBBBBBHHIQQ2b6b')
+FEATURE_WIRE_FLAG_GAP = 0x02
+FEATURE_ENCODING_FLOAT16 = 1
+FEATURE_STAT_NAMES = ('spectralCentroid', 'spectralBandwidth', 'spectralRolloff',
+                      'spectralFlatness', 'zeroCrossingRate', 'rmsEnergy')
+
+
+def decode_feature_frames(payload):
+    """解碼一則緊湊特徵訊息，回傳每幀的 {'timestamp', 'samplePosition', 'sequence', 'gap', 'mfcc', 'mel', 特徵...} 列表
+    timestamp (ms) 由樣本時鐘推得：裝置已校時為 Unix 時間，否則為串流開始後的時間；gap 表示此幀之前有幀遺失"""
+    if len(payload) < FEATURE_WIRE_HEADER.size:
+        raise ValueError("特徵幀訊息過短")
+    fields = FEATURE_WIRE_HEADER.unpack_from(payload, 0)
+    (magic, version, encoding, frame_count, mfcc_count, mel_count, stat_count, flags,
+     sequence, hop_samples, sample_rate, position, epoch_us) = fields[:13]
+    mfcc_q, mel_q = fields[13], fields[14]
+    stat_q = fields[15:]
+    if magic != FEATURE_WIRE_MAGIC or version != FEATURE_WIRE_VERSION or stat_count not in (0, len(FEATURE_STAT_NAMES)):
+        raise ValueError("不支援的特徵幀標頭")
+
+    values_per_frame = mfcc_count + mel_count + stat_count
+    dtype = '<f2' if encoding == FEATURE_ENCODING_FLOAT16 else '<i2'
+    raw = np.frombuffer(payload, dtype=dtype, count=frame_count * values_per_frame,
+                        offset=FEATURE_WIRE_HEADER.size).astype(np.float32)
+    raw = raw.reshape(frame_count, values_per_frame)
+    if encoding != FEATURE_ENCODING_FLOAT16:
+        # 定點值 = int16 / 2^Q
+        scale = np.concatenate([np.full(mfcc_count, mfcc_q), np.full(mel_count, mel_q), stat_q[:stat_count]])
+        raw = raw * np.exp2(-scale)
+
+    frames = []
+    for i in range(frame_count):
+        frame_position = position + i * hop_samples
+        frame = {
+            'timestamp': (epoch_us + frame_position * 1000000 // sample_rate) // 1000,
+            'samplePosition': frame_position,
+            'sequence': (sequence + i) & 0xFFFF,
+            'gap': i == 0 and bool(flags & FEATURE_WIRE_FLAG_GAP),
+        }
+        # 裝置的特徵集 (configure 命令的 featureSet) 未選取的部分數量為 0，不放入結果
+        if mfcc_count:
+            frame['mfcc'] = raw[i, :mfcc_count]
+        if mel_count:
+            frame['mel'] = raw[i, mfcc_count:mfcc_count + mel_count]
+        for name, value in zip(FEATURE_STAT_NAMES, raw[i, mfcc_count + mel_count:]):
+            frame[name] = float(value)
+        frames.append(frame)
+    return frames
+
+
 class ESP32MqttAudioClient:
     def __init__(self, mqtt_host="192.168.137.1", mqtt_port=1883, 
                  mqtt_user=None, mqtt_password=None):
@@ -71,6 +125,7 @@ class ESP32MqttAudioClient:
                 ("esp32/audio/mfcc", 0),
                 ("esp32/audio/mel", 0),
                 ("esp32/audio/features", 0),
+                ("esp32/audio/frame", 0),
                 ("esp32/audio/status", 0)
             ]
             
@@ -90,6 +145,15 @@ class ESP32MqttAudioClient:
         """MQTT 消息處理回調"""
         try:
             topic = msg.topic
+            if topic == "esp32/audio/frame":
+                # 二進位緊湊特徵幀：每幀交給與 JSON 主題相同的處理函數
+                for frame in decode_feature_frames(msg.payload):
+                    self.handle_mfcc_data(frame)
+                    self.handle_mel_data(frame)
+                    if 'rmsEnergy' in frame:
+                        self.handle_features_data(frame)
+                return
+
             payload = msg.payload.decode('utf-8')
             data = json.loads(payload)
             
@@ -198,7 +262,15 @@ class ESP32MqttAudioClient:
                       f"過零率: {features['zeroCrossingRate']:.3f}")
     
     def handle_status_data(self, data):
-        """處理狀態數據"""
+        """處理狀態數據 (configure / resetConfig 的確認也發布在狀態主題)"""
+        if 'ack' in data:
+            if data.get('ok'):
+                print(f"✓ {data['ack']} #{data.get('id', '-')} 已套用: {', '.join(data.get('fields', []))}"
+                      f"{' (已儲存)' if data.get('persisted') else ''}")
+                print(f"  目前設定: {json.dumps(data.get('config', {}))}")
+            else:
+                print(f"✗ {data['ack']} #{data.get('id', '-')} 被拒絕，無效欄位: {data.get('field')}")
+            return
         print(f"ESP32 狀態: {json.dumps(data, indent=2)}")
     
     def send_control_command(self, command):
@@ -230,6 +302,19 @@ class ESP32MqttAudioClient:
     def get_status(self):
         """獲取 ESP32 狀態"""
         self.send_control_command("getStatus")
+
+    def configure(self, persist=False, **fields):
+        """執行期修改串流設定，例如 configure(audioCodec="adpcm", hopSamples=320, persist=True)"""
+        if not self.connected:
+            print("未連接到 MQTT，無法發送命令")
+            return None
+        self.config_id = getattr(self, 'config_id', 0) + 1
+        payload = {"command": "configure", "id": self.config_id, **fields}
+        if persist:
+            payload["persist"] = True
+        self.client.publish("esp32/audio/control", json.dumps(payload))
+        print(f"發送設定 #{self.config_id}: {fields}")
+        return self.config_id
     
     def connect(self):
         """連接到 MQTT 服務器"""
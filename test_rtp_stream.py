@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+ESP32 UDP/RTP 音訊串流接收與回環測試
+用法：
+- 接收裝置串流：python test_rtp_stream.py --listen 5004
+  (先以 MQTT 控制命令 {"command": "startRtp", "host": "<本機 IP>", "port": 5004} 啟動)
+- Linux 回環測試：python test_rtp_stream.py --loopback [--loss 0.02] [--seconds 10]
+  在本機以裝置相同的節奏 (每 16 ms 一個 256 樣本資料報) 送到 127.0.0.1，量測延遲與遺失
+"""
+
+import argparse
+import random
+import socket
+import struct
+import threading
+import time
+
+import numpy as np
+
+# RTP 封包格式，與 include/RtpWireFormat.h 一致
+RTP_HEADER = struct.Struct('!BBHII')
+RTP_VERSION = 2
+RTP_PAYLOAD_TYPE_L16 = 96
+SAMPLE_RATE = 16000
+BLOCK_SAMPLES = 256
+
+
+def decode_rtp(payload):
+    """解碼 RTP L16 資料報，回傳 {'marker', 'sequence', 'timestamp', 'ssrc', 'audio'}"""
+    if len(payload) < RTP_HEADER.size:
+        raise ValueError("RTP 資料報過短")
+    first, second, sequence, timestamp, ssrc = RTP_HEADER.unpack_from(payload, 0)
+    if first >> 6 != RTP_VERSION:
+        raise ValueError("不支援的 RTP 版本")
+    offset = RTP_HEADER.size + 4 * (first & 0x0F)
+    if first & 0x10:
+        _, words = struct.unpack_from('!HH', payload, offset)
+        offset += 4 + 4 * words
+    return {
+        'marker': bool(second & 0x80),
+        'payload_type': second & 0x7F,
+        'sequence': sequence,
+        'timestamp': timestamp,
+        'ssrc': ssrc,
+        'audio': np.frombuffer(payload, dtype='>i2', offset=offset).astype(np.int16),
+    }
+
+
+def encode_rtp(sequence, timestamp, ssrc, samples, marker=False):
+    """編碼 RTP L16 資料報 (回環測試的模擬裝置)"""
+    header = RTP_HEADER.pack(RTP_VERSION << 6, (0x80 if marker else 0) | RTP_PAYLOAD_TYPE_L16,
+                             sequence & 0xFFFF, timestamp & 0xFFFFFFFF, ssrc)
+    return header + samples.astype('>i2').tobytes()
+
+
+class RtpStreamStats:
+    """依 RFC 3550 計算遺失與到達抖動；延遲相對於樣本時鐘 (第一個資料報的到達時間為基準)"""
+
+    def __init__(self, sample_rate=SAMPLE_RATE):
+        self.sample_rate = sample_rate
+        self.ssrc = None
+        self.received = 0
+        self.expected_base = None
+        self.highest = None
+        self.reordered = 0
+        self.markers = 0
+        self.jitter = 0.0
+        self.last_transit = None
+        self.base_arrival = None
+        self.base_timestamp = None
+        self.delays = []
+
+    def on_packet(self, packet, arrival):
+        if packet['ssrc'] != self.ssrc:
+            # 新串流 (裝置重新啟動 RTP)：重新開始統計
+            self.__init__(self.sample_rate)
+            self.ssrc = packet['ssrc']
+            self.expected_base = packet['sequence']
+            self.highest = packet['sequence']
+            self.base_arrival = arrival
+            self.base_timestamp = packet['timestamp']
+
+        self.received += 1
+        if packet['marker']:
+            self.markers += 1
+
+        # 以 16 位元差值擴展序號，處理回繞
+        delta = (packet['sequence'] - (self.highest & 0xFFFF) + 0x8000) % 0x10000 - 0x8000
+        if delta > 0:
+            self.highest += delta
+        elif delta < 0:
+            self.reordered += 1
+
+        # 到達抖動 (RFC 3550 6.4.1)，單位秒
+        media_time = ((packet['timestamp'] - self.base_timestamp) & 0xFFFFFFFF) / self.sample_rate
+        transit = arrival - media_time
+        if self.last_transit is not None:
+            self.jitter += (abs(transit - self.last_transit) - self.jitter) / 16
+        self.last_transit = transit
+
+        # 相對延遲：比第一個資料報晚到多少 (接收端播放緩衝至少需要這麼多)
+        self.delays.append(arrival - self.base_arrival - media_time)
+
+    @property
+    def expected(self):
+        return 0 if self.highest is None else self.highest - self.expected_base + 1
+
+    @property
+    def lost(self):
+        return max(0, self.expected - self.received)
+
+    def summary(self):
+        delays = np.array(self.delays) * 1000 if self.delays else np.zeros(1)
+        delays -= delays.min()
+        loss = self.lost / self.expected * 100 if self.expected else 0.0
+        return (f"收到 {self.received}/{self.expected} 包 (遺失 {self.lost}, {loss:.2f}%), "
+                f"亂序 {self.reordered}, M 標記 {self.markers}, 抖動 {self.jitter * 1000:.2f} ms, "
+                f"相對延遲 p50 {np.percentile(delays, 50):.2f} / p99 {np.percentile(delays, 99):.2f} / "
+                f"max {delays.max():.2f} ms")
+
+
+def listen(port, seconds, on_packet=None):
+    """接收 RTP 資料報直到逾時，回傳統計"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sock.bind(('0.0.0.0', port))
+    sock.settimeout(0.5)
+    stats = RtpStreamStats()
+    deadline = time.time() + seconds if seconds else None
+    last_report = time.time()
+
+    while deadline is None or time.time() < deadline:
+        try:
+            payload, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            continue
+        arrival = time.monotonic()
+        try:
+            packet = decode_rtp(payload)
+        except ValueError as e:
+            print(f"⚠️ {e}")
+            continue
+        stats.on_packet(packet, arrival)
+        if on_packet:
+            on_packet(packet, arrival)
+        if time.time() - last_report >= 5:
+            print(f"📊 {stats.summary()}")
+            last_report = time.time()
+
+    sock.close()
+    return stats
+
+
+def loopback(port, seconds, loss):
+    """模擬裝置以即時節奏送出資料報 (依 loss 比例隨機丟棄)，同時在本機接收並量測單向延遲"""
+    sent_at = {}
+    one_way = []
+    ssrc = random.getrandbits(32)
+
+    def on_packet(packet, arrival):
+        send_time = sent_at.pop(packet['sequence'], None)
+        if send_time is not None:
+            one_way.append(arrival - send_time)
+
+    receiver = threading.Thread(target=lambda: results.append(listen(port, seconds + 1, on_packet)))
+    results = []
+    receiver.start()
+    time.sleep(0.2)
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tone = (np.sin(2 * np.pi * 440 * np.arange(BLOCK_SAMPLES) / SAMPLE_RATE) * 8000).astype(np.int16)
+    interval = BLOCK_SAMPLES / SAMPLE_RATE
+    start = time.monotonic()
+    sequence = random.getrandbits(16)
+    timestamp = random.getrandbits(32)
+    dropped = 0
+    count = int(seconds / interval)
+
+    for n in range(count):
+        # 與裝置相同：遺失的資料報仍消耗序號與時間戳；頭尾不丟，遺失才落在接收端可計算的範圍內
+        datagram = encode_rtp(sequence, timestamp, ssrc, tone, marker=(n == 0))
+        if n == 0 or n == count - 1 or random.random() >= loss:
+            sent_at[sequence & 0xFFFF] = time.monotonic()
+            sock.sendto(datagram, ('127.0.0.1', port))
+        else:
+            dropped += 1
+        sequence = (sequence + 1) & 0xFFFF
+        timestamp += BLOCK_SAMPLES
+        delay = start + (n + 1) * interval - time.monotonic()
+        if delay > 0:
+            time.sleep(delay)
+
+    sock.close()
+    receiver.join()
+    stats = results[0]
+    latency = np.array(one_way) * 1e6
+    print(f"送出 {count} 包 (模擬遺失 {dropped})")
+    print(f"📊 {stats.summary()}")
+    if len(latency):
+        print(f"⏱️ 單向延遲 p50 {np.percentile(latency, 50):.0f} µs, p99 {np.percentile(latency, 99):.0f} µs, "
+              f"max {latency.max():.0f} µs")
+    ok = stats.lost == dropped and stats.reordered == 0
+    print("✓ 遺失統計與模擬一致" if ok else "✗ 遺失統計與模擬不一致")
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ESP32 UDP/RTP 音訊串流接收與回環測試")
+    parser.add_argument('--listen', type=int, metavar='PORT', help="接收裝置串流的埠 (預設 5004)")
+    parser.add_argument('--loopback', action='store_true', help="在本機模擬裝置並量測延遲與遺失")
+    parser.add_argument('--port', type=int, default=5004, help="回環測試使用的埠")
+    parser.add_argument('--seconds', type=float, default=10, help="測試時間 (秒)，接收模式 0 表示不限")
+    parser.add_argument('--loss', type=float, default=0.0, help="回環測試的模擬遺失比例")
+    args = parser.parse_args()
+
+    if args.loopback:
+        raise SystemExit(0 if loopback(args.port, args.seconds, args.loss) else 1)
+
+    port = args.listen or 5004
+    print(f"🎧 在 UDP {port} 等待 RTP 串流，按 Ctrl+C 停止")
+    try:
+        stats = listen(port, args.seconds if args.listen is None else 0)
+        print(f"📊 {stats.summary()}")
+    except KeyboardInterrupt:
+        print("\n已停止")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+ESP32 WebSocket 串流客戶端
+直接連到裝置的 WebSocket 伺服器 (不經過 MQTT 服務器)，解碼二進位音訊封包與緊湊特徵幀，
+每 5 秒輸出速率、缺口標記 (依樣本位置計算遺失樣本數) 與重新同步次數
+用法：
+    python test_websocket_stream.py ws://<裝置 IP>:81/adpcm+features
+    python test_websocket_stream.py ws://<裝置 IP>:81/pcm --slow 0.05   # 模擬慢客戶端 (每則訊息延遲 50 ms)
+"""
+
+import argparse
+import struct
+import time
+
+import numpy as np
+import websocket
+
+from test_mqtt_audio_client import decode_feature_frames
+
+# 二進位音訊封包，與 include/AudioWireFormat.h 一致
+AUDIO_WIRE_HEADER = struct.Struct('<BBBBHHIQQ')
+AUDIO_WIRE_MAGIC = 0xA5
+FEATURE_WIRE_MAGIC = 0xA6
+AUDIO_WIRE_FLAG_RESYNC = 0x01
+AUDIO_WIRE_FLAG_GAP = 0x04
+
+
+class StreamStats:
+    def __init__(self):
+        self.audio_packets = 0
+        self.audio_gaps = 0
+        self.audio_missing = 0
+        self.resyncs = 0
+        self.feature_messages = 0
+        self.feature_frames = 0
+        self.feature_gaps = 0
+        self.bytes = 0
+        self.next_position = None
+        self.latencies = []
+        self.clock_offset = None
+        self.start = time.time()
+
+    def on_audio(self, payload):
+        (magic, version, codec, flags, sequence, count, sample_rate,
+         position, epoch_us) = AUDIO_WIRE_HEADER.unpack_from(payload)
+        self.audio_packets += 1
+        if flags & AUDIO_WIRE_FLAG_RESYNC:
+            self.resyncs += 1
+        # 缺口標記與樣本位置的跳躍應一致：位置差即遺失的樣本數
+        if flags & AUDIO_WIRE_FLAG_GAP:
+            self.audio_gaps += 1
+            if self.next_position is not None and position > self.next_position:
+                self.audio_missing += position - self.next_position
+        self.next_position = position + count
+
+        # 相對延遲：樣本時鐘推得的擷取時間與到達時間之差，以最早到達的封包對齊 (ms)
+        offset = time.time() * 1000 - (epoch_us + position * 1000000 // sample_rate) / 1000
+        self.clock_offset = offset if self.clock_offset is None else min(self.clock_offset, offset)
+        self.latencies.append(offset)
+
+    def on_features(self, payload):
+        frames = decode_feature_frames(payload)
+        self.feature_messages += 1
+        self.feature_frames += len(frames)
+        if frames and frames[0]['gap']:
+            self.feature_gaps += 1
+
+    def summary(self):
+        elapsed = max(time.time() - self.start, 1e-6)
+        text = (f"音訊 {self.audio_packets} 包 ({self.audio_packets / elapsed:.1f}/s), "
+                f"缺口 {self.audio_gaps} 次/{self.audio_missing} 樣本, 重新同步 {self.resyncs}, "
+                f"特徵 {self.feature_frames} 幀/{self.feature_messages} 則 (缺口 {self.feature_gaps}), "
+                f"{self.bytes / elapsed / 1024:.1f} KB/s")
+        if self.latencies:
+            latency = np.array(self.latencies) - self.clock_offset
+            text += f", 相對延遲 p50 {np.percentile(latency, 50):.0f} / p99 {np.percentile(latency, 99):.0f} ms"
+        return text
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ESP32 WebSocket 串流客戶端")
+    parser.add_argument('url', help="例如 ws://192.168.1.100:81/adpcm+features")
+    parser.add_argument('--seconds', type=float, default=0, help="接收時間 (秒)，0 表示不限")
+    parser.add_argument('--slow', type=float, default=0, help="每則訊息後延遲的秒數 (模擬慢客戶端)")
+    args = parser.parse_args()
+
+    ws = websocket.create_connection(args.url, timeout=5)
+    print(f"✓ 已連線 {args.url}")
+    stats = StreamStats()
+    deadline = time.time() + args.seconds if args.seconds else None
+    last_report = time.time()
+
+    try:
+        while deadline is None or time.time() < deadline:
+            try:
+                payload = ws.recv()
+            except websocket.WebSocketTimeoutException:
+                continue
+            if not isinstance(payload, bytes) or not payload:
+                continue
+            stats.bytes += len(payload)
+            if payload[0] == AUDIO_WIRE_MAGIC:
+                stats.on_audio(payload)
+            elif payload[0] == FEATURE_WIRE_MAGIC:
+                stats.on_features(payload)
+            if args.slow:
+                time.sleep(args.slow)
+            if time.time() - last_report >= 5:
+                print(f"📊 {stats.summary()}")
+                last_report = time.time()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        ws.close()
+
+    print(f"📊 {stats.summary()}")
+
+
+if __name__ == "__main__":
+    main()